@@ -3,7 +3,7 @@
 
 #include "database.h"
 
-std::map<String, Holder<Asset>, StringComparatorFast> assets;
+std::map<HeapString, Holder<Asset>, StringComparatorFast> assets;
 
 Serializer &operator << (Serializer &ser, const Asset &s)
 {
@@ -2,6 +2,7 @@
 #define guard_database_h_f17e7ce9_c9c5_49b3_b59d_c42929085c79_
 
 #include <cage-core/string.h> // StringComparatorFast
+#include <cage-core/heapString.h>
 #include <cage-core/serialization.h>
 #include <cage-core/config.h>
 
@@ -43,7 +44,7 @@ struct Scheme
 	friend Deserializer &operator >> (Deserializer &des, Scheme &s);
 };
 
-extern std::map<String, Holder<Scheme>, StringComparatorFast> schemes;
+extern std::map<HeapString, Holder<Scheme>, StringComparatorFast> schemes;
 
 void loadSchemes();
 
@@ -66,7 +67,7 @@ struct Asset
 	friend Deserializer &operator >> (Deserializer &des, Asset &s);
 };
 
-extern std::map<String, Holder<Asset>, StringComparatorFast> assets;
+extern std::map<HeapString, Holder<Asset>, StringComparatorFast> assets;
 
 extern uint64 lastModificationTime;
 extern std::set<String, StringComparatorFast> corruptedDatabanks;
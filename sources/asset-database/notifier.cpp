@@ -71,7 +71,7 @@ void notifierSendNotifications()
 		{
 			CAGE_ASSERT(!it.second->corrupted);
 			if (notifierInstance)
-				notifierInstance->notify(it.first);
+				notifierInstance->notify(String(it.first));
 			it.second->needNotify = false;
 		}
 	}
@@ -44,6 +44,12 @@ void processAnimation()
 	}();
 	anim->skeletonName(skeletonName);
 
+	if (toBool(properties("compress")))
+	{
+		anim->compress();
+		CAGE_LOG(SeverityEnum::Info, logComponentName, "keyframes compressed");
+	}
+
 	Holder<PointerRange<char>> buff = anim->exportBuffer();
 	CAGE_LOG(SeverityEnum::Info, logComponentName, Stringizer() + "buffer size (before compression): " + buff.size());
 	Holder<PointerRange<char>> comp = compress(buff);
@@ -0,0 +1,104 @@
+#ifndef guard_commandBuffer_h_c1v7k4w9qz3m
+#define guard_commandBuffer_h_c1v7k4w9qz3m
+
+#include "core.h"
+
+#include <vector>
+
+namespace cage
+{
+	// contiguous stream of tagged trivially copyable commands, each optionally followed by additional bytes
+	// commands are aligned to 8 bytes
+	// the storage is retained after clear
+
+	struct CommandBuffer : private Noncopyable
+	{
+		struct Command
+		{
+			uint32 type = m;
+			PointerRange<const char> payload; // the command structure followed by the additional bytes
+
+			template<class T>
+			CAGE_FORCE_INLINE const T &as() const
+			{
+				CAGE_ASSERT(payload.size() >= sizeof(T));
+				return *(const T *)payload.data();
+			}
+
+			template<class T>
+			CAGE_FORCE_INLINE PointerRange<const char> extra() const
+			{
+				CAGE_ASSERT(payload.size() >= sizeof(T));
+				return { payload.data() + sizeof(T), payload.data() + payload.size() };
+			}
+		};
+
+		struct Iterator
+		{
+			const uint64 *p = nullptr;
+
+			CAGE_FORCE_INLINE Command operator * () const
+			{
+				Command c;
+				c.type = uint32(*p);
+				const uint32 size = uint32(*p >> 32);
+				c.payload = { (const char *)(p + 1), (const char *)(p + 1) + size };
+				return c;
+			}
+
+			CAGE_FORCE_INLINE Iterator &operator ++ ()
+			{
+				p += words(uint32(*p >> 32));
+				return *this;
+			}
+
+			CAGE_FORCE_INLINE bool operator == (const Iterator &other) const { return p == other.p; }
+			CAGE_FORCE_INLINE bool operator != (const Iterator &other) const { return p != other.p; }
+		};
+
+		template<class T>
+		void add(uint32 type, const T &command, PointerRange<const char> extra = {})
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			static_assert(std::is_trivially_destructible_v<T>);
+			static_assert(alignof(T) <= sizeof(uint64));
+			const uint32 size = numeric_cast<uint32>(sizeof(T) + extra.size());
+			const uintPtr pos = data.size();
+			data.resize(pos + words(size));
+			data[pos] = uint64(type) | (uint64(size) << 32);
+			char *dst = (char *)(data.data() + pos + 1);
+			detail::memcpy(dst, &command, sizeof(T));
+			if (!extra.empty())
+				detail::memcpy(dst + sizeof(T), extra.data(), extra.size());
+			commands++;
+		}
+
+		void clear()
+		{
+			data.clear();
+			commands = 0;
+		}
+
+		void reserve(uintPtr bytes)
+		{
+			data.reserve(bytes / sizeof(uint64));
+		}
+
+		Iterator begin() const { return { data.data() }; }
+		Iterator end() const { return { data.data() + data.size() }; }
+		uint32 count() const { return commands; }
+		uintPtr size() const { return data.size() * sizeof(uint64); } // bytes
+		bool empty() const { return commands == 0; }
+
+	private:
+		CAGE_FORCE_INLINE static uintPtr words(uint32 size)
+		{
+			return 1 + (size + sizeof(uint64) - 1) / sizeof(uint64);
+		}
+
+		std::vector<uint64> data;
+		uint32 commands = 0;
+	};
+}
+
+#endif // guard_commandBuffer_h_c1v7k4w9qz3m
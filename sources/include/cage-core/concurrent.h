@@ -50,6 +50,7 @@ namespace cage
 	{
 	public:
 		void lock(); // decrements value
+		bool tryLock(uint64 micros); // decrements value, gives up after the timeout; return true on success
 		void unlock(); // increments value
 	};
 
@@ -96,6 +97,7 @@ namespace cage
 	CAGE_CORE_API uint64 currentThreadId();
 	CAGE_CORE_API uint64 currentProcessId();
 	CAGE_CORE_API uint32 processorsCount(); // return number of threads that can physically run simultaneously
+	CAGE_CORE_API void currentThreadAffinity(PointerRange<const uint32> processors); // restrict the calling thread to the logical processors, empty range removes the restriction
 	CAGE_CORE_API void threadSleep(uint64 micros);
 	CAGE_CORE_API void threadYield();
 }
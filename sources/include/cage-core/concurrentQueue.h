@@ -5,6 +5,9 @@
 
 #include <plf_list.h>
 
+#include <atomic>
+#include <vector>
+
 namespace cage
 {
 	struct CAGE_CORE_API ConcurrentQueueTerminated : public Exception
@@ -146,6 +149,312 @@ namespace cage
 		const uint32 maxItems = m;
 		bool stop = false;
 	};
+
+	namespace privat
+	{
+		// threads spin for a while before they park on an atomic counter
+		struct ConcurrentQueueParking
+		{
+			std::atomic<uint32> epoch = 0;
+			std::atomic<uint32> waiters = 0;
+
+			CAGE_FORCE_INLINE void notify()
+			{
+				epoch.fetch_add(1);
+				if (waiters.load() > 0)
+					epoch.notify_one();
+			}
+
+			void notifyAll()
+			{
+				epoch.fetch_add(1);
+				epoch.notify_all();
+			}
+
+			template<class F>
+			CAGE_FORCE_INLINE void loop(const std::atomic<bool> &stop, F &&attempt)
+			{
+				static constexpr uint32 SpinCount = 64;
+				static constexpr uint32 YieldCount = 16;
+				// busy spinning is pointless when there is no other processor to make progress
+				static const uint32 firstSpin = processorsCount() > 1 ? 0 : SpinCount - YieldCount;
+				for (uint32 spin = firstSpin;; spin++)
+				{
+					if (stop.load(std::memory_order_relaxed))
+						CAGE_THROW_SILENT(ConcurrentQueueTerminated, "concurrent queue terminated");
+					if (attempt())
+						return;
+					if (spin < SpinCount)
+					{
+						if (spin >= SpinCount - YieldCount)
+							threadYield();
+						continue;
+					}
+					waiters.fetch_add(1);
+					const uint32 e = epoch.load();
+					// recheck after registering as waiter, any change after this point modifies the epoch
+					if (!stop.load() && !attempt())
+					{
+						epoch.wait(e);
+						waiters.fetch_sub(1);
+						continue;
+					}
+					waiters.fetch_sub(1);
+					if (stop.load())
+						CAGE_THROW_SILENT(ConcurrentQueueTerminated, "concurrent queue terminated");
+					return;
+				}
+			}
+		};
+
+		template<class Queue, class T>
+		class ConcurrentRingQueueBase : private Immovable
+		{
+		public:
+			void push(const T &value)
+			{
+				T tmp(value);
+				push(std::move(tmp));
+			}
+
+			void push(T &&value)
+			{
+				writers.loop(stop, [&]() { return queue()->tryPushImpl(value); });
+				readers.notify();
+			}
+
+			bool tryPush(const T &value)
+			{
+				T tmp(value);
+				return tryPush(std::move(tmp));
+			}
+
+			bool tryPush(T &&value)
+			{
+				if (stop.load(std::memory_order_relaxed))
+					CAGE_THROW_SILENT(ConcurrentQueueTerminated, "concurrent queue terminated");
+				if (!queue()->tryPushImpl(value))
+					return false;
+				readers.notify();
+				return true;
+			}
+
+			void pop(T &value)
+			{
+				readers.loop(stop, [&]() { return queue()->tryPopImpl(value); });
+				writers.notify();
+			}
+
+			bool tryPop(T &value)
+			{
+				if (stop.load(std::memory_order_relaxed))
+					CAGE_THROW_SILENT(ConcurrentQueueTerminated, "concurrent queue terminated");
+				if (!queue()->tryPopImpl(value))
+					return false;
+				writers.notify();
+				return true;
+			}
+
+			void terminate()
+			{
+				stop.store(true);
+				writers.notifyAll();
+				readers.notifyAll();
+			}
+
+			bool stopped() const
+			{
+				return stop.load();
+			}
+
+		protected:
+			static_assert(std::is_nothrow_move_constructible_v<T>);
+
+			struct alignas(T) Storage
+			{
+				char data[sizeof(T)];
+			};
+
+			static uint32 roundCapacity(uint32 capacity)
+			{
+				CAGE_ASSERT(capacity > 0 && capacity <= (1u << 31));
+				uint32 r = 1;
+				while (r < capacity)
+					r *= 2;
+				return r;
+			}
+
+		private:
+			CAGE_FORCE_INLINE Queue *queue() { return static_cast<Queue *>(this); }
+
+			alignas(64) ConcurrentQueueParking writers;
+			alignas(64) ConcurrentQueueParking readers;
+			std::atomic<bool> stop = false;
+		};
+	}
+
+	// bounded lock-free queue for multiple producers and multiple consumers
+	// the capacity is rounded up to power of two
+	// blocking operations spin for a short while before they park the thread
+	template<class T>
+	class ConcurrentQueueMpmc : public privat::ConcurrentRingQueueBase<ConcurrentQueueMpmc<T>, T>
+	{
+		using Base = privat::ConcurrentRingQueueBase<ConcurrentQueueMpmc<T>, T>;
+		using Storage = typename Base::Storage;
+
+	public:
+		explicit ConcurrentQueueMpmc(uint32 capacity = 1024) : cells(Base::roundCapacity(capacity)), mask(numeric_cast<uint32>(cells.size() - 1))
+		{
+			for (uint64 i = 0; i < cells.size(); i++)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		~ConcurrentQueueMpmc()
+		{
+			for (uint64 i = dequeuePos.load(); i != enqueuePos.load(); i++)
+				((T *)cells[i & mask].storage.data)->~T();
+		}
+
+		uint32 estimatedSize() const
+		{
+			const uint64 a = enqueuePos.load(std::memory_order_relaxed);
+			const uint64 b = dequeuePos.load(std::memory_order_relaxed);
+			return a > b ? numeric_cast<uint32>(a - b) : 0;
+		}
+
+		uint32 capacity() const { return mask + 1; }
+
+	private:
+		struct Cell
+		{
+			std::atomic<uint64> sequence = 0;
+			Storage storage;
+		};
+
+		bool tryPushImpl(T &value)
+		{
+			uint64 pos = enqueuePos.load(std::memory_order_relaxed);
+			Cell *c = nullptr;
+			while (true)
+			{
+				c = &cells[pos & mask];
+				const sint64 dif = (sint64)c->sequence.load(std::memory_order_acquire) - (sint64)pos;
+				if (dif == 0)
+				{
+					if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (dif < 0)
+					return false; // full
+				else
+					pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+			new (c->storage.data) T(std::move(value));
+			c->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool tryPopImpl(T &value)
+		{
+			uint64 pos = dequeuePos.load(std::memory_order_relaxed);
+			Cell *c = nullptr;
+			while (true)
+			{
+				c = &cells[pos & mask];
+				const sint64 dif = (sint64)c->sequence.load(std::memory_order_acquire) - (sint64)(pos + 1);
+				if (dif == 0)
+				{
+					if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (dif < 0)
+					return false; // empty
+				else
+					pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+			T *p = (T *)c->storage.data;
+			value = std::move(*p);
+			p->~T();
+			c->sequence.store(pos + mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		std::vector<Cell> cells;
+		const uint32 mask = 0;
+		alignas(64) std::atomic<uint64> enqueuePos = 0;
+		alignas(64) std::atomic<uint64> dequeuePos = 0;
+
+		friend Base;
+	};
+
+	// bounded lock-free queue for a single producer thread and a single consumer thread
+	// the capacity is rounded up to power of two
+	// blocking operations spin for a short while before they park the thread
+	template<class T>
+	class ConcurrentQueueSpsc : public privat::ConcurrentRingQueueBase<ConcurrentQueueSpsc<T>, T>
+	{
+		using Base = privat::ConcurrentRingQueueBase<ConcurrentQueueSpsc<T>, T>;
+		using Storage = typename Base::Storage;
+
+	public:
+		explicit ConcurrentQueueSpsc(uint32 capacity = 1024) : slots(Base::roundCapacity(capacity)), mask(numeric_cast<uint32>(slots.size() - 1))
+		{}
+
+		~ConcurrentQueueSpsc()
+		{
+			for (uint64 i = head.load(); i != tail.load(); i++)
+				((T *)slots[i & mask].data)->~T();
+		}
+
+		uint32 estimatedSize() const
+		{
+			const uint64 a = tail.load(std::memory_order_relaxed);
+			const uint64 b = head.load(std::memory_order_relaxed);
+			return a > b ? numeric_cast<uint32>(a - b) : 0;
+		}
+
+		uint32 capacity() const { return mask + 1; }
+
+	private:
+		bool tryPushImpl(T &value)
+		{
+			const uint64 t = tail.load(std::memory_order_relaxed);
+			if (t - headCache > mask)
+			{
+				headCache = head.load(std::memory_order_acquire);
+				if (t - headCache > mask)
+					return false; // full
+			}
+			new (slots[t & mask].data) T(std::move(value));
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool tryPopImpl(T &value)
+		{
+			const uint64 h = head.load(std::memory_order_relaxed);
+			if (h == tailCache)
+			{
+				tailCache = tail.load(std::memory_order_acquire);
+				if (h == tailCache)
+					return false; // empty
+			}
+			T *p = (T *)slots[h & mask].data;
+			value = std::move(*p);
+			p->~T();
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		std::vector<Storage> slots;
+		const uint32 mask = 0;
+		alignas(64) std::atomic<uint64> head = 0; // written by the consumer
+		uint64 tailCache = 0;
+		alignas(64) std::atomic<uint64> tail = 0; // written by the producer
+		uint64 headCache = 0;
+
+		friend Base;
+	};
 }
 
 #endif // guard_concurrentQueue_h_F17509C840DB4228AF89C97FCD8EC1E5
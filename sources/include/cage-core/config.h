@@ -40,27 +40,27 @@ namespace cage
 
 	struct CAGE_CORE_API ConfigString
 	{
-		explicit ConfigString(const String &name);
-		explicit ConfigString(const String &name, const String &default_);
+		explicit ConfigString(StringView name);
+		explicit ConfigString(StringView name, const String &default_);
 		operator String() const;
 		ConfigString &operator = (const String &value);
 	private:
 		privat::ConfigVariable *data = nullptr;
 	};
-	CAGE_CORE_API void configSetString(const String &name, const String &value);
-	CAGE_CORE_API String configGetString(const String &name, const String &default_ = "");
+	CAGE_CORE_API void configSetString(StringView name, const String &value);
+	CAGE_CORE_API String configGetString(StringView name, const String &default_ = "");
 
 #define GCHL_CONFIG(T, t) \
 	struct CAGE_CORE_API Config##T \
 	{ \
-		explicit Config##T(const String &name); \
-		explicit Config##T(const String &name, t default_); \
+		explicit Config##T(StringView name); \
+		explicit Config##T(StringView name, t default_); \
 		operator t() const; \
 		Config##T &operator = (t value); \
 		private: privat::ConfigVariable *data = nullptr; \
 	}; \
-	CAGE_CORE_API void configSet##T(const String &name, t value); \
-	CAGE_CORE_API t configGet##T(const String &name, t default_ = 0);
+	CAGE_CORE_API void configSet##T(StringView name, t value); \
+	CAGE_CORE_API t configGet##T(StringView name, t default_ = 0);
 	GCHL_CONFIG(Bool, bool)
 	GCHL_CONFIG(Sint32, sint32)
 	GCHL_CONFIG(Sint64, sint64)
@@ -70,10 +70,10 @@ namespace cage
 	GCHL_CONFIG(Double, double)
 #undef GCHL_CONFIG
 
-	CAGE_CORE_API void configSetDynamic(const String &name, const String &value); // changes the type of the config variable to the one best suited for the value
+	CAGE_CORE_API void configSetDynamic(StringView name, const String &value); // changes the type of the config variable to the one best suited for the value
 
 	CAGE_CORE_API String configTypeToString(const ConfigTypeEnum type);
-	CAGE_CORE_API ConfigTypeEnum configGetType(const String &name);
+	CAGE_CORE_API ConfigTypeEnum configGetType(StringView name);
 
 	CAGE_CORE_API void configApplyIni(const Ini *ini, const String &prefix);
 	CAGE_CORE_API Holder<Ini> configGenerateIni(const String &prefix);
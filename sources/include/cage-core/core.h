@@ -67,6 +67,8 @@ namespace cage
 	}
 	using String = detail::StringBase<1019>;
 	using Stringizer = detail::StringizerBase<1019>;
+	struct StringView;
+	struct HeapString;
 
 	struct Real;
 	struct Rads;
@@ -601,6 +603,13 @@ namespace cage
 				return *this;
 			}
 
+			CAGE_FORCE_INLINE constexpr StringizerBase<N> &operator + (StringLiteral other)
+			{
+				return *this + (const char *)other;
+			}
+
+			CAGE_FORCE_INLINE constexpr StringizerBase<N> &operator + (const StringView &other);
+
 			template<class T>
 			CAGE_FORCE_INLINE constexpr StringizerBase<N> &operator + (T *other)
 			{
@@ -641,6 +650,77 @@ namespace cage
 		{}
 	}
 
+	// string view
+
+	// non-owning reference to characters of a String, HeapString, string literal, or a range
+	// the referenced characters must outlive the view, and are not necessarily null-terminated
+	struct StringView
+	{
+		constexpr StringView() noexcept = default;
+
+		CAGE_FORCE_INLINE constexpr StringView(const char *str) noexcept : ptr(str)
+		{
+			while (str[len])
+				len++;
+		}
+
+		CAGE_FORCE_INLINE constexpr StringView(StringLiteral str) noexcept : StringView((const char *)str) {}
+
+		CAGE_FORCE_INLINE constexpr StringView(const PointerRange<const char> &range) : ptr(range.data()), len(numeric_cast<uint32>(range.size())) {}
+
+		template<uint32 N>
+		CAGE_FORCE_INLINE constexpr StringView(const detail::StringBase<N> &str) noexcept : ptr(str.data()), len(str.size()) {}
+
+		template<uint32 N>
+		CAGE_FORCE_INLINE constexpr StringView(const detail::StringizerBase<N> &str) noexcept : StringView(str.value) {}
+
+		CAGE_FORCE_INLINE constexpr operator PointerRange<const char>() const noexcept { return { ptr, ptr + len }; }
+
+		CAGE_FORCE_INLINE constexpr char operator [] (uint32 idx) const
+		{
+			CAGE_ASSERT(idx < len);
+			return ptr[idx];
+		}
+
+		CAGE_FORCE_INLINE friend constexpr bool operator == (const StringView &a, const StringView &b) noexcept
+		{
+			return privat::stringComparison(a.ptr, a.len, b.ptr, b.len) == 0;
+		}
+
+		CAGE_FORCE_INLINE friend constexpr auto operator <=> (const StringView &a, const StringView &b) noexcept
+		{
+			return privat::stringComparison(a.ptr, a.len, b.ptr, b.len) <=> 0;
+		}
+
+		CAGE_FORCE_INLINE constexpr const char *begin() const noexcept { return ptr; }
+		CAGE_FORCE_INLINE constexpr const char *end() const noexcept { return ptr + len; }
+		CAGE_FORCE_INLINE constexpr const char *data() const noexcept { return ptr; }
+		CAGE_FORCE_INLINE constexpr uint32 size() const noexcept { return len; }
+		CAGE_FORCE_INLINE constexpr uint32 length() const noexcept { return len; }
+		CAGE_FORCE_INLINE constexpr bool empty() const noexcept { return len == 0; }
+
+		using value_type = char;
+
+	private:
+		const char *ptr = "";
+		uint32 len = 0;
+	};
+
+	namespace detail
+	{
+		template<uint32 N>
+		CAGE_FORCE_INLINE constexpr StringizerBase<N> &StringizerBase<N>::operator + (const StringView &other)
+		{
+			const uint32 l = value.length();
+			if (l + other.size() > N)
+				CAGE_THROW_ERROR(Exception, "string truncation");
+			detail::memcpy(value.rawData() + l, other.data(), other.size());
+			value.rawLength() = l + other.size();
+			value.rawData()[value.rawLength()] = 0;
+			return *this;
+		}
+	}
+
 	// delegates
 
 	template<class T>
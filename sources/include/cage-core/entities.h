@@ -46,6 +46,16 @@ namespace cage
 
 		void destroy(); // destroy all entities
 
+		// dirty tracking records created entities and their components that were added, removed or accessed for writing (non-const unsafeValue or value)
+		// reading through the const accessors (and const references in entitiesVisitor) does not mark anything
+		// writes may be marked from multiple threads concurrently, as long as each value is accessed by single thread
+		// only the first write to each value after clearDirty synchronizes with other threads
+		// the records are meant for a single consumer, which synchronizes other data with this manager and then clears them
+		void dirtyTracking(bool enable);
+		bool dirtyTracking() const;
+		PointerRange<Entity *const> dirtyEntities() const;
+		void clearDirty();
+
 	private:
 		EntityComponent *defineComponent_(uint32 typeIndex, const void *prototype);
 	};
@@ -64,6 +74,12 @@ namespace cage
 		CAGE_FORCE_INLINE uint32 count() const { return numeric_cast<uint32>(entities().size()); }
 
 		void destroy(); // destroy all entities with this component
+
+		// copies values of this component into the destination component (of same type and manager) for all entities with this component
+		// the destination is added to entities that miss it, and only values that differ are written (and marked dirty)
+		// runs in multiple tasks when there are at least parallelThreshold entities
+		// returns number of written values
+		uint32 copyValuesTo(EntityComponent *destination, uint32 parallelThreshold = 2000);
 	};
 
 	class CAGE_CORE_API Entity : private Immovable
@@ -88,7 +104,12 @@ namespace cage
 
 		template<class T> CAGE_FORCE_INLINE T &value(EntityComponent *component) { CAGE_ASSERT(component->manager() == manager()); CAGE_ASSERT(component->typeIndex() == detail::typeIndex<T>()); return *(T *)unsafeValue(component); }
 		template<class T> CAGE_FORCE_INLINE T &value() { return value<T>(component_<T>()); }
-		void *unsafeValue(EntityComponent *component);
+		template<class T> CAGE_FORCE_INLINE const T &value(const EntityComponent *component) const { CAGE_ASSERT(component->manager() == manager()); CAGE_ASSERT(component->typeIndex() == detail::typeIndex<T>()); return *(const T *)unsafeValue(component); }
+		template<class T> CAGE_FORCE_INLINE const T &value() const { return value<T>((const EntityComponent *)component_<T>()); }
+		void *unsafeValue(EntityComponent *component); // adds the component if missing, marks it dirty
+		const void *unsafeValue(const EntityComponent *component) const; // the component must be present, does not mark dirty
+
+		bool dirty(const EntityComponent *component) const; // see EntityManager::dirtyTracking
 
 		void destroy();
 
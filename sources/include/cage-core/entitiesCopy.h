@@ -13,7 +13,27 @@ namespace cage
 		EntityManager *destination = nullptr;
 	};
 
+	// destroys all entities in the destination and recreates them from the source
 	CAGE_CORE_API void entitiesCopy(const EntitiesCopyConfig &config);
+
+	struct CAGE_CORE_API EntitiesCopierCreateConfig
+	{
+		EntityManager *source = nullptr;
+		EntityManager *destination = nullptr;
+		uint32 parallelThreshold = 2000; // minimum number of components values to copy in multiple tasks
+	};
+
+	// keeps the destination synchronized with the source incrementally
+	// enables dirty tracking in the source and applies only entities and components that changed since previous copy
+	// the destination must not be modified by anything else
+	class CAGE_CORE_API EntitiesCopier : private Immovable
+	{
+	public:
+		void copy(); // the first copy is full
+		void reset(); // next copy will be full
+	};
+
+	CAGE_CORE_API Holder<EntitiesCopier> newEntitiesCopier(const EntitiesCopierCreateConfig &config);
 }
 
 #endif // guard_entitiesCopy_4jh1gv89sert74hz
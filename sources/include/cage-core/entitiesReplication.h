@@ -0,0 +1,75 @@
+#ifndef guard_entitiesReplication_h_4hb1vx8r5tq2
+#define guard_entitiesReplication_h_4hb1vx8r5tq2
+
+#include "entities.h"
+
+namespace cage
+{
+	class GinnelConnection;
+
+	// replicates named entities and their components from a server to multiple clients
+	// each client acknowledges snapshots it has applied, and the server encodes following snapshots as differences against the latest acknowledged snapshot (baseline)
+	// components are compared byte-wise; unchanged components are omitted entirely, changed ones are sent as xor against the baseline with runs of zeroes skipped
+	// snapshots and acknowledgements may be lost, duplicated or reordered, therefore they are suitable for unreliable channels
+
+	struct CAGE_CORE_API EntitiesReplicationServerCreateConfig
+	{
+		const EntityGroup *entities = nullptr; // required; only named entities are replicated
+		PointerRange<EntityComponent *const> components; // empty -> all components of the manager
+		uint32 historySize = 64; // number of snapshots retained as potential baselines
+		uint32 channel = 13; // used by the ginnel helpers
+	};
+
+	class CAGE_CORE_API EntitiesReplicationServer : private Immovable
+	{
+	public:
+		// record current state of the entities as a new snapshot
+		void capture();
+
+		// encode the latest snapshot for the particular client
+		// clients are identified by arbitrary numbers chosen by the application, their state is created on demand
+		Holder<PointerRange<char>> encode(uint32 client);
+
+		// process acknowledgement message received from the client
+		void acknowledge(uint32 client, PointerRange<const char> message);
+
+		// forget all state for the client (eg. on disconnect)
+		void remove(uint32 client);
+
+		// encode the latest snapshot and write it into the connection as unreliable message
+		void send(uint32 client, GinnelConnection *connection);
+
+		uint32 snapshotId() const; // id of the latest captured snapshot
+		uint32 baselineId(uint32 client) const; // id of the latest snapshot acknowledged by the client, or zero
+	};
+
+	CAGE_CORE_API Holder<EntitiesReplicationServer> newEntitiesReplicationServer(const EntitiesReplicationServerCreateConfig &config);
+
+	struct CAGE_CORE_API EntitiesReplicationClientCreateConfig
+	{
+		EntityManager *manager = nullptr; // required; must define same components (in same order) as the server
+		uint32 historySize = 64; // number of applied snapshots retained for decoding following differences
+		uint32 channel = 13; // used by the ginnel helpers
+	};
+
+	class CAGE_CORE_API EntitiesReplicationClient : private Immovable
+	{
+	public:
+		// decode the snapshot and apply it to the entities
+		// returns false when the snapshot is obsolete or its baseline is no longer available (it is ignored)
+		bool apply(PointerRange<const char> message);
+
+		// message acknowledging the latest applied snapshot, to be sent to the server
+		// empty if no snapshot was applied yet
+		Holder<PointerRange<char>> acknowledgement() const;
+
+		// write the acknowledgement into the connection as unreliable message (if any)
+		void send(GinnelConnection *connection) const;
+
+		uint32 snapshotId() const; // id of the latest applied snapshot, or zero
+	};
+
+	CAGE_CORE_API Holder<EntitiesReplicationClient> newEntitiesReplicationClient(const EntitiesReplicationClientCreateConfig &config);
+}
+
+#endif // guard_entitiesReplication_h_4hb1vx8r5tq2
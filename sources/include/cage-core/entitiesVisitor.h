@@ -53,13 +53,24 @@ namespace cage
 			((fillComponentsArray<Types, I>(ents, components)), ...);
 		}
 
+		// const references read the values without marking them dirty
+		template<class T>
+		CAGE_FORCE_INLINE T visitorValue(Entity *e, EntityComponent *component)
+		{
+			using D = std::decay_t<T>;
+			if constexpr (std::is_same_v<T, const D &>)
+				return ((const Entity *)e)->value<D>((const EntityComponent *)component);
+			else
+				return e->value<D>(component);
+		}
+
 		template<bool UseEnt, class Visitor, class Types, std::size_t... I>
 		CAGE_FORCE_INLINE void invokeVisitor(const Visitor &visitor, EntityComponent *components[], Entity *e, std::index_sequence<I...>)
 		{
 			if constexpr (UseEnt)
-				visitor(e, ((e->value<std::decay_t<std::tuple_element_t<I, Types>>>(components[I])))...);
+				visitor(e, (visitorValue<std::tuple_element_t<I, Types>>(e, components[I]))...);
 			else
-				visitor(((e->value<std::decay_t<std::tuple_element_t<I, Types>>>(components[I])))...);
+				visitor((visitorValue<std::tuple_element_t<I, Types>>(e, components[I]))...);
 		}
 
 		template<bool ArrayCopy> struct VectorOrNothing {};
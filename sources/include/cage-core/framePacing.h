@@ -0,0 +1,72 @@
+#ifndef guard_framePacing_h_k3x8v1q7nz5m2w
+#define guard_framePacing_h_k3x8v1q7nz5m2w
+
+#include "variableSmoothingBuffer.h"
+
+namespace cage
+{
+	enum class FrameStageEnum : uint32
+	{
+		Input = 0, // inputs processed in the control thread
+		Emit, // control state published to graphics
+		PrepareStart,
+		PrepareEnd,
+		DispatchStart,
+		DispatchEnd,
+		Present, // buffers swapped, completes the frame
+	};
+
+	constexpr uint32 FrameStagesCount = 7;
+
+	struct FrameTimestamps
+	{
+		uint64 stages[FrameStagesCount] = {}; // zero for stages that were not recorded
+		uint32 frameIndex = m;
+	};
+
+	struct CAGE_CORE_API FramePacingStatistics
+	{
+		static constexpr uint32 StatisticsWindowSize = 100;
+		VariableSmoothingBuffer<uint64, StatisticsWindowSize> frameTimes; // between consecutive presents
+		VariableSmoothingBuffer<uint64, StatisticsWindowSize> frameJitters; // absolute difference of consecutive frame times
+		VariableSmoothingBuffer<uint64, StatisticsWindowSize> latencies; // from input to present
+		VariableSmoothingBuffer<uint64, StatisticsWindowSize> presentDelays; // from start of prepare to present
+		VariableSmoothingBuffer<uint64, StatisticsWindowSize> stageDelays[FrameStagesCount]; // from the previous recorded stage to this stage
+		FrameTimestamps latest;
+		uint32 frames = 0;
+		uint32 missedFrames = 0; // frames that took more than one and half of the target frame time
+
+		void add(const FrameTimestamps &timestamps, uint64 targetFrameTime = 0);
+	};
+
+	struct CAGE_CORE_API FramePacerCreateConfig
+	{
+		Delegate<uint64()> clock; // defaults to applicationTime
+		Delegate<void(uint64)> sleep; // defaults to threadSleep; zero duration is used to yield
+		uint64 targetFrameTime = 0; // 0 = not limited
+	};
+
+	class CAGE_CORE_API FramePacer : private Immovable
+	{
+	public:
+		void targetFrameTime(uint64 time);
+		uint64 targetFrameTime() const;
+
+		// waits for the start of the next frame
+		// sleeps for the remaining time minus the predicted oversleep, and yields for the rest
+		// when late by more than a whole frame, the cadence is restarted instead of catching up
+		void wait();
+		uint64 predictedOversleep() const;
+
+		// can be called from any thread; the present stage completes the frame and updates the statistics
+		void stage(uint32 frameIndex, FrameStageEnum stage);
+		void stage(uint32 frameIndex, FrameStageEnum stage, uint64 time);
+
+		uint64 presentDelay() const; // smoothed time from start of prepare to present
+		FramePacingStatistics statistics() const;
+	};
+
+	CAGE_CORE_API Holder<FramePacer> newFramePacer(const FramePacerCreateConfig &config);
+}
+
+#endif // guard_framePacing_h_k3x8v1q7nz5m2w
@@ -7,7 +7,31 @@
 
 namespace cage
 {
+	// fast non-cryptographic hashes suitable for large buffers
+	// hash64 gives same results as xxhash64
+	// hash128 extends it with a second, differently merged, 64 bit lane
+	CAGE_CORE_API uint64 hash64(PointerRange<const char> data, uint64 seed = 0) noexcept;
+	CAGE_CORE_API std::array<uint8, 16> hash128(PointerRange<const char> data, uint64 seed = 0) noexcept;
+
+	// incremental variant of hash64 and hash128, gives same results as hashing the whole buffer at once
+	struct CAGE_CORE_API HashStream
+	{
+		explicit HashStream(uint64 seed = 0) noexcept;
+		void update(PointerRange<const char> data) noexcept;
+		uint64 hash64() const noexcept;
+		std::array<uint8, 16> hash128() const noexcept;
+
+	private:
+		uint64 acc[4] = {};
+		uint64 total = 0;
+		uint64 seed = 0;
+		uint8 buffer[32] = {};
+		uint32 buffered = 0;
+	};
+
+	// cryptographic hashes use cpu sha extensions when available
 	CAGE_CORE_API std::array<uint8, 20> hashSha1(PointerRange<const char> data);
+	CAGE_CORE_API std::array<uint8, 32> hashSha256(PointerRange<const char> data);
 
 	CAGE_CORE_API String hashToHexadecimal(PointerRange<const uint8> data);
 	CAGE_CORE_API String hashToBase64(PointerRange<const uint8> data);
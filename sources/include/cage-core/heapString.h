@@ -0,0 +1,87 @@
+#ifndef guard_heapString_h_u7c3kw1p9fzq4n
+#define guard_heapString_h_u7c3kw1p9fzq4n
+
+#include "serialization.h"
+
+namespace cage
+{
+	// string without length limit
+	// short texts are stored inline, longer texts are allocated on heap
+	// use it for long-living strings, eg. keys in containers, to avoid copying the full capacity of String
+	struct CAGE_CORE_API HeapString
+	{
+		HeapString() noexcept {}
+		HeapString(const HeapString &other) : HeapString(StringView(other)) {}
+		HeapString(HeapString &&other) noexcept;
+		HeapString(StringView str);
+		HeapString(const char *str) : HeapString(StringView(str)) {}
+		template<uint32 N>
+		HeapString(const detail::StringBase<N> &str) : HeapString(StringView(str)) {}
+		template<uint32 N>
+		HeapString(const detail::StringizerBase<N> &str) : HeapString(StringView(str)) {}
+		~HeapString();
+
+		HeapString &operator = (const HeapString &other);
+		HeapString &operator = (HeapString &&other) noexcept;
+
+		HeapString &operator += (StringView other);
+		HeapString operator + (StringView other) const { return HeapString(*this) += other; }
+
+		CAGE_FORCE_INLINE friend bool operator == (const HeapString &a, StringView b) noexcept { return StringView(a) == b; }
+		CAGE_FORCE_INLINE friend auto operator <=> (const HeapString &a, StringView b) noexcept { return StringView(a) <=> b; }
+
+		CAGE_FORCE_INLINE char &operator [] (uint32 idx)
+		{
+			CAGE_ASSERT(idx < len);
+			return ptr[idx];
+		}
+
+		CAGE_FORCE_INLINE char operator [] (uint32 idx) const
+		{
+			CAGE_ASSERT(idx < len);
+			return ptr[idx];
+		}
+
+		CAGE_FORCE_INLINE operator StringView() const noexcept { return PointerRange<const char>(ptr, ptr + len); }
+		CAGE_FORCE_INLINE operator PointerRange<const char>() const noexcept { return { ptr, ptr + len }; }
+
+		CAGE_FORCE_INLINE const char *c_str() const noexcept { return ptr; }
+		CAGE_FORCE_INLINE const char *begin() const noexcept { return ptr; }
+		CAGE_FORCE_INLINE const char *end() const noexcept { return ptr + len; }
+		CAGE_FORCE_INLINE const char *data() const noexcept { return ptr; }
+		CAGE_FORCE_INLINE uint32 size() const noexcept { return len; }
+		CAGE_FORCE_INLINE uint32 length() const noexcept { return len; }
+		CAGE_FORCE_INLINE uint32 capacity() const noexcept { return cap; }
+		CAGE_FORCE_INLINE bool empty() const noexcept { return len == 0; }
+
+		void reserve(uint32 capacity); // allows the storage to grow only
+		void clear() noexcept; // keeps the storage
+
+		static constexpr uint32 InlineCapacity = 23;
+		using value_type = char;
+
+	private:
+		char *ptr = local;
+		uint32 len = 0;
+		uint32 cap = InlineCapacity;
+		char local[InlineCapacity + 1] = {};
+	};
+
+	// serialized same as String
+	inline Serializer &operator << (Serializer &s, const HeapString &v)
+	{
+		s << v.length();
+		s.write(v);
+		return s;
+	}
+
+	inline Deserializer &operator >> (Deserializer &s, HeapString &v)
+	{
+		uint32 size = 0;
+		s >> size;
+		v = HeapString(StringView(s.read(size)));
+		return s;
+	}
+}
+
+#endif // guard_heapString_h_u7c3kw1p9fzq4n
@@ -9,6 +9,7 @@ namespace cage
 	struct CAGE_CORE_API ImageKtxEncodeConfig
 	{
 		bool normals = false; // treat inputs as normal map
+		bool parallelize = true; // bcn encoding of large images is split into strips of block rows, the output is identical either way
 	};
 
 	CAGE_CORE_API Holder<PointerRange<char>> imageKtxEncode(PointerRange<const Image *> images, const ImageKtxEncodeConfig &config);
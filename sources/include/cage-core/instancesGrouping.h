@@ -0,0 +1,197 @@
+#ifndef guard_instancesGrouping_h_o5k2r8d1xa7v
+#define guard_instancesGrouping_h_o5k2r8d1xa7v
+
+#include "core.h"
+
+#include <vector>
+#include <algorithm>
+#include <functional> // hash, less
+#include <tuple>
+#include <utility> // pair
+
+namespace cage
+{
+	// groups instances with equal keys into contiguous ranges, ordered by the keys
+	// the key may be move-only, it needs equality operator, hasher and comparator
+	// all storage is retained after clear to avoid allocations in subsequent frames
+
+	template<class Key, class Instance, class Hasher = std::hash<Key>, class Compare = std::less<Key>>
+	struct InstancesGrouping : private Immovable
+	{
+		struct Group
+		{
+			Key key;
+			PointerRange<Instance> instances;
+		};
+
+		void add(Key &&key, Instance &&instance)
+		{
+			CAGE_ASSERT(!finished);
+			if (slots.size() < groups.size() * 2 + 16)
+				rehash();
+			const uint32 hash = numeric_cast<uint32>(Hasher()(key) & std::numeric_limits<uint32>::max());
+			const uint32 mask = numeric_cast<uint32>(slots.size() - 1);
+			uint32 i = hash & mask;
+			while (true)
+			{
+				Slot &s = slots[i];
+				if (s.index == m)
+				{
+					s.index = numeric_cast<uint32>(groups.size());
+					s.hash = hash;
+					groups.push_back({ std::move(key), {} });
+					counts.push_back(0);
+					break;
+				}
+				if (s.hash == hash && groups[s.index].key == key)
+					break;
+				i = (i + 1) & mask;
+			}
+			const uint32 g = slots[i].index;
+			counts[g]++;
+			unsorted.push_back(std::move(instance));
+			owners.push_back(g);
+		}
+
+		// sorts the groups and moves the instances into contiguous ranges
+		// no more instances may be added until clear
+		PointerRange<Group> finish()
+		{
+			if (finished)
+				return groups;
+			finished = true;
+
+			order.resize(groups.size());
+			for (uint32 i = 0; i < order.size(); i++)
+				order[i] = i;
+			std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return Compare()(groups[a].key, groups[b].key); });
+
+			// offsets of the ranges, indexed by the original group index
+			offsets.resize(groups.size());
+			uint32 offset = 0;
+			for (uint32 g : order)
+			{
+				offsets[g] = offset;
+				offset += counts[g];
+			}
+
+			sorted.resize(unsorted.size());
+			for (uint32 i = 0; i < unsorted.size(); i++)
+				sorted[offsets[owners[i]]++] = std::move(unsorted[i]);
+			unsorted.clear();
+			owners.clear();
+
+			sortedGroups.clear();
+			offset = 0;
+			for (uint32 g : order)
+			{
+				sortedGroups.push_back({ std::move(groups[g].key), { sorted.data() + offset, sorted.data() + offset + counts[g] } });
+				offset += counts[g];
+			}
+			std::swap(groups, sortedGroups);
+			sortedGroups.clear();
+			return groups;
+		}
+
+		// valid after finish
+		PointerRange<const Group> result() const
+		{
+			CAGE_ASSERT(finished);
+			return groups;
+		}
+
+		void clear()
+		{
+			groups.clear();
+			counts.clear();
+			unsorted.clear();
+			owners.clear();
+			sorted.clear();
+			for (Slot &s : slots)
+				s.index = m;
+			finished = false;
+		}
+
+		uint32 groupsCount() const { return numeric_cast<uint32>(groups.size()); }
+		uint32 instancesCount() const { return numeric_cast<uint32>(unsorted.size() + sorted.size()); }
+		bool empty() const { return groups.empty(); }
+
+	private:
+		struct Slot
+		{
+			uint32 hash = 0;
+			uint32 index = m;
+		};
+
+		void rehash()
+		{
+			uint32 size = 32;
+			while (size < groups.size() * 4)
+				size *= 2;
+			slots.clear();
+			slots.resize(size);
+			const uint32 mask = size - 1;
+			for (uint32 g = 0; g < groups.size(); g++)
+			{
+				const uint32 hash = numeric_cast<uint32>(Hasher()(groups[g].key) & std::numeric_limits<uint32>::max());
+				uint32 i = hash & mask;
+				while (slots[i].index != m)
+					i = (i + 1) & mask;
+				slots[i] = { hash, g };
+			}
+		}
+
+		std::vector<Group> groups, sortedGroups;
+		std::vector<Slot> slots;
+		std::vector<uint32> counts, owners, order, offsets;
+		std::vector<Instance> unsorted, sorted;
+		bool finished = false;
+	};
+
+	// key of batches of opaque instances, ordered to reduce state changes when rendering:
+	// shaders first, then depth test/writes and other render flags, then textures, then meshes
+	// equality and hash use the mesh identity only, the other fields are derived from the mesh
+	struct InstancesSortKey
+	{
+		uint32 shader = 0;
+		uint32 flags = 0;
+		uint32 textures[3] = {};
+		uintPtr meshId = 0;
+		bool skeletal = false;
+
+		auto cmp() const
+		{
+			return std::tuple{ shader, flags, textures[0], textures[1], textures[2], meshId, skeletal };
+		}
+
+		bool operator < (const InstancesSortKey &other) const
+		{
+			return cmp() < other.cmp();
+		}
+
+		bool operator == (const InstancesSortKey &other) const
+		{
+			return meshId == other.meshId && skeletal == other.skeletal;
+		}
+	};
+
+	struct InstancesSortKeyHasher
+	{
+		uint64 operator () (const InstancesSortKey &key) const
+		{
+			return (uint64)key.meshId * 31 + key.skeletal;
+		}
+	};
+
+	// translucent instances are rendered back-to-front, one at a time
+	// only the compact pairs of depth and index are sorted, farther first, equal depths keep their order
+	template<class Depth>
+	void instancesSortBackToFront(std::vector<std::pair<Depth, uint32>> &order)
+	{
+		const auto &farther = [](const std::pair<Depth, uint32> &a, const std::pair<Depth, uint32> &b) { return a.first > b.first; };
+		if (!std::is_sorted(order.begin(), order.end(), farther))
+			std::stable_sort(order.begin(), order.end(), farther);
+	}
+}
+
+#endif // guard_instancesGrouping_h_o5k2r8d1xa7v
@@ -51,6 +51,27 @@ namespace cage
 	CAGE_CORE_API Holder<LoggerOutputFile> newLoggerOutputFile(const String &path, bool append, bool realFilesystemOnly = true);
 	CAGE_CORE_API Holder<LoggerOutputFile> newLoggerOutputFile(Holder<File> file);
 
+	enum class LoggerAsyncOverflowEnum : uint32
+	{
+		Block, // the calling thread waits until the writer thread makes space
+		Drop, // the record is discarded, number of discarded records is reported later
+	};
+
+	struct CAGE_CORE_API LoggerAsyncConfig
+	{
+		uint32 capacityPerThread = 256; // number of records buffered by each logging thread
+		LoggerAsyncOverflowEnum overflow = LoggerAsyncOverflowEnum::Block;
+	};
+
+	// in asynchronous mode, records are enqueued into per-thread buffers, and formatted and written by a dedicated thread in batches
+	// critical records flush all pending records and are written synchronously
+	// the records are flushed when a logger is destroyed, when asynchronous mode is disabled, at exit, and in std::terminate (with limited wait)
+	// on fatal signals (SIGSEGV, SIGABRT, SIGFPE, SIGILL), pending messages are written unformatted to stderr, best-effort only
+	// changing the capacity replaces the buffers of all threads
+	CAGE_CORE_API void loggerAsyncEnable(const LoggerAsyncConfig &config = {});
+	CAGE_CORE_API void loggerAsyncDisable();
+	CAGE_CORE_API void loggerAsyncFlush(); // waits until all records enqueued before this call are written
+
 	namespace detail
 	{
 		CAGE_CORE_API Logger *globalLogger();
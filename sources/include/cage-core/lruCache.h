@@ -1,12 +1,14 @@
 #ifndef guard_lruCache_h_ABEDFC7ADD4A
 #define guard_lruCache_h_ABEDFC7ADD4A
 
-#include "core.h"
+#include "concurrent.h"
 
 #include <robin_hood.h>
 
-#include <vector>
+#include <atomic>
+#include <memory>
 #include <optional>
+#include <vector>
 
 namespace cage
 {
@@ -165,6 +167,246 @@ namespace cage
 			cache.clear();
 		}
 	};
+
+	struct ConcurrentLruCacheCreateConfig
+	{
+		uint64 maxCost = m; // sum of costs of all items, ignored if m
+		uint32 maxItems = 1000; // ignored if m
+		uint32 shards = 16; // rounded up to power of two
+	};
+
+	// thread-safe cache split into independently locked shards
+	// hits take shared lock only and mark the item as recently used (approximate lru via clock algorithm)
+	// the limits are divided evenly among the shards
+	template<class Key, class Value, class Hasher = std::hash<Key>>
+	struct ConcurrentLruCache : private Immovable
+	{
+	private:
+		struct Slot
+		{
+			Key key = Key();
+			Value value = Value();
+			uint64 cost = 0;
+			mutable std::atomic<bool> referenced = false;
+			bool valid = false;
+
+			Slot() = default;
+			Slot(Slot &&other) noexcept : key(std::move(other.key)), value(std::move(other.value)), cost(other.cost), referenced(other.referenced.load(std::memory_order_relaxed)), valid(other.valid) {}
+		};
+
+		struct Shard
+		{
+			Holder<RwMutex> mutex = newRwMutex();
+			robin_hood::unordered_map<Key, uint32, Hasher> indices;
+			std::vector<Slot> slots;
+			std::vector<uint32> unused;
+			uint64 cost = 0;
+			uint32 hand = 0;
+		};
+
+		const ConcurrentLruCacheCreateConfig config;
+		std::unique_ptr<Shard[]> shards;
+		const uint32 mask = 0;
+		const uint64 shardCost = m;
+		const uint32 shardItems = m;
+
+		static uint32 roundShards(uint32 shards)
+		{
+			CAGE_ASSERT(shards > 0 && shards <= 1024);
+			uint32 r = 1;
+			while (r < shards)
+				r *= 2;
+			return r;
+		}
+
+		Shard &shard(const Key &k) const
+		{
+			const uint64 h = Hasher()(k);
+			return shards[(h ^ (h >> 17) ^ (h >> 31)) & mask];
+		}
+
+		void release(Shard &s, uint32 index)
+		{
+			Slot &d = s.slots[index];
+			CAGE_ASSERT(d.valid);
+			s.indices.erase(d.key);
+			s.cost -= d.cost;
+			d.key = Key();
+			d.value = Value();
+			d.cost = 0;
+			d.valid = false;
+			s.unused.push_back(index);
+		}
+
+		bool overLimit(const Shard &s) const
+		{
+			return (shardItems != m && s.indices.size() > shardItems) || (shardCost != m && s.cost > shardCost);
+		}
+
+		void evict(Shard &s, uint32 keep)
+		{
+			// second chance for recently used items, each item is visited at most twice
+			uint32 budget = numeric_cast<uint32>(s.slots.size()) * 2 + 1;
+			while (overLimit(s) && s.indices.size() > 1 && budget--)
+			{
+				if (s.hand >= s.slots.size())
+					s.hand = 0;
+				const uint32 i = s.hand++;
+				Slot &d = s.slots[i];
+				if (!d.valid || i == keep)
+					continue;
+				if (d.referenced.exchange(false, std::memory_order_relaxed))
+					continue;
+				release(s, i);
+			}
+		}
+
+	public:
+		explicit ConcurrentLruCache(const ConcurrentLruCacheCreateConfig &config = {}) : config(config), mask(roundShards(config.shards) - 1), shardCost(config.maxCost == m ? m : (config.maxCost + mask) / (mask + 1)), shardItems(config.maxItems == m ? m : (config.maxItems + mask) / (mask + 1))
+		{
+			shards = std::make_unique<Shard[]>(mask + 1);
+		}
+
+		std::optional<Value> find(const Key &k) const
+		{
+			Shard &s = shard(k);
+			ScopeLock lock(s.mutex, ReadLockTag());
+			auto it = s.indices.find(k);
+			if (it == s.indices.end())
+				return {};
+			const Slot &d = s.slots[it->second];
+			CAGE_ASSERT(d.valid);
+			if (!d.referenced.load(std::memory_order_relaxed))
+				d.referenced.store(true, std::memory_order_relaxed);
+			return d.value;
+		}
+
+		// replaces previous value with same key, if any
+		Value set(const Key &k, Value value, uint64 cost = 1)
+		{
+			Shard &s = shard(k);
+			ScopeLock lock(s.mutex, WriteLockTag());
+			uint32 index = m;
+			auto it = s.indices.find(k);
+			if (it != s.indices.end())
+			{
+				index = it->second;
+				s.cost -= s.slots[index].cost;
+			}
+			else
+			{
+				if (s.unused.empty())
+				{
+					index = numeric_cast<uint32>(s.slots.size());
+					s.slots.emplace_back();
+				}
+				else
+				{
+					index = s.unused.back();
+					s.unused.pop_back();
+				}
+				s.indices[k] = index;
+			}
+			Slot &d = s.slots[index];
+			d.key = k;
+			d.value = std::move(value);
+			d.cost = cost;
+			d.valid = true;
+			d.referenced.store(true, std::memory_order_relaxed);
+			s.cost += cost;
+			evict(s, index);
+			return s.slots[index].value;
+		}
+
+		void erase(const Key &k)
+		{
+			Shard &s = shard(k);
+			ScopeLock lock(s.mutex, WriteLockTag());
+			auto it = s.indices.find(k);
+			if (it != s.indices.end())
+				release(s, it->second);
+		}
+
+		void clear()
+		{
+			for (uint32 i = 0; i <= mask; i++)
+			{
+				Shard &s = shards[i];
+				ScopeLock lock(s.mutex, WriteLockTag());
+				s.indices.clear();
+				s.slots.clear();
+				s.unused.clear();
+				s.cost = 0;
+				s.hand = 0;
+			}
+		}
+
+		uint32 count() const
+		{
+			uint32 r = 0;
+			for (uint32 i = 0; i <= mask; i++)
+			{
+				Shard &s = shards[i];
+				ScopeLock lock(s.mutex, ReadLockTag());
+				r += numeric_cast<uint32>(s.indices.size());
+			}
+			return r;
+		}
+
+		uint64 cost() const
+		{
+			uint64 r = 0;
+			for (uint32 i = 0; i <= mask; i++)
+			{
+				Shard &s = shards[i];
+				ScopeLock lock(s.mutex, ReadLockTag());
+				r += s.cost;
+			}
+			return r;
+		}
+	};
+
+	template<class Key, class Value, class Hasher>
+	struct ConcurrentLruCache<Key, Holder<Value>, Hasher> : private Immovable
+	{
+	private:
+		struct Data
+		{
+			Holder<Value> data;
+
+			Data() = default;
+			Data(Data &&other) = default;
+			Data(const Data &other) : data(other.data.share()) {}
+			Data &operator = (Data &&other) = default;
+			Data &operator = (const Data &other) { data = other.data.share(); return *this; }
+		};
+
+		ConcurrentLruCache<Key, Data, Hasher> cache;
+
+	public:
+		explicit ConcurrentLruCache(const ConcurrentLruCacheCreateConfig &config = {}) : cache(config)
+		{}
+
+		Holder<Value> find(const Key &k) const
+		{
+			auto v = cache.find(k);
+			if (v)
+				return std::move(v->data);
+			return {};
+		}
+
+		Holder<Value> set(const Key &k, Holder<Value> value, uint64 cost = 1)
+		{
+			Data d;
+			d.data = std::move(value);
+			return std::move(cache.set(k, std::move(d), cost).data);
+		}
+
+		void erase(const Key &k) { cache.erase(k); }
+		void clear() { cache.clear(); }
+		uint32 count() const { return cache.count(); }
+		uint64 cost() const { return cache.cost(); }
+	};
 }
 
 #endif // guard_lruCache_h_ABEDFC7ADD4A
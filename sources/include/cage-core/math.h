@@ -3,6 +3,14 @@
 
 #include "core.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CAGE_SIMD_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define CAGE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 #define GCHL_DIMENSION(TYPE) (sizeof(TYPE::data) / sizeof(TYPE::data[0]))
 
 namespace cage
@@ -242,7 +250,7 @@ namespace cage
 		CAGE_FORCE_INLINE constexpr Mat3() noexcept {}
 		CAGE_FORCE_INLINE explicit constexpr Mat3(Real a, Real b, Real c, Real d, Real e, Real f, Real g, Real h, Real i) noexcept : data{ a, b, c, d, e, f, g, h, i } {}
 		explicit Mat3(const Vec3 &forward, const Vec3 &up, bool keepUp = false);
-		explicit Mat3(const Quat &other) noexcept;
+		CAGE_FORCE_INLINE explicit Mat3(const Quat &other) noexcept;
 		explicit constexpr Mat3(const Mat4 &other) noexcept;
 
 		bool operator == (const Mat3 &) const noexcept = default;
@@ -263,7 +271,7 @@ namespace cage
 		CAGE_FORCE_INLINE explicit constexpr Mat4(Real a, Real b, Real c, Real d, Real e, Real f, Real g, Real h, Real i, Real j, Real k, Real l, Real m, Real n, Real o, Real p) noexcept : data{ a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p } {}
 		CAGE_FORCE_INLINE explicit constexpr Mat4(const Mat3 &other) noexcept : data{ other[0], other[1], other[2], 0, other[3], other[4], other[5], 0, other[6], other[7], other[8], 0, 0, 0, 0, 1 } {}
 		CAGE_FORCE_INLINE explicit constexpr Mat4(const Vec3 &position) noexcept : data{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, position[0], position[1], position[2], 1 } {}
-		explicit Mat4(const Vec3 &position, const Quat &orientation, const Vec3 &scale = Vec3(1)) noexcept;
+		CAGE_FORCE_INLINE explicit Mat4(const Vec3 &position, const Quat &orientation, const Vec3 &scale = Vec3(1)) noexcept;
 		CAGE_FORCE_INLINE explicit Mat4(const Quat &orientation) noexcept : Mat4(Mat3(orientation)) {}
 		explicit Mat4(const Transform &other) noexcept;
 
@@ -368,21 +376,22 @@ namespace cage
 	CAGE_CORE_API Mat3 operator OPERATOR (const Mat3 &l, const Mat3 &r) noexcept; \
 	CAGE_FORCE_INLINE constexpr Mat3 operator OPERATOR (const Mat3 &l, const Real &r) noexcept { Mat3 res; for (uint32 i = 0; i < 9; i++) res[i] = l[i] OPERATOR r; return res; } \
 	CAGE_FORCE_INLINE constexpr Mat3 operator OPERATOR (const Real &l, const Mat3 &r) noexcept { Mat3 res; for (uint32 i = 0; i < 9; i++) res[i] = l OPERATOR r[i]; return res; } \
-	CAGE_CORE_API Mat4 operator OPERATOR (const Mat4 &l, const Mat4 &r) noexcept; \
 	CAGE_FORCE_INLINE constexpr Mat4 operator OPERATOR (const Mat4 &l, const Real &r) noexcept { Mat4 res; for (uint32 i = 0; i < 16; i++) res[i] = l[i] OPERATOR r; return res; } \
 	CAGE_FORCE_INLINE constexpr Mat4 operator OPERATOR (const Real &l, const Mat4 &r) noexcept { Mat4 res; for (uint32 i = 0; i < 16; i++) res[i] = l OPERATOR r[i]; return res; }
 	GCHL_GENERATE(+);
 	GCHL_GENERATE(*);
 #undef GCHL_GENERATE
-	CAGE_CORE_API Vec3 operator * (const Transform &l, const Vec3 &r) noexcept;
-	CAGE_CORE_API Vec3 operator * (const Vec3 &l, const Transform &r) noexcept;
-	CAGE_CORE_API Vec3 operator * (const Vec3 &l, const Quat &r) noexcept;
-	CAGE_CORE_API Vec3 operator * (const Quat &l, const Vec3 &r) noexcept;
-	CAGE_CORE_API Vec3 operator * (const Vec3 &l, const Mat3 &r) noexcept;
-	CAGE_CORE_API Vec3 operator * (const Mat3 &l, const Vec3 &r) noexcept;
-	CAGE_CORE_API Vec4 operator * (const Vec4 &l, const Mat4 &r) noexcept;
-	CAGE_CORE_API Vec4 operator * (const Mat4 &l, const Vec4 &r) noexcept;
-	CAGE_CORE_API Transform operator * (const Transform &l, const Transform &r) noexcept;
+	CAGE_FORCE_INLINE Mat4 operator + (const Mat4 &l, const Mat4 &r) noexcept;
+	CAGE_FORCE_INLINE Mat4 operator * (const Mat4 &l, const Mat4 &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Transform &l, const Vec3 &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Vec3 &l, const Transform &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Vec3 &l, const Quat &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Quat &l, const Vec3 &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Vec3 &l, const Mat3 &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Mat3 &l, const Vec3 &r) noexcept;
+	CAGE_FORCE_INLINE Vec4 operator * (const Vec4 &l, const Mat4 &r) noexcept;
+	CAGE_FORCE_INLINE Vec4 operator * (const Mat4 &l, const Vec4 &r) noexcept;
+	CAGE_FORCE_INLINE constexpr Transform operator * (const Transform &l, const Transform &r) noexcept;
 	CAGE_CORE_API Transform operator * (const Transform &l, const Quat &r) noexcept;
 	CAGE_CORE_API Transform operator * (const Quat &l, const Transform &r) noexcept;
 	CAGE_CORE_API Transform operator * (const Transform &l, const Real &r) noexcept;
@@ -539,7 +548,6 @@ namespace cage
 	CAGE_CORE_API Mat3 transpose(const Mat3 &x) noexcept;
 	CAGE_CORE_API Mat3 normalize(const Mat3 &x);
 	CAGE_CORE_API Real determinant(const Mat3 &x);
-	CAGE_CORE_API Mat4 inverse(const Mat4 &x);
 	CAGE_CORE_API Mat4 transpose(const Mat4 &x) noexcept;
 	CAGE_CORE_API Mat4 normalize(const Mat4 &x);
 	CAGE_CORE_API Real determinant(const Mat4 &x);
@@ -683,6 +691,228 @@ namespace cage
 	CAGE_CORE_API Quat randomDirectionQuat();
 	CAGE_CORE_API Vec4i randomRange4i(sint32 a, sint32 b);
 
+	namespace privat
+	{
+		// column-major 4x4 matrix times consecutive 4-component vectors, res may be the same as v but must not overlap m
+		CAGE_FORCE_INLINE void mat4MulColumns(const float *m, const float *v, float *res, uint32 columns) noexcept
+		{
+#if defined(CAGE_SIMD_SSE)
+			const __m128 c0 = _mm_loadu_ps(m + 0);
+			const __m128 c1 = _mm_loadu_ps(m + 4);
+			const __m128 c2 = _mm_loadu_ps(m + 8);
+			const __m128 c3 = _mm_loadu_ps(m + 12);
+			for (uint32 i = 0; i < columns; i++)
+			{
+				const float *b = v + i * 4;
+				__m128 a = _mm_mul_ps(c0, _mm_set1_ps(b[0]));
+				a = _mm_add_ps(a, _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+				a = _mm_add_ps(a, _mm_mul_ps(c2, _mm_set1_ps(b[2])));
+				a = _mm_add_ps(a, _mm_mul_ps(c3, _mm_set1_ps(b[3])));
+				_mm_storeu_ps(res + i * 4, a);
+			}
+#elif defined(CAGE_SIMD_NEON)
+			const float32x4_t c0 = vld1q_f32(m + 0);
+			const float32x4_t c1 = vld1q_f32(m + 4);
+			const float32x4_t c2 = vld1q_f32(m + 8);
+			const float32x4_t c3 = vld1q_f32(m + 12);
+			for (uint32 i = 0; i < columns; i++)
+			{
+				const float *b = v + i * 4;
+				float32x4_t a = vmulq_n_f32(c0, b[0]);
+				a = vaddq_f32(a, vmulq_n_f32(c1, b[1]));
+				a = vaddq_f32(a, vmulq_n_f32(c2, b[2]));
+				a = vaddq_f32(a, vmulq_n_f32(c3, b[3]));
+				vst1q_f32(res + i * 4, a);
+			}
+#else
+			for (uint32 i = 0; i < columns; i++)
+			{
+				const float b[4] = { v[i * 4 + 0], v[i * 4 + 1], v[i * 4 + 2], v[i * 4 + 3] };
+				for (uint32 j = 0; j < 4; j++)
+					res[i * 4 + j] = m[j] * b[0] + m[4 + j] * b[1] + m[8 + j] * b[2] + m[12 + j] * b[3];
+			}
+#endif
+		}
+
+		// column-major 4x4 matrix inverse, computed from cross products of the columns (Lengyel), res must not overlap m
+		CAGE_FORCE_INLINE void mat4Inverse(const float *m, float *res) noexcept
+		{
+#if defined(CAGE_SIMD_SSE)
+			const auto &cross = [](__m128 a, __m128 b) -> __m128 {
+				const __m128 a1 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+				const __m128 b1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+				const __m128 a2 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+				const __m128 b2 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+				return _mm_sub_ps(_mm_mul_ps(a1, b2), _mm_mul_ps(a2, b1));
+			};
+			const auto &dot = [](__m128 a, __m128 b) -> float {
+				alignas(16) float f[4];
+				_mm_store_ps(f, _mm_mul_ps(a, b));
+				return f[0] + f[1] + f[2];
+			};
+			const __m128 a = _mm_loadu_ps(m + 0);
+			const __m128 b = _mm_loadu_ps(m + 4);
+			const __m128 c = _mm_loadu_ps(m + 8);
+			const __m128 d = _mm_loadu_ps(m + 12);
+			const __m128 x = _mm_set1_ps(m[3]);
+			const __m128 y = _mm_set1_ps(m[7]);
+			const __m128 z = _mm_set1_ps(m[11]);
+			const __m128 w = _mm_set1_ps(m[15]);
+			__m128 s = cross(a, b);
+			__m128 t = cross(c, d);
+			__m128 u = _mm_sub_ps(_mm_mul_ps(a, y), _mm_mul_ps(b, x));
+			__m128 v = _mm_sub_ps(_mm_mul_ps(c, w), _mm_mul_ps(d, z));
+			const __m128 invDet = _mm_set1_ps(1.0f / (dot(s, v) + dot(t, u)));
+			s = _mm_mul_ps(s, invDet);
+			t = _mm_mul_ps(t, invDet);
+			u = _mm_mul_ps(u, invDet);
+			v = _mm_mul_ps(v, invDet);
+			alignas(16) float r[4][4];
+			_mm_store_ps(r[0], _mm_add_ps(cross(b, v), _mm_mul_ps(t, y)));
+			_mm_store_ps(r[1], _mm_sub_ps(cross(v, a), _mm_mul_ps(t, x)));
+			_mm_store_ps(r[2], _mm_add_ps(cross(d, u), _mm_mul_ps(s, w)));
+			_mm_store_ps(r[3], _mm_sub_ps(cross(u, c), _mm_mul_ps(s, z)));
+			r[0][3] = -dot(b, t);
+			r[1][3] = dot(a, t);
+			r[2][3] = -dot(d, s);
+			r[3][3] = dot(c, s);
+			for (uint32 i = 0; i < 4; i++)
+				for (uint32 j = 0; j < 4; j++)
+					res[j * 4 + i] = r[i][j];
+#else
+			const Vec3 a = Vec3(m[0], m[1], m[2]);
+			const Vec3 b = Vec3(m[4], m[5], m[6]);
+			const Vec3 c = Vec3(m[8], m[9], m[10]);
+			const Vec3 d = Vec3(m[12], m[13], m[14]);
+			const Real x = m[3], y = m[7], z = m[11], w = m[15];
+			Vec3 s = cross(a, b);
+			Vec3 t = cross(c, d);
+			Vec3 u = a * y - b * x;
+			Vec3 v = c * w - d * z;
+			const Real invDet = 1 / (dot(s, v) + dot(t, u));
+			s *= invDet;
+			t *= invDet;
+			u *= invDet;
+			v *= invDet;
+			const Vec3 r[4] = { cross(b, v) + t * y, cross(v, a) - t * x, cross(d, u) + s * w, cross(u, c) - s * z };
+			for (uint32 i = 0; i < 4; i++)
+				for (uint32 j = 0; j < 3; j++)
+					res[j * 4 + i] = r[i][j].value;
+			res[12] = -dot(b, t).value;
+			res[13] = dot(a, t).value;
+			res[14] = -dot(d, s).value;
+			res[15] = dot(c, s).value;
+#endif
+		}
+	}
+
+	static_assert(sizeof(Vec4) == 4 * sizeof(float));
+	static_assert(sizeof(Mat4) == 16 * sizeof(float));
+
+	CAGE_FORCE_INLINE Mat4 operator * (const Mat4 &l, const Mat4 &r) noexcept
+	{
+		Mat4 res;
+		privat::mat4MulColumns(&l.data[0].value, &r.data[0].value, &res.data[0].value, 4);
+		return res;
+	}
+
+	CAGE_FORCE_INLINE Vec4 operator * (const Mat4 &l, const Vec4 &r) noexcept
+	{
+		Vec4 res;
+		privat::mat4MulColumns(&l.data[0].value, &r.data[0].value, &res.data[0].value, 1);
+		return res;
+	}
+
+	CAGE_FORCE_INLINE Mat4 inverse(const Mat4 &x) noexcept
+	{
+		Mat4 res;
+		privat::mat4Inverse(&x.data[0].value, &res.data[0].value);
+		return res;
+	}
+
+	CAGE_FORCE_INLINE Vec4 operator * (const Vec4 &l, const Mat4 &r) noexcept
+	{
+		return Vec4(dot(l, Vec4(r[0], r[1], r[2], r[3])), dot(l, Vec4(r[4], r[5], r[6], r[7])), dot(l, Vec4(r[8], r[9], r[10], r[11])), dot(l, Vec4(r[12], r[13], r[14], r[15])));
+	}
+
+	CAGE_FORCE_INLINE Mat4 operator + (const Mat4 &l, const Mat4 &r) noexcept
+	{
+		Mat4 res;
+		for (uint32 i = 0; i < 16; i++)
+			res[i] = l[i] + r[i];
+		return res;
+	}
+
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Mat3 &l, const Vec3 &r) noexcept
+	{
+		return Vec3(l[0] * r[0] + l[3] * r[1] + l[6] * r[2], l[1] * r[0] + l[4] * r[1] + l[7] * r[2], l[2] * r[0] + l[5] * r[1] + l[8] * r[2]);
+	}
+
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Vec3 &l, const Mat3 &r) noexcept
+	{
+		return Vec3(dot(l, Vec3(r[0], r[1], r[2])), dot(l, Vec3(r[3], r[4], r[5])), dot(l, Vec3(r[6], r[7], r[8])));
+	}
+
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Quat &l, const Vec3 &r) noexcept
+	{
+		const Vec3 u = Vec3(l[0], l[1], l[2]);
+		const Vec3 t = cross(u, r) * 2;
+		return r + t * l[3] + cross(u, t);
+	}
+
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Vec3 &l, const Quat &r) noexcept { return r * l; }
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Transform &l, const Vec3 &r) noexcept { return (l.orientation * r) * l.scale + l.position; }
+	CAGE_FORCE_INLINE constexpr Vec3 operator * (const Vec3 &l, const Transform &r) noexcept { return r * l; }
+
+	CAGE_FORCE_INLINE constexpr Transform operator * (const Transform &l, const Transform &r) noexcept
+	{
+		Transform res;
+		res.orientation = l.orientation * r.orientation;
+		res.scale = l.scale * r.scale;
+		res.position = l.position + (r.position * l.orientation) * l.scale;
+		return res;
+	}
+
+	CAGE_FORCE_INLINE Mat3::Mat3(const Quat &other) noexcept
+	{
+		const Real x2 = other[0] * other[0];
+		const Real y2 = other[1] * other[1];
+		const Real z2 = other[2] * other[2];
+		const Real xy = other[0] * other[1];
+		const Real xz = other[0] * other[2];
+		const Real yz = other[1] * other[2];
+		const Real wx = other[3] * other[0];
+		const Real wy = other[3] * other[1];
+		const Real wz = other[3] * other[2];
+		data[0] = 1 - 2 * (y2 + z2);
+		data[1] = 2 * (xy + wz);
+		data[2] = 2 * (xz - wy);
+		data[3] = 2 * (xy - wz);
+		data[4] = 1 - 2 * (x2 + z2);
+		data[5] = 2 * (yz + wx);
+		data[6] = 2 * (xz + wy);
+		data[7] = 2 * (yz - wx);
+		data[8] = 1 - 2 * (x2 + y2);
+	}
+
+	CAGE_FORCE_INLINE Mat4::Mat4(const Vec3 &p, const Quat &q, const Vec3 &s) noexcept
+	{
+		// this = T * R * S
+		const Mat3 r(q);
+		data[0] = r[0] * s[0]; data[1] = r[1] * s[0]; data[2] = r[2] * s[0]; data[3] = 0;
+		data[4] = r[3] * s[1]; data[5] = r[4] * s[1]; data[6] = r[5] * s[1]; data[7] = 0;
+		data[8] = r[6] * s[2]; data[9] = r[7] * s[2]; data[10] = r[8] * s[2]; data[11] = 0;
+		data[12] = p[0]; data[13] = p[1]; data[14] = p[2]; data[15] = 1;
+	}
+
+	// batch operations over arrays, the output may alias the input
+	CAGE_CORE_API void transformPoints(const Mat4 &m, PointerRange<const Vec3> in, PointerRange<Vec3> out); // w = 1, no perspective division
+	CAGE_CORE_API void transformPoints(const Transform &t, PointerRange<const Vec3> in, PointerRange<Vec3> out);
+	CAGE_CORE_API void transformVectors(const Mat4 &m, PointerRange<const Vec4> in, PointerRange<Vec4> out);
+	CAGE_CORE_API void multiplyMatrices(const Mat4 &l, PointerRange<const Mat4> r, PointerRange<Mat4> out); // out[i] = l * r[i]
+	CAGE_CORE_API void multiplyMatrices(PointerRange<const Mat4> l, PointerRange<const Mat4> r, PointerRange<Mat4> out); // out[i] = l[i] * r[i]
+	CAGE_CORE_API void transformsToMatrices(PointerRange<const Transform> in, PointerRange<Mat4> out);
+
 	CAGE_FORCE_INLINE constexpr uint32 hash(uint32 key) noexcept
 	{ // integer finalizer hash function
 		key ^= key >> 16;
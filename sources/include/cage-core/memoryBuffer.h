@@ -58,6 +58,8 @@ namespace cage
 		operator Holder<PointerRange<char>>() &&;
 
 	private:
+		friend struct Serializer; // grows the size inline within the capacity
+
 		char *data_ = nullptr;
 		uintPtr size_ = 0;
 		uintPtr capacity_ = 0;
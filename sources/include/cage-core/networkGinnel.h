@@ -61,9 +61,12 @@ namespace cage
 		sint64 capacity() const;
 	};
 
+	class GinnelSimulator;
+
 	// non-zero timeout will block the caller for up to the specified time to ensure that the connection is established and throw an exception otherwise
 	// zero timeout will return immediately and the connection will be established progressively as you use it
-	CAGE_CORE_API Holder<GinnelConnection> newGinnelConnection(const String &address, uint16 port, uint64 timeout);
+	// when simulator is given, the connection is made within the simulator instead of the operating system network (the address is ignored)
+	CAGE_CORE_API Holder<GinnelConnection> newGinnelConnection(const String &address, uint16 port, uint64 timeout, GinnelSimulator *simulator = nullptr);
 
 	class CAGE_CORE_API GinnelServer : private Immovable
 	{
@@ -72,7 +75,45 @@ namespace cage
 		Holder<GinnelConnection> accept(); // non-blocking
 	};
 
-	CAGE_CORE_API Holder<GinnelServer> newGinnelServer(uint16 port); // non-blocking
+	CAGE_CORE_API Holder<GinnelServer> newGinnelServer(uint16 port, GinnelSimulator *simulator = nullptr); // non-blocking
+
+	// in-process network for testing and tuning ginnel without the operating system network stack
+	// all impairments are driven by seeded random generator, and are reproducible for the same sequence of operations
+	// with manual time, the whole simulation is deterministic (when used from single thread)
+	// the cage/ginnel/simulatedPacketLoss configuration does not apply to connections in the simulator, use packetLoss instead
+
+	struct CAGE_CORE_API GinnelSimulatorCreateConfig
+	{
+		uint64 seed = 0;
+		uint64 latency = 0; // one-way delay, in microseconds
+		uint64 jitter = 0; // additional uniformly random one-way delay, in microseconds
+		uint64 bandwidth = 0; // bytes per second in each direction of each connection, zero for unlimited
+		uint64 queueDuration = 100000; // packets exceeding the bandwidth are queued for up to this duration and dropped afterwards, in microseconds
+		float packetLoss = 0; // probability that a packet is dropped
+		float duplication = 0; // probability that a packet is delivered twice
+		float reordering = 0; // probability that a packet is held back (by up to twice the latency, at least 1 ms) and delivered after packets sent later
+		bool manualTime = false; // simulated time advances with calls to advance only; otherwise it follows the application time
+	};
+
+	struct CAGE_CORE_API GinnelSimulatorStatistics
+	{
+		uint64 bytesSent = 0, bytesDelivered = 0;
+		uint64 packetsSent = 0, packetsDelivered = 0;
+		uint64 packetsLost = 0; // dropped by the simulated packet loss or sent to nonexistent endpoint
+		uint64 packetsOverflow = 0; // dropped due to the bandwidth limit
+		uint64 packetsDuplicated = 0;
+		uint64 packetsReordered = 0;
+	};
+
+	class CAGE_CORE_API GinnelSimulator : private Immovable
+	{
+	public:
+		uint64 time() const; // current simulated time, in microseconds
+		void advance(uint64 duration); // requires manual time
+		GinnelSimulatorStatistics statistics() const;
+	};
+
+	CAGE_CORE_API Holder<GinnelSimulator> newGinnelSimulator(const GinnelSimulatorCreateConfig &config);
 }
 
 #endif // guard_networkGinnel_h_yxdrz748wq
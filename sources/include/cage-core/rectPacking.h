@@ -32,6 +32,36 @@ namespace cage
 	};
 
 	CAGE_CORE_API Holder<RectPacking> newRectPacking();
+
+	struct CAGE_CORE_API DynamicRectPackingCreateConfig
+	{
+		uint32 width = 0;
+		uint32 height = 0;
+		uint32 margin = 0;
+	};
+
+	// incremental packing for atlases that change at runtime
+	// uses guillotine splitting of free space, freed rectangles are merged with their neighbors
+	class CAGE_CORE_API DynamicRectPacking : private Immovable
+	{
+	public:
+		bool insert(PackingRect &rect); // fills in the position, returns false if there is not enough space
+		void remove(uint32 id);
+		bool has(uint32 id) const;
+		PackingRect get(uint32 id) const;
+		void clear();
+
+		// repacks all rectangles from scratch to reduce fragmentation
+		// returns false and leaves the packing unchanged if the rectangles would not fit
+		// on success, moved receives the rectangles that have moved, with their new positions (it may be empty)
+		bool defragment(Holder<PointerRange<PackingRect>> &moved);
+
+		uint32 count() const;
+		uint32 freeRectsCount() const; // fragmentation of the free space
+		Real occupancy() const; // used area, including margins, relative to the whole area
+	};
+
+	CAGE_CORE_API Holder<DynamicRectPacking> newDynamicRectPacking(const DynamicRectPackingCreateConfig &config);
 }
 
 #endif // guard_rectPacking_h_CBAB7F4B_90B1_4151_968F_9C5336718D0D
@@ -23,6 +23,9 @@ namespace cage
 		ScheduleTypeEnum type = ScheduleTypeEnum::Once;
 		sint32 priority = 0; // higher priority is run earlier or more often
 		uint32 maxSteadyPeriods = 3; // when the schedule is not managing by this many runs, reset its timer (valid for steady periodic schedules only)
+		uint64 deadline = 0; // maximum acceptable delay before the action starts; among schedules with same priority, earlier deadline is run first; 0 = no deadline
+		uint64 budget = 0; // maximum acceptable duration of the action; 0 = no budget
+		bool independent = false; // the action may run on the tasks executor, concurrently with other schedules (valid in threaded scheduler only); such action may only call trigger on schedules and stop on the scheduler
 	};
 
 	struct ScheduleStatistics : private Immovable
@@ -35,8 +38,10 @@ namespace cage
 		uint64 maxDelay = 0;
 		uint64 maxDuration = 0;
 		uint32 runs = 0;
+		uint32 deadlineMisses = 0;
+		uint32 budgetOverruns = 0;
 
-		void add(uint64 delay, uint64 duration);
+		void add(uint64 delay, uint64 duration, uint64 deadline = 0, uint64 budget = 0);
 	};
 
 	class CAGE_CORE_API Schedule : private Immovable
@@ -45,12 +50,12 @@ namespace cage
 		void trigger(); // valid for external schedule only; can be called from any thread (but beware of deallocation)
 		void run(); // call the action
 
-		void detach(); // removes the schedule from the scheduler
+		void detach(); // removes the schedule from the scheduler; must be called from the thread running the scheduler (if it is running)
 
 		void period(uint64 p); // valid for periodic schedules only
 		uint64 period() const;
 
-		void priority(sint32 p); // set current priority
+		void priority(sint32 p); // set current priority; must be called from the thread running the scheduler (if it is running)
 		sint32 priority() const;
 
 		uint64 time() const;
@@ -62,6 +67,7 @@ namespace cage
 	struct CAGE_CORE_API SchedulerCreateConfig
 	{
 		uint64 maxSleepDuration = 1000000;
+		bool threaded = false; // dispatch independent schedules onto the tasks executor; the lockstep mode runs all schedules in the calling thread
 	};
 
 	class CAGE_CORE_API Scheduler : private Immovable
@@ -70,7 +76,7 @@ namespace cage
 		void run();
 		void stop(); // can be called from any thread
 
-		Holder<Schedule> newSchedule(const ScheduleCreateConfig &config);
+		Holder<Schedule> newSchedule(const ScheduleCreateConfig &config); // must be called from the thread running the scheduler (if it is running)
 		void clear(); // removes all schedules from the scheduler
 
 		void lockstep(bool enable);
@@ -1,31 +1,51 @@
 #ifndef guard_serialization_h_edsg45df4h654fdr56h4gfd564h
 #define guard_serialization_h_edsg45df4h654fdr56h4gfd564h
 
-#include "core.h"
+#include "memoryBuffer.h"
 
 namespace cage
 {
-	struct MemoryBuffer;
-
 	struct CAGE_CORE_API Serializer : private Noncopyable
 	{
 		explicit Serializer(PointerRange<char> buffer);
 		explicit Serializer(MemoryBuffer &buffer, uintPtr size = m);
 		
 		uintPtr available() const; // number of bytes still available in the buffer (valid only if the maximum size was given in the constructor)
-		void write(PointerRange<const char> buffer);
-		PointerRange<char> write(uintPtr size); // use with care!
+		CAGE_FORCE_INLINE void write(PointerRange<const char> buffer)
+		{
+			auto dst = advance(buffer.size());
+			detail::memcpy(dst.data(), buffer.data(), buffer.size());
+		}
+		CAGE_FORCE_INLINE PointerRange<char> write(uintPtr size) { return advance(size); } // use with care!
 		void writeLine(const String &line);
+		void writeVarint(uint64 value); // 7 bits per byte, small values take fewer bytes
+		void writeZigzag(sint64 value); // varint of zigzag-encoded value, small magnitudes take fewer bytes
 		Serializer reserve(uintPtr s);
 
 	private:
 		explicit Serializer(MemoryBuffer *buffer, char *data, uintPtr offset, uintPtr size);
-		PointerRange<char> advance(uintPtr s); // future writes may cause the MemoryBuffer to reallocate invalidating the PointerRange
+
+		// bumps inline while the write fits into the cached allocation, growing the MemoryBuffer goes out-of-line
+		CAGE_FORCE_INLINE PointerRange<char> advance(uintPtr s) // future writes may cause the MemoryBuffer to reallocate invalidating the PointerRange
+		{
+			if (s <= capacity - offset && (!buffer || buffer->data_ == data)) // the buffer may have been reallocated by another serializer
+			{
+				char *dst = data + offset;
+				offset += s;
+				if (buffer && buffer->size_ < offset)
+					buffer->size_ = offset;
+				return { dst, dst + s };
+			}
+			return advanceSlow(s);
+		}
+
+		PointerRange<char> advanceSlow(uintPtr s);
 
 		MemoryBuffer *buffer = nullptr;
 		char *data = nullptr;
 		uintPtr offset = 0; // current position in the buffer
 		uintPtr size = 0; // max size of the buffer
+		uintPtr capacity = 0; // writable without reallocation, never more than size
 	};
 
 	struct CAGE_CORE_API Deserializer : private Noncopyable
@@ -33,21 +53,78 @@ namespace cage
 		explicit Deserializer(PointerRange<const char> buffer);
 
 		uintPtr available() const; // number of bytes still available in the buffer
-		void read(PointerRange<char> buffer);
-		PointerRange<const char> read(uintPtr size);
+		CAGE_FORCE_INLINE void read(PointerRange<char> buffer)
+		{
+			auto src = advance(buffer.size());
+			detail::memcpy(buffer.data(), src.data(), buffer.size());
+		}
+		CAGE_FORCE_INLINE PointerRange<const char> read(uintPtr size) { return advance(size); }
 		bool readLine(PointerRange<const char> &line);
 		bool readLine(String &line);
+		uint64 readVarint();
+		sint64 readZigzag();
 		Deserializer subview(uintPtr s);
 		Deserializer copy() const;
 
 	private:
 		explicit Deserializer(const char *data, uintPtr offset, uintPtr size);
 
+		CAGE_FORCE_INLINE PointerRange<const char> advance(uintPtr s)
+		{
+			if (s > size - offset)
+				outOfSpace();
+			const char *src = data + offset;
+			offset += s;
+			return { src, src + s };
+		}
+
+		[[noreturn]] static void outOfSpace();
+
 		const char *data = nullptr;
 		uintPtr offset = 0; // current position in the buffer
 		uintPtr size = 0; // max size of the buffer
 	};
 
+	// writes individual bits, starting with the least significant bits, into whole bytes of the serializer
+	// call flush after the last write, the last byte is padded with zeros
+	struct CAGE_CORE_API BitSerializer : private Immovable
+	{
+		explicit BitSerializer(Serializer &ser);
+		~BitSerializer();
+
+		void write(uint64 value, uint32 bits);
+		void write(bool value);
+		void writeQuantized(Real value, Real min, Real max, uint32 bits); // value is clamped to the range
+		void writeNormalized(Vec3 value, uint32 bits); // unit vector, octahedral mapping, two components with the bits each
+		void writeNormalized(Quat value, uint32 bits); // unit quaternion, smallest three components with the bits each, plus 2 bits
+		void flush();
+
+	private:
+		Serializer *ser = nullptr;
+		uint64 accum = 0;
+		uint32 count = 0;
+	};
+
+	struct CAGE_CORE_API BitDeserializer : private Immovable
+	{
+		explicit BitDeserializer(Deserializer &des);
+
+		uint64 read(uint32 bits);
+		bool readBool();
+		Real readQuantized(Real min, Real max, uint32 bits);
+		Vec3 readNormalizedVec3(uint32 bits);
+		Quat readNormalizedQuat(uint32 bits);
+
+	private:
+		Deserializer *des = nullptr;
+		uint64 accum = 0;
+		uint32 count = 0;
+	};
+
+	// maps the value from the range onto integers 0 .. 2^bits-1 (inclusive)
+	CAGE_CORE_API uint32 quantize(Real value, Real min, Real max, uint32 bits);
+	CAGE_CORE_API Real dequantize(uint32 value, Real min, Real max, uint32 bits);
+
 	// helpers
 
 	// reinterpret types of range of elements
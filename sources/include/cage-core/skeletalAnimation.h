@@ -1,12 +1,20 @@
 #ifndef guard_skeletalAnimation_h_dhg4g56efd4km1n56dstfr
 #define guard_skeletalAnimation_h_dhg4g56efd4km1n56dstfr
 
-#include "core.h"
+#include "math.h"
 
 namespace cage
 {
 	class Mesh;
 
+	struct CAGE_CORE_API SkeletalAnimationCompressionConfig
+	{
+		// maximum deviations introduced by removing keyframes
+		Real positionTolerance = 1e-4;
+		Rads rotationTolerance = Degs(0.05);
+		Real scaleTolerance = 1e-4;
+	};
+
 	class CAGE_CORE_API SkeletalAnimation : private Immovable
 	{
 	public:
@@ -29,6 +37,11 @@ namespace cage
 
 		void skeletonName(uint32 name);
 		uint32 skeletonName() const;
+
+		// removes keyframes reproducible by interpolation and quantizes the remaining ones to 16 bits
+		// the compressed clip is evaluated directly (no decompression on load) and is preserved by export/import
+		void compress(const SkeletalAnimationCompressionConfig &config = {});
+		bool compressed() const;
 	};
 
 	CAGE_CORE_API Holder<SkeletalAnimation> newSkeletalAnimation();
@@ -61,8 +74,34 @@ namespace cage
 	CAGE_CORE_API AssetScheme genAssetSchemeSkeletonRig();
 	constexpr uint32 AssetSchemeIndexSkeletonRig = 5;
 
-	CAGE_CORE_API void animateSkin(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output); // provides transformation matrices for skinning meshes
-	CAGE_CORE_API void animateSkeleton(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output); // provides transformation matrices for individual bones for debug visualization
+	// remembers keyframes found by previous evaluation of one animated instance
+	// subsequent evaluations with nearby coefficients continue from there instead of searching all channels again
+	// use one cursor per instance; it is not thread safe
+	class CAGE_CORE_API SkeletalAnimationCursor : private Immovable
+	{
+	public:
+		void reset();
+	};
+
+	CAGE_CORE_API Holder<SkeletalAnimationCursor> newSkeletalAnimationCursor();
+
+	CAGE_CORE_API void animateSkin(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output, SkeletalAnimationCursor *cursor = nullptr); // provides transformation matrices for skinning meshes
+	CAGE_CORE_API void animateSkin(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat3x4> output, SkeletalAnimationCursor *cursor = nullptr); // same as above, avoids conversions when the output is uploaded to gpu
+	CAGE_CORE_API void animateSkeleton(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output, SkeletalAnimationCursor *cursor = nullptr); // provides transformation matrices for individual bones for debug visualization
+
+	struct CAGE_CORE_API SkeletalAnimationLayer
+	{
+		const SkeletalAnimation *animation = nullptr;
+		SkeletalAnimationCursor *cursor = nullptr; // optional
+		Real coefficient = 0;
+		Real weight = 1;
+		bool additive = false; // false -> regular layers are averaged by their weights; true -> applied (scaled by weight) on top of the averaged pose
+	};
+
+	// evaluates all layers in a single pass over the skeleton
+	CAGE_CORE_API void animateSkin(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat4> output);
+	CAGE_CORE_API void animateSkin(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat3x4> output);
+	CAGE_CORE_API void animateSkeleton(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat4> output);
 	CAGE_CORE_API void animateMesh(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, Mesh *mesh);
 
 	namespace detail
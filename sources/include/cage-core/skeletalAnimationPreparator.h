@@ -17,8 +17,10 @@ namespace cage
 	class CAGE_CORE_API SkeletalAnimationPreparatorCollection : private Immovable
 	{
 	public:
+		// the object identifies the animated instance across frames, and keys its SkeletalAnimationCursor
 		Holder<SkeletalAnimationPreparatorInstance> create(void *object, Holder<SkeletalAnimation> animation, Real coefficient); // thread safe
-		void clear();
+		void clear(); // call once per frame; keeps cursors of objects used recently
+		uint32 cursorsCount() const;
 	};
 
 	CAGE_CORE_API Holder<SkeletalAnimationPreparatorCollection> newSkeletalAnimationPreparatorCollection(AssetManager *assets, bool animateSkeletonsInsteadOfSkins = false);
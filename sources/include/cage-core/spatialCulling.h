@@ -0,0 +1,38 @@
+#ifndef guard_spatialCulling_h_w3j8d5n1ko6e
+#define guard_spatialCulling_h_w3j8d5n1ko6e
+
+#include "geometry.h"
+
+namespace cage
+{
+	// maintains world-space bounding boxes of many (mostly static) items and finds those intersecting a frustum
+	// settled items are stored in a spatial structure, recently changed items are tested individually
+	// the spatial structure is rebuilt only once enough items have changed
+
+	class CAGE_CORE_API SpatialCulling : private Immovable
+	{
+	public:
+		void update(uint32 name, const Aabb &box); // cheap when the box has not changed
+		void remove(uint32 name);
+		void clear();
+
+		// call after updates and before culling
+		void commit();
+
+		// names of all items whose boxes intersect the frustum, in unspecified order
+		// culling from multiple threads is allowed, but not concurrently with updates or commit
+		Holder<PointerRange<uint32>> cull(const Frustum &frustum) const;
+
+		uint32 count() const; // total number of items
+		uint32 dynamicCount() const; // number of items tested individually
+	};
+
+	struct CAGE_CORE_API SpatialCullingCreateConfig
+	{
+		uint32 settleCommits = 30; // number of commits without change after which the item is considered static
+	};
+
+	CAGE_CORE_API Holder<SpatialCulling> newSpatialCulling(const SpatialCullingCreateConfig &config);
+}
+
+#endif // guard_spatialCulling_h_w3j8d5n1ko6e
@@ -1,7 +1,8 @@
 #ifndef guard_stdHash_ik4j1hb8vsaerg
 #define guard_stdHash_ik4j1hb8vsaerg
 
-#include "hashBuffer.h"
+#include "hashes.h"
+#include "heapString.h"
 
 #include <functional> // std::hash
 
@@ -21,7 +22,25 @@ namespace std
 	{
 		std::size_t operator() (const cage::detail::StringBase<N> &s) const noexcept
 		{
-			return cage::hashBuffer(s);
+			return cage::hash64(s);
+		}
+	};
+
+	template<>
+	struct hash<cage::StringView>
+	{
+		std::size_t operator() (const cage::StringView &s) const noexcept
+		{
+			return cage::hash64(s);
+		}
+	};
+
+	template<>
+	struct hash<cage::HeapString>
+	{
+		std::size_t operator() (const cage::HeapString &s) const noexcept
+		{
+			return cage::hash64(s);
 		}
 	};
 
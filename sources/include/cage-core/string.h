@@ -226,10 +226,13 @@ namespace cage
 
 	namespace detail
 	{
+		// the comparators take views to avoid copying strings of different capacities
 		template<uint32 N>
 		struct StringComparatorFastBase
 		{
-			bool operator () (const StringBase<N> &a, const StringBase<N> &b) const noexcept
+			using is_transparent = void;
+
+			bool operator () (const StringView &a, const StringView &b) const noexcept
 			{
 				if (a.length() == b.length())
 					return detail::memcmp(a.begin(), b.begin(), a.length()) < 0;
@@ -242,7 +245,9 @@ namespace cage
 		template<uint32 N>
 		struct StringComparatorNaturalBase
 		{
-			bool operator () (const StringBase<N> &a, const StringBase<N> &b) const noexcept
+			using is_transparent = void;
+
+			bool operator () (const StringView &a, const StringView &b) const noexcept
 			{
 				return naturalComparison(a, b) < 0;
 			}
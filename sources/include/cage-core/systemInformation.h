@@ -3,6 +3,8 @@
 
 #include "core.h"
 
+#include <vector>
+
 namespace cage
 {
 	CAGE_CORE_API String systemName(); // operating system information
@@ -16,6 +18,54 @@ namespace cage
 	CAGE_CORE_API uint64 memoryCapacity(); // total memory in bytes for use by the operating system
 	CAGE_CORE_API uint64 memoryAvailable(); // estimated unused memory in bytes
 	CAGE_CORE_API uint64 memoryUsed(); // memory used by this process alone
+
+	enum class ProcessorClassEnum : uint8
+	{
+		Performance = 0,
+		Efficiency,
+	};
+
+	struct CAGE_CORE_API ProcessorTopology
+	{
+		uint32 id = 0; // logical processor index as used by the operating system
+		uint32 core = 0; // physical core, shared by smt siblings
+		uint32 smt = 0; // index of this processor among its smt siblings
+		uint32 package = 0; // socket
+		uint32 numaNode = 0;
+		uint32 cacheGroup = 0; // processors sharing the last level cache
+		ProcessorClassEnum processorClass = ProcessorClassEnum::Performance;
+	};
+
+	// cores, packages, numa nodes and cache groups are renumbered to consecutive indices starting at zero
+	struct CAGE_CORE_API ProcessorsTopology
+	{
+		std::vector<ProcessorTopology> processors; // sorted by id
+		uint32 cores = 0;
+		uint32 packages = 0;
+		uint32 numaNodes = 0;
+		uint32 cacheGroups = 0;
+		bool hybrid = false; // has both performance and efficiency processors
+	};
+
+	// detected once, limited to processors available to this process
+	CAGE_CORE_API const ProcessorsTopology &processorsTopology();
+
+	// parses linux sysfs tree found at the root (eg. "/sys")
+	CAGE_CORE_API ProcessorsTopology processorsTopologyFromSysfs(const String &root);
+
+	enum class ThreadAffinityPolicyEnum : uint8
+	{
+		None = 0, // leave the placement to the operating system
+		Spread, // one thread per core, alternating numa nodes and caches, smt siblings are used last
+		Compact, // fill cores of one numa node before continuing with another node, smt siblings are used last in each node
+		Performance, // threads float among performance processors
+		Efficiency, // threads float among efficiency processors
+	};
+
+	CAGE_CORE_API ThreadAffinityPolicyEnum threadAffinityPolicyFromString(const String &name); // none, spread, compact, performance, efficiency
+
+	// returns logical processors for each thread, an empty list means no restriction
+	CAGE_CORE_API std::vector<std::vector<uint32>> threadsAffinityPlan(const ProcessorsTopology &topology, ThreadAffinityPolicyEnum policy, uint32 threadsCount);
 }
 
 #endif // guard_systemInformation_h_dsgdfhtdhsdirgrdht54fd54hj54jz
@@ -8,6 +8,7 @@ namespace cage
 	class RenderQueue;
 	class Model;
 	class ShaderProgram;
+	class AssetManager;
 
 	struct CAGE_ENGINE_API FontFormat
 	{
@@ -17,6 +18,20 @@ namespace cage
 		TextAlignEnum align = TextAlignEnum::Left;
 	};
 
+	struct CAGE_ENGINE_API FontLayout
+	{
+		struct Instance
+		{
+			Vec4 wrld; // position and size of the glyph
+			Vec4 text; // texture coordinates
+		};
+
+		Holder<PointerRange<uint32>> glyphs;
+		Holder<PointerRange<Instance>> instances;
+		FontFormat format;
+		Vec2 size;
+	};
+
 	class CAGE_ENGINE_API Font : private Immovable
 	{
 #ifdef CAGE_DEBUG
@@ -45,11 +60,34 @@ namespace cage
 		Vec2 size(PointerRange<const uint32> glyphs, const FontFormat &format) const;
 		Vec2 size(PointerRange<const uint32> glyphs, const FontFormat &format, const Vec2 &mousePosition, uint32 &cursor) const;
 
+		FontLayout layout(PointerRange<const uint32> glyphs, const FontFormat &format) const; // positions all glyphs, the result can be rendered repeatedly
+
 		void render(RenderQueue *queue, const Holder<Model> &model, const Holder<ShaderProgram> &shader, PointerRange<const uint32> glyphs, const FontFormat &format, uint32 cursor = m) const;
+		void render(RenderQueue *queue, const Holder<Model> &model, const Holder<ShaderProgram> &shader, const FontLayout &layout) const;
 	};
 
 	CAGE_ENGINE_API Holder<Font> newFont();
 
+	// shares transcribed and laid out texts between frames
+	// thread-safe
+	class CAGE_ENGINE_API TextLayoutCache : private Immovable
+	{
+	public:
+		Holder<const FontLayout> get(const Holder<const Font> &font, const String &text, const FontFormat &format);
+		Holder<const FontLayout> get(const Holder<const Font> &font, AssetManager *assets, uint32 assetName, uint32 textName, const String &params, const FontFormat &format); // formats the text same as loadFormattedString
+
+		void nextFrame(); // removes layouts that were not used in several last frames
+		void clear();
+		uint32 count() const;
+	};
+
+	struct CAGE_ENGINE_API TextLayoutCacheCreateConfig
+	{
+		uint32 unusedFramesLimit = 30;
+	};
+
+	CAGE_ENGINE_API Holder<TextLayoutCache> newTextLayoutCache(const TextLayoutCacheCreateConfig &config);
+
 	CAGE_ENGINE_API AssetScheme genAssetSchemeFont(uint32 threadIndex);
 	constexpr uint32 AssetSchemeIndexFont = 14;
 }
@@ -22,9 +22,9 @@ namespace cage
 		void focus(uint32 widget);
 		uint32 focus() const;
 
-		void prepare(); // prepare the gui for handling events
-		Holder<RenderQueue> finish(); // finish handling events, generate rendering commands, and release resources
-		void cleanUp();
+		void prepare(); // prepare the gui for handling events, the hierarchy is regenerated only if any gui component or other input has changed since last prepare
+		Holder<RenderQueue> finish(); // finish handling events and generate rendering commands
+		void cleanUp(); // release the retained hierarchy and all resources it references
 
 		bool handleInput(const GenericInput &);
 		void invalidateInputs(); // skip all remaining inputs until next prepare
@@ -35,7 +35,7 @@ namespace cage
 		GuiSkinConfig &skin(uint32 index = 0);
 		const GuiSkinConfig &skin(uint32 index = 0) const;
 
-		EntityManager *entities();
+		EntityManager *entities(); // dirty tracking is enabled and consumed by the gui, components accessed for writing trigger regeneration of the hierarchy
 	};
 
 	struct CAGE_ENGINE_API GuiManagerCreateConfig
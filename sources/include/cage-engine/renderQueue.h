@@ -15,6 +15,12 @@ namespace cage
 		uint32 size = 0;
 	};
 
+	struct CAGE_ENGINE_API RenderQueueInspection
+	{
+		Holder<PointerRange<StringLiteral>> commands; // names of commands that would be executed
+		uint32 redundant = 0; // state changes that would be skipped
+	};
+
 	class CAGE_ENGINE_API RenderQueue : private Immovable
 	{
 	public:
@@ -128,6 +134,7 @@ namespace cage
 		void resetQueue(); // erase all stored commands
 
 		void dispatch(); // requires opengl context bound in current thread
+		RenderQueueInspection inspect() const; // walks the commands, including enqueued queues, without opengl
 
 		uint32 commandsCount() const;
 		uint32 drawsCount() const;
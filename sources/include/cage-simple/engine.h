@@ -2,6 +2,8 @@
 #define guard_engine_asg4ukio4up897sdr
 
 #include <cage-core/events.h>
+#include <cage-core/framePacing.h>
+#include <cage-core/systemInformation.h>
 #include <cage-engine/core.h>
 
 namespace cage
@@ -64,6 +66,7 @@ namespace cage
 		AssetManagerCreateConfig *assets = nullptr;
 		GuiManagerCreateConfig *gui = nullptr;
 		SpeakerCreateConfig *speaker = nullptr;
+		ThreadAffinityPolicyEnum threadsAffinity = ThreadAffinityPolicyEnum::None; // applies to graphics dispatch, graphics prepare and sound threads
 	};
 
 	void engineInitialize(const EngineCreateConfig &config);
@@ -81,6 +84,7 @@ namespace cage
 	VoicesMixer *engineEffectsMixer();
 	VoicesMixer *engineGuiMixer();
 	uint64 engineControlTime();
+	FramePacingStatistics engineFramePacingStatistics(); // frame rate limit is configured with cage/graphics/frameRateLimit
 }
 
 #endif // guard_engine_asg4ukio4up897sdr
@@ -16,6 +16,8 @@ namespace cage
 		DrawCalls = 1 << 5,
 		DrawPrimitives = 1 << 6,
 		Entities = 1 << 7,
+		FrameLatency = 1 << 8, // from processing inputs to presenting the frame
+		FrameJitter = 1 << 9, // difference between consecutive frame times
 	};
 	GCHL_ENUM_BITS(StatisticsGuiFlags);
 
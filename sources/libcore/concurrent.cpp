@@ -1,4 +1,5 @@
 #include <cage-core/concurrent.h>
+#include <cage-core/systemInformation.h>
 #include <cage-core/debug.h>
 
 #ifdef CAGE_SYSTEM_WINDOWS
@@ -12,6 +13,7 @@
 
 #ifdef CAGE_SYSTEM_LINUX
 #include <sys/prctl.h>
+#include <sched.h>
 #endif
 
 #ifdef CAGE_SYSTEM_MAC
@@ -19,6 +21,7 @@
 #endif
 
 #include <thread>
+#include <vector>
 #include <atomic>
 #include <exception>
 #include <cerrno>
@@ -223,6 +226,28 @@ namespace cage
 #endif
 	}
 
+	bool Semaphore::tryLock(uint64 micros)
+	{
+		SemaphoreImpl *impl = (SemaphoreImpl *)this;
+#ifdef CAGE_SYSTEM_WINDOWS
+		return WaitForSingleObject(impl->sem, numeric_cast<DWORD>((micros + 999) / 1000)) == WAIT_OBJECT_0;
+#elif defined(CAGE_SYSTEM_MAC)
+		return dispatch_semaphore_wait(impl->sem, dispatch_time(DISPATCH_TIME_NOW, micros * 1000)) == 0;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		micros += ts.tv_nsec / 1000;
+		ts.tv_sec += micros / 1000000;
+		ts.tv_nsec = (micros % 1000000) * 1000;
+		int r;
+		do
+		{
+			r = sem_timedwait(&impl->sem, &ts);
+		} while (r != 0 && errno == EINTR);
+		return r == 0;
+#endif
+	}
+
 	void Semaphore::unlock()
 	{
 		SemaphoreImpl *impl = (SemaphoreImpl *)this;
@@ -767,6 +792,40 @@ namespace cage
 		return std::thread::hardware_concurrency();
 	}
 
+	void currentThreadAffinity(PointerRange<const uint32> processors)
+	{
+		std::vector<uint32> all;
+		if (processors.empty())
+		{
+			for (const ProcessorTopology &p : processorsTopology().processors)
+				all.push_back(p.id);
+			processors = all;
+		}
+
+#if defined(CAGE_SYSTEM_WINDOWS)
+		// threads are restricted to single processor group
+		GROUP_AFFINITY ga = {};
+		ga.Group = numeric_cast<WORD>(processors[0] / 64);
+		for (uint32 id : processors)
+			if (id / 64 == ga.Group)
+				ga.Mask |= KAFFINITY(1) << (id % 64);
+		if (!SetThreadGroupAffinity(GetCurrentThread(), &ga, nullptr))
+			CAGE_THROW_ERROR(SystemError, "SetThreadGroupAffinity", GetLastError());
+#elif defined(CAGE_SYSTEM_LINUX)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (uint32 id : processors)
+		{
+			CAGE_ASSERT(id < CPU_SETSIZE);
+			CPU_SET(id, &set);
+		}
+		if (int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+			CAGE_THROW_ERROR(SystemError, "pthread_setaffinity_np", err);
+#else
+		// mac does not support pinning threads to processors
+#endif
+	}
+
 	void threadSleep(uint64 micros)
 	{
 #ifdef CAGE_SYSTEM_WINDOWS
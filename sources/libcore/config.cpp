@@ -41,7 +41,28 @@ namespace cage
 			return +*m;
 		}
 
-		using ConfigStorage = robin_hood::unordered_map<String, ConfigVariable *>;
+		// transparent, so that lookups by StringView do not allocate
+		struct ConfigNameHasher
+		{
+			using is_transparent = void;
+
+			std::size_t operator() (StringView name) const noexcept
+			{
+				return std::hash<StringView>()(name);
+			}
+		};
+
+		struct ConfigNameEqual
+		{
+			using is_transparent = void;
+
+			bool operator() (StringView a, StringView b) const noexcept
+			{
+				return a == b;
+			}
+		};
+
+		using ConfigStorage = robin_hood::unordered_map<HeapString, ConfigVariable *, ConfigNameHasher, ConfigNameEqual>;
 
 		ConfigStorage &storageAlreadyLocked()
 		{
@@ -49,17 +70,18 @@ namespace cage
 			return *v;
 		}
 
-		ConfigVariable *cfgVarAlreadyLocked(const String &name)
+		ConfigVariable *cfgVarAlreadyLocked(StringView name)
 		{
 			ConfigStorage &s = storageAlreadyLocked();
 			auto it = s.find(name);
 			if (it != s.end())
 				return it->second;
-			s[name] = new ConfigVariable(); // this leak is intentional
-			return s[name];
+			ConfigVariable *v = new ConfigVariable(); // this leak is intentional
+			s.emplace(HeapString(name), v);
+			return v;
 		}
 
-		ConfigVariable *cfgVar(const String &name)
+		ConfigVariable *cfgVar(StringView name)
 		{
 			ScopeLock lock(mut());
 			static int dummy = loadGlobalConfiguration();
@@ -121,7 +143,7 @@ namespace cage
 		}
 
 		template<class T>
-		ConfigVariable *cfgVar(const String &name, const T &default_)
+		ConfigVariable *cfgVar(StringView name, const T &default_)
 		{
 			ConfigVariable *var = cfgVar(name);
 			if (var->type == ConfigTypeEnum::Undefined)
@@ -192,13 +214,13 @@ namespace cage
 		T cfgGet(const ConfigList *ths);
 
 		template<class T>
-		void cfgSet(const String &name, const T &value)
+		void cfgSet(StringView name, const T &value)
 		{
 			cfgSet<T>(cfgVar(name), value);
 		}
 
 		template<class T>
-		T cfgGet(const String &name, const T &default_)
+		T cfgGet(StringView name, const T &default_)
 		{
 			const ConfigVariable *cfg = cfgVar(name);
 			if (cfg->type == ConfigTypeEnum::Undefined)
@@ -209,19 +231,19 @@ namespace cage
 
 	// public api
 
-	void configSetString(const String &name, const String &value) { cfgSet(name, value); }
-	String configGetString(const String &name, const String &default_) { return cfgGet(name, default_); }
-	ConfigString::ConfigString(const String &name) { data = cfgVar(name); }
-	ConfigString::ConfigString(const String &name, const String &default_) { data = cfgVar(name, default_); }
+	void configSetString(StringView name, const String &value) { cfgSet(name, value); }
+	String configGetString(StringView name, const String &default_) { return cfgGet(name, default_); }
+	ConfigString::ConfigString(StringView name) { data = cfgVar(name); }
+	ConfigString::ConfigString(StringView name, const String &default_) { data = cfgVar(name, default_); }
 	ConfigString &ConfigString::operator = (const String &value) { cfgSet(data, value); return *this; }
 	ConfigString::operator String() const { return cfgGet<String>(data); }
 	String ConfigList::getString() const { return cfgGet<String>(this); }
 
 #define GCHL_CONFIG(T, t) \
-	void CAGE_JOIN(configSet, T)(const String &name, t value) { cfgSet(name, value); } \
-	t CAGE_JOIN(configGet, T)(const String &name, t default_) { return cfgGet(name, default_); } \
-	CAGE_JOIN(Config, T)::CAGE_JOIN(Config, T)(const String &name) { data = cfgVar(name); } \
-	CAGE_JOIN(Config, T)::CAGE_JOIN(Config, T)(const String &name, t default_) { data = cfgVar(name, default_); } \
+	void CAGE_JOIN(configSet, T)(StringView name, t value) { cfgSet(name, value); } \
+	t CAGE_JOIN(configGet, T)(StringView name, t default_) { return cfgGet(name, default_); } \
+	CAGE_JOIN(Config, T)::CAGE_JOIN(Config, T)(StringView name) { data = cfgVar(name); } \
+	CAGE_JOIN(Config, T)::CAGE_JOIN(Config, T)(StringView name, t default_) { data = cfgVar(name, default_); } \
 	CAGE_JOIN(Config, T) &CAGE_JOIN(Config, T)::operator = (t value) { cfgSet(data, value); return *this; } \
 	CAGE_JOIN(Config, T)::operator t() const { return cfgGet<t>(data); } \
 	t ConfigList::CAGE_JOIN(get, T)() const { return cfgGet<t>(this); }
@@ -234,7 +256,7 @@ namespace cage
 	GCHL_CONFIG(Double, double)
 #undef GCHL_CONFIG
 
-	void configSetDynamic(const String &name, const String &value)
+	void configSetDynamic(StringView name, const String &value)
 	{
 		cfgSetDynamic(cfgVar(name), value);
 	}
@@ -256,7 +278,7 @@ namespace cage
 		}
 	}
 
-	ConfigTypeEnum configGetType(const String &name)
+	ConfigTypeEnum configGetType(StringView name)
 	{
 		return cfgVar(name)->type;
 	}
@@ -335,7 +357,7 @@ namespace cage
 					const auto &s = storageAlreadyLocked();
 					names.reserve(s.size());
 					for (const auto &it : s)
-						names.push_back(it.first);
+						names.push_back(String(it.first));
 				}
 				valid = !names.empty();
 				if (valid)
@@ -0,0 +1,106 @@
+#include <cage-core/heapString.h>
+
+namespace cage
+{
+	namespace
+	{
+		char *allocateChars(uint32 capacity)
+		{
+			return (char *)systemMemory().allocate(capacity + 1, 1);
+		}
+	}
+
+	HeapString::HeapString(HeapString &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	HeapString::HeapString(StringView str)
+	{
+		reserve(str.size());
+		detail::memcpy(ptr, str.data(), str.size());
+		len = str.size();
+		ptr[len] = 0;
+	}
+
+	HeapString::~HeapString()
+	{
+		if (ptr != local)
+			systemMemory().deallocate(ptr);
+	}
+
+	HeapString &HeapString::operator = (const HeapString &other)
+	{
+		if (this == &other)
+			return *this;
+		clear();
+		return *this += other;
+	}
+
+	HeapString &HeapString::operator = (HeapString &&other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		if (ptr != local)
+			systemMemory().deallocate(ptr);
+		if (other.ptr == other.local)
+		{
+			detail::memcpy(local, other.local, other.len + 1);
+			ptr = local;
+			cap = InlineCapacity;
+		}
+		else
+		{
+			ptr = other.ptr;
+			cap = other.cap;
+			other.ptr = other.local;
+			other.cap = InlineCapacity;
+		}
+		len = other.len;
+		other.len = 0;
+		other.local[0] = 0;
+		return *this;
+	}
+
+	HeapString &HeapString::operator += (StringView other)
+	{
+		if (other.empty())
+			return *this;
+		const uint32 l = len + other.size();
+		if (l > cap)
+		{
+			// the other may reference this string, the old storage is released only after copying
+			const uint32 c = l > cap * 2 ? l : cap * 2;
+			char *p = allocateChars(c);
+			detail::memcpy(p, ptr, len);
+			detail::memcpy(p + len, other.data(), other.size());
+			if (ptr != local)
+				systemMemory().deallocate(ptr);
+			ptr = p;
+			cap = c;
+		}
+		else
+			detail::memcpy(ptr + len, other.data(), other.size()); // destination does not overlap the source
+		len = l;
+		ptr[len] = 0;
+		return *this;
+	}
+
+	void HeapString::reserve(uint32 capacity)
+	{
+		if (capacity <= cap)
+			return;
+		char *p = allocateChars(capacity);
+		detail::memcpy(p, ptr, len + 1);
+		if (ptr != local)
+			systemMemory().deallocate(ptr);
+		ptr = p;
+		cap = capacity;
+	}
+
+	void HeapString::clear() noexcept
+	{
+		len = 0;
+		ptr[0] = 0;
+	}
+}
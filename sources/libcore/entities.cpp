@@ -4,6 +4,8 @@
 #include <cage-core/pointerRangeHolder.h>
 #include <cage-core/serialization.h>
 #include <cage-core/flatSet.h>
+#include <cage-core/tasks.h>
+#include <cage-core/concurrent.h> // processorsCount
 #include <cage-core/math.h>
 
 #include <robin_hood.h>
@@ -11,6 +13,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
 
 namespace cage
 {
@@ -38,8 +41,10 @@ namespace cage
 		public:
 			GroupsSet groups;
 			std::vector<void *> components;
+			std::vector<uint8> dirty; // indexed by component definition, same size as components, accessed atomically
 			EntityManagerImpl *const manager = nullptr;
 			const uint32 name = m;
+			uint32 dirtyIndex = m; // position in the list of dirty entities
 
 			EntityImpl(EntityManagerImpl *manager, uint32 name);
 			~EntityImpl();
@@ -53,8 +58,11 @@ namespace cage
 			std::vector<EntityComponent *> componentsByTypes;
 			robin_hood::unordered_map<uint32, Entity *> namedEntities;
 			plf::colony<EntityImpl> ents;
+			std::vector<Entity *> dirtyEntities;
+			Holder<Mutex> dirtyMutex = newMutex();
 			GroupImpl allEntities;
 			uint32 generateName = 0;
+			bool dirtyTracking = false;
 
 #ifdef _MSC_VER
 #pragma warning (push)
@@ -95,6 +103,58 @@ namespace cage
 			{
 				ents.erase(ents.get_iterator(e));
 			}
+
+			void listDirty(EntityImpl *e)
+			{
+				if (e->dirtyIndex != m)
+					return;
+				e->dirtyIndex = numeric_cast<uint32>(dirtyEntities.size());
+				dirtyEntities.push_back(e);
+			}
+
+			void markDirty(EntityImpl *e)
+			{
+				if (!dirtyTracking)
+					return;
+				ScopeLock lock(dirtyMutex);
+				listDirty(e);
+			}
+
+			// the lock is taken only by the first write to the value since last clear
+			CAGE_FORCE_INLINE void markDirty(EntityImpl *e, uint32 definitionIndex)
+			{
+				if (!dirtyTracking)
+					return;
+				CAGE_ASSERT(definitionIndex < e->dirty.size());
+				std::atomic_ref<uint8> flag(e->dirty[definitionIndex]);
+				if (flag.load(std::memory_order_relaxed) || flag.exchange(1, std::memory_order_relaxed))
+					return;
+				markDirty(e);
+			}
+
+			void unlistDirty(EntityImpl *e)
+			{
+				if (e->dirtyIndex == m)
+					return;
+				ScopeLock lock(dirtyMutex);
+				EntityImpl *last = (EntityImpl *)dirtyEntities.back();
+				dirtyEntities[e->dirtyIndex] = last;
+				last->dirtyIndex = e->dirtyIndex;
+				dirtyEntities.pop_back();
+				e->dirtyIndex = m;
+			}
+
+			void clearDirty()
+			{
+				ScopeLock lock(dirtyMutex);
+				for (Entity *e : dirtyEntities)
+				{
+					EntityImpl *i = (EntityImpl *)e;
+					std::fill(i->dirty.begin(), i->dirty.end(), 0);
+					i->dirtyIndex = m;
+				}
+				dirtyEntities.clear();
+			}
 		};
 
 		class Values
@@ -209,6 +269,7 @@ namespace cage
 			if (name != 0)
 				manager->namedEntities.emplace(name, this);
 			manager->allEntities.add(this);
+			manager->markDirty(this);
 		}
 
 		EntityImpl::~EntityImpl()
@@ -220,12 +281,54 @@ namespace cage
 				remove(*groups.begin());
 			if (name != 0)
 				manager->namedEntities.erase(name);
+			manager->unlistDirty(this);
 		}
 
 		GroupImpl::GroupImpl(EntityManagerImpl *manager) : manager(manager), definitionIndex(numeric_cast<uint32>(manager->groups.size()))
 		{
 			entities.reserve(100);
 		}
+
+		struct CopyValues
+		{
+			struct Chunk
+			{
+				std::vector<EntityImpl *> missing;
+				std::vector<EntityImpl *> changed;
+				uint32 written = 0;
+			};
+
+			std::vector<Chunk> chunks;
+			PointerRange<Entity *const> entities;
+			uint32 source = m;
+			uint32 destination = m;
+			uint32 size = 0;
+			bool tracking = false;
+
+			// entities are not modified structurally here, missing destination values are added afterwards on the calling thread
+			void operator () (uint32 idx)
+			{
+				Chunk &ch = chunks[idx];
+				const auto r = tasksSplit(idx, numeric_cast<uint32>(chunks.size()), numeric_cast<uint32>(entities.size()));
+				for (uint32 i = r.first; i < r.second; i++)
+				{
+					EntityImpl *e = (EntityImpl *)entities[i];
+					const void *s = e->components[source];
+					void *d = e->components.size() > destination ? e->components[destination] : nullptr;
+					if (!d)
+					{
+						ch.missing.push_back(e);
+						continue;
+					}
+					if (detail::memcmp(d, s, size) == 0)
+						continue;
+					detail::memcpy(d, s, size);
+					ch.written++;
+					if (tracking)
+						ch.changed.push_back(e);
+				}
+			}
+		};
 	}
 
 	EntityComponent *EntityManager::componentByDefinition(uint32 definitionIndex) const
@@ -369,6 +472,32 @@ namespace cage
 		impl->allEntities.destroy();
 	}
 
+	void EntityManager::dirtyTracking(bool enable)
+	{
+		EntityManagerImpl *impl = (EntityManagerImpl *)this;
+		if (!enable)
+			impl->clearDirty();
+		impl->dirtyTracking = enable;
+	}
+
+	bool EntityManager::dirtyTracking() const
+	{
+		const EntityManagerImpl *impl = (const EntityManagerImpl *)this;
+		return impl->dirtyTracking;
+	}
+
+	PointerRange<Entity *const> EntityManager::dirtyEntities() const
+	{
+		const EntityManagerImpl *impl = (const EntityManagerImpl *)this;
+		return impl->dirtyEntities;
+	}
+
+	void EntityManager::clearDirty()
+	{
+		EntityManagerImpl *impl = (EntityManagerImpl *)this;
+		impl->clearDirty();
+	}
+
 	EntityComponent *EntityManager::defineComponent_(uint32 typeIndex, const void *prototype)
 	{
 		EntityManagerImpl *impl = (EntityManagerImpl *)this;
@@ -425,6 +554,44 @@ namespace cage
 		impl->componentEntities.get()->destroy();
 	}
 
+	uint32 EntityComponent::copyValuesTo(EntityComponent *destination, uint32 parallelThreshold)
+	{
+		ComponentImpl *impl = (ComponentImpl *)this;
+		ComponentImpl *dst = (ComponentImpl *)destination;
+		CAGE_ASSERT(dst && dst != impl);
+		CAGE_ASSERT(dst->manager == impl->manager);
+		CAGE_ASSERT(dst->typeIndex == impl->typeIndex);
+
+		CopyValues cv;
+		cv.entities = impl->componentEntities->entities;
+		cv.source = impl->definitionIndex;
+		cv.destination = dst->definitionIndex;
+		cv.size = impl->typeSize;
+		cv.tracking = impl->manager->dirtyTracking;
+		const uint32 cnt = numeric_cast<uint32>(cv.entities.size());
+		if (cnt >= parallelThreshold && parallelThreshold > 0)
+		{
+			cv.chunks.resize(min(cnt / parallelThreshold + 1, processorsCount()));
+			tasksRunBlocking<CopyValues>("entities copy values", cv, numeric_cast<uint32>(cv.chunks.size()));
+		}
+		else
+		{
+			cv.chunks.resize(1);
+			cv(0);
+		}
+
+		uint32 written = 0;
+		for (const CopyValues::Chunk &ch : cv.chunks)
+		{
+			for (EntityImpl *e : ch.changed)
+				impl->manager->markDirty(e, cv.destination);
+			for (EntityImpl *e : ch.missing)
+				detail::memcpy(e->unsafeValue(destination), e->components[cv.source], cv.size);
+			written += ch.written + numeric_cast<uint32>(ch.missing.size());
+		}
+		return written;
+	}
+
 	EntityManager *Entity::manager() const
 	{
 		const EntityImpl *impl = (const EntityImpl *)this;
@@ -478,10 +645,14 @@ namespace cage
 		EntityImpl *impl = (EntityImpl *)this;
 		ComponentImpl *ci = (ComponentImpl *)component;
 		if (impl->components.size() < ci->definitionIndex + 1)
+		{
 			impl->components.resize(ci->definitionIndex + 1);
+			impl->dirty.resize(ci->definitionIndex + 1);
+		}
 		impl->components[ci->definitionIndex] = ci->newVal();
 		if (ci->componentEntities)
 			ci->componentEntities->add(this);
+		impl->manager->markDirty(impl, ci->definitionIndex);
 	}
 
 	void Entity::remove(EntityComponent *component)
@@ -494,6 +665,7 @@ namespace cage
 			ci->componentEntities->remove(this);
 		ci->values->desVal(impl->components[ci->definitionIndex]);
 		impl->components[ci->definitionIndex] = nullptr;
+		impl->manager->markDirty(impl, ci->definitionIndex);
 	}
 
 	bool Entity::has(const EntityComponent *component) const
@@ -515,12 +687,31 @@ namespace cage
 		{
 			void *res = impl->components[ci->definitionIndex];
 			if (res)
+			{
+				impl->manager->markDirty(impl, ci->definitionIndex);
 				return res;
+			}
 		}
 		add(component);
 		return unsafeValue(component);
 	}
 
+	const void *Entity::unsafeValue(const EntityComponent *component) const
+	{
+		CAGE_ASSERT(component->manager() == this->manager());
+		CAGE_ASSERT(has(component));
+		const EntityImpl *impl = (const EntityImpl *)this;
+		return impl->components[component->definitionIndex()];
+	}
+
+	bool Entity::dirty(const EntityComponent *component) const
+	{
+		CAGE_ASSERT(component->manager() == this->manager());
+		const EntityImpl *impl = (const EntityImpl *)this;
+		const uint32 idx = component->definitionIndex();
+		return idx < impl->dirty.size() && std::atomic_ref<uint8>(const_cast<uint8 &>(impl->dirty[idx])).load(std::memory_order_relaxed);
+	}
+
 	void Entity::destroy()
 	{
 		CAGE_ASSERT(this); // calling free/delete on null is ok, but calling the destroy METHOD is not, and some compilers totally ignored that issue
@@ -608,7 +799,7 @@ namespace cage
 				continue;
 			cnt++;
 			ser << name;
-			const char *u = (const char *)e->unsafeValue(component);
+			const char *u = (const char *)((const Entity *)e)->unsafeValue(component);
 			ser.write({ u, u + typeSize });
 		}
 		if (cnt == 0)
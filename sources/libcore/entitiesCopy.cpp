@@ -1,53 +1,195 @@
 #include <cage-core/entities.h>
 #include <cage-core/entitiesCopy.h>
+#include <cage-core/tasks.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/math.h>
 
-#include <map>
+#include <robin_hood.h>
+
+#include <vector>
 
 namespace cage
 {
 	namespace
 	{
-		std::map<EntityComponent *, EntityComponent *> mapping(const EntitiesCopyConfig &config)
+		// components are paired by type and order of definition, missing components are defined in the destination
+		std::vector<EntityComponent *> mapping(const EntityManager *source, EntityManager *destination)
 		{
-			std::map<EntityComponent *, EntityComponent *> res;
-			for (EntityComponent *sc : config.source->components())
+			std::vector<EntityComponent *> res;
+			res.reserve(source->componentsCount());
+			robin_hood::unordered_map<uint32, uint32> indices; // type index -> number of components of that type so far
+			for (EntityComponent *sc : source->components())
 			{
-				uint32 idx = 0;
-				for (EntityComponent *dc : config.source->componentsByType(sc->typeIndex()))
-				{
-					if (sc == dc)
-						break;
-					else
-						idx++;
-				}
-				auto cbts = config.destination->componentsByType(sc->typeIndex());
-				if (idx >= cbts.size())
+				const uint32 idx = indices[sc->typeIndex()]++;
+				auto dcs = destination->componentsByType(sc->typeIndex());
+				if (idx >= dcs.size())
 				{
-					const uint32 k = idx - cbts.size() + 1;
+					const uint32 k = numeric_cast<uint32>(idx - dcs.size() + 1);
 					for (uint32 i = 0; i < k; i++)
-						config.destination->defineComponent(sc);
-					cbts = config.destination->componentsByType(sc->typeIndex());
+						destination->defineComponent(sc);
+					dcs = destination->componentsByType(sc->typeIndex());
 				}
-				res[sc] = cbts[idx];
+				res.push_back(dcs[idx]);
 			}
 			return res;
 		}
-	}
 
-	void entitiesCopy(const EntitiesCopyConfig &config)
-	{
-		const auto mp = mapping(config);
-		config.destination->destroy();
-		for (Entity *se : config.source->entities())
+		struct Values
+		{
+			struct Job
+			{
+				void *dst = nullptr;
+				const void *src = nullptr;
+				uintPtr size = 0;
+			};
+
+			std::vector<Job> jobs;
+			uint32 groups = 1;
+
+			void operator () (uint32 idx)
+			{
+				const auto r = tasksSplit(idx, groups, numeric_cast<uint32>(jobs.size()));
+				for (uint32 i = r.first; i < r.second; i++)
+					detail::memcpy(jobs[i].dst, jobs[i].src, jobs[i].size);
+			}
+
+			void run(uint32 parallelThreshold)
+			{
+				if (jobs.size() >= parallelThreshold && parallelThreshold > 0)
+				{
+					groups = min(numeric_cast<uint32>(jobs.size() / parallelThreshold) + 1, processorsCount());
+					tasksRunBlocking<Values>("entities copy", *this, groups);
+				}
+				else
+				{
+					groups = 1;
+					(*this)(0);
+				}
+				jobs.clear();
+			}
+		};
+
+		Entity *createLike(EntityManager *destination, const Entity *se)
+		{
+			return se->name() ? destination->create(se->name()) : destination->createAnonymous();
+		}
+
+		void copyAll(const EntityManager *source, EntityManager *destination, PointerRange<EntityComponent *const> mp, Values &values, robin_hood::unordered_map<Entity *, Entity *> *pairs)
 		{
-			Entity *de = se->name() ? config.destination->create(se->name()) : config.destination->createAnonymous();
-			for (const auto &it : mp)
+			destination->destroy();
+			const uint32 cnt = numeric_cast<uint32>(mp.size());
+			for (Entity *se : source->entities())
 			{
-				if (!se->has(it.first))
-					continue;
-				detail::memcpy(de->unsafeValue(it.second), se->unsafeValue(it.first), detail::typeSizeByIndex(it.first->typeIndex()));
+				Entity *de = createLike(destination, se);
+				if (pairs)
+					pairs->emplace(se, de);
+				for (uint32 i = 0; i < cnt; i++)
+				{
+					EntityComponent *sc = source->componentByDefinition(i);
+					if (!se->has(sc))
+						continue;
+					values.jobs.push_back({ de->unsafeValue(mp[i]), ((const Entity *)se)->unsafeValue(sc), detail::typeSizeByIndex(sc->typeIndex()) });
+				}
 			}
 		}
+
+		class EntitiesCopierImpl : public EntitiesCopier
+		{
+		public:
+			const EntitiesCopierCreateConfig config;
+			std::vector<EntityComponent *> mp;
+			robin_hood::unordered_map<Entity *, Entity *> pairs; // source -> destination
+			std::vector<Entity *> pendingDestroys; // in the destination
+			EventListener<bool(Entity *)> removedListener;
+			Values values;
+			bool full = true;
+
+			EntitiesCopierImpl(const EntitiesCopierCreateConfig &config) : config(config)
+			{
+				CAGE_ASSERT(config.source && config.destination && config.source != config.destination);
+				config.source->dirtyTracking(true);
+				removedListener.bind<EntitiesCopierImpl, &EntitiesCopierImpl::entityRemoved>(this);
+				removedListener.attach(config.source->group()->entityRemoved);
+			}
+
+			bool entityRemoved(Entity *se)
+			{
+				auto it = pairs.find(se);
+				if (it != pairs.end())
+				{
+					pendingDestroys.push_back(it->second);
+					pairs.erase(it);
+				}
+				return false;
+			}
+
+			void copy()
+			{
+				EntityManager *src = config.source;
+				EntityManager *dst = config.destination;
+				if (mp.size() != src->componentsCount())
+					mp = mapping(src, dst);
+
+				if (full)
+				{
+					pairs.clear();
+					pendingDestroys.clear();
+					copyAll(src, dst, mp, values, &pairs);
+					full = false;
+				}
+				else
+				{
+					for (Entity *de : pendingDestroys)
+						de->destroy();
+					pendingDestroys.clear();
+
+					const uint32 cnt = numeric_cast<uint32>(mp.size());
+					for (Entity *se : src->dirtyEntities())
+					{
+						Entity *&de = pairs[se];
+						if (!de)
+							de = createLike(dst, se);
+						for (uint32 i = 0; i < cnt; i++)
+						{
+							EntityComponent *sc = src->componentByDefinition(i);
+							if (!se->dirty(sc))
+								continue;
+							if (se->has(sc))
+								values.jobs.push_back({ de->unsafeValue(mp[i]), ((const Entity *)se)->unsafeValue(sc), detail::typeSizeByIndex(sc->typeIndex()) });
+							else
+								de->remove(mp[i]);
+						}
+					}
+				}
+
+				values.run(config.parallelThreshold);
+				src->clearDirty(); // all changes were consumed
+			}
+		};
+	}
+
+	void entitiesCopy(const EntitiesCopyConfig &config)
+	{
+		const auto mp = mapping(config.source, config.destination);
+		Values values;
+		copyAll(config.source, config.destination, mp, values, nullptr);
+		values.run(m);
+	}
+
+	void EntitiesCopier::copy()
+	{
+		EntitiesCopierImpl *impl = (EntitiesCopierImpl *)this;
+		impl->copy();
+	}
+
+	void EntitiesCopier::reset()
+	{
+		EntitiesCopierImpl *impl = (EntitiesCopierImpl *)this;
+		impl->full = true;
 	}
-}
 
+	Holder<EntitiesCopier> newEntitiesCopier(const EntitiesCopierCreateConfig &config)
+	{
+		return systemMemory().createImpl<EntitiesCopier, EntitiesCopierImpl>(config);
+	}
+}
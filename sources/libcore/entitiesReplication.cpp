@@ -0,0 +1,505 @@
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <cage-core/entitiesReplication.h>
+#include <cage-core/memoryBuffer.h>
+#include <cage-core/networkGinnel.h>
+#include <cage-core/serialization.h>
+
+namespace cage
+{
+	namespace
+	{
+		struct ComponentSnapshot
+		{
+			std::vector<uint32> names; // sorted
+			std::vector<char> data; // names.size() * typeSize
+			uint32 definitionIndex = 0;
+			uint32 typeSize = 0;
+
+			PointerRange<const char> value(uintPtr index) const { return { data.data() + index * typeSize, data.data() + (index + 1) * typeSize }; }
+		};
+
+		struct Snapshot
+		{
+			std::vector<uint32> names; // sorted
+			std::vector<ComponentSnapshot> components;
+			uint32 id = 0;
+		};
+
+		// xor of the two values, with runs of zeroes skipped
+		// sequence of: uint16 skip, uint16 length, length bytes
+		void encodeDifference(Serializer &ser, PointerRange<const char> current, PointerRange<const char> baseline)
+		{
+			CAGE_ASSERT(baseline.empty() || baseline.size() == current.size());
+			const uint32 size = numeric_cast<uint32>(current.size());
+			const auto &diff = [&](uint32 i) -> char { return baseline.empty() ? current[i] : char(current[i] ^ baseline[i]); };
+			uint32 i = 0;
+			while (i < size)
+			{
+				const uint32 start = i;
+				while (i < size && diff(i) == 0 && i - start < 65535)
+					i++;
+				const uint16 skip = numeric_cast<uint16>(i - start);
+				const uint32 literal = i;
+				uint32 zeroes = 0;
+				// short runs of zeroes are cheaper inside the literal than as a new token
+				while (i < size && zeroes < 4 && i - literal < 65535)
+				{
+					if (diff(i) == 0)
+						zeroes++;
+					else
+						zeroes = 0;
+					i++;
+				}
+				i -= zeroes;
+				const uint16 length = numeric_cast<uint16>(i - literal);
+				ser << skip << length;
+				PointerRange<char> dst = ser.write(length);
+				for (uint32 j = 0; j < length; j++)
+					dst[j] = diff(literal + j);
+			}
+		}
+
+		void decodeDifference(Deserializer &des, PointerRange<char> result)
+		{
+			const uint32 size = numeric_cast<uint32>(result.size());
+			uint32 i = 0;
+			while (i < size)
+			{
+				uint16 skip, length;
+				des >> skip >> length;
+				if ((skip == 0 && length == 0) || uint32(skip) + length > size - i)
+					CAGE_THROW_ERROR(Exception, "invalid entities replication difference");
+				i += skip;
+				PointerRange<const char> src = des.read(length);
+				for (uint32 j = 0; j < length; j++)
+					result[i + j] ^= src[j];
+				i += length;
+			}
+		}
+
+		// names present in a but not in b
+		void setDifference(const std::vector<uint32> &a, const std::vector<uint32> &b, std::vector<uint32> &result)
+		{
+			result.clear();
+			std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+		}
+
+		void writeNames(Serializer &ser, const std::vector<uint32> &names)
+		{
+			ser << numeric_cast<uint32>(names.size());
+			ser.write(bufferCast<const char, const uint32>(names));
+		}
+
+		void readNames(Deserializer &des, std::vector<uint32> &names)
+		{
+			uint32 cnt = 0;
+			des >> cnt;
+			if (cnt > des.available() / sizeof(uint32))
+				CAGE_THROW_ERROR(Exception, "invalid entities replication names");
+			names.resize(cnt);
+			des.read(bufferCast<char, uint32>(names));
+		}
+
+		const Snapshot *findSnapshot(const std::deque<Snapshot> &history, uint32 id)
+		{
+			if (id == 0)
+				return nullptr;
+			for (const Snapshot &s : history)
+				if (s.id == id)
+					return &s;
+			return nullptr;
+		}
+
+		Holder<PointerRange<char>> encodeSnapshot(const Snapshot &current, const Snapshot *baseline)
+		{
+			static const Snapshot empty;
+			const Snapshot &base = baseline ? *baseline : empty;
+			CAGE_ASSERT(!baseline || baseline->components.size() == current.components.size());
+
+			MemoryBuffer buffer;
+			Serializer ser(buffer);
+			ser << current.id << base.id;
+
+			std::vector<uint32> tmp;
+			setDifference(base.names, current.names, tmp);
+			writeNames(ser, tmp); // destroyed
+			setDifference(current.names, base.names, tmp);
+			writeNames(ser, tmp); // created
+
+			ser << numeric_cast<uint32>(current.components.size());
+			for (uint32 ci = 0; ci < current.components.size(); ci++)
+			{
+				const ComponentSnapshot &cur = current.components[ci];
+				const ComponentSnapshot *bs = baseline ? &base.components[ci] : nullptr;
+				ser << cur.definitionIndex << cur.typeSize;
+
+				if (bs)
+					setDifference(bs->names, cur.names, tmp);
+				else
+					tmp.clear();
+				writeNames(ser, tmp); // removed
+
+				Serializer cntPlaceholder = ser.reserve(sizeof(uint32));
+				uint32 cnt = 0;
+				uintPtr j = 0;
+				for (uintPtr i = 0; i < cur.names.size(); i++)
+				{
+					const uint32 name = cur.names[i];
+					PointerRange<const char> prev;
+					if (bs)
+					{
+						while (j < bs->names.size() && bs->names[j] < name)
+							j++;
+						if (j < bs->names.size() && bs->names[j] == name)
+						{
+							prev = bs->value(j);
+							if (detail::memcmp(prev.data(), cur.value(i).data(), cur.typeSize) == 0)
+								continue; // unchanged
+						}
+					}
+					ser << name;
+					Serializer sizePlaceholder = ser.reserve(sizeof(uint32));
+					const uintPtr before = buffer.size();
+					encodeDifference(ser, cur.value(i), prev);
+					sizePlaceholder << numeric_cast<uint32>(buffer.size() - before);
+					cnt++;
+				}
+				cntPlaceholder << cnt;
+			}
+
+			return std::move(buffer);
+		}
+
+		class EntitiesReplicationServerImpl : public EntitiesReplicationServer
+		{
+		public:
+			const EntitiesReplicationServerCreateConfig config;
+			std::vector<EntityComponent *> components;
+			std::deque<Snapshot> history;
+			std::unordered_map<uint32, uint32> clients; // client -> acknowledged snapshot id
+			std::vector<std::pair<uint32, Entity *>> sorted;
+			uint32 lastId = 0;
+
+			EntitiesReplicationServerImpl(const EntitiesReplicationServerCreateConfig &config) : config(config)
+			{
+				CAGE_ASSERT(config.entities);
+				CAGE_ASSERT(config.historySize > 0);
+				if (config.components.empty())
+				{
+					auto cs = config.entities->manager()->components();
+					components = std::vector<EntityComponent *>(cs.begin(), cs.end());
+				}
+				else
+					components = std::vector<EntityComponent *>(config.components.begin(), config.components.end());
+				for (EntityComponent *c : components)
+					CAGE_ASSERT(c->manager() == config.entities->manager());
+			}
+
+			void capture()
+			{
+				sorted.clear();
+				for (Entity *e : config.entities->entities())
+					if (e->name())
+						sorted.emplace_back(e->name(), e);
+				std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+				Snapshot s;
+				if (history.size() >= config.historySize)
+				{
+					s = std::move(history.front()); // reuse the allocations
+					history.pop_front();
+				}
+				s.id = ++lastId;
+				s.names.clear();
+				for (const auto &it : sorted)
+					s.names.push_back(it.first);
+				s.components.resize(components.size());
+				for (uint32 ci = 0; ci < components.size(); ci++)
+				{
+					EntityComponent *c = components[ci];
+					ComponentSnapshot &cs = s.components[ci];
+					cs.definitionIndex = c->definitionIndex();
+					cs.typeSize = numeric_cast<uint32>(detail::typeSizeByIndex(c->typeIndex()));
+					cs.names.clear();
+					cs.data.clear();
+					for (const auto &it : sorted)
+					{
+						if (!it.second->has(c))
+							continue;
+						cs.names.push_back(it.first);
+						const char *u = (const char *)((const Entity *)it.second)->unsafeValue(c);
+						cs.data.insert(cs.data.end(), u, u + cs.typeSize);
+					}
+				}
+				history.push_back(std::move(s));
+			}
+
+			Holder<PointerRange<char>> encode(uint32 client)
+			{
+				if (history.empty())
+					CAGE_THROW_ERROR(Exception, "entities replication requires captured snapshot");
+				return encodeSnapshot(history.back(), findSnapshot(history, clients[client]));
+			}
+
+			void acknowledge(uint32 client, PointerRange<const char> message)
+			{
+				if (message.size() != sizeof(uint32))
+					CAGE_THROW_ERROR(Exception, "invalid entities replication acknowledgement");
+				Deserializer des(message);
+				uint32 id = 0;
+				des >> id;
+				if (id > lastId)
+					return; // not a snapshot we have sent
+				uint32 &acked = clients[client];
+				acked = std::max(acked, id);
+			}
+		};
+
+		class EntitiesReplicationClientImpl : public EntitiesReplicationClient
+		{
+		public:
+			const EntitiesReplicationClientCreateConfig config;
+			std::deque<Snapshot> history;
+			std::vector<uint32> destroyed, created, removed, tmp;
+			std::vector<std::pair<uint32, PointerRange<const char>>> changed;
+
+			EntitiesReplicationClientImpl(const EntitiesReplicationClientCreateConfig &config) : config(config)
+			{
+				CAGE_ASSERT(config.manager);
+				CAGE_ASSERT(config.historySize > 0);
+			}
+
+			uint32 lastId() const { return history.empty() ? 0 : history.back().id; }
+
+			static void mergeNames(const std::vector<uint32> &base, const std::vector<uint32> &remove, const std::vector<uint32> &add, std::vector<uint32> &tmp, std::vector<uint32> &result)
+			{
+				tmp.clear();
+				std::set_difference(base.begin(), base.end(), remove.begin(), remove.end(), std::back_inserter(tmp));
+				result.clear();
+				std::set_union(tmp.begin(), tmp.end(), add.begin(), add.end(), std::back_inserter(result));
+			}
+
+			void decodeComponent(Deserializer &des, const ComponentSnapshot *base, ComponentSnapshot &cs)
+			{
+				des >> cs.definitionIndex >> cs.typeSize;
+				if (base && (base->definitionIndex != cs.definitionIndex || base->typeSize != cs.typeSize))
+					CAGE_THROW_ERROR(Exception, "entities replication baseline mismatch");
+				readNames(des, removed);
+				uint32 cnt = 0;
+				des >> cnt;
+				changed.clear();
+				for (uint32 i = 0; i < cnt; i++)
+				{
+					uint32 name = 0, size = 0;
+					des >> name >> size;
+					if (!changed.empty() && changed.back().first >= name)
+						CAGE_THROW_ERROR(Exception, "invalid entities replication order");
+					changed.emplace_back(name, des.read(size));
+				}
+
+				static const ComponentSnapshot empty;
+				const ComponentSnapshot &bs = base ? *base : empty;
+				cs.names.clear();
+				cs.data.clear();
+				uintPtr i = 0, j = 0, k = 0;
+				while (i < bs.names.size() || j < changed.size())
+				{
+					const uint32 nb = i < bs.names.size() ? bs.names[i] : m;
+					const uint32 nc = j < changed.size() ? changed[j].first : m;
+					if (nb < nc)
+					{
+						while (k < removed.size() && removed[k] < nb)
+							k++;
+						if (k == removed.size() || removed[k] != nb)
+						{
+							cs.names.push_back(nb);
+							PointerRange<const char> v = bs.value(i);
+							cs.data.insert(cs.data.end(), v.begin(), v.end());
+						}
+						i++;
+					}
+					else
+					{
+						cs.names.push_back(nc);
+						const uintPtr offset = cs.data.size();
+						if (nb == nc)
+						{
+							PointerRange<const char> v = bs.value(i);
+							cs.data.insert(cs.data.end(), v.begin(), v.end());
+							i++;
+						}
+						else
+							cs.data.resize(offset + cs.typeSize, 0);
+						Deserializer d(changed[j].second);
+						decodeDifference(d, { cs.data.data() + offset, cs.data.data() + offset + cs.typeSize });
+						if (d.available())
+							CAGE_THROW_ERROR(Exception, "invalid entities replication difference");
+						j++;
+					}
+				}
+			}
+
+			void applyToManager(const Snapshot *prev, const Snapshot &next)
+			{
+				EntityManager *man = config.manager;
+				if (prev)
+				{
+					setDifference(prev->names, next.names, tmp);
+					for (uint32 n : tmp)
+						if (Entity *e = man->tryGet(n))
+							e->destroy();
+				}
+				for (uint32 n : next.names)
+					man->getOrCreate(n);
+				for (uint32 ci = 0; ci < next.components.size(); ci++)
+				{
+					const ComponentSnapshot &cs = next.components[ci];
+					EntityComponent *c = man->componentByDefinition(cs.definitionIndex);
+					if (prev && ci < prev->components.size())
+					{
+						setDifference(prev->components[ci].names, cs.names, tmp);
+						for (uint32 n : tmp)
+							if (Entity *e = man->tryGet(n))
+								e->remove(c);
+					}
+					for (uintPtr i = 0; i < cs.names.size(); i++)
+					{
+						char *u = (char *)man->get(cs.names[i])->unsafeValue(c);
+						detail::memcpy(u, cs.value(i).data(), cs.typeSize);
+					}
+				}
+			}
+
+			bool apply(PointerRange<const char> message)
+			{
+				Deserializer des(message);
+				uint32 id = 0, baselineId = 0;
+				des >> id >> baselineId;
+				if (id <= lastId())
+					return false; // obsolete
+				const Snapshot *base = findSnapshot(history, baselineId);
+				if (baselineId && !base)
+					return false; // baseline no longer available, wait for the server to catch up with acknowledgements
+
+				Snapshot s;
+				s.id = id;
+				readNames(des, destroyed);
+				readNames(des, created);
+				mergeNames(base ? base->names : std::vector<uint32>(), destroyed, created, tmp, s.names);
+
+				uint32 cnt = 0;
+				des >> cnt;
+				if (base && base->components.size() != cnt)
+					CAGE_THROW_ERROR(Exception, "entities replication baseline mismatch");
+				s.components.resize(cnt);
+				for (uint32 ci = 0; ci < cnt; ci++)
+				{
+					decodeComponent(des, base ? &base->components[ci] : nullptr, s.components[ci]);
+					const ComponentSnapshot &cs = s.components[ci];
+					if (cs.definitionIndex >= config.manager->componentsCount())
+						CAGE_THROW_ERROR(Exception, "incompatible component (different index)");
+					if (detail::typeSizeByIndex(config.manager->componentByDefinition(cs.definitionIndex)->typeIndex()) != cs.typeSize)
+						CAGE_THROW_ERROR(Exception, "incompatible component (different size)");
+				}
+				if (des.available())
+					CAGE_THROW_ERROR(Exception, "invalid entities replication snapshot");
+
+				applyToManager(history.empty() ? nullptr : &history.back(), s);
+				history.push_back(std::move(s));
+				while (history.size() > config.historySize)
+					history.pop_front();
+				return true;
+			}
+		};
+	}
+
+	void EntitiesReplicationServer::capture()
+	{
+		EntitiesReplicationServerImpl *impl = (EntitiesReplicationServerImpl *)this;
+		impl->capture();
+	}
+
+	Holder<PointerRange<char>> EntitiesReplicationServer::encode(uint32 client)
+	{
+		EntitiesReplicationServerImpl *impl = (EntitiesReplicationServerImpl *)this;
+		return impl->encode(client);
+	}
+
+	void EntitiesReplicationServer::acknowledge(uint32 client, PointerRange<const char> message)
+	{
+		EntitiesReplicationServerImpl *impl = (EntitiesReplicationServerImpl *)this;
+		impl->acknowledge(client, message);
+	}
+
+	void EntitiesReplicationServer::remove(uint32 client)
+	{
+		EntitiesReplicationServerImpl *impl = (EntitiesReplicationServerImpl *)this;
+		impl->clients.erase(client);
+	}
+
+	void EntitiesReplicationServer::send(uint32 client, GinnelConnection *connection)
+	{
+		EntitiesReplicationServerImpl *impl = (EntitiesReplicationServerImpl *)this;
+		Holder<PointerRange<char>> buff = impl->encode(client);
+		connection->write(buff, impl->config.channel, false);
+	}
+
+	uint32 EntitiesReplicationServer::snapshotId() const
+	{
+		const EntitiesReplicationServerImpl *impl = (const EntitiesReplicationServerImpl *)this;
+		return impl->lastId;
+	}
+
+	uint32 EntitiesReplicationServer::baselineId(uint32 client) const
+	{
+		const EntitiesReplicationServerImpl *impl = (const EntitiesReplicationServerImpl *)this;
+		const auto it = impl->clients.find(client);
+		return it == impl->clients.end() ? 0 : it->second;
+	}
+
+	Holder<EntitiesReplicationServer> newEntitiesReplicationServer(const EntitiesReplicationServerCreateConfig &config)
+	{
+		return systemMemory().createImpl<EntitiesReplicationServer, EntitiesReplicationServerImpl>(config);
+	}
+
+	bool EntitiesReplicationClient::apply(PointerRange<const char> message)
+	{
+		EntitiesReplicationClientImpl *impl = (EntitiesReplicationClientImpl *)this;
+		return impl->apply(message);
+	}
+
+	Holder<PointerRange<char>> EntitiesReplicationClient::acknowledgement() const
+	{
+		const EntitiesReplicationClientImpl *impl = (const EntitiesReplicationClientImpl *)this;
+		const uint32 id = impl->lastId();
+		if (id == 0)
+			return {};
+		MemoryBuffer buffer;
+		Serializer ser(buffer);
+		ser << id;
+		return std::move(buffer);
+	}
+
+	void EntitiesReplicationClient::send(GinnelConnection *connection) const
+	{
+		const EntitiesReplicationClientImpl *impl = (const EntitiesReplicationClientImpl *)this;
+		Holder<PointerRange<char>> buff = acknowledgement();
+		if (buff)
+			connection->write(buff, impl->config.channel, false);
+	}
+
+	uint32 EntitiesReplicationClient::snapshotId() const
+	{
+		const EntitiesReplicationClientImpl *impl = (const EntitiesReplicationClientImpl *)this;
+		return impl->lastId();
+	}
+
+	Holder<EntitiesReplicationClient> newEntitiesReplicationClient(const EntitiesReplicationClientCreateConfig &config)
+	{
+		return systemMemory().createImpl<EntitiesReplicationClient, EntitiesReplicationClientImpl>(config);
+	}
+}
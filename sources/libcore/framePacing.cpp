@@ -0,0 +1,198 @@
+#include <cage-core/framePacing.h>
+#include <cage-core/concurrent.h>
+
+namespace cage
+{
+	void FramePacingStatistics::add(const FrameTimestamps &ts, uint64 targetFrameTime)
+	{
+		for (uint32 i = 1; i < FrameStagesCount; i++)
+		{
+			if (ts.stages[i] == 0)
+				continue;
+			for (uint32 j = i; j-- > 0;)
+			{
+				if (ts.stages[j] == 0)
+					continue;
+				stageDelays[i].add(ts.stages[i] >= ts.stages[j] ? ts.stages[i] - ts.stages[j] : 0);
+				break;
+			}
+		}
+
+		const uint64 present = ts.stages[(uint32)FrameStageEnum::Present];
+		const uint64 input = ts.stages[(uint32)FrameStageEnum::Input];
+		const uint64 prepare = ts.stages[(uint32)FrameStageEnum::PrepareStart];
+		if (input && present >= input)
+			latencies.add(present - input);
+		if (prepare && present >= prepare)
+			presentDelays.add(present - prepare);
+
+		const uint64 previous = latest.stages[(uint32)FrameStageEnum::Present];
+		if (previous && present >= previous)
+		{
+			const uint64 ft = present - previous;
+			if (frames >= 2)
+			{
+				const uint64 last = frameTimes.current();
+				frameJitters.add(ft > last ? ft - last : last - ft);
+			}
+			frameTimes.add(ft);
+			if (targetFrameTime && ft > targetFrameTime * 3 / 2)
+				missedFrames++;
+		}
+
+		latest = ts;
+		frames++;
+	}
+
+	namespace
+	{
+		constexpr uint32 RingSize = 4; // frames in flight
+
+		uint64 defaultClock()
+		{
+			return applicationTime();
+		}
+
+		void defaultSleep(uint64 duration)
+		{
+			if (duration)
+				threadSleep(duration);
+			else
+				threadYield();
+		}
+
+		class FramePacerImpl : public FramePacer
+		{
+		public:
+			Holder<Mutex> mutex = newMutex();
+			Delegate<uint64()> clock;
+			Delegate<void(uint64)> sleep;
+			VariableSmoothingBuffer<uint64, 16> oversleeps;
+			FramePacingStatistics stats;
+			FrameTimestamps ring[RingSize];
+			uint64 target = 0;
+			uint64 next = 0; // time at which next frame should start
+
+			explicit FramePacerImpl(const FramePacerCreateConfig &config) : clock(config.clock), sleep(config.sleep), target(config.targetFrameTime)
+			{
+				if (!clock)
+					clock.bind<&defaultClock>();
+				if (!sleep)
+					sleep.bind<&defaultSleep>();
+				oversleeps.seed(1000); // typical scheduler granularity
+			}
+
+			uint64 predicted() const
+			{
+				return oversleeps.max();
+			}
+
+			void wait()
+			{
+				uint64 now = clock();
+				if (target == 0)
+				{
+					next = now;
+					return;
+				}
+				if (next == 0 || now > next + target)
+					next = now; // restart the cadence
+				while (now < next)
+				{
+					const uint64 remaining = next - now;
+					const uint64 margin = predicted();
+					if (remaining > margin)
+					{
+						const uint64 request = remaining - margin;
+						sleep(request);
+						const uint64 after = clock();
+						const uint64 actual = after - now;
+						oversleeps.add(actual > request ? actual - request : 0);
+						now = after;
+					}
+					else
+					{
+						sleep(0);
+						now = clock();
+					}
+				}
+				next += target;
+			}
+
+			void stage(uint32 frameIndex, FrameStageEnum stage, uint64 time)
+			{
+				CAGE_ASSERT((uint32)stage < FrameStagesCount);
+				ScopeLock lock(mutex);
+				FrameTimestamps &ts = ring[frameIndex % RingSize];
+				if (ts.frameIndex != frameIndex)
+				{
+					ts = {}; // discard incomplete frame
+					ts.frameIndex = frameIndex;
+				}
+				ts.stages[(uint32)stage] = time;
+				if (stage == FrameStageEnum::Present)
+				{
+					stats.add(ts, target);
+					ts = {};
+				}
+			}
+		};
+	}
+
+	void FramePacer::targetFrameTime(uint64 time)
+	{
+		FramePacerImpl *impl = (FramePacerImpl *)this;
+		if (impl->target != time)
+			impl->next = 0;
+		impl->target = time;
+	}
+
+	uint64 FramePacer::targetFrameTime() const
+	{
+		const FramePacerImpl *impl = (const FramePacerImpl *)this;
+		return impl->target;
+	}
+
+	void FramePacer::wait()
+	{
+		FramePacerImpl *impl = (FramePacerImpl *)this;
+		impl->wait();
+	}
+
+	uint64 FramePacer::predictedOversleep() const
+	{
+		const FramePacerImpl *impl = (const FramePacerImpl *)this;
+		return impl->predicted();
+	}
+
+	void FramePacer::stage(uint32 frameIndex, FrameStageEnum stage)
+	{
+		FramePacerImpl *impl = (FramePacerImpl *)this;
+		impl->stage(frameIndex, stage, impl->clock());
+	}
+
+	void FramePacer::stage(uint32 frameIndex, FrameStageEnum stage, uint64 time)
+	{
+		FramePacerImpl *impl = (FramePacerImpl *)this;
+		impl->stage(frameIndex, stage, time);
+	}
+
+	uint64 FramePacer::presentDelay() const
+	{
+		const FramePacerImpl *impl = (const FramePacerImpl *)this;
+		ScopeLock lock(impl->mutex);
+		return impl->stats.presentDelays.smooth();
+	}
+
+	FramePacingStatistics FramePacer::statistics() const
+	{
+		const FramePacerImpl *impl = (const FramePacerImpl *)this;
+		ScopeLock lock(impl->mutex);
+		return impl->stats;
+	}
+
+	Holder<FramePacer> newFramePacer(const FramePacerCreateConfig &config)
+	{
+		return systemMemory().createImpl<FramePacer, FramePacerImpl>(config);
+	}
+}
@@ -1,109 +1,505 @@
 #include <cage-core/hashes.h>
+#include <cage-core/config.h>
 
 #include <array>
-#include <vector>
 #include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CAGE_HASHES_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CAGE_HASHES_SHA_TARGET
+#else
+#include <cpuid.h>
+#define CAGE_HASHES_SHA_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#endif
 
 namespace cage
 {
-	std::array<uint8, 20> hashSha1(PointerRange<const char> data)
+	namespace
 	{
-		// https://thealgorithms.github.io/C-Plus-Plus/d8/d7a/sha1_8cpp.html
-		// modified
+		const ConfigBool confHardware("cage/hashes/hardware", true);
+
+		constexpr uint64 P1 = 0x9E3779B185EBCA87ull;
+		constexpr uint64 P2 = 0xC2B2AE3D27D4EB4Full;
+		constexpr uint64 P3 = 0x165667B19E3779F9ull;
+		constexpr uint64 P4 = 0x85EBCA77C2B2AE63ull;
+		constexpr uint64 P5 = 0x27D4EB2F165667C5ull;
+		constexpr uint64 SecondLane = 0x5851F42D4C957F2Dull;
+
+		CAGE_FORCE_INLINE uint64 rotl(uint64 v, uint32 r)
+		{
+			return (v << r) | (v >> (64 - r));
+		}
+
+		CAGE_FORCE_INLINE uint64 read64(const uint8 *p)
+		{
+			uint64 r;
+			std::memcpy(&r, p, sizeof(r));
+			return r;
+		}
+
+		CAGE_FORCE_INLINE uint32 read32(const uint8 *p)
+		{
+			uint32 r;
+			std::memcpy(&r, p, sizeof(r));
+			return r;
+		}
+
+		CAGE_FORCE_INLINE uint64 accumulate(uint64 acc, uint64 input)
+		{
+			acc += input * P2;
+			acc = rotl(acc, 31);
+			return acc * P1;
+		}
+
+		CAGE_FORCE_INLINE uint64 mergeRound(uint64 acc, uint64 val)
+		{
+			acc ^= accumulate(0, val);
+			return acc * P1 + P4;
+		}
 
-		const auto &leftRotate32bits = [](uint32 n, uint32 rotate) -> uint32
+		void initAccumulators(uint64 acc[4], uint64 seed)
+		{
+			acc[0] = seed + P1 + P2;
+			acc[1] = seed + P2;
+			acc[2] = seed;
+			acc[3] = seed - P1;
+		}
+
+		// the four lanes are independent and are processed in 32 byte stripes
+		const uint8 *stripes(uint64 acc[4], const uint8 *p, const uint8 *e)
+		{
+			uint64 a = acc[0], b = acc[1], c = acc[2], d = acc[3];
+			while (e - p >= 32)
+			{
+				a = accumulate(a, read64(p + 0));
+				b = accumulate(b, read64(p + 8));
+				c = accumulate(c, read64(p + 16));
+				d = accumulate(d, read64(p + 24));
+				p += 32;
+			}
+			acc[0] = a;
+			acc[1] = b;
+			acc[2] = c;
+			acc[3] = d;
+			return p;
+		}
+
+		uint64 finalize(const uint64 acc[4], uint64 total, uint64 seed, const uint8 *p, const uint8 *e, bool second)
+		{
+			uint64 h;
+			if (total >= 32)
+			{
+				if (second)
+				{
+					h = rotl(acc[3], 1) + rotl(acc[2], 7) + rotl(acc[1], 12) + rotl(acc[0], 18);
+					for (uint32 i = 0; i < 4; i++)
+						h = mergeRound(h, acc[3 - i]);
+				}
+				else
+				{
+					h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+					for (uint32 i = 0; i < 4; i++)
+						h = mergeRound(h, acc[i]);
+				}
+			}
+			else
+				h = (second ? seed ^ SecondLane : seed) + P5;
+			h += total;
+			while (e - p >= 8)
+			{
+				h ^= accumulate(0, read64(p));
+				h = rotl(h, 27) * P1 + P4;
+				p += 8;
+			}
+			if (e - p >= 4)
+			{
+				h ^= uint64(read32(p)) * P1;
+				h = rotl(h, 23) * P2 + P3;
+				p += 4;
+			}
+			while (p < e)
+			{
+				h ^= uint64(*p++) * P5;
+				h = rotl(h, 11) * P1;
+			}
+			h ^= h >> 33;
+			h *= P2;
+			h ^= h >> 29;
+			h *= P3;
+			h ^= h >> 32;
+			return h;
+		}
+
+		std::array<uint8, 16> toBytes(uint64 a, uint64 b)
+		{
+			std::array<uint8, 16> r = {};
+			for (uint32 i = 0; i < 8; i++)
+			{
+				r[i] = uint8(a >> (56 - 8 * i));
+				r[i + 8] = uint8(b >> (56 - 8 * i));
+			}
+			return r;
+		}
+
+		template<bool Second>
+		uint64 hashImpl(PointerRange<const char> data, uint64 seed)
+		{
+			const uint8 *p = (const uint8 *)data.begin();
+			const uint8 *e = (const uint8 *)data.end();
+			uint64 acc[4];
+			initAccumulators(acc, seed);
+			p = stripes(acc, p, e);
+			return finalize(acc, data.size(), seed, p, e, Second);
+		}
+
+		CAGE_FORCE_INLINE uint32 leftRotate32(uint32 n, uint32 rotate)
 		{
 			return (n << rotate) | (n >> (32 - rotate));
-		};
+		}
 
-		uint32 h0 = 0x67452301, a = 0;
-		uint32 h1 = 0xEFCDAB89, b = 0;
-		uint32 h2 = 0x98BADCFE, c = 0;
-		uint32 h3 = 0x10325476, d = 0;
-		uint32 h4 = 0xC3D2E1F0, e = 0;
+		CAGE_FORCE_INLINE uint32 rightRotate32(uint32 n, uint32 rotate)
+		{
+			return (n >> rotate) | (n << (32 - rotate));
+		}
 
-		const uint32 input_size = numeric_cast<uint32>(data.size());
-		const uint64 padded_message_size = input_size % 64 < 56 ? input_size + 64 - (input_size % 64) : input_size + 128 - (input_size % 64);
-		std::vector<uint8> padded_message;
-		padded_message.resize(padded_message_size);
-		std::copy((const uint8 *)data.begin(), (const uint8 *)data.end(), padded_message.begin());
-		padded_message[input_size] = 1 << 7; // 10000000
-		for (uint64 i = input_size; i % 64 != 56; i++)
+		CAGE_FORCE_INLINE uint32 readBe32(const uint8 *p)
 		{
-			if (i == input_size)
-				continue;
-			padded_message[i] = 0;
+			return (uint32(p[0]) << 24) | (uint32(p[1]) << 16) | (uint32(p[2]) << 8) | uint32(p[3]);
 		}
-		for (uint8 i = 0; i < 8; i++)
-			padded_message[padded_message_size - 8 + i] = (uint64(input_size * 8) >> (56 - 8 * i)) & 0xFF;
 
-		std::array<uint32, 80> blocks = {};
-		for (uint64 chunk = 0; chunk * 64 < padded_message_size; chunk++)
+		void sha1Software(uint32 state[5], const uint8 *data, uintPtr blocksCount)
 		{
-			for (uint8 bid = 0; bid < 16; bid++)
+			std::array<uint32, 80> w = {};
+			for (uintPtr block = 0; block < blocksCount; block++, data += 64)
 			{
-				blocks[bid] = 0;
-				for (uint8 cid = 0; cid < 4; cid++)
-					blocks[bid] = (blocks[bid] << 8) + padded_message[chunk * 64 + bid * 4 + cid];
-				for (uint8 i = 16; i < 80; i++)
-					blocks[i] = leftRotate32bits(blocks[i - 3] ^ blocks[i - 8] ^ blocks[i - 14] ^ blocks[i - 16], 1);
+				for (uint32 i = 0; i < 16; i++)
+					w[i] = readBe32(data + i * 4);
+				for (uint32 i = 16; i < 80; i++)
+					w[i] = leftRotate32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+				uint32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+				for (uint32 i = 0; i < 80; i++)
+				{
+					uint32 f = 0, k = 0;
+					if (i < 20)
+					{
+						f = (b & c) | ((~b) & d);
+						k = 0x5A827999;
+					}
+					else if (i < 40)
+					{
+						f = b ^ c ^ d;
+						k = 0x6ED9EBA1;
+					}
+					else if (i < 60)
+					{
+						f = (b & c) | (b & d) | (c & d);
+						k = 0x8F1BBCDC;
+					}
+					else
+					{
+						f = b ^ c ^ d;
+						k = 0xCA62C1D6;
+					}
+					const uint32 temp = leftRotate32(a, 5) + f + e + k + w[i];
+					e = d;
+					d = c;
+					c = leftRotate32(b, 30);
+					b = a;
+					a = temp;
+				}
+				state[0] += a;
+				state[1] += b;
+				state[2] += c;
+				state[3] += d;
+				state[4] += e;
 			}
+		}
 
-			a = h0;
-			b = h1;
-			c = h2;
-			d = h3;
-			e = h4;
+		alignas(16) constexpr uint32 Sha256K[64] = {
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+		};
 
-			for (uint8 i = 0; i < 80; i++)
+		void sha256Software(uint32 state[8], const uint8 *data, uintPtr blocksCount)
+		{
+			std::array<uint32, 64> w = {};
+			for (uintPtr block = 0; block < blocksCount; block++, data += 64)
 			{
-				uint32 F = 0, g = 0;
-				if (i < 20)
+				for (uint32 i = 0; i < 16; i++)
+					w[i] = readBe32(data + i * 4);
+				for (uint32 i = 16; i < 64; i++)
 				{
-					F = (b & c) | ((~b) & d);
-					g = 0x5A827999;
+					const uint32 s0 = rightRotate32(w[i - 15], 7) ^ rightRotate32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+					const uint32 s1 = rightRotate32(w[i - 2], 17) ^ rightRotate32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+					w[i] = w[i - 16] + s0 + w[i - 7] + s1;
 				}
-				else if (i < 40)
+
+				uint32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+				for (uint32 i = 0; i < 64; i++)
 				{
-					F = b ^ c ^ d;
-					g = 0x6ED9EBA1;
+					const uint32 s1 = rightRotate32(e, 6) ^ rightRotate32(e, 11) ^ rightRotate32(e, 25);
+					const uint32 ch = (e & f) ^ ((~e) & g);
+					const uint32 temp1 = h + s1 + ch + Sha256K[i] + w[i];
+					const uint32 s0 = rightRotate32(a, 2) ^ rightRotate32(a, 13) ^ rightRotate32(a, 22);
+					const uint32 maj = (a & b) ^ (a & c) ^ (b & c);
+					const uint32 temp2 = s0 + maj;
+					h = g;
+					g = f;
+					f = e;
+					e = d + temp1;
+					d = c;
+					c = b;
+					b = a;
+					a = temp1 + temp2;
 				}
-				else if (i < 60)
+				state[0] += a;
+				state[1] += b;
+				state[2] += c;
+				state[3] += d;
+				state[4] += e;
+				state[5] += f;
+				state[6] += g;
+				state[7] += h;
+			}
+		}
+
+#ifdef CAGE_HASHES_X86
+		bool detectShaExtensions()
+		{
+#ifdef _MSC_VER
+			int regs[4] = {};
+			__cpuid(regs, 0);
+			if (regs[0] < 7)
+				return false;
+			__cpuidex(regs, 7, 0);
+			const bool sha = regs[1] & (1 << 29);
+			__cpuid(regs, 1);
+			const bool sse41 = regs[2] & (1 << 19);
+			const bool ssse3 = regs[2] & (1 << 9);
+#else
+			unsigned a = 0, b = 0, c = 0, d = 0;
+			if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+				return false;
+			const bool sha = b & (1u << 29);
+			if (!__get_cpuid(1, &a, &b, &c, &d))
+				return false;
+			const bool sse41 = c & (1u << 19);
+			const bool ssse3 = c & (1u << 9);
+#endif
+			return sha && sse41 && ssse3;
+		}
+
+		bool useShaExtensions()
+		{
+			static const bool available = detectShaExtensions();
+			return available && confHardware;
+		}
+
+		CAGE_HASHES_SHA_TARGET void sha1Hardware(uint32 state[5], const uint8 *data, uintPtr blocksCount)
+		{
+			const __m128i mask = _mm_set_epi64x(0x0001020304050607ull, 0x08090a0b0c0d0e0full);
+			__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1B);
+			__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+			__m128i e1;
+			__m128i msg[4];
+
+			for (uintPtr block = 0; block < blocksCount; block++, data += 64)
+			{
+				const __m128i abcdSave = abcd;
+				const __m128i e0Save = e0;
+
+				// 20 groups of 4 rounds, the message schedule runs ahead of the rounds
+				for (uint32 g = 0; g < 20; g++)
 				{
-					F = (b & c) | (b & d) | (c & d);
-					g = 0x8F1BBCDC;
+					__m128i &cur = msg[g % 4];
+					if (g < 4)
+						cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + g * 16)), mask);
+					__m128i &e = (g % 2) ? e1 : e0;
+					if (g == 0)
+						e = _mm_add_epi32(e, cur);
+					else
+						e = _mm_sha1nexte_epu32(e, cur);
+					((g % 2) ? e0 : e1) = abcd;
+					if (g >= 3 && g <= 18)
+						msg[(g + 1) % 4] = _mm_sha1msg2_epu32(msg[(g + 1) % 4], cur);
+					switch (g / 5)
+					{
+					case 0: abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break;
+					case 1: abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break;
+					case 2: abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break;
+					default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break;
+					}
+					if (g >= 1 && g <= 16)
+						msg[(g + 3) % 4] = _mm_sha1msg1_epu32(msg[(g + 3) % 4], cur);
+					if (g >= 2 && g <= 17)
+						msg[(g + 2) % 4] = _mm_xor_si128(msg[(g + 2) % 4], cur);
 				}
-				else
+
+				e0 = _mm_sha1nexte_epu32(e0, e0Save);
+				abcd = _mm_add_epi32(abcd, abcdSave);
+			}
+
+			_mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1B));
+			state[4] = _mm_extract_epi32(e0, 3);
+		}
+
+		CAGE_HASHES_SHA_TARGET void sha256Hardware(uint32 state[8], const uint8 *data, uintPtr blocksCount)
+		{
+			const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+			__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1); // CDAB
+			__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B); // EFGH
+			__m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+			state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+			__m128i msg[4];
+
+			for (uintPtr block = 0; block < blocksCount; block++, data += 64)
+			{
+				const __m128i abefSave = state0;
+				const __m128i cdghSave = state1;
+
+				// 16 groups of 4 rounds, the message schedule runs ahead of the rounds
+				for (uint32 g = 0; g < 16; g++)
 				{
-					F = b ^ c ^ d;
-					g = 0xCA62C1D6;
+					__m128i &cur = msg[g % 4];
+					if (g < 4)
+						cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + g * 16)), mask);
+					__m128i m = _mm_add_epi32(cur, _mm_load_si128((const __m128i *)(Sha256K + g * 4)));
+					state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+					if (g >= 3 && g <= 14)
+					{
+						__m128i &next = msg[(g + 1) % 4];
+						next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msg[(g + 3) % 4], 4));
+						next = _mm_sha256msg2_epu32(next, cur);
+					}
+					m = _mm_shuffle_epi32(m, 0x0E);
+					state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+					if (g >= 1 && g <= 12)
+						msg[(g + 3) % 4] = _mm_sha256msg1_epu32(msg[(g + 3) % 4], cur);
 				}
 
-				const uint32 temp = leftRotate32bits(a, 5) + F + e + g + blocks[i];
-				e = d;
-				d = c;
-				c = leftRotate32bits(b, 30);
-				b = a;
-				a = temp;
+				state0 = _mm_add_epi32(state0, abefSave);
+				state1 = _mm_add_epi32(state1, cdghSave);
 			}
 
-			h0 += a;
-			h1 += b;
-			h2 += c;
-			h3 += d;
-			h4 += e;
+			tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+			state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+			state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+			state1 = _mm_alignr_epi8(state1, tmp, 8); // ABEF
+			_mm_storeu_si128((__m128i *)&state[0], state0);
+			_mm_storeu_si128((__m128i *)&state[4], state1);
+		}
+#else
+		bool useShaExtensions()
+		{
+			return false;
+		}
+#endif // CAGE_HASHES_X86
+
+		// full blocks are processed directly from the input, only the tail is copied for padding
+		template<uint32 N>
+		std::array<uint8, N * 4> shaImpl(PointerRange<const char> data, uint32 (&state)[N], void (*blocks)(uint32[N], const uint8 *, uintPtr))
+		{
+			const uint8 *p = (const uint8 *)data.begin();
+			const uintPtr full = data.size() / 64;
+			blocks(state, p, full);
+
+			uint8 tail[128] = {};
+			const uintPtr rest = data.size() - full * 64;
+			if (rest)
+				std::memcpy(tail, p + full * 64, rest);
+			tail[rest] = 0x80;
+			const uintPtr tailSize = rest < 56 ? 64 : 128;
+			const uint64 bits = uint64(data.size()) * 8;
+			for (uint32 i = 0; i < 8; i++)
+				tail[tailSize - 8 + i] = uint8(bits >> (56 - 8 * i));
+			blocks(state, tail, tailSize / 64);
+
+			std::array<uint8, N * 4> sig = {};
+			for (uint32 i = 0; i < N; i++)
+				for (uint32 j = 0; j < 4; j++)
+					sig[i * 4 + j] = uint8(state[i] >> (24 - 8 * j));
+			return sig;
 		}
+	}
+
+	uint64 hash64(PointerRange<const char> data, uint64 seed) noexcept
+	{
+		return hashImpl<false>(data, seed);
+	}
+
+	std::array<uint8, 16> hash128(PointerRange<const char> data, uint64 seed) noexcept
+	{
+		return toBytes(hashImpl<false>(data, seed), hashImpl<true>(data, seed));
+	}
+
+	HashStream::HashStream(uint64 seed) noexcept : seed(seed)
+	{
+		initAccumulators(acc, seed);
+	}
 
-		std::array<uint8, 20> sig = {};
-		for (uint8 i = 0; i < 4; i++)
+	void HashStream::update(PointerRange<const char> data) noexcept
+	{
+		const uint8 *p = (const uint8 *)data.begin();
+		const uint8 *e = (const uint8 *)data.end();
+		total += data.size();
+		if (buffered)
 		{
-			sig[i] = (h0 >> (24 - 8 * i)) & 0xFF;
-			sig[i + 4] = (h1 >> (24 - 8 * i)) & 0xFF;
-			sig[i + 8] = (h2 >> (24 - 8 * i)) & 0xFF;
-			sig[i + 12] = (h3 >> (24 - 8 * i)) & 0xFF;
-			sig[i + 16] = (h4 >> (24 - 8 * i)) & 0xFF;
+			const uint32 n = numeric_cast<uint32>(std::min(uintPtr(32 - buffered), uintPtr(e - p)));
+			if (n)
+				std::memcpy(buffer + buffered, p, n);
+			buffered += n;
+			p += n;
+			if (buffered < 32)
+				return;
+			stripes(acc, buffer, buffer + 32);
+			buffered = 0;
 		}
-		return sig;
+		p = stripes(acc, p, e);
+		buffered = numeric_cast<uint32>(e - p);
+		if (buffered)
+			std::memcpy(buffer, p, buffered);
+	}
+
+	uint64 HashStream::hash64() const noexcept
+	{
+		return finalize(acc, total, seed, buffer, buffer + buffered, false);
+	}
+
+	std::array<uint8, 16> HashStream::hash128() const noexcept
+	{
+		return toBytes(finalize(acc, total, seed, buffer, buffer + buffered, false), finalize(acc, total, seed, buffer, buffer + buffered, true));
+	}
+
+	std::array<uint8, 20> hashSha1(PointerRange<const char> data)
+	{
+		uint32 state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+#ifdef CAGE_HASHES_X86
+		if (useShaExtensions())
+			return shaImpl(data, state, &sha1Hardware);
+#endif
+		return shaImpl(data, state, &sha1Software);
+	}
+
+	std::array<uint8, 32> hashSha256(PointerRange<const char> data)
+	{
+		uint32 state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+#ifdef CAGE_HASHES_X86
+		if (useShaExtensions())
+			return shaImpl(data, state, &sha256Hardware);
+#endif
+		return shaImpl(data, state, &sha256Software);
 	}
 
 	String hashToHexadecimal(PointerRange<const uint8> data)
@@ -1,60 +1,119 @@
 #include "image.h"
 
+#include <cage-core/imageAlgorithms.h>
 #include <cage-core/imageBlocks.h>
+#include <cage-core/pointerRangeHolder.h>
 #include <cage-core/serialization.h>
+#include <cage-core/tasks.h>
 #include <basis_universal/encoder/basisu_gpu_texture.h>
 #include <vector>
 
 namespace cage
 {
+	namespace
+	{
+		// bcn blocks are encoded independently of each other
+		// the image is split into horizontal strips of whole block rows, which are encoded in parallel and concatenated
+		// the strip height is fixed (independent of the number of threads) so that the output is deterministic
+		constexpr uint32 StripBlockRows = 16;
+		constexpr uint32 StripHeight = StripBlockRows * 4;
+
+		Holder<PointerRange<char>> bcnEncodeSingle(const Image *image, const ImageKtxEncodeConfig &config, ImageKtxTranscodeFormatEnum format)
+		{
+			const Image *imgs[1] = { image };
+			ImageKtxTranscodeConfig cfg2;
+			cfg2.format = format;
+			return std::move(imageKtxTranscode(imgs, config, cfg2)[0].data);
+		}
+
+		struct StripsEncoder
+		{
+			const Image *image = nullptr;
+			const ImageKtxEncodeConfig &config;
+			const ImageKtxTranscodeFormatEnum format;
+			std::vector<Holder<PointerRange<char>>> results;
+
+			StripsEncoder(const Image *image, const ImageKtxEncodeConfig &config, ImageKtxTranscodeFormatEnum format) : image(image), config(config), format(format)
+			{
+				results.resize((image->height() + StripHeight - 1) / StripHeight);
+			}
+
+			void operator() (uint32 idx)
+			{
+				const uint32 y = idx * StripHeight;
+				const uint32 h = min(StripHeight, image->height() - y);
+				Holder<Image> strip = newImage();
+				imageBlit(image, +strip, 0, y, 0, 0, image->width(), h);
+				results[idx] = bcnEncodeSingle(+strip, config, format);
+			}
+
+			Holder<PointerRange<char>> concatenate() const
+			{
+				uintPtr total = 0;
+				for (const auto &it : results)
+					total += it.size();
+				PointerRangeHolder<char> buff;
+				buff.resize(total);
+				char *dst = buff.data();
+				for (const auto &it : results)
+				{
+					detail::memcpy(dst, it.data(), it.size());
+					dst += it.size();
+				}
+				return buff;
+			}
+		};
+
+		Holder<PointerRange<char>> bcnEncode(const Image *image, const ImageKtxEncodeConfig &config, ImageKtxTranscodeFormatEnum format)
+		{
+			if (image->height() <= StripHeight)
+				return bcnEncodeSingle(image, config, format);
+			StripsEncoder encoder(image, config, format);
+			if (config.parallelize)
+				tasksRunBlocking<StripsEncoder>("bcn encode", encoder, numeric_cast<uint32>(encoder.results.size()));
+			else
+			{
+				const uint32 cnt = numeric_cast<uint32>(encoder.results.size());
+				for (uint32 i = 0; i < cnt; i++)
+					encoder(i);
+			}
+			return encoder.concatenate();
+		}
+	}
+
 	Holder<PointerRange<char>> imageBc1Encode(const Image *image, const ImageKtxEncodeConfig &config)
 	{
 		if (image->channels() != 3)
 			CAGE_THROW_ERROR(Exception, "invalid number of channels for bc1 encoding");
-		const Image *imgs[1] = { image };
-		ImageKtxTranscodeConfig cfg2;
-		cfg2.format = ImageKtxTranscodeFormatEnum::Bc1;
-		return std::move(imageKtxTranscode(imgs, config, cfg2)[0].data);
+		return bcnEncode(image, config, ImageKtxTranscodeFormatEnum::Bc1);
 	}
 
 	Holder<PointerRange<char>> imageBc3Encode(const Image *image, const ImageKtxEncodeConfig &config)
 	{
 		if (image->channels() != 4)
 			CAGE_THROW_ERROR(Exception, "invalid number of channels for bc3 encoding");
-		const Image *imgs[1] = { image };
-		ImageKtxTranscodeConfig cfg2;
-		cfg2.format = ImageKtxTranscodeFormatEnum::Bc3;
-		return std::move(imageKtxTranscode(imgs, config, cfg2)[0].data);
+		return bcnEncode(image, config, ImageKtxTranscodeFormatEnum::Bc3);
 	}
 
 	Holder<PointerRange<char>> imageBc4Encode(const Image *image, const ImageKtxEncodeConfig &config)
 	{
 		if (image->channels() != 1)
 			CAGE_THROW_ERROR(Exception, "invalid number of channels for bc4 encoding");
-		const Image *imgs[1] = { image };
-		ImageKtxTranscodeConfig cfg2;
-		cfg2.format = ImageKtxTranscodeFormatEnum::Bc4;
-		return std::move(imageKtxTranscode(imgs, config, cfg2)[0].data);
+		return bcnEncode(image, config, ImageKtxTranscodeFormatEnum::Bc4);
 	}
 
 	Holder<PointerRange<char>> imageBc5Encode(const Image *image, const ImageKtxEncodeConfig &config)
 	{
 		if (image->channels() != 2)
 			CAGE_THROW_ERROR(Exception, "invalid number of channels for bc5 encoding");
-		const Image *imgs[1] = { image };
-		ImageKtxTranscodeConfig cfg2;
-		cfg2.format = ImageKtxTranscodeFormatEnum::Bc5;
-		return std::move(imageKtxTranscode(imgs, config, cfg2)[0].data);
+		return bcnEncode(image, config, ImageKtxTranscodeFormatEnum::Bc5);
 	}
 
 	Holder<PointerRange<char>> imageBc7Encode(const Image *image, const ImageKtxEncodeConfig &config)
 	{
 		if (image->channels() != 3 && image->channels() != 4)
 			CAGE_THROW_ERROR(Exception, "invalid number of channels for bc7 encoding");
-		const Image *imgs[1] = { image };
-		ImageKtxTranscodeConfig cfg2;
-		cfg2.format = ImageKtxTranscodeFormatEnum::Bc7;
-		return std::move(imageKtxTranscode(imgs, config, cfg2)[0].data);
+		return bcnEncode(image, config, ImageKtxTranscodeFormatEnum::Bc7);
 	}
 
 	namespace
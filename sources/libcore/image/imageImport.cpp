@@ -3,6 +3,9 @@
 #include <cage-core/imageImport.h>
 #include <cage-core/imageBlocks.h>
 #include <cage-core/pointerRangeHolder.h>
+#include <cage-core/tasks.h>
+
+#include <vector>
 
 namespace cage
 {
@@ -79,42 +82,61 @@ namespace cage
 		}
 	}
 
-	void imageImportConvertImagesToBcn(ImageImportResult &result, bool normals)
+	namespace
 	{
-		for (ImageImportPart &part : result.parts)
+		void convertPartToBcn(ImageImportPart &part, bool normals)
 		{
-			if (part.image && !part.raw)
+			ImageImportRaw r;
+			r.colorConfig = part.image->colorConfig;
+			r.resolution = part.image->resolution();
+			r.channels = part.image->channels();
+			switch (part.image->channels())
 			{
-				ImageImportRaw r;
-				r.colorConfig = part.image->colorConfig;
-				r.resolution = part.image->resolution();
-				r.channels = part.image->channels();
-				switch (part.image->channels())
-				{
-				case 1:
-					r.format = "bc4";
-					r.data = imageBc4Encode(+part.image, { normals });
-					break;
-				case 2:
-					r.format = "bc5";
-					r.data = imageBc5Encode(+part.image, { normals });
-					break;
-				case 3:
-					r.format = "bc7";
-					r.data = imageBc7Encode(+part.image, { normals });
-					break;
-				case 4:
-					r.format = "bc7";
-					r.data = imageBc7Encode(+part.image, { normals });
-					break;
-				default:
-					CAGE_THROW_ERROR(Exception, "unsupported number of channels for image-to-bcn conversion");
-				}
-				CAGE_ASSERT(r.data);
-				part.raw = systemMemory().createHolder<ImageImportRaw>(std::move(r));
-				part.image.clear();
+			case 1:
+				r.format = "bc4";
+				r.data = imageBc4Encode(+part.image, { normals });
+				break;
+			case 2:
+				r.format = "bc5";
+				r.data = imageBc5Encode(+part.image, { normals });
+				break;
+			case 3:
+				r.format = "bc7";
+				r.data = imageBc7Encode(+part.image, { normals });
+				break;
+			case 4:
+				r.format = "bc7";
+				r.data = imageBc7Encode(+part.image, { normals });
+				break;
+			default:
+				CAGE_THROW_ERROR(Exception, "unsupported number of channels for image-to-bcn conversion");
 			}
+			CAGE_ASSERT(r.data);
+			part.raw = systemMemory().createHolder<ImageImportRaw>(std::move(r));
+			part.image.clear();
 		}
+
+		struct BcnConverter
+		{
+			std::vector<ImageImportPart *> parts;
+			bool normals = false;
+
+			void operator() (uint32 idx)
+			{
+				convertPartToBcn(*parts[idx], normals);
+			}
+		};
+	}
+
+	void imageImportConvertImagesToBcn(ImageImportResult &result, bool normals)
+	{
+		// all mipmap levels, cube faces and layers are encoded concurrently, each of them writes into its own part only
+		BcnConverter converter;
+		converter.normals = normals;
+		for (ImageImportPart &part : result.parts)
+			if (part.image && !part.raw)
+				converter.parts.push_back(&part);
+		tasksRunBlocking<BcnConverter>("image import bcn", converter, numeric_cast<uint32>(converter.parts.size()));
 	}
 
 	void imageImportGenerateMipmaps(ImageImportResult &result)
@@ -8,12 +8,22 @@
 #include <cage-core/string.h>
 
 #include <cstdio>
+#include <cstdlib>
+#include <csignal>
 #include <exception>
 #include <chrono>
 #include <ctime>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 
 #ifdef CAGE_SYSTEM_WINDOWS
 #include "incWin.h" // SetConsoleCP
+#include <io.h> // _write
+#else
+#include <unistd.h> // write
 #endif
 
 namespace cage
@@ -43,11 +53,21 @@ namespace cage
 			return l;
 		}
 
+		// shared by loggers and records, records are delivered to loggers created before them only
+		std::atomic<uint64> &loggerSequence()
+		{
+			static std::atomic<uint64> s = 0;
+			return s;
+		}
+
+		void asyncFlushForLogger();
+
 		class LoggerImpl : public Logger
 		{
 		public:
 			LoggerImpl *prev = nullptr, *next = nullptr;
 			const uint64 thread = currentThreadId();
+			const uint64 sequence = loggerSequence()++;
 
 			LoggerImpl()
 			{
@@ -63,6 +83,7 @@ namespace cage
 
 			~LoggerImpl()
 			{
+				asyncFlushForLogger();
 				ScopeLock l(loggerMutex());
 				if (prev)
 					prev->next = next;
@@ -74,6 +95,411 @@ namespace cage
 		};
 	}
 
+	namespace
+	{
+		// requires locked loggerMutex
+		void dispatch(detail::LoggerInfo &info, uint64 sequence)
+		{
+			LoggerImpl *cur = loggerLast();
+			while (cur)
+			{
+				const auto ou = cur->output; // keep a copy in case the configuration changed mid-way
+				if (ou && cur->sequence < sequence)
+				{
+					const auto fi = cur->filter;
+					info.createThreadId = cur->thread;
+					if (!fi || fi(info))
+					{
+						const auto fo = cur->format;
+						if (fo)
+							fo(info, ou);
+						else
+							ou(info.message);
+					}
+				}
+
+				cur = cur->prev;
+			}
+		}
+
+		struct AsyncRecord
+		{
+			detail::LoggerInfo info;
+			uint64 sequence = 0;
+		};
+
+		// single producer (the owning thread), single consumer (the writer thread)
+		struct AsyncRing : private Immovable
+		{
+			std::vector<AsyncRecord> records;
+			std::atomic<uint32> head = 0; // written by producer
+			std::atomic<uint32> tail = 0; // written by consumer
+			std::atomic<bool> finished = false;
+			const uint32 generation = 0;
+
+			explicit AsyncRing(uint32 capacity, uint32 generation) : generation(generation)
+			{
+				records.resize(std::max(capacity, 1u));
+			}
+
+			uint32 capacity() const noexcept
+			{
+				return numeric_cast<uint32>(records.size());
+			}
+
+			uint32 used() const noexcept
+			{
+				return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire);
+			}
+
+			void push(detail::LoggerInfo &&info, uint64 sequence) noexcept
+			{
+				const uint32 h = head.load(std::memory_order_relaxed);
+				AsyncRecord &r = records[h % capacity()];
+				r.info = std::move(info);
+				r.sequence = sequence;
+				head.store(h + 1, std::memory_order_release);
+			}
+
+			void drain(std::vector<AsyncRecord> &out)
+			{
+				const uint32 h = head.load(std::memory_order_acquire);
+				uint32 t = tail.load(std::memory_order_relaxed);
+				for (; t != h; t++)
+					out.push_back(std::move(records[t % capacity()]));
+				tail.store(t, std::memory_order_release);
+			}
+
+			bool empty() const noexcept
+			{
+				return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+			}
+		};
+
+		struct AsyncRingHandle : private Immovable
+		{
+			Holder<AsyncRing> ring;
+
+			~AsyncRingHandle()
+			{
+				if (ring)
+					ring->finished = true;
+			}
+		};
+
+		thread_local AsyncRingHandle asyncRingHandle;
+
+		void writeStdErrSignalSafe(const char *str, uintPtr len) noexcept
+		{
+#ifdef CAGE_SYSTEM_WINDOWS
+			_write(2, str, numeric_cast<unsigned int>(len));
+#else
+			[[maybe_unused]] auto r = ::write(2, str, len);
+#endif
+		}
+
+		void installCrashHandlers();
+
+		// using std mutex etc to avoid logging from within cage::Mutex
+		class AsyncLogger : private Immovable
+		{
+		public:
+			std::atomic<bool> enabled = false;
+
+			void enable(const LoggerAsyncConfig &cfg)
+			{
+				std::unique_lock controlLock(control);
+				if (thread)
+					disableImpl();
+				if (cfg.capacityPerThread != config.capacityPerThread)
+				{
+					// threads replace their rings on next record, the old rings were drained when disabled
+					ringsGeneration++;
+					std::unique_lock lock(mutex);
+					rings.clear();
+				}
+				config = cfg;
+				{
+					std::unique_lock lock(mutex);
+					stopping = false;
+					running = true;
+				}
+				thread = newThread(Delegate<void()>().bind<AsyncLogger, &AsyncLogger::threadEntry>(this), "log writer");
+				writerThreadId = thread->id();
+				enabled = true;
+				static int registerHandlers = []() { std::atexit(+[]() { loggerAsyncDisable(); }); installCrashHandlers(); return 0; }();
+				(void)registerHandlers;
+			}
+
+			void disable()
+			{
+				std::unique_lock controlLock(control);
+				disableImpl();
+			}
+
+			void flush()
+			{
+				if (!enabled || currentThreadId() == writerThreadId)
+					return;
+				std::unique_lock lock(mutex);
+				const uint64 target = ++requestedGeneration;
+				writerCond.notify_one();
+				flushedCond.wait(lock, [&]() { return completedGeneration >= target || !running; });
+			}
+
+			// used from std::terminate, the writer thread may be stuck, therefore the wait is limited
+			void flushBounded() noexcept
+			{
+				try
+				{
+					if (!enabled || currentThreadId() == writerThreadId)
+						return;
+					std::unique_lock lock(mutex, std::defer_lock);
+					const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+					while (!lock.try_lock())
+					{
+						if (std::chrono::steady_clock::now() > deadline)
+							return;
+						threadYield();
+					}
+					const uint64 target = ++requestedGeneration;
+					writerCond.notify_one();
+					flushedCond.wait_for(lock, std::chrono::seconds(2), [&]() { return completedGeneration >= target || !running; });
+				}
+				catch (...)
+				{
+					// nothing
+				}
+			}
+
+			// used from fatal signal handlers, must be async-signal-safe
+			// writes unformatted messages of records that the writer thread has not yet taken, without any locks
+			void drainSignalSafe() noexcept
+			{
+				if (!enabled.exchange(false))
+					return;
+				for (const Holder<AsyncRing> &r : rings)
+				{
+					const uint32 h = r->head.load(std::memory_order_acquire);
+					for (uint32 t = r->tail.load(std::memory_order_acquire); t != h; t++)
+					{
+						const String &msg = r->records[t % r->capacity()].info.message;
+						writeStdErrSignalSafe(msg.c_str(), msg.length());
+						writeStdErrSignalSafe("\n", 1);
+					}
+				}
+			}
+
+			// returns false if the record must be dispatched synchronously
+			bool enqueue(detail::LoggerInfo &info)
+			{
+				if (!enabled.load(std::memory_order_relaxed))
+					return false;
+				if (currentThreadId() == writerThreadId)
+					return false; // logging from inside the writer thread (eg. failing output)
+				if (info.severity == SeverityEnum::Critical)
+				{
+					flush();
+					return false;
+				}
+
+				struct InFlight : private Immovable
+				{
+					std::atomic<uint32> &cnt;
+					explicit InFlight(std::atomic<uint32> &cnt) : cnt(cnt) { cnt++; }
+					~InFlight() { cnt--; }
+				} inFlightGuard(inFlight);
+				if (!enabled)
+					return false;
+
+				AsyncRing *r = ring();
+				while (r->used() >= r->capacity())
+				{
+					if (config.overflow == LoggerAsyncOverflowEnum::Drop)
+					{
+						dropped++;
+						return true;
+					}
+					std::unique_lock lock(mutex);
+					writerCond.notify_one();
+					producersCond.wait_for(lock, std::chrono::milliseconds(5), [&]() { return r->used() < r->capacity() || !enabled; });
+					if (!enabled)
+						return false;
+				}
+				r->push(std::move(info), loggerSequence()++);
+				if (r->used() * 2 >= r->capacity())
+					writerCond.notify_one();
+				return true;
+			}
+
+		private:
+			std::mutex control; // serializes enable and disable
+			std::mutex mutex;
+			std::condition_variable writerCond, producersCond, flushedCond;
+			std::vector<Holder<AsyncRing>> rings; // guarded by mutex
+			LoggerAsyncConfig config;
+			Holder<Thread> thread;
+			std::atomic<uint64> writerThreadId = m;
+			std::atomic<uint32> ringsGeneration = 0;
+			std::atomic<uint32> inFlight = 0;
+			std::atomic<uint32> dropped = 0;
+			uint64 requestedGeneration = 0; // guarded by mutex
+			uint64 completedGeneration = 0; // guarded by mutex
+			bool stopping = false; // guarded by mutex
+			bool running = false; // guarded by mutex
+
+			void disableImpl()
+			{
+				if (!thread)
+					return;
+				enabled = false;
+				while (inFlight > 0)
+					threadYield();
+				{
+					std::unique_lock lock(mutex);
+					stopping = true;
+				}
+				writerCond.notify_one();
+				thread->wait();
+				thread.clear();
+				writerThreadId = (uint64)m;
+			}
+
+			AsyncRing *ring()
+			{
+				const uint32 gen = ringsGeneration.load(std::memory_order_relaxed);
+				if (!asyncRingHandle.ring || asyncRingHandle.ring->generation != gen) [[unlikely]]
+				{
+					if (asyncRingHandle.ring)
+						asyncRingHandle.ring->finished = true;
+					Holder<AsyncRing> r = systemMemory().createHolder<AsyncRing>(config.capacityPerThread, gen);
+					std::unique_lock lock(mutex);
+					rings.push_back(r.share());
+					asyncRingHandle.ring = std::move(r);
+				}
+				return +asyncRingHandle.ring;
+			}
+
+			void threadEntry()
+			{
+				std::vector<AsyncRecord> batch;
+				batch.reserve(1000);
+				while (true)
+				{
+					uint64 generation = 0;
+					bool stop = false;
+					std::vector<Holder<AsyncRing>> rs;
+					{
+						std::unique_lock lock(mutex);
+						writerCond.wait_for(lock, std::chrono::milliseconds(20), [&]() { return stopping || requestedGeneration != completedGeneration; });
+						generation = requestedGeneration;
+						stop = stopping;
+						std::erase_if(rings, [](const Holder<AsyncRing> &r) { return r->finished && r->empty(); });
+						rs.reserve(rings.size());
+						for (const auto &r : rings)
+							rs.push_back(r.share());
+					}
+
+					for (const auto &r : rs)
+						r->drain(batch);
+					producersCond.notify_all();
+
+					if (!batch.empty())
+					{
+						std::sort(batch.begin(), batch.end(), [](const AsyncRecord &a, const AsyncRecord &b) { return a.sequence < b.sequence; });
+						ScopeLock l(loggerMutex());
+						for (AsyncRecord &r : batch)
+						{
+							try
+							{
+								dispatch(r.info, r.sequence);
+							}
+							catch (...)
+							{
+								detail::debugOutput("ignoring asynchronous log exception");
+							}
+						}
+						batch.clear();
+					}
+
+					if (const uint32 d = dropped.exchange(0))
+						CAGE_LOG(SeverityEnum::Warning, "log", Stringizer() + "dropped " + d + " log records");
+
+					{
+						std::unique_lock lock(mutex);
+						completedGeneration = generation;
+						if (stop)
+							running = false;
+					}
+					flushedCond.notify_all();
+					if (stop)
+						break;
+				}
+			}
+		};
+
+		AsyncLogger &asyncLogger()
+		{
+			static AsyncLogger *a = new AsyncLogger(); // this leak is intentional
+			return *a;
+		}
+
+		void asyncFlushForLogger()
+		{
+			asyncLogger().flush();
+		}
+
+		std::terminate_handler previousTerminateHandler = nullptr;
+
+		void terminateHandler()
+		{
+			asyncLogger().flushBounded();
+			if (previousTerminateHandler)
+				previousTerminateHandler();
+			std::abort();
+		}
+
+		constexpr int CrashSignals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+		using SignalHandler = void (*)(int);
+		SignalHandler previousSignalHandlers[sizeof(CrashSignals) / sizeof(CrashSignals[0])] = {};
+
+		void signalHandler(int sig)
+		{
+			asyncLogger().drainSignalSafe();
+			for (uint32 i = 0; i < sizeof(CrashSignals) / sizeof(CrashSignals[0]); i++)
+			{
+				if (CrashSignals[i] == sig)
+				{
+					const SignalHandler prev = previousSignalHandlers[i];
+					std::signal(sig, prev == SIG_ERR || prev == nullptr ? SIG_DFL : prev);
+				}
+			}
+			std::raise(sig);
+		}
+
+		void installCrashHandlers()
+		{
+			previousTerminateHandler = std::set_terminate(&terminateHandler);
+			for (uint32 i = 0; i < sizeof(CrashSignals) / sizeof(CrashSignals[0]); i++)
+				previousSignalHandlers[i] = std::signal(CrashSignals[i], &signalHandler);
+		}
+	}
+
+	void loggerAsyncEnable(const LoggerAsyncConfig &config)
+	{
+		asyncLogger().enable(config);
+	}
+
+	void loggerAsyncDisable()
+	{
+		asyncLogger().disable();
+	}
+
+	void loggerAsyncFlush()
+	{
+		asyncLogger().flush();
+	}
+
 	Holder<Logger> newLogger()
 	{
 		return systemMemory().createImpl<Logger, LoggerImpl>();
@@ -186,31 +612,14 @@ namespace cage
 				info.currentThreadName = currentThreadName();
 				info.time = applicationTime();
 
+				const uint64 time = info.time;
+				if (!asyncLogger().enqueue(info))
 				{
 					ScopeLock l(loggerMutex());
-					LoggerImpl *cur = loggerLast();
-					while (cur)
-					{
-						const auto ou = cur->output; // keep a copy in case the configuration changed mid-way
-						if (ou)
-						{
-							const auto fi = cur->filter;
-							info.createThreadId = cur->thread;
-							if (!fi || fi(info))
-							{
-								const auto fo = cur->format;
-								if (fo)
-									fo(info, ou);
-								else
-									ou(info.message);
-							}
-						}
-
-						cur = cur->prev;
-					}
+					dispatch(info, m);
 				}
 
-				return info.time;
+				return time;
 			}
 			catch (...)
 			{
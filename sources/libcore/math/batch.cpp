@@ -0,0 +1,104 @@
+#include "math.h"
+
+namespace cage
+{
+	namespace
+	{
+		CAGE_FORCE_INLINE const float *floats(const Mat4 &m)
+		{
+			return &m.data[0].value;
+		}
+
+		template<class A, class B>
+		CAGE_FORCE_INLINE void checkSizes(PointerRange<A> a, PointerRange<B> b)
+		{
+			if (a.size() != b.size())
+				CAGE_THROW_ERROR(Exception, "mismatched sizes of input and output ranges");
+		}
+	}
+
+	void transformPoints(const Mat4 &m, PointerRange<const Vec3> in, PointerRange<Vec3> out)
+	{
+		checkSizes(in, out);
+		const uintPtr cnt = in.size();
+		const Vec3 *src = in.data();
+		Vec3 *dst = out.data();
+#if defined(CAGE_SIMD_SSE)
+		const __m128 c0 = _mm_loadu_ps(floats(m) + 0);
+		const __m128 c1 = _mm_loadu_ps(floats(m) + 4);
+		const __m128 c2 = _mm_loadu_ps(floats(m) + 8);
+		const __m128 c3 = _mm_loadu_ps(floats(m) + 12);
+		for (uintPtr i = 0; i < cnt; i++)
+		{
+			const float *p = &src[i].data[0].value;
+			// same order of operations as mat4MulColumns with w = 1
+			__m128 a = _mm_mul_ps(c0, _mm_set1_ps(p[0]));
+			a = _mm_add_ps(a, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+			a = _mm_add_ps(a, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+			a = _mm_add_ps(a, c3);
+			alignas(16) float r[4];
+			_mm_store_ps(r, a);
+			dst[i] = Vec3(r[0], r[1], r[2]);
+		}
+#elif defined(CAGE_SIMD_NEON)
+		const float32x4_t c0 = vld1q_f32(floats(m) + 0);
+		const float32x4_t c1 = vld1q_f32(floats(m) + 4);
+		const float32x4_t c2 = vld1q_f32(floats(m) + 8);
+		const float32x4_t c3 = vld1q_f32(floats(m) + 12);
+		for (uintPtr i = 0; i < cnt; i++)
+		{
+			const float *p = &src[i].data[0].value;
+			// same order of operations as mat4MulColumns with w = 1
+			float32x4_t a = vmulq_n_f32(c0, p[0]);
+			a = vaddq_f32(a, vmulq_n_f32(c1, p[1]));
+			a = vaddq_f32(a, vmulq_n_f32(c2, p[2]));
+			a = vaddq_f32(a, c3);
+			float r[4];
+			vst1q_f32(r, a);
+			dst[i] = Vec3(r[0], r[1], r[2]);
+		}
+#else
+		for (uintPtr i = 0; i < cnt; i++)
+			dst[i] = Vec3(m * Vec4(src[i], 1));
+#endif
+	}
+
+	void transformPoints(const Transform &t, PointerRange<const Vec3> in, PointerRange<Vec3> out)
+	{
+		transformPoints(Mat4(t), in, out);
+	}
+
+	void transformVectors(const Mat4 &m, PointerRange<const Vec4> in, PointerRange<Vec4> out)
+	{
+		checkSizes(in, out);
+		if (in.empty())
+			return;
+		const Mat4 l = m; // the output may overlap the matrix
+		privat::mat4MulColumns(floats(l), &in[0].data[0].value, &out[0].data[0].value, numeric_cast<uint32>(in.size()));
+	}
+
+	void multiplyMatrices(const Mat4 &l, PointerRange<const Mat4> r, PointerRange<Mat4> out)
+	{
+		checkSizes(r, out);
+		if (r.empty())
+			return;
+		const Mat4 a = l; // the output may overlap the left matrix
+		// columns of all right matrices are processed as one continuous sequence
+		privat::mat4MulColumns(floats(a), floats(r[0]), &out[0].data[0].value, numeric_cast<uint32>(r.size() * 4));
+	}
+
+	void multiplyMatrices(PointerRange<const Mat4> l, PointerRange<const Mat4> r, PointerRange<Mat4> out)
+	{
+		checkSizes(l, r);
+		checkSizes(l, out);
+		for (uintPtr i = 0; i < l.size(); i++)
+			out[i] = l[i] * r[i];
+	}
+
+	void transformsToMatrices(PointerRange<const Transform> in, PointerRange<Mat4> out)
+	{
+		checkSizes(in, out);
+		for (uintPtr i = 0; i < in.size(); i++)
+			out[i] = Mat4(in[i]);
+	}
+}
@@ -14,28 +14,6 @@ namespace cage
 		return data;
 	}
 
-	Mat3::Mat3(const Quat &other) noexcept
-	{
-		Real x2 = other[0] * other[0];
-		Real y2 = other[1] * other[1];
-		Real z2 = other[2] * other[2];
-		Real xy = other[0] * other[1];
-		Real xz = other[0] * other[2];
-		Real yz = other[1] * other[2];
-		Real wx = other[3] * other[0];
-		Real wy = other[3] * other[1];
-		Real wz = other[3] * other[2];
-		data[0] = 1.0 - 2.0 * (y2 + z2);
-		data[1] = 2.0 * (xy + wz);
-		data[2] = 2.0 * (xz - wy);
-		data[3] = 2.0 * (xy - wz);
-		data[4] = 1.0 - 2.0 * (x2 + z2);
-		data[5] = 2.0 * (yz + wx);
-		data[6] = 2.0 * (xz + wy);
-		data[7] = 2.0 * (yz - wx);
-		data[8] = 1.0 - 2.0 * (x2 + y2);
-	}
-
 	Mat3::Mat3(const Vec3 &forward_, const Vec3 &up_, bool keepUp)
 	{
 		Vec3 forward = forward_;
@@ -55,22 +33,6 @@ namespace cage
 		);
 	}
 
-	Vec3 operator * (const Mat3 &l, const Vec3 &r) noexcept
-	{
-		Vec3 res;
-		for (uint8 i = 0; i < 3; i++)
-		{
-			for (uint8 j = 0; j < 3; j++)
-				res[i] += r[j] * l[j * 3 + i];
-		}
-		return res;
-	}
-
-	Vec3 operator * (const Vec3 &l, const Mat3 &r) noexcept
-	{
-		return transpose(r) * l;
-	}
-
 	Mat3 operator * (const Mat3 &l, const Mat3 &r) noexcept
 	{
 		Mat3 res = Mat3::Zero();
@@ -138,82 +100,6 @@ namespace cage
 		return data;
 	}
 
-	Mat4::Mat4(const Vec3 &p, const Quat &q, const Vec3 &s) noexcept
-	{
-		// this = T * R * S
-		Mat3 r(q);
-		*this = Mat4(
-			r[0] * s[0], r[1] * s[0], r[2] * s[0], 0,
-			r[3] * s[1], r[4] * s[1], r[5] * s[1], 0,
-			r[6] * s[2], r[7] * s[2], r[8] * s[2], 0,
-			p[0], p[1], p[2], 1
-		);
-	}
-
-	Vec4 operator * (const Mat4 &l, const Vec4 &r) noexcept
-	{
-		Vec4 res;
-		for (uint8 i = 0; i < 4; i++)
-		{
-			for (uint8 j = 0; j < 4; j++)
-				res[i] += r[j] * l[j * 4 + i];
-		}
-		return res;
-	}
-
-	Vec4 operator * (const Vec4 &l, const Mat4 &r) noexcept
-	{
-		return transpose(r) * l;
-	}
-
-	Mat4 operator + (const Mat4 &l, const Mat4 &r) noexcept
-	{
-		Mat4 res;
-		for (uint8 i = 0; i < 16; i++)
-			res[i] = l[i] + r[i];
-		return res;
-	}
-
-	Mat4 operator * (const Mat4 &l, const Mat4 &r) noexcept
-	{
-		Mat4 res;
-		for (uint8 x = 0; x < 4; x++)
-		{
-			for (uint8 y = 0; y < 4; y++)
-			{
-				res.data[y * 4 + x] = 0;
-				for (uint8 z = 0; z < 4; z++)
-					res.data[y * 4 + x] += l[z * 4 + x] * r[y * 4 + z];
-			}
-		}
-		return res;
-	}
-
-	Mat4 inverse(const Mat4 &x)
-	{
-		Mat4 res;
-		res[0] = x[5] * x[10] * x[15] - x[5] * x[11] * x[14] - x[9] * x[6] * x[15] + x[9] * x[7] * x[14] + x[13] * x[6] * x[11] - x[13] * x[7] * x[10];
-		res[4] = -x[4] * x[10] * x[15] + x[4] * x[11] * x[14] + x[8] * x[6] * x[15] - x[8] * x[7] * x[14] - x[12] * x[6] * x[11] + x[12] * x[7] * x[10];
-		res[8] = x[4] * x[9] * x[15] - x[4] * x[11] * x[13] - x[8] * x[5] * x[15] + x[8] * x[7] * x[13] + x[12] * x[5] * x[11] - x[12] * x[7] * x[9];
-		res[12] = -x[4] * x[9] * x[14] + x[4] * x[10] * x[13] + x[8] * x[5] * x[14] - x[8] * x[6] * x[13] - x[12] * x[5] * x[10] + x[12] * x[6] * x[9];
-		res[1] = -x[1] * x[10] * x[15] + x[1] * x[11] * x[14] + x[9] * x[2] * x[15] - x[9] * x[3] * x[14] - x[13] * x[2] * x[11] + x[13] * x[3] * x[10];
-		res[5] = x[0] * x[10] * x[15] - x[0] * x[11] * x[14] - x[8] * x[2] * x[15] + x[8] * x[3] * x[14] + x[12] * x[2] * x[11] - x[12] * x[3] * x[10];
-		res[9] = -x[0] * x[9] * x[15] + x[0] * x[11] * x[13] + x[8] * x[1] * x[15] - x[8] * x[3] * x[13] - x[12] * x[1] * x[11] + x[12] * x[3] * x[9];
-		res[13] = x[0] * x[9] * x[14] - x[0] * x[10] * x[13] - x[8] * x[1] * x[14] + x[8] * x[2] * x[13] + x[12] * x[1] * x[10] - x[12] * x[2] * x[9];
-		res[2] = x[1] * x[6] * x[15] - x[1] * x[7] * x[14] - x[5] * x[2] * x[15] + x[5] * x[3] * x[14] + x[13] * x[2] * x[7] - x[13] * x[3] * x[6];
-		res[6] = -x[0] * x[6] * x[15] + x[0] * x[7] * x[14] + x[4] * x[2] * x[15] - x[4] * x[3] * x[14] - x[12] * x[2] * x[7] + x[12] * x[3] * x[6];
-		res[10] = x[0] * x[5] * x[15] - x[0] * x[7] * x[13] - x[4] * x[1] * x[15] + x[4] * x[3] * x[13] + x[12] * x[1] * x[7] - x[12] * x[3] * x[5];
-		res[14] = -x[0] * x[5] * x[14] + x[0] * x[6] * x[13] + x[4] * x[1] * x[14] - x[4] * x[2] * x[13] - x[12] * x[1] * x[6] + x[12] * x[2] * x[5];
-		res[3] = -x[1] * x[6] * x[11] + x[1] * x[7] * x[10] + x[5] * x[2] * x[11] - x[5] * x[3] * x[10] - x[9] * x[2] * x[7] + x[9] * x[3] * x[6];
-		res[7] = x[0] * x[6] * x[11] - x[0] * x[7] * x[10] - x[4] * x[2] * x[11] + x[4] * x[3] * x[10] + x[8] * x[2] * x[7] - x[8] * x[3] * x[6];
-		res[11] = -x[0] * x[5] * x[11] + x[0] * x[7] * x[9] + x[4] * x[1] * x[11] - x[4] * x[3] * x[9] - x[8] * x[1] * x[7] + x[8] * x[3] * x[5];
-		res[15] = x[0] * x[5] * x[10] - x[0] * x[6] * x[9] - x[4] * x[1] * x[10] + x[4] * x[2] * x[9] + x[8] * x[1] * x[6] - x[8] * x[2] * x[5];
-		Real det = x[0] * res[0] + x[1] * res[4] + x[2] * res[8] + x[3] * res[12];
-		det = 1 / det;
-		res *= det;
-		return res;
-	}
-
 	Real determinant(const Mat4 &x)
 	{
 		return
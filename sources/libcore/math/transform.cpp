@@ -7,15 +7,6 @@ namespace cage
 		CAGE_THROW_CRITICAL(NotImplemented, "transform::parse");
 	}
 
-	Transform operator * (const Transform &l, const Transform &r) noexcept
-	{
-		Transform res;
-		res.orientation = l.orientation * r.orientation;
-		res.scale = l.scale * r.scale;
-		res.position = l.position + (r.position * l.orientation) * l.scale;
-		return res;
-	}
-
 	Transform operator * (const Transform &l, const Quat &r) noexcept
 	{
 		Transform res = l;
@@ -54,16 +45,6 @@ namespace cage
 		return r * l;
 	}
 
-	Vec3 operator * (const Transform &l, const Vec3 &r) noexcept
-	{
-		return (l.orientation * r) * l.scale + l.position;
-	}
-
-	Vec3 operator * (const Vec3 &l, const Transform &r) noexcept
-	{
-		return r * l;
-	}
-
 	Transform inverse(const Transform &x)
 	{
 		Transform res;
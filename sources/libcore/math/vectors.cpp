@@ -150,17 +150,6 @@ namespace cage
 		*this = Quat(Mat3(forward, up, keepUp));
 	}
 
-	Vec3 operator * (const Quat &l, const Vec3 &r) noexcept
-	{
-		Vec3 t = cross(Vec3(l[0], l[1], l[2]), r) * 2;
-		return r + t * l[3] + cross(Vec3(l[0], l[1], l[2]), t);
-	}
-
-	Vec3 operator * (const Vec3 &l, const Quat &r) noexcept
-	{
-		return r * l;
-	}
-
 	Quat lerp(const Quat &a, const Quat &b, Real f)
 	{
 		return normalize(a * (1 - f) + b * f);
@@ -6,6 +6,7 @@
 #include <cage-core/flatSet.h>
 
 #include "net.h"
+#include "ginnelSimulator.h"
 
 #include <robin_hood.h>
 #include <plf_list.h>
@@ -68,29 +69,165 @@ namespace cage
 			uintPtr size = 0;
 		};
 
+		// receive buffers are recycled once all packets referencing them are released
+		struct BufferPool : private Immovable
+		{
+			static constexpr uint32 MaxPooled = 64;
+
+			struct State
+			{
+				Holder<Mutex> mut = newMutex();
+				std::vector<MemoryBuffer> buffers;
+			};
+
+			struct Pooled : public MemoryBuffer
+			{
+				std::shared_ptr<State> state;
+
+				Pooled(MemoryBuffer &&buffer, std::shared_ptr<State> state) : MemoryBuffer(std::move(buffer)), state(std::move(state))
+				{}
+
+				~Pooled()
+				{
+					ScopeLock lock(state->mut);
+					if (state->buffers.size() < MaxPooled)
+						state->buffers.push_back(std::move(*(MemoryBuffer *)this));
+				}
+			};
+
+			std::shared_ptr<State> state = std::make_shared<State>();
+
+			Holder<MemoryBuffer> acquire(uintPtr size)
+			{
+				MemoryBuffer b;
+				{
+					ScopeLock lock(state->mut);
+					if (!state->buffers.empty())
+					{
+						b = std::move(state->buffers.back());
+						state->buffers.pop_back();
+					}
+				}
+				b.resize(size);
+				return systemMemory().createHolder<Pooled>(std::move(b), state).cast<MemoryBuffer>();
+			}
+		};
+
 		struct SockGroup : private Immovable
 		{
+			static constexpr uint32 BatchSize = 16; // datagrams per system call
+			static constexpr uint32 SlotSize = 2048; // larger than any packet composed by ginnel
+
 			struct Receiver : private Immovable
 			{
 				Addr address;
 				std::vector<MemView> packets;
 				uint32 sockIndex = m;
 				uint32 connId = 0;
+				uint32 simulatedPeer = 0; // endpoint in the simulator
 			};
 
 			robin_hood::unordered_map<uint32, std::weak_ptr<Receiver>> receivers;
 			std::weak_ptr<std::vector<std::shared_ptr<Receiver>>> accepting;
 			std::vector<Sock> socks;
+			BufferPool pool;
 			Holder<Mutex> mut = newMutex();
 
+			// the group is either backed by the system sockets or by single endpoint in the simulator
+			std::shared_ptr<GinnelSimulatorState> simulator;
+			std::vector<SimulatedPacket> simulatedPackets;
+			uint32 simulatedEndpoint = 0;
+			uint16 simulatedPort = 0; // remote port for outgoing connections
+
+			SockGroup() = default;
+
+			SockGroup(GinnelSimulator *sim, uint16 bindPort) : simulator(((GinnelSimulatorImpl *)sim)->state)
+			{
+				simulatedEndpoint = simulator->createEndpoint(bindPort);
+			}
+
+			~SockGroup()
+			{
+				if (simulator)
+					simulator->destroyEndpoint(simulatedEndpoint);
+			}
+
+			uint64 time() const
+			{
+				return simulator ? simulator->time() : applicationTime();
+			}
+
 			void applyBufferSizes()
 			{
 				for (Sock &s : socks)
 					s.setBufferSize(confBufferSize);
 			}
 
+			void processPacket(uint32 sockIndex, MemView &&mv, const Addr &adr, uint32 simulatedPeer = 0)
+			{
+				if (mv.size < 8)
+				{
+					UDP_LOG(7, "received invalid packet (too small)");
+					return;
+				}
+				Deserializer des = mv.des();
+				{ // read signature
+					char c, a, g, e;
+					des >> c >> a >> g >> e;
+					if (c != 'c' || a != 'a' || g != 'g' || e != 'e')
+					{
+						UDP_LOG(7, "received invalid packet (wrong signature)");
+						return;
+					}
+				}
+				uint32 connId;
+				des >> connId;
+				auto r = receivers[connId].lock();
+				if (r)
+				{
+					r->packets.push_back(std::move(mv));
+					if (r->sockIndex == m)
+					{
+						r->sockIndex = sockIndex;
+						r->address = adr;
+						r->simulatedPeer = simulatedPeer;
+					}
+				}
+				else
+				{
+					auto ac = accepting.lock();
+					if (!ac)
+					{
+						UDP_LOG(7, "received invalid packet (unknown connection id)");
+						return;
+					}
+					auto s = std::make_shared<Receiver>();
+					s->address = adr;
+					s->connId = connId;
+					s->packets.push_back(std::move(mv));
+					s->sockIndex = sockIndex;
+					s->simulatedPeer = simulatedPeer;
+					receivers[connId] = s;
+					ac->push_back(s);
+				}
+			}
+
+			void readSimulated()
+			{
+				simulatedPackets.clear();
+				simulator->receive(simulatedEndpoint, simulatedPackets);
+				for (SimulatedPacket &p : simulatedPackets)
+				{
+					const uintPtr size = p.data->size();
+					processPacket(0, MemView(std::move(p.data), 0, size), Addr(), p.from);
+				}
+			}
+
 			void readAll()
 			{
+				if (simulator)
+					readSimulated();
+				std::array<Datagram, BatchSize> datagrams;
 				for (uint32 sockIndex = 0; sockIndex < numeric_cast<uint32>(socks.size()); sockIndex++)
 				{
 					Sock &s = socks[sockIndex];
@@ -98,66 +235,38 @@ namespace cage
 						continue;
 					try
 					{
-						Addr adr;
 						while (true)
 						{
-							auto avail = s.available();
-							if (avail < 8)
-								break;
-							Holder<MemoryBuffer> buff = systemMemory().createHolder<MemoryBuffer>();
-							buff->resize(avail);
-							uintPtr off = 0;
-							while (avail)
+							// all datagrams of one batch share single pooled buffer
+							Holder<MemoryBuffer> buff = pool.acquire(BatchSize * SlotSize);
+							for (uint32 i = 0; i < BatchSize; i++)
+							{
+								datagrams[i].data = buff->data() + i * SlotSize;
+								datagrams[i].size = SlotSize;
+							}
+							const uint32 cnt = s.recvBatch(datagrams);
+							// each view keeps the whole batch buffer alive until its connection processes the packet in its next update
+							// packets of sparse batches are copied out so that they do not pin mostly unused buffers
+							const bool copyOut = cnt <= BatchSize / 4;
+							for (uint32 i = 0; i < cnt; i++)
 							{
-								uintPtr siz = s.recvFrom(buff->data() + off, avail, adr);
-								CAGE_ASSERT(siz <= avail);
-								MemView mv(buff.share(), off, siz);
-								avail -= siz;
-								off += siz;
-								if (siz < 8)
+								const Datagram &d = datagrams[i];
+								if (d.truncated)
 								{
-									UDP_LOG(7, "received invalid packet (too small)");
+									UDP_LOG(7, "received invalid packet (too large)");
 									continue;
 								}
-								Deserializer des = mv.des();
-								{ // read signature
-									char c, a, g, e;
-									des >> c >> a >> g >> e;
-									if (c != 'c' || a != 'a' || g != 'g' || e != 'e')
-									{
-										UDP_LOG(7, "received invalid packet (wrong signature)");
-										continue;
-									}
-								}
-								uint32 connId;
-								des >> connId;
-								auto r = receivers[connId].lock();
-								if (r)
+								if (copyOut)
 								{
-									r->packets.push_back(mv);
-									if (r->sockIndex == m)
-									{
-										r->sockIndex = sockIndex;
-										r->address = adr;
-									}
+									Holder<MemoryBuffer> b = systemMemory().createHolder<MemoryBuffer>(d.size);
+									detail::memcpy(b->data(), d.data, d.size);
+									processPacket(sockIndex, MemView(std::move(b), 0, d.size), d.address);
 								}
 								else
-								{
-									auto ac = accepting.lock();
-									if (!ac)
-									{
-										UDP_LOG(7, "received invalid packet (unknown connection id)");
-										continue;
-									}
-									auto s = std::make_shared<Receiver>();
-									s->address = adr;
-									s->connId = connId;
-									s->packets.push_back(mv);
-									s->sockIndex = sockIndex;
-									receivers[connId] = s;
-									ac->push_back(s);
-								}
+									processPacket(sockIndex, MemView(buff.share(), i * SlotSize, d.size), d.address);
 							}
+							if (cnt < BatchSize)
+								break;
 						}
 					}
 					catch (...)
@@ -278,27 +387,38 @@ namespace cage
 		class GinnelConnectionImpl : public GinnelConnection
 		{
 		public:
-			GinnelConnectionImpl(const String &address, uint16 port, uint64 timeout) : startTime(applicationTime()), connId(randomRange(1u, std::numeric_limits<uint32>::max()))
+			GinnelConnectionImpl(const String &address, uint16 port, uint64 timeout, GinnelSimulator *simulator) : connId(simulator ? ((GinnelSimulatorImpl *)simulator)->state->randomId() : randomRange(1u, std::numeric_limits<uint32>::max()))
 			{
 				UDP_LOG(1, "creating new connection to address: '" + address + "', port: " + port + ", timeout: " + timeout);
-				sockGroup = std::make_shared<SockGroup>();
-				AddrList lst(address, port, AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, AI_PASSIVE);
-				while (lst.valid())
-				{
-					Addr adr;
-					int family, type, protocol;
-					lst.getAll(adr, family, type, protocol);
-					Sock s(family, type, protocol);
-					s.setBlocking(false);
-					s.connect(adr);
-					if (s.isValid())
-						sockGroup->socks.push_back(std::move(s));
-					lst.next();
+				if (simulator)
+				{
+					if (timeout && ((GinnelSimulatorImpl *)simulator)->state->config.manualTime)
+						CAGE_THROW_ERROR(Exception, "blocking connection requires simulator with automatic time");
+					sockGroup = std::make_shared<SockGroup>(simulator, 0);
+					sockGroup->simulatedPort = port;
 				}
-				sockGroup->applyBufferSizes();
-				if (sockGroup->socks.empty())
-					CAGE_THROW_ERROR(Exception, "failed to connect (no sockets available)");
-				UDP_LOG(2, "created " + sockGroup->socks.size() + " sockets");
+				else
+				{
+					sockGroup = std::make_shared<SockGroup>();
+					AddrList lst(address, port, AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, AI_PASSIVE);
+					while (lst.valid())
+					{
+						Addr adr;
+						int family, type, protocol;
+						lst.getAll(adr, family, type, protocol);
+						Sock s(family, type, protocol);
+						s.setBlocking(false);
+						s.connect(adr);
+						if (s.isValid())
+							sockGroup->socks.push_back(std::move(s));
+						lst.next();
+					}
+					sockGroup->applyBufferSizes();
+					if (sockGroup->socks.empty())
+						CAGE_THROW_ERROR(Exception, "failed to connect (no sockets available)");
+					UDP_LOG(2, "created " + sockGroup->socks.size() + " sockets");
+				}
+				startTime = sockGroup->time();
 				sockReceiver = std::make_shared<SockGroup::Receiver>();
 				sockReceiver->connId = connId;
 				sockGroup->receivers[connId] = sockReceiver;
@@ -312,14 +432,14 @@ namespace cage
 							service();
 							if (established)
 								break;
-							if (applicationTime() > startTime + timeout)
+							if (sockGroup->time() > startTime + timeout)
 								CAGE_THROW_ERROR(Disconnected, "failed to connect (timeout)");
 						}
 					}
 				}
 			}
 
-			GinnelConnectionImpl(std::shared_ptr<SockGroup> sg, std::shared_ptr<SockGroup::Receiver> rec) : sockGroup(sg), sockReceiver(rec), startTime(applicationTime()), connId(rec->connId)
+			GinnelConnectionImpl(std::shared_ptr<SockGroup> sg, std::shared_ptr<SockGroup::Receiver> rec) : sockGroup(sg), sockReceiver(rec), startTime(sg->time()), connId(rec->connId)
 			{
 				UDP_LOG(1, "accepting new connection");
 			}
@@ -349,12 +469,22 @@ namespace cage
 
 			// SENDING
 
+			struct Outgoing
+			{
+				MemoryBuffer buffer;
+				std::vector<std::pair<uintPtr, uintPtr>> packets; // offset, size
+				std::vector<Datagram> datagrams;
+			} outgoing;
+
 			void dispatchPacket(const void *data, uintPtr size)
 			{
 				stats.bytesSentTotal += size;
 				stats.packetsSentTotal++;
 
-				{ // simulated packet loss for testing purposes
+				// simulated packet loss for testing purposes
+				// not applied in the simulator, it has its own seeded packet loss and must stay reproducible
+				if (!sockGroup->simulator)
+				{
 					float ch = confSimulatedPacketLoss;
 					if (ch > 0 && randomChance() < ch)
 					{
@@ -363,15 +493,60 @@ namespace cage
 					}
 				}
 
+				// queue the packet, all packets composed together are sent in single batch
+				const uintPtr offset = outgoing.buffer.size();
+				outgoing.buffer.resize(offset + size);
+				detail::memcpy(outgoing.buffer.data() + offset, data, size);
+				outgoing.packets.push_back({ offset, size });
+			}
+
+			void flushPackets()
+			{
+				if (outgoing.packets.empty())
+					return;
+				struct Clearer
+				{
+					Outgoing &o;
+					~Clearer()
+					{
+						o.buffer.resize(0);
+						o.packets.clear();
+					}
+				} clearer{ outgoing };
+
+				std::vector<Datagram> &datagrams = outgoing.datagrams;
+				datagrams.resize(outgoing.packets.size());
+				const bool direct = sockReceiver->sockIndex != m;
+				for (uint32 i = 0; i < datagrams.size(); i++)
+				{
+					datagrams[i].data = outgoing.buffer.data() + outgoing.packets[i].first;
+					datagrams[i].size = outgoing.packets[i].second;
+					if (direct)
+						datagrams[i].address = sockReceiver->address;
+				}
+
+				if (sockGroup->simulator)
+				{
+					GinnelSimulatorState *sim = sockGroup->simulator.get();
+					for (const Datagram &d : datagrams)
+					{
+						if (direct)
+							sim->send(sockGroup->simulatedEndpoint, sockReceiver->simulatedPeer, { d.data, d.data + d.size });
+						else
+							sim->sendToPort(sockGroup->simulatedEndpoint, sockGroup->simulatedPort, { d.data, d.data + d.size });
+					}
+					return;
+				}
+
 				// sending does not need to be under mutex
-				if (sockReceiver->sockIndex == m)
+				if (!direct)
 				{
 					for (Sock &s : sockGroup->socks)
 					{
 						if (!s.isValid())
 							continue;
 						CAGE_ASSERT(s.getConnected());
-						s.send(data, size);
+						s.sendBatch(datagrams);
 					}
 				}
 				else
@@ -379,13 +554,8 @@ namespace cage
 					Sock &s = sockGroup->socks[sockReceiver->sockIndex];
 					if (s.isValid())
 					{
-						if (s.getConnected())
-						{
-							CAGE_ASSERT(s.getRemoteAddress() == sockReceiver->address);
-							s.send(data, size);
-						}
-						else
-							s.sendTo(data, size, sockReceiver->address);
+						CAGE_ASSERT(!s.getConnected() || s.getRemoteAddress() == sockReceiver->address);
+						s.sendBatch(datagrams);
 					}
 				}
 			}
@@ -676,6 +846,7 @@ namespace cage
 				}
 				if (!empty)
 					dispatchPacket(buff.data(), buff.size());
+				flushPackets();
 			}
 
 			void serviceSending()
@@ -1101,7 +1272,7 @@ namespace cage
 			GinnelStatistics stats;
 			std::shared_ptr<SockGroup> sockGroup;
 			std::shared_ptr<SockGroup::Receiver> sockReceiver;
-			const uint64 startTime = m;
+			uint64 startTime = m;
 			const uint32 connId = m;
 			uint64 lastStatsSendTime = 0;
 			uint64 currentServiceTime = 0; // time at which this service has started
@@ -1151,7 +1322,7 @@ namespace cage
 
 			void service()
 			{
-				const uint64 newTime = applicationTime();
+				const uint64 newTime = sockGroup->time();
 				deltaTime = newTime - currentServiceTime;
 				currentServiceTime = newTime;
 				detail::OverrideBreakpoint brk;
@@ -1164,27 +1335,32 @@ namespace cage
 		class GinnelServerImpl : public GinnelServer
 		{
 		public:
-			GinnelServerImpl(uint16 port)
+			GinnelServerImpl(uint16 port, GinnelSimulator *simulator)
 			{
 				UDP_LOG(1, "creating new server on port " + port);
-				sockGroup = std::make_shared<SockGroup>();
-				AddrList lst(nullptr, port, AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, AI_PASSIVE);
-				while (lst.valid())
-				{
-					Addr adr;
-					int family, type, protocol;
-					lst.getAll(adr, family, type, protocol);
-					Sock s(family, type, protocol);
-					s.setBlocking(false);
-					s.setReuseaddr(true);
-					s.bind(adr);
-					if (s.isValid())
-						sockGroup->socks.push_back(std::move(s));
-					lst.next();
+				if (simulator)
+					sockGroup = std::make_shared<SockGroup>(simulator, port);
+				else
+				{
+					sockGroup = std::make_shared<SockGroup>();
+					AddrList lst(nullptr, port, AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, AI_PASSIVE);
+					while (lst.valid())
+					{
+						Addr adr;
+						int family, type, protocol;
+						lst.getAll(adr, family, type, protocol);
+						Sock s(family, type, protocol);
+						s.setBlocking(false);
+						s.setReuseaddr(true);
+						s.bind(adr);
+						if (s.isValid())
+							sockGroup->socks.push_back(std::move(s));
+						lst.next();
+					}
+					sockGroup->applyBufferSizes();
+					if (sockGroup->socks.empty())
+						CAGE_THROW_ERROR(Exception, "failed to bind (no sockets available)");
 				}
-				sockGroup->applyBufferSizes();
-				if (sockGroup->socks.empty())
-					CAGE_THROW_ERROR(Exception, "failed to bind (no sockets available)");
 				accepting = std::make_shared<std::vector<std::shared_ptr<SockGroup::Receiver>>>();
 				sockGroup->accepting = accepting;
 				UDP_LOG(2, "listening on " + sockGroup->socks.size() + " sockets");
@@ -1343,13 +1519,13 @@ namespace cage
 		return impl->accept();
 	}
 
-	Holder<GinnelConnection> newGinnelConnection(const String &address, uint16 port, uint64 timeout)
+	Holder<GinnelConnection> newGinnelConnection(const String &address, uint16 port, uint64 timeout, GinnelSimulator *simulator)
 	{
-		return systemMemory().createImpl<GinnelConnection, GinnelConnectionImpl>(address, port, timeout);
+		return systemMemory().createImpl<GinnelConnection, GinnelConnectionImpl>(address, port, timeout, simulator);
 	}
 
-	Holder<GinnelServer> newGinnelServer(uint16 port)
+	Holder<GinnelServer> newGinnelServer(uint16 port, GinnelSimulator *simulator)
 	{
-		return systemMemory().createImpl<GinnelServer, GinnelServerImpl>(port);
+		return systemMemory().createImpl<GinnelServer, GinnelServerImpl>(port, simulator);
 	}
 }
@@ -0,0 +1,196 @@
+#include "ginnelSimulator.h"
+
+#include <algorithm>
+
+namespace cage
+{
+	namespace privat
+	{
+		namespace
+		{
+			struct PacketLater
+			{
+				bool operator () (const SimulatedPacket &a, const SimulatedPacket &b) const
+				{
+					if (a.time == b.time)
+						return a.order > b.order;
+					return a.time > b.time;
+				}
+			};
+		}
+
+		GinnelSimulatorState::GinnelSimulatorState(const GinnelSimulatorCreateConfig &config) : config(config), rng(config.seed, config.seed ^ 0x9E3779B97F4A7C15ull)
+		{
+			CAGE_ASSERT(config.packetLoss >= 0 && config.packetLoss <= 1);
+			CAGE_ASSERT(config.duplication >= 0 && config.duplication <= 1);
+			CAGE_ASSERT(config.reordering >= 0 && config.reordering <= 1);
+		}
+
+		uint64 GinnelSimulatorState::time() const
+		{
+			if (!config.manualTime)
+				return applicationTime();
+			ScopeLock<Mutex> lock(mutex);
+			return manualTime;
+		}
+
+		void GinnelSimulatorState::advance(uint64 duration)
+		{
+			if (!config.manualTime)
+				CAGE_THROW_ERROR(Exception, "ginnel simulator time is not manual");
+			ScopeLock<Mutex> lock(mutex);
+			manualTime += duration;
+		}
+
+		GinnelSimulatorStatistics GinnelSimulatorState::statistics() const
+		{
+			ScopeLock<Mutex> lock(mutex);
+			return stats;
+		}
+
+		uint32 GinnelSimulatorState::randomId()
+		{
+			ScopeLock<Mutex> lock(mutex);
+			return rng.randomRange(1u, std::numeric_limits<uint32>::max());
+		}
+
+		uint32 GinnelSimulatorState::createEndpoint(uint16 port)
+		{
+			ScopeLock<Mutex> lock(mutex);
+			if (port)
+			{
+				if (ports.count(port))
+					CAGE_THROW_ERROR(Exception, "simulated port is already in use");
+				ports[port] = lastEndpoint + 1;
+			}
+			const uint32 id = ++lastEndpoint;
+			endpoints[id].port = port;
+			return id;
+		}
+
+		void GinnelSimulatorState::destroyEndpoint(uint32 endpoint)
+		{
+			ScopeLock<Mutex> lock(mutex);
+			const auto it = endpoints.find(endpoint);
+			CAGE_ASSERT(it != endpoints.end());
+			if (it->second.port)
+				ports.erase(it->second.port);
+			endpoints.erase(it);
+			std::erase_if(links, [&](const auto &l) { return l.first.first == endpoint || l.first.second == endpoint; });
+		}
+
+		void GinnelSimulatorState::enqueue(Endpoint &e, uint32 from, PointerRange<const char> data, uint64 time)
+		{
+			SimulatedPacket p;
+			p.data = systemMemory().createHolder<MemoryBuffer>(data.size());
+			detail::memcpy(p.data->data(), data.data(), data.size());
+			p.time = time;
+			p.order = order++;
+			p.from = from;
+			e.queue.push_back(std::move(p));
+			std::push_heap(e.queue.begin(), e.queue.end(), PacketLater());
+		}
+
+		void GinnelSimulatorState::send(uint32 from, uint32 to, PointerRange<const char> data, uint64 now)
+		{
+			stats.packetsSent++;
+			stats.bytesSent += data.size();
+
+			const auto it = endpoints.find(to);
+			if (it == endpoints.end() || rng.randomChance() < config.packetLoss)
+			{
+				stats.packetsLost++;
+				return;
+			}
+
+			uint64 departure = now;
+			if (config.bandwidth)
+			{
+				uint64 &idle = links[{ from, to }];
+				departure = std::max(idle, now);
+				if (departure > now + config.queueDuration)
+				{
+					stats.packetsOverflow++;
+					return;
+				}
+				idle = departure + data.size() * 1000000 / config.bandwidth;
+			}
+
+			const auto &delay = [&]() -> uint64
+			{
+				uint64 d = config.latency;
+				if (config.jitter)
+					d += rng.randomRange(uint64(0), config.jitter + 1);
+				if (config.reordering > 0 && rng.randomChance() < config.reordering)
+				{
+					d += rng.randomRange(uint64(1), std::max(config.latency * 2, uint64(1000)) + 1);
+					stats.packetsReordered++;
+				}
+				return d;
+			};
+
+			enqueue(it->second, from, data, departure + delay());
+			if (config.duplication > 0 && rng.randomChance() < config.duplication)
+			{
+				enqueue(it->second, from, data, departure + delay());
+				stats.packetsDuplicated++;
+			}
+		}
+
+		void GinnelSimulatorState::send(uint32 from, uint32 to, PointerRange<const char> data)
+		{
+			const uint64 now = time();
+			ScopeLock<Mutex> lock(mutex);
+			send(from, to, data, now);
+		}
+
+		void GinnelSimulatorState::sendToPort(uint32 from, uint16 port, PointerRange<const char> data)
+		{
+			const uint64 now = time();
+			ScopeLock<Mutex> lock(mutex);
+			const auto it = ports.find(port);
+			send(from, it == ports.end() ? 0 : it->second, data, now);
+		}
+
+		void GinnelSimulatorState::receive(uint32 endpoint, std::vector<SimulatedPacket> &packets)
+		{
+			const uint64 now = time();
+			ScopeLock<Mutex> lock(mutex);
+			const auto it = endpoints.find(endpoint);
+			if (it == endpoints.end())
+				return;
+			std::vector<SimulatedPacket> &q = it->second.queue;
+			while (!q.empty() && q.front().time <= now)
+			{
+				std::pop_heap(q.begin(), q.end(), PacketLater());
+				stats.packetsDelivered++;
+				stats.bytesDelivered += q.back().data->size();
+				packets.push_back(std::move(q.back()));
+				q.pop_back();
+			}
+		}
+	}
+
+	uint64 GinnelSimulator::time() const
+	{
+		const privat::GinnelSimulatorImpl *impl = (const privat::GinnelSimulatorImpl *)this;
+		return impl->state->time();
+	}
+
+	void GinnelSimulator::advance(uint64 duration)
+	{
+		privat::GinnelSimulatorImpl *impl = (privat::GinnelSimulatorImpl *)this;
+		impl->state->advance(duration);
+	}
+
+	GinnelSimulatorStatistics GinnelSimulator::statistics() const
+	{
+		const privat::GinnelSimulatorImpl *impl = (const privat::GinnelSimulatorImpl *)this;
+		return impl->state->statistics();
+	}
+
+	Holder<GinnelSimulator> newGinnelSimulator(const GinnelSimulatorCreateConfig &config)
+	{
+		return systemMemory().createImpl<GinnelSimulator, privat::GinnelSimulatorImpl>(config);
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef guard_ginnelSimulator_h_k1m9v7c3x0qa
+#define guard_ginnelSimulator_h_k1m9v7c3x0qa
+
+#include <cage-core/networkGinnel.h>
+#include <cage-core/memoryBuffer.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/math.h> // random
+#include <cage-core/random.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace cage
+{
+	namespace privat
+	{
+		struct SimulatedPacket
+		{
+			Holder<MemoryBuffer> data;
+			uint64 time = 0; // delivery time
+			uint64 order = 0; // tie breaker for same delivery time
+			uint32 from = 0; // endpoint
+		};
+
+		struct GinnelSimulatorState : private Immovable
+		{
+			explicit GinnelSimulatorState(const GinnelSimulatorCreateConfig &config);
+
+			uint64 time() const;
+			void advance(uint64 duration);
+			GinnelSimulatorStatistics statistics() const;
+			uint32 randomId();
+
+			uint32 createEndpoint(uint16 port); // zero port for unbound endpoint
+			void destroyEndpoint(uint32 endpoint);
+
+			void send(uint32 from, uint32 to, PointerRange<const char> data);
+			void sendToPort(uint32 from, uint16 port, PointerRange<const char> data);
+			void receive(uint32 endpoint, std::vector<SimulatedPacket> &packets); // appends all packets due for delivery
+
+			const GinnelSimulatorCreateConfig config;
+
+		private:
+			struct Endpoint
+			{
+				std::vector<SimulatedPacket> queue; // heap ordered by delivery time
+				uint16 port = 0;
+			};
+
+			void enqueue(Endpoint &e, uint32 from, PointerRange<const char> data, uint64 time);
+			void send(uint32 from, uint32 to, PointerRange<const char> data, uint64 now);
+
+			Holder<Mutex> mutex = newMutex();
+			RandomGenerator rng;
+			GinnelSimulatorStatistics stats;
+			std::map<uint32, Endpoint> endpoints;
+			std::map<uint16, uint32> ports;
+			std::map<std::pair<uint32, uint32>, uint64> links; // time at which the link becomes idle
+			uint64 manualTime = 1000000;
+			uint64 order = 0;
+			uint32 lastEndpoint = 0;
+		};
+
+		class GinnelSimulatorImpl : public GinnelSimulator
+		{
+		public:
+			explicit GinnelSimulatorImpl(const GinnelSimulatorCreateConfig &config) : state(std::make_shared<GinnelSimulatorState>(config))
+			{}
+
+			std::shared_ptr<GinnelSimulatorState> state;
+		};
+	}
+}
+
+#endif // guard_ginnelSimulator_h_k1m9v7c3x0qa
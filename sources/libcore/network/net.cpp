@@ -2,6 +2,9 @@
 
 #include "net.h"
 
+#include <atomic>
+#include <algorithm>
+
 namespace cage
 {
 	namespace
@@ -264,6 +267,156 @@ namespace cage
 			return rtn;
 		}
 
+		namespace
+		{
+#ifdef CAGE_SYSTEM_LINUX
+			constexpr uint32 MaxBatch = 64;
+			std::atomic<bool> batchingUnavailable = false; // kernel without recvmmsg/sendmmsg support
+#endif // CAGE_SYSTEM_LINUX
+		}
+
+		uint32 Sock::recvBatch(PointerRange<Datagram> datagrams)
+		{
+#ifdef CAGE_SYSTEM_LINUX
+			if (!batchingUnavailable)
+			{
+				const uint32 cnt = std::min(numeric_cast<uint32>(datagrams.size()), MaxBatch);
+				mmsghdr msgs[MaxBatch];
+				iovec iovs[MaxBatch];
+				for (uint32 i = 0; i < cnt; i++)
+				{
+					Datagram &d = datagrams[i];
+					iovs[i].iov_base = d.data;
+					iovs[i].iov_len = d.size;
+					msgs[i] = {};
+					msgs[i].msg_hdr.msg_iov = &iovs[i];
+					msgs[i].msg_hdr.msg_iovlen = 1;
+					msgs[i].msg_hdr.msg_name = &d.address.storage;
+					msgs[i].msg_hdr.msg_namelen = sizeof(d.address.storage);
+				}
+				const int rtn = ::recvmmsg(descriptor, msgs, cnt, MSG_DONTWAIT, nullptr);
+				if (rtn >= 0)
+				{
+					for (int i = 0; i < rtn; i++)
+					{
+						Datagram &d = datagrams[i];
+						d.size = msgs[i].msg_len;
+						d.address.addrlen = msgs[i].msg_hdr.msg_namelen;
+						d.truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+					}
+					return rtn;
+				}
+				const int err = WSAGetLastError();
+				if (err != ENOSYS)
+				{
+					if (err != WSAEWOULDBLOCK && (err != WSAECONNRESET || protocol != IPPROTO_UDP))
+						CAGE_THROW_ERROR(SystemError, "received failed (recvmmsg)", err);
+					return 0;
+				}
+				batchingUnavailable = true;
+			}
+#endif // CAGE_SYSTEM_LINUX
+
+			// one call per datagram until the socket would block
+			// truncation is reported for each datagram by the system (MSG_TRUNC or WSAEMSGSIZE)
+			uint32 cnt = 0;
+			while (cnt < datagrams.size())
+			{
+				Datagram &d = datagrams[cnt];
+#ifdef CAGE_SYSTEM_WINDOWS
+				d.address.addrlen = sizeof(d.address.storage);
+				const int rtn = ::recvfrom(descriptor, (raw_type *)d.data, numeric_cast<int>(d.size), 0, (sockaddr *)&d.address.storage, &d.address.addrlen);
+				if (rtn >= 0)
+				{
+					d.size = rtn;
+					d.truncated = false;
+					cnt++;
+					continue;
+				}
+				const int err = WSAGetLastError();
+				if (err == WSAEMSGSIZE)
+				{
+					// the buffer was filled with the beginning of the datagram, the rest was discarded
+					d.truncated = true;
+					cnt++;
+					continue;
+				}
+#else
+				iovec iov;
+				iov.iov_base = d.data;
+				iov.iov_len = d.size;
+				msghdr msg = {};
+				msg.msg_iov = &iov;
+				msg.msg_iovlen = 1;
+				msg.msg_name = &d.address.storage;
+				msg.msg_namelen = sizeof(d.address.storage);
+				const auto rtn = ::recvmsg(descriptor, &msg, MSG_DONTWAIT);
+				if (rtn >= 0)
+				{
+					d.size = rtn;
+					d.address.addrlen = msg.msg_namelen;
+					d.truncated = (msg.msg_flags & MSG_TRUNC) != 0;
+					cnt++;
+					continue;
+				}
+				const int err = WSAGetLastError();
+#endif // CAGE_SYSTEM_WINDOWS
+				if (err == WSAECONNRESET && protocol == IPPROTO_UDP)
+					continue; // error report of a previously sent datagram, try the next one
+				if (err != WSAEWOULDBLOCK)
+					CAGE_THROW_ERROR(SystemError, "received failed (recvBatch)", err);
+				break;
+			}
+			return cnt;
+		}
+
+		void Sock::sendBatch(PointerRange<const Datagram> datagrams)
+		{
+#ifdef CAGE_SYSTEM_LINUX
+			while (!datagrams.empty() && !batchingUnavailable)
+			{
+				const uint32 cnt = std::min(numeric_cast<uint32>(datagrams.size()), MaxBatch);
+				mmsghdr msgs[MaxBatch];
+				iovec iovs[MaxBatch];
+				for (uint32 i = 0; i < cnt; i++)
+				{
+					const Datagram &d = datagrams[i];
+					iovs[i].iov_base = d.data;
+					iovs[i].iov_len = d.size;
+					msgs[i] = {};
+					msgs[i].msg_hdr.msg_iov = &iovs[i];
+					msgs[i].msg_hdr.msg_iovlen = 1;
+					if (!connected)
+					{
+						msgs[i].msg_hdr.msg_name = (void *)&d.address.storage;
+						msgs[i].msg_hdr.msg_namelen = d.address.addrlen;
+					}
+				}
+				const int rtn = ::sendmmsg(descriptor, msgs, cnt, 0);
+				if (rtn < 0)
+				{
+					const int err = WSAGetLastError();
+					if (err != ENOSYS)
+						CAGE_THROW_ERROR(SystemError, "send failed (sendmmsg)", err);
+					batchingUnavailable = true;
+					break;
+				}
+				for (int i = 0; i < rtn; i++)
+					if (msgs[i].msg_len != datagrams[i].size)
+						CAGE_THROW_ERROR(SystemError, "send failed (sendmmsg)", WSAGetLastError());
+				datagrams = { datagrams.begin() + rtn, datagrams.end() };
+			}
+#endif // CAGE_SYSTEM_LINUX
+
+			for (const Datagram &d : datagrams)
+			{
+				if (connected)
+					send(d.data, d.size);
+				else
+					sendTo(d.data, d.size, d.address);
+			}
+		}
+
 		AddrList::AddrList(const String &address, uint16 port, int family, int type, int protocol, int flags) : AddrList(address.c_str(), port, family, type, protocol, flags)
 		{}
 
@@ -44,6 +44,8 @@ namespace cage
 {
 	namespace privat
 	{
+		struct Datagram;
+
 		struct Addr
 		{
 			Addr();
@@ -103,6 +105,10 @@ namespace cage
 			uintPtr recv(void *buffer, uintPtr bufferSize, int flags = 0);
 			uintPtr recvFrom(void *buffer, uintPtr bufferSize, Addr &remoteAddress, int flags = 0);
 
+			// batched transfers use single system call for multiple datagrams where available (recvmmsg/sendmmsg), and fall back to one call per datagram otherwise
+			uint32 recvBatch(PointerRange<Datagram> datagrams); // returns number of received datagrams, stops early when the socket would block
+			void sendBatch(PointerRange<const Datagram> datagrams);
+
 			bool operator < (const Sock &other) const // fast comparison
 			{
 				return descriptor < other.descriptor;
@@ -119,6 +125,14 @@ namespace cage
 			bool connected;
 		};
 
+		struct Datagram
+		{
+			char *data = nullptr;
+			uintPtr size = 0; // receiving: capacity of the buffer on input, size of the datagram on output
+			Addr address; // receiving: source address; sending: destination address, ignored on connected sockets
+			bool truncated = false; // the datagram did not fit into the buffer
+		};
+
 		struct AddrList : private Immovable
 		{
 			AddrList(const String &address, uint16 port, int family, int type, int protocol, int flags);
@@ -0,0 +1,423 @@
+#include <cage-core/systemInformation.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/string.h>
+#include <cage-core/files.h> // pathJoinUnchecked
+
+#ifdef CAGE_SYSTEM_WINDOWS
+#include "incWin.h"
+#endif
+
+#ifdef CAGE_SYSTEM_LINUX
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <tuple>
+
+namespace cage
+{
+	namespace
+	{
+		// sysfs files report fixed size regardless of their content, therefore they are read directly
+		bool readSysfs(const String &path, String &result)
+		{
+			FILE *f = std::fopen(path.c_str(), "rb");
+			if (!f)
+				return false;
+			char buf[String::MaxLength];
+			const uintPtr r = std::fread(buf, 1, String::MaxLength - 1, f);
+			std::fclose(f);
+			result = trim(String(PointerRange<const char>(buf, buf + r)));
+			return true;
+		}
+
+		uint32 readSysfsUint(const String &path, uint32 fallback)
+		{
+			String s;
+			if (!readSysfs(path, s) || s.empty() || s[0] == '-')
+				return fallback;
+			return toUint32(s);
+		}
+
+		// eg. "0-3,8,10-11"
+		std::vector<uint32> parseCpuList(String s)
+		{
+			std::vector<uint32> res;
+			while (!s.empty())
+			{
+				String range = trim(split(s, ","));
+				if (range.empty())
+					continue;
+				const String a = split(range, "-");
+				const uint32 first = toUint32(trim(a));
+				const uint32 last = range.empty() ? first : toUint32(trim(range));
+				if (last < first)
+					CAGE_THROW_ERROR(Exception, "invalid processors list");
+				for (uint32 i = first; i <= last; i++)
+					res.push_back(i);
+			}
+			std::sort(res.begin(), res.end());
+			res.erase(std::unique(res.begin(), res.end()), res.end());
+			return res;
+		}
+
+		bool readCpuList(const String &path, std::vector<uint32> &result)
+		{
+			String s;
+			if (!readSysfs(path, s))
+				return false;
+			result = parseCpuList(s);
+			return true;
+		}
+
+		template<class T>
+		uint32 renumber(std::map<T, uint32> &ids, const T &key)
+		{
+			auto it = ids.find(key);
+			if (it != ids.end())
+				return it->second;
+			const uint32 r = numeric_cast<uint32>(ids.size());
+			ids[key] = r;
+			return r;
+		}
+
+		// the fields contain arbitrary unique keys on input and are converted to consecutive indices
+		void finalizeTopology(ProcessorsTopology &t)
+		{
+			std::sort(t.processors.begin(), t.processors.end(), [](const ProcessorTopology &a, const ProcessorTopology &b) { return a.id < b.id; });
+			std::map<uint32, uint32> packages, nodes, caches;
+			std::map<std::pair<uint32, uint32>, uint32> cores;
+			std::vector<uint32> smts;
+			bool perf = false, eff = false;
+			for (ProcessorTopology &p : t.processors)
+			{
+				p.core = renumber(cores, std::pair(p.package, p.core));
+				p.package = renumber(packages, p.package);
+				p.numaNode = renumber(nodes, p.numaNode);
+				p.cacheGroup = renumber(caches, p.cacheGroup);
+				if (p.core >= smts.size())
+					smts.resize(p.core + 1, 0);
+				p.smt = smts[p.core]++;
+				(p.processorClass == ProcessorClassEnum::Performance ? perf : eff) = true;
+			}
+			t.cores = numeric_cast<uint32>(cores.size());
+			t.packages = numeric_cast<uint32>(packages.size());
+			t.numaNodes = numeric_cast<uint32>(nodes.size());
+			t.cacheGroups = numeric_cast<uint32>(caches.size());
+			t.hybrid = perf && eff;
+		}
+
+		// each processor is its own core
+		ProcessorsTopology flatTopology()
+		{
+			ProcessorsTopology t;
+			const uint32 cnt = std::max(processorsCount(), 1u);
+			for (uint32 i = 0; i < cnt; i++)
+			{
+				ProcessorTopology p;
+				p.id = i;
+				p.core = i;
+				t.processors.push_back(p);
+			}
+			finalizeTopology(t);
+			return t;
+		}
+
+		// marks processors as efficiency when their value is significantly lower than the maximum
+		void classifyByValue(ProcessorsTopology &t, const std::vector<uint32> &values)
+		{
+			const uint32 mx = *std::max_element(values.begin(), values.end());
+			for (uint32 i = 0; i < t.processors.size(); i++)
+				if (values[i] < mx * 4 / 5)
+					t.processors[i].processorClass = ProcessorClassEnum::Efficiency;
+		}
+
+#ifdef CAGE_SYSTEM_WINDOWS
+		ProcessorsTopology windowsTopology()
+		{
+			DWORD len = 0;
+			GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
+			std::vector<char> buffer;
+			buffer.resize(len);
+			if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(), &len))
+				CAGE_THROW_ERROR(SystemError, "GetLogicalProcessorInformationEx", GetLastError());
+
+			struct Info
+			{
+				uint32 core = m, package = 0, numaNode = 0, cacheGroup = m, cacheLevel = 0, efficiencyClass = 0;
+			};
+			std::map<uint32, Info> infos;
+			const auto &forEach = [&](const GROUP_AFFINITY &ga, auto &&fnc)
+			{
+				for (uint32 b = 0; b < 64; b++)
+					if (ga.Mask & (KAFFINITY(1) << b))
+						fnc(infos[ga.Group * 64 + b]);
+			};
+
+			uint32 cores = 0, packages = 0, caches = 0;
+			for (DWORD off = 0; off < len;)
+			{
+				const auto *info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)(buffer.data() + off);
+				off += info->Size;
+				switch (info->Relationship)
+				{
+				case RelationProcessorCore:
+				{
+					const uint32 core = cores++;
+					for (uint32 g = 0; g < info->Processor.GroupCount; g++)
+						forEach(info->Processor.GroupMask[g], [&](Info &i) { i.core = core; i.efficiencyClass = info->Processor.EfficiencyClass; });
+				} break;
+				case RelationProcessorPackage:
+				{
+					const uint32 package = packages++;
+					for (uint32 g = 0; g < info->Processor.GroupCount; g++)
+						forEach(info->Processor.GroupMask[g], [&](Info &i) { i.package = package; });
+				} break;
+				case RelationNumaNode:
+					forEach(info->NumaNode.GroupMask, [&](Info &i) { i.numaNode = info->NumaNode.NodeNumber; });
+					break;
+				case RelationCache:
+				{
+					const uint32 cache = caches++;
+					const uint32 level = info->Cache.Level;
+					forEach(info->Cache.GroupMask, [&](Info &i) {
+						if (level >= i.cacheLevel)
+						{
+							i.cacheLevel = level;
+							i.cacheGroup = cache;
+						}
+					});
+				} break;
+				default:
+					break;
+				}
+			}
+
+			ProcessorsTopology t;
+			uint32 maxClass = 0;
+			for (const auto &it : infos)
+				maxClass = std::max(maxClass, it.second.efficiencyClass);
+			for (const auto &it : infos)
+			{
+				ProcessorTopology p;
+				p.id = it.first;
+				p.core = it.second.core;
+				p.package = it.second.package;
+				p.numaNode = it.second.numaNode;
+				p.cacheGroup = it.second.cacheGroup == m ? (uint32)m - p.package : it.second.cacheGroup;
+				p.processorClass = it.second.efficiencyClass < maxClass ? ProcessorClassEnum::Efficiency : ProcessorClassEnum::Performance; // higher efficiency class means higher performance
+				t.processors.push_back(p);
+			}
+			finalizeTopology(t);
+			return t;
+		}
+#endif // CAGE_SYSTEM_WINDOWS
+
+		ProcessorsTopology detectTopology()
+		{
+			try
+			{
+#if defined(CAGE_SYSTEM_WINDOWS)
+				return windowsTopology();
+#elif defined(CAGE_SYSTEM_LINUX)
+				ProcessorsTopology t = processorsTopologyFromSysfs("/sys");
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				if (sched_getaffinity(0, sizeof(set), &set) == 0)
+				{
+					std::erase_if(t.processors, [&](const ProcessorTopology &p) { return p.id >= CPU_SETSIZE || !CPU_ISSET(p.id, &set); });
+					if (!t.processors.empty())
+						finalizeTopology(t);
+				}
+				if (!t.processors.empty())
+					return t;
+#endif
+			}
+			catch (const cage::Exception &)
+			{
+				CAGE_LOG(SeverityEnum::Warning, "systemInformation", "failed to detect processors topology");
+			}
+			return flatTopology();
+		}
+
+		struct SpreadKey
+		{
+			uint32 smt = 0, cls = 0, rank = 0, node = 0, id = 0;
+			auto operator <=> (const SpreadKey &) const = default;
+		};
+	}
+
+	ProcessorsTopology processorsTopologyFromSysfs(const String &root)
+	{
+		const String cpuDir = pathJoinUnchecked(root, "devices/system/cpu");
+		std::vector<uint32> ids;
+		if (!readCpuList(pathJoinUnchecked(cpuDir, "online"), ids) && !readCpuList(pathJoinUnchecked(cpuDir, "present"), ids))
+			CAGE_THROW_ERROR(Exception, "missing processors list in sysfs");
+		if (ids.empty())
+			CAGE_THROW_ERROR(Exception, "empty processors list in sysfs");
+
+		std::map<uint32, uint32> nodeOfCpu;
+		{
+			std::vector<uint32> nodes;
+			if (readCpuList(pathJoinUnchecked(root, "devices/system/node/online"), nodes))
+			{
+				for (uint32 n : nodes)
+				{
+					std::vector<uint32> cpus;
+					if (readCpuList(pathJoinUnchecked(root, Stringizer() + "devices/system/node/node" + n + "/cpulist"), cpus))
+						for (uint32 c : cpus)
+							nodeOfCpu[c] = n;
+				}
+			}
+		}
+
+		ProcessorsTopology t;
+		std::vector<uint32> capacities, frequencies;
+		for (uint32 id : ids)
+		{
+			const String dir = pathJoinUnchecked(cpuDir, Stringizer() + "cpu" + id);
+			ProcessorTopology p;
+			p.id = id;
+			p.package = readSysfsUint(pathJoinUnchecked(dir, "topology/physical_package_id"), 0);
+			{
+				// smallest sibling identifies the core
+				std::vector<uint32> siblings;
+				if ((readCpuList(pathJoinUnchecked(dir, "topology/core_cpus_list"), siblings) || readCpuList(pathJoinUnchecked(dir, "topology/thread_siblings_list"), siblings)) && !siblings.empty())
+					p.core = siblings[0];
+				else
+					p.core = (uint32)m - readSysfsUint(pathJoinUnchecked(dir, "topology/core_id"), id); // avoid collisions with the processor ids
+			}
+			{
+				const auto it = nodeOfCpu.find(id);
+				p.numaNode = it == nodeOfCpu.end() ? 0 : it->second;
+			}
+			{
+				// smallest processor sharing the highest level cache identifies the cache
+				p.cacheGroup = (uint32)m - p.package;
+				uint32 level = 0;
+				for (uint32 i = 0; i < 16; i++)
+				{
+					const String cdir = pathJoinUnchecked(dir, Stringizer() + "cache/index" + i);
+					const uint32 l = readSysfsUint(pathJoinUnchecked(cdir, "level"), m);
+					if (l == m)
+						break;
+					std::vector<uint32> shared;
+					if (l > level && readCpuList(pathJoinUnchecked(cdir, "shared_cpu_list"), shared) && !shared.empty())
+					{
+						level = l;
+						p.cacheGroup = shared[0];
+					}
+				}
+			}
+			capacities.push_back(readSysfsUint(pathJoinUnchecked(dir, "cpu_capacity"), 0));
+			frequencies.push_back(readSysfsUint(pathJoinUnchecked(dir, "cpufreq/cpuinfo_max_freq"), 0));
+			t.processors.push_back(p);
+		}
+
+		{
+			// intel hybrid processors expose separate pmu devices for each core type
+			std::vector<uint32> atoms;
+			if (readCpuList(pathJoinUnchecked(root, "devices/cpu_atom/cpus"), atoms))
+			{
+				for (ProcessorTopology &p : t.processors)
+					if (std::binary_search(atoms.begin(), atoms.end(), p.id))
+						p.processorClass = ProcessorClassEnum::Efficiency;
+			}
+			else if (std::find(capacities.begin(), capacities.end(), 0) == capacities.end())
+				classifyByValue(t, capacities); // arm big.little
+			else if (std::find(frequencies.begin(), frequencies.end(), 0) == frequencies.end())
+				classifyByValue(t, frequencies);
+		}
+
+		finalizeTopology(t);
+		return t;
+	}
+
+	const ProcessorsTopology &processorsTopology()
+	{
+		static const ProcessorsTopology topology = detectTopology();
+		return topology;
+	}
+
+	ThreadAffinityPolicyEnum threadAffinityPolicyFromString(const String &name)
+	{
+		const String n = toLower(name);
+		if (n == "none" || n.empty())
+			return ThreadAffinityPolicyEnum::None;
+		if (n == "spread")
+			return ThreadAffinityPolicyEnum::Spread;
+		if (n == "compact")
+			return ThreadAffinityPolicyEnum::Compact;
+		if (n == "performance")
+			return ThreadAffinityPolicyEnum::Performance;
+		if (n == "efficiency")
+			return ThreadAffinityPolicyEnum::Efficiency;
+		CAGE_LOG_THROW(Stringizer() + "affinity policy: " + name);
+		CAGE_THROW_ERROR(Exception, "unknown thread affinity policy");
+	}
+
+	std::vector<std::vector<uint32>> threadsAffinityPlan(const ProcessorsTopology &topology, ThreadAffinityPolicyEnum policy, uint32 threadsCount)
+	{
+		std::vector<std::vector<uint32>> res;
+		res.resize(threadsCount);
+		if (topology.processors.empty())
+			return res;
+
+		switch (policy)
+		{
+		case ThreadAffinityPolicyEnum::None:
+			break;
+		case ThreadAffinityPolicyEnum::Performance:
+		case ThreadAffinityPolicyEnum::Efficiency:
+		{
+			if (!topology.hybrid)
+				break; // all processors are of the same class
+			const ProcessorClassEnum cls = policy == ThreadAffinityPolicyEnum::Performance ? ProcessorClassEnum::Performance : ProcessorClassEnum::Efficiency;
+			std::vector<uint32> ids;
+			for (const ProcessorTopology &p : topology.processors)
+				if (p.processorClass == cls)
+					ids.push_back(p.id);
+			for (auto &r : res)
+				r = ids;
+		} break;
+		case ThreadAffinityPolicyEnum::Spread:
+		{
+			// nested round robin: numa nodes, then caches within each node
+			const std::vector<ProcessorTopology> &ps = topology.processors;
+			std::vector<uint32> rankInCache(ps.size()), rankInNode(ps.size());
+			{
+				std::map<std::tuple<uint32, uint32, uint32>, uint32> counters;
+				for (uint32 i = 0; i < ps.size(); i++) // processors are sorted by id, which typically follows cores
+					rankInCache[i] = counters[{ ps[i].smt, (uint32)ps[i].processorClass, ps[i].cacheGroup }]++;
+			}
+			{
+				std::vector<uint32> order;
+				for (uint32 i = 0; i < ps.size(); i++)
+					order.push_back(i);
+				std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return std::tuple(rankInCache[a], ps[a].cacheGroup, ps[a].id) < std::tuple(rankInCache[b], ps[b].cacheGroup, ps[b].id); });
+				std::map<std::tuple<uint32, uint32, uint32>, uint32> counters;
+				for (uint32 i : order)
+					rankInNode[i] = counters[{ ps[i].smt, (uint32)ps[i].processorClass, ps[i].numaNode }]++;
+			}
+			std::vector<SpreadKey> keys;
+			for (uint32 i = 0; i < ps.size(); i++)
+				keys.push_back({ ps[i].smt, (uint32)ps[i].processorClass, rankInNode[i], ps[i].numaNode, ps[i].id });
+			std::sort(keys.begin(), keys.end());
+			for (uint32 i = 0; i < threadsCount; i++)
+				res[i] = { keys[i % keys.size()].id };
+		} break;
+		case ThreadAffinityPolicyEnum::Compact:
+		{
+			std::vector<ProcessorTopology> ps = topology.processors;
+			std::sort(ps.begin(), ps.end(), [](const ProcessorTopology &a, const ProcessorTopology &b) { return std::tuple(a.numaNode, a.smt, a.processorClass, a.cacheGroup, a.core, a.id) < std::tuple(b.numaNode, b.smt, b.processorClass, b.cacheGroup, b.core, b.id); });
+			for (uint32 i = 0; i < threadsCount; i++)
+				res[i] = { ps[i % ps.size()].id };
+		} break;
+		default:
+			CAGE_THROW_CRITICAL(Exception, "invalid thread affinity policy");
+		}
+		return res;
+	}
+}
@@ -2,7 +2,6 @@
 
 #include <cage-core/profiling.h>
 #include <cage-core/concurrent.h>
-#include <cage-core/concurrentQueue.h>
 #include <cage-core/networkWebsocket.h>
 #include <cage-core/process.h>
 #include <cage-core/config.h>
@@ -28,25 +27,24 @@ namespace cage
 		constexpr String DefaultBrowser = "firefox";
 #endif // CAGE_SYSTEM_WINDOWS
 
-		constexpr uint64 ThreadNameSpecifier = (uint64)-2;
-
 		ConfigBool confEnabled("cage/profiling/enabled", false);
 		const ConfigBool confAutoStartClient("cage/profiling/autoStartClient", true);
 		const ConfigString confBrowser("cage/profiling/browser", DefaultBrowser);
+		const ConfigString confTraceFile("cage/profiling/traceFile", ""); // when not empty, events are written into this file (chrome trace format) instead of the live client
 
 		uint64 timestamp() noexcept
 		{
 			try
 			{
-				// ensures that all timestamps are unique
+				// ensures that all timestamps are unique, across all threads (the client uses them as keys)
 				static std::atomic<uint64> atom = 0;
 				uint64 newv = applicationTime();
-				uint64 oldv = atom.load();
+				uint64 oldv = atom.load(std::memory_order_relaxed);
 				do
 				{
 					if (oldv >= newv)
 						newv = oldv + 1;
-				} while (!atom.compare_exchange_weak(oldv, newv));
+				} while (!atom.compare_exchange_weak(oldv, newv, std::memory_order_relaxed));
 				return newv;
 			}
 			catch (...)
@@ -55,22 +53,128 @@ namespace cage
 			}
 		}
 
-		struct QueueItem
+		constexpr uint32 RecordsCapacity = 1 << 13; // per thread, events exceeding the capacity before the dispatcher collects them are dropped
+		constexpr uint32 DataCapacity = 1 << 9; // per thread, events exceeding the capacity lose their data
+		using DataString = detail::StringBase<123>; // longer data are truncated
+
+		struct EventRecord
 		{
-			String data;
-			StringLiteral name;
+			const char *name = nullptr; // interned by the string literal address
 			uint64 startTime = 0;
-			uint64 endTime = 0;
-			uint64 threadId = 0;
+			uint64 duration = 0;
+			uint32 dataIndex = 0;
+			bool hasData = false;
 			bool framing = false;
 		};
+		static_assert(sizeof(EventRecord) == 32);
+
+		// single producer (the owning thread), single consumer (the dispatcher)
+		struct ThreadRing : private Immovable
+		{
+			std::vector<EventRecord> records;
+			std::vector<DataString> datas;
+			std::atomic<uint32> recordsHead = 0; // written by producer
+			std::atomic<uint32> recordsTail = 0; // written by consumer
+			uint32 dataHead = 0; // producer only
+			std::atomic<uint32> dataTail = 0; // written by consumer
+			std::atomic<uint32> dropped = 0;
+			std::atomic<bool> finished = false;
+			String threadName; // guarded by the registry mutex
+			bool threadNameChanged = true; // guarded by the registry mutex
+			const uint64 threadId = currentThreadId();
+
+			ThreadRing()
+			{
+				records.resize(RecordsCapacity);
+				datas.resize(DataCapacity);
+			}
+
+			void push(const ProfilingEvent &ev, uint64 endTime) noexcept
+			{
+				const uint32 head = recordsHead.load(std::memory_order_relaxed);
+				if (head - recordsTail.load(std::memory_order_acquire) >= RecordsCapacity)
+				{
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				EventRecord &r = records[head % RecordsCapacity];
+				r.name = ev.name;
+				r.startTime = ev.startTime;
+				r.duration = endTime - ev.startTime;
+				r.framing = ev.framing;
+				r.hasData = false;
+				if (!ev.data.empty() && dataHead - dataTail.load(std::memory_order_acquire) < DataCapacity)
+				{
+					datas[dataHead % DataCapacity] = DataString(PointerRange<const char>(ev.data.begin(), ev.data.begin() + min(ev.data.length(), DataString::MaxLength)));
+					r.dataIndex = dataHead++;
+					r.hasData = true;
+				}
+				recordsHead.store(head + 1, std::memory_order_release);
+			}
 
-		using QueueType = ConcurrentQueue<QueueItem>;
+			template<class Consumer>
+			void drain(Consumer &consumer)
+			{
+				const uint32 head = recordsHead.load(std::memory_order_acquire);
+				uint32 tail = recordsTail.load(std::memory_order_relaxed);
+				static const DataString empty;
+				for (; tail != head; tail++)
+				{
+					const EventRecord &r = records[tail % RecordsCapacity];
+					if (r.hasData)
+					{
+						consumer(*this, r, datas[r.dataIndex % DataCapacity]);
+						dataTail.store(r.dataIndex + 1, std::memory_order_release);
+					}
+					else
+						consumer(*this, r, empty);
+				}
+				recordsTail.store(tail, std::memory_order_release);
+			}
+
+			bool empty() const noexcept
+			{
+				return recordsHead.load(std::memory_order_acquire) == recordsTail.load(std::memory_order_relaxed);
+			}
+		};
+
+		struct Registry : private Immovable
+		{
+			Holder<Mutex> mutex = newMutex();
+			std::vector<Holder<ThreadRing>> rings;
+		};
 
-		QueueType &queue()
+		Registry &registry()
 		{
-			static QueueType *q = new QueueType(); // intentional memory leak
-			return *q;
+			static Registry *r = new Registry(); // intentional memory leak
+			return *r;
+		}
+
+		struct ThreadRingHandle : private Immovable
+		{
+			Holder<ThreadRing> ring;
+
+			~ThreadRingHandle()
+			{
+				if (ring)
+					ring->finished = true;
+			}
+		};
+
+		thread_local ThreadRingHandle threadRingHandle;
+
+		ThreadRing *threadRing()
+		{
+			if (!threadRingHandle.ring) [[unlikely]]
+			{
+				Holder<ThreadRing> r = systemMemory().createHolder<ThreadRing>();
+				r->threadName = currentThreadName();
+				Registry &reg = registry();
+				ScopeLock lock(reg.mutex);
+				reg.rings.push_back(r.share());
+				threadRingHandle.ring = std::move(r);
+			}
+			return +threadRingHandle.ring;
 		}
 
 		constexpr String sanitize(const String &s)
@@ -94,6 +198,49 @@ namespace cage
 
 		static_assert(validateSanitize());
 
+		struct NamesMap
+		{
+			std::unordered_map<String, uint32> data;
+			std::unordered_map<const char *, uint32> literals;
+			uint32 next = 0;
+
+			uint32 index(const String &name)
+			{
+				const auto it = data.find(name);
+				if (it != data.end()) [[likely]]
+					return it->second;
+				return data[name] = next++;
+			}
+
+			uint32 index(const char *name)
+			{
+				const auto it = literals.find(name);
+				if (it != literals.end()) [[likely]]
+					return it->second;
+				return literals[name] = index(String(name));
+			}
+
+			std::string mapping() const
+			{
+				std::vector<const String *> v;
+				v.resize(data.size());
+				for (const auto &it : data)
+					v[it.second] = &it.first;
+
+				std::string str;
+				str.reserve(v.size() * 100);
+				for (const auto &n : v)
+					str += (Stringizer() + "\"" + sanitize(*n) + "\",\n ").value.c_str();
+				return str + "\"\"";
+			}
+
+			NamesMap()
+			{
+				data.reserve(200);
+				literals.reserve(200);
+			}
+		};
+
 		struct Dispatcher
 		{
 			struct Runner
@@ -102,58 +249,64 @@ namespace cage
 				Holder<WebsocketServer> server;
 				Holder<WebsocketConnection> connection;
 				Holder<Process> client;
+				Holder<File> traceFile;
+				String traceFileName;
+				std::atomic<bool> &stopping;
 
-				void eraseQueue()
+				explicit Runner(std::atomic<bool> &stopping) : stopping(stopping)
+				{}
+
+				~Runner()
 				{
-					QueueItem qi;
-					while (queue().tryPop(qi))
+					try
 					{
-						if (qi.startTime == ThreadNameSpecifier && qi.endTime == ThreadNameSpecifier)
-							threadNames[qi.threadId] = sanitize(qi.data);
+						closeTraceFile();
+					}
+					catch (...)
+					{
+						// nothing
 					}
 				}
 
-				void updateConnected()
+				template<class Consumer>
+				void drainAll(Consumer &consumer)
 				{
-					ProfilingScope profiling("connected");
-
-					struct NamesMap
+					std::vector<Holder<ThreadRing>> rings;
 					{
-						std::unordered_map<String, uint32> data;
-						uint32 next = 0;
-
-						uint32 index(const String &name)
+						Registry &reg = registry();
+						ScopeLock lock(reg.mutex);
+						std::erase_if(reg.rings, [](const Holder<ThreadRing> &r) { return r->finished && r->empty(); });
+						rings.reserve(reg.rings.size());
+						for (const auto &r : reg.rings)
 						{
-							const auto it = data.find(name);
-							if (it != data.end()) [[likely]]
-								return it->second;
-							return data[name] = next++;
+							if (r->threadNameChanged)
+							{
+								threadNames[r->threadId] = sanitize(r->threadName);
+								r->threadNameChanged = false;
+							}
+							rings.push_back(r.share());
 						}
+					}
+					for (const auto &r : rings)
+					{
+						r->drain(consumer);
+						const uint32 dropped = r->dropped.exchange(0, std::memory_order_relaxed);
+						if (dropped)
+							CAGE_LOG(SeverityEnum::Warning, "profiling", Stringizer() + "dropped " + dropped + " profiling events in thread: " + threadNames[r->threadId]);
+					}
+				}
 
-						uint32 index(StringLiteral name)
-						{
-							return index(String(name));
-						}
+				void eraseQueue()
+				{
+					const auto &consumer = [](const ThreadRing &, const EventRecord &, const DataString &) {};
+					drainAll(consumer);
+				}
 
-						std::string mapping() const
-						{
-							std::vector<const String *> v;
-							v.resize(data.size());
-							for (const auto &it : data)
-								v[it.second] = &it.first;
-
-							std::string str;
-							str.reserve(v.size() * 100);
-							for (const auto &n : v)
-								str += (Stringizer() + "\"" + sanitize(*n) + "\",\n ").value.c_str();
-							return str + "\"\"";
-						}
+				void updateConnected()
+				{
+					ProfilingScope profiling("connected");
 
-						NamesMap()
-						{
-							data.reserve(200);
-						}
-					} names;
+					NamesMap names;
 
 					struct ThreadData
 					{
@@ -166,17 +319,12 @@ namespace cage
 					};
 					std::unordered_map<uint64, ThreadData> data;
 
-					QueueItem qi;
-					while (queue().tryPop(qi))
+					const auto &consumer = [&](const ThreadRing &ring, const EventRecord &r, const DataString &d)
 					{
-						if (qi.startTime == ThreadNameSpecifier && qi.endTime == ThreadNameSpecifier)
-							threadNames[qi.threadId] = sanitize(qi.data);
-						else
-						{
-							const String s = Stringizer() + "[" + names.index(qi.name) + ",\"" + sanitize(qi.data) + "\"," + qi.startTime + "," + (qi.endTime - qi.startTime) + (qi.framing ? ",1" : "") + "], ";
-							data[qi.threadId].events += s.c_str();
-						}
-					}
+						const String s = Stringizer() + "[" + names.index(r.name) + ",\"" + sanitize(String(d)) + "\"," + r.startTime + "," + r.duration + (r.framing ? ",1" : "") + "], ";
+						data[ring.threadId].events += s.c_str();
+					};
+					drainAll(consumer);
 
 					std::string str = "{\"names\":[";
 					str += names.mapping();
@@ -238,28 +386,99 @@ namespace cage
 					eraseQueue();
 				}
 
+				// chrome trace event format (json array), viewable in chrome://tracing or perfetto
+				void updateTraceFile(const String &fileName)
+				{
+					ProfilingScope profiling("trace file");
+
+					if (fileName != traceFileName)
+					{
+						closeTraceFile();
+						traceFile = writeFile(fileName);
+						traceFile->write("[\n");
+						traceFileName = fileName;
+						for (const auto &it : threadNames)
+							writeThreadName(it.first, it.second);
+						CAGE_LOG(SeverityEnum::Info, "profiling", Stringizer() + "profiling into trace file: " + fileName);
+					}
+
+					const auto oldNames = threadNames;
+					std::string str;
+					str.reserve(100000);
+					const auto &consumer = [&](const ThreadRing &ring, const EventRecord &r, const DataString &d)
+					{
+						str += (Stringizer() + "{\"name\":\"" + sanitize(String(r.name)) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + ring.threadId + ",\"ts\":" + r.startTime + ",\"dur\":" + r.duration).value.c_str();
+						if (!d.empty())
+							str += (Stringizer() + ",\"args\":{\"data\":\"" + sanitize(String(d)) + "\"}").value.c_str();
+						str += "},\n";
+						if (str.size() > 90000)
+						{
+							traceFile->write(str);
+							str.clear();
+						}
+					};
+					drainAll(consumer);
+					traceFile->write(str);
+
+					for (const auto &it : threadNames)
+					{
+						const auto o = oldNames.find(it.first);
+						if (o == oldNames.end() || o->second != it.second)
+							writeThreadName(it.first, it.second);
+					}
+				}
+
+				void writeThreadName(uint64 threadId, const String &name)
+				{
+					traceFile->write(String(Stringizer() + "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + threadId + ",\"args\":{\"name\":\"" + name + "\"}},\n"));
+				}
+
+				void closeTraceFile()
+				{
+					if (!traceFile)
+						return;
+					traceFile->write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"cage\"}}\n]\n");
+					traceFile->close();
+					traceFile.clear();
+					traceFileName = "";
+				}
+
 				void updateDisabled()
 				{
 					ProfilingScope profiling("disabled");
 					server.clear();
 					connection.clear();
 					client.clear();
+					if (traceFile)
+						updateTraceFile(traceFileName); // events recorded before disabling still belong to the file
+					closeTraceFile();
 					eraseQueue();
 				}
 
 				void run()
 				{
-					while (!queue().stopped())
+					while (!stopping)
 					{
 						const bool enabled = confEnabled;
 						try
 						{
 							if (enabled)
 							{
-								if (connection)
-									updateConnected();
+								const String fileName = confTraceFile;
+								if (!fileName.empty())
+								{
+									server.clear();
+									connection.clear();
+									updateTraceFile(fileName);
+								}
 								else
-									updateConnecting();
+								{
+									closeTraceFile();
+									if (connection)
+										updateConnected();
+									else
+										updateConnecting();
+								}
 								threadSleep(50000);
 							}
 							else
@@ -277,13 +496,15 @@ namespace cage
 							}
 						}
 					}
+					if (traceFile)
+						updateTraceFile(traceFileName); // flush remaining events
 				}
 			};
 
 			void threadEntry()
 			{
 				sem->unlock();
-				Runner runner;
+				Runner runner(stopping);
 				runner.run();
 			}
 
@@ -297,7 +518,7 @@ namespace cage
 
 			~Dispatcher()
 			{
-				queue().terminate();
+				stopping = true;
 				try
 				{
 					thread->wait();
@@ -309,6 +530,7 @@ namespace cage
 				}
 			}
 
+			std::atomic<bool> stopping = false;
 			Holder<Semaphore> sem;
 			Holder<Thread> thread;
 		};
@@ -318,11 +540,12 @@ namespace cage
 	{
 		try
 		{
-			QueueItem qi;
-			qi.data = currentThreadName();
-			qi.threadId = currentThreadId();
-			qi.startTime = qi.endTime = ThreadNameSpecifier;
-			queue().push(qi);
+			if (!threadRingHandle.ring)
+				return; // the name will be picked up when the ring is created
+			Registry &reg = registry();
+			ScopeLock lock(reg.mutex);
+			threadRingHandle.ring->threadName = currentThreadName();
+			threadRingHandle.ring->threadNameChanged = true;
 		}
 		catch (...)
 		{
@@ -362,14 +585,7 @@ namespace cage
 			if (!confEnabled)
 				return;
 			static Dispatcher dispatcher;
-			QueueItem qi;
-			qi.name = ev.name;
-			qi.data = ev.data;
-			qi.startTime = ev.startTime;
-			qi.endTime = timestamp();
-			qi.threadId = currentThreadId();
-			qi.framing = ev.framing;
-			queue().push(qi);
+			threadRing()->push(ev, timestamp());
 		}
 		catch (...)
 		{
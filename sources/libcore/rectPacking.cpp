@@ -1,8 +1,12 @@
 #include <cage-core/rectPacking.h>
+#include <cage-core/math.h>
+#include <cage-core/pointerRangeHolder.h>
 
 #include <vector>
+#include <algorithm>
 
 #include <stb_rect_pack.h>
+#include <robin_hood.h>
 
 namespace cage
 {
@@ -96,4 +100,274 @@ namespace cage
 	{
 		return systemMemory().createImpl<RectPacking, RectPackingImpl>();
 	}
+
+	namespace
+	{
+		struct Slot
+		{
+			uint32 x = 0, y = 0, w = 0, h = 0;
+		};
+
+		struct Allocator
+		{
+			std::vector<Slot> frees;
+			uint64 usedArea = 0;
+
+			void reset(uint32 width, uint32 height)
+			{
+				frees.clear();
+				if (width > 0 && height > 0)
+					frees.push_back(Slot{ 0, 0, width, height });
+				usedArea = 0;
+			}
+
+			bool allocate(uint32 w, uint32 h, Slot &result)
+			{
+				if (w == 0 || h == 0)
+				{
+					result = Slot{ 0, 0, w, h }; // degenerate rectangle needs no space
+					return true;
+				}
+				// best area fit, ties broken by best short side fit
+				uint32 best = m;
+				uint64 bestArea = m;
+				uint32 bestSide = m;
+				for (uint32 i = 0, e = numeric_cast<uint32>(frees.size()); i < e; i++)
+				{
+					const Slot &f = frees[i];
+					if (f.w < w || f.h < h)
+						continue;
+					const uint64 area = uint64(f.w) * f.h - uint64(w) * h;
+					const uint32 side = min(f.w - w, f.h - h);
+					if (area < bestArea || (area == bestArea && side < bestSide))
+					{
+						best = i;
+						bestArea = area;
+						bestSide = side;
+						if (area == 0)
+							break;
+					}
+				}
+				if (best == m)
+					return false;
+
+				const Slot f = frees[best];
+				frees[best] = frees.back();
+				frees.pop_back();
+				result = Slot{ f.x, f.y, w, h };
+				usedArea += uint64(w) * h;
+
+				// split along the shorter leftover axis
+				Slot right, bottom;
+				if (f.w - w <= f.h - h)
+				{
+					right = Slot{ f.x + w, f.y, f.w - w, h };
+					bottom = Slot{ f.x, f.y + h, f.w, f.h - h };
+				}
+				else
+				{
+					right = Slot{ f.x + w, f.y, f.w - w, f.h };
+					bottom = Slot{ f.x, f.y + h, w, f.h - h };
+				}
+				if (right.w > 0 && right.h > 0)
+					frees.push_back(right);
+				if (bottom.w > 0 && bottom.h > 0)
+					frees.push_back(bottom);
+				return true;
+			}
+
+			static bool merge(Slot &a, const Slot &b)
+			{
+				if (a.x == b.x && a.w == b.w)
+				{
+					if (a.y + a.h == b.y)
+					{
+						a.h += b.h;
+						return true;
+					}
+					if (b.y + b.h == a.y)
+					{
+						a.y = b.y;
+						a.h += b.h;
+						return true;
+					}
+				}
+				if (a.y == b.y && a.h == b.h)
+				{
+					if (a.x + a.w == b.x)
+					{
+						a.w += b.w;
+						return true;
+					}
+					if (b.x + b.w == a.x)
+					{
+						a.x = b.x;
+						a.w += b.w;
+						return true;
+					}
+				}
+				return false;
+			}
+
+			void release(const Slot &s)
+			{
+				CAGE_ASSERT(usedArea >= uint64(s.w) * s.h);
+				if (s.w == 0 || s.h == 0)
+					return; // degenerate rectangle did not occupy any space
+				usedArea -= uint64(s.w) * s.h;
+				Slot c = s;
+				// merge with neighbors sharing a whole edge, repeat while the rectangle keeps growing
+				bool merged = true;
+				while (merged)
+				{
+					merged = false;
+					for (uint32 i = 0; i < frees.size(); i++)
+					{
+						if (merge(c, frees[i]))
+						{
+							frees[i] = frees.back();
+							frees.pop_back();
+							merged = true;
+							break;
+						}
+					}
+				}
+				frees.push_back(c);
+			}
+		};
+
+		class DynamicRectPackingImpl : public DynamicRectPacking
+		{
+		public:
+			const DynamicRectPackingCreateConfig config;
+			Allocator alloc;
+			robin_hood::unordered_map<uint32, PackingRect> rects;
+
+			DynamicRectPackingImpl(const DynamicRectPackingCreateConfig &config) : config(config)
+			{
+				alloc.reset(config.width, config.height);
+			}
+
+			Slot slot(const PackingRect &r) const
+			{
+				return Slot{ r.x - config.margin, r.y - config.margin, r.width + config.margin * 2, r.height + config.margin * 2 };
+			}
+
+			bool place(Allocator &a, PackingRect &r) const
+			{
+				Slot s;
+				if (!a.allocate(r.width + config.margin * 2, r.height + config.margin * 2, s))
+					return false;
+				r.x = s.x + config.margin;
+				r.y = s.y + config.margin;
+				return true;
+			}
+		};
+	}
+
+	bool DynamicRectPacking::insert(PackingRect &rect)
+	{
+		DynamicRectPackingImpl *impl = (DynamicRectPackingImpl *)this;
+		if (impl->rects.count(rect.id))
+			CAGE_THROW_ERROR(Exception, "duplicate id in dynamic rect packing");
+		if (!impl->place(impl->alloc, rect))
+			return false;
+		impl->rects[rect.id] = rect;
+		return true;
+	}
+
+	void DynamicRectPacking::remove(uint32 id)
+	{
+		DynamicRectPackingImpl *impl = (DynamicRectPackingImpl *)this;
+		auto it = impl->rects.find(id);
+		if (it == impl->rects.end())
+			CAGE_THROW_ERROR(Exception, "unknown id in dynamic rect packing");
+		const Slot s = impl->slot(it->second);
+		impl->rects.erase(it);
+		if (impl->rects.empty())
+			impl->alloc.reset(impl->config.width, impl->config.height);
+		else
+			impl->alloc.release(s);
+	}
+
+	bool DynamicRectPacking::has(uint32 id) const
+	{
+		const DynamicRectPackingImpl *impl = (const DynamicRectPackingImpl *)this;
+		return impl->rects.count(id) > 0;
+	}
+
+	PackingRect DynamicRectPacking::get(uint32 id) const
+	{
+		const DynamicRectPackingImpl *impl = (const DynamicRectPackingImpl *)this;
+		auto it = impl->rects.find(id);
+		if (it == impl->rects.end())
+			CAGE_THROW_ERROR(Exception, "unknown id in dynamic rect packing");
+		return it->second;
+	}
+
+	void DynamicRectPacking::clear()
+	{
+		DynamicRectPackingImpl *impl = (DynamicRectPackingImpl *)this;
+		impl->rects.clear();
+		impl->alloc.reset(impl->config.width, impl->config.height);
+	}
+
+	bool DynamicRectPacking::defragment(Holder<PointerRange<PackingRect>> &moved)
+	{
+		DynamicRectPackingImpl *impl = (DynamicRectPackingImpl *)this;
+		std::vector<PackingRect> all;
+		all.reserve(impl->rects.size());
+		for (const auto &it : impl->rects)
+			all.push_back(it.second);
+		// larger rectangles first, the id makes the order deterministic
+		std::sort(all.begin(), all.end(), [](const PackingRect &a, const PackingRect &b) {
+			if (a.height != b.height)
+				return a.height > b.height;
+			if (a.width != b.width)
+				return a.width > b.width;
+			return a.id < b.id;
+		});
+		Allocator a;
+		a.reset(impl->config.width, impl->config.height);
+		for (PackingRect &r : all)
+			if (!impl->place(a, r))
+				return false;
+		PointerRangeHolder<PackingRect> mv;
+		for (const PackingRect &r : all)
+		{
+			PackingRect &o = impl->rects[r.id];
+			if (o.x != r.x || o.y != r.y)
+				mv.push_back(r);
+			o = r;
+		}
+		impl->alloc = std::move(a);
+		moved = std::move(mv);
+		return true;
+	}
+
+	uint32 DynamicRectPacking::count() const
+	{
+		const DynamicRectPackingImpl *impl = (const DynamicRectPackingImpl *)this;
+		return numeric_cast<uint32>(impl->rects.size());
+	}
+
+	uint32 DynamicRectPacking::freeRectsCount() const
+	{
+		const DynamicRectPackingImpl *impl = (const DynamicRectPackingImpl *)this;
+		return numeric_cast<uint32>(impl->alloc.frees.size());
+	}
+
+	Real DynamicRectPacking::occupancy() const
+	{
+		const DynamicRectPackingImpl *impl = (const DynamicRectPackingImpl *)this;
+		const uint64 total = uint64(impl->config.width) * impl->config.height;
+		if (total == 0)
+			return 0;
+		return Real(double(impl->alloc.usedArea) / double(total));
+	}
+
+	Holder<DynamicRectPacking> newDynamicRectPacking(const DynamicRectPackingCreateConfig &config)
+	{
+		return systemMemory().createImpl<DynamicRectPacking, DynamicRectPackingImpl>(config);
+	}
 }
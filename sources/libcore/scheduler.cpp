@@ -1,17 +1,19 @@
 #include <cage-core/scheduler.h>
 #include <cage-core/timer.h>
 #include <cage-core/math.h> // max
-#include <cage-core/concurrent.h> // threadSleep
+#include <cage-core/concurrent.h> // threadSleep, Semaphore
 #include <cage-core/variableSmoothingBuffer.h>
 #include <cage-core/profiling.h>
+#include <cage-core/tasks.h>
 
 #include <vector>
 #include <algorithm>
 #include <atomic>
+#include <exception>
 
 namespace cage
 {
-	void ScheduleStatistics::add(uint64 delay, uint64 duration)
+	void ScheduleStatistics::add(uint64 delay, uint64 duration, uint64 deadline, uint64 budget)
 	{
 		delays.add(delay);
 		durations.add(duration);
@@ -20,6 +22,10 @@ namespace cage
 		maxDelay = max(maxDelay, delay);
 		maxDuration = max(maxDuration, duration);
 		runs++;
+		if (deadline && delay > deadline)
+			deadlineMisses++;
+		if (budget && duration > budget)
+			budgetOverruns++;
 	}
 
 	namespace
@@ -32,9 +38,14 @@ namespace cage
 			const ScheduleCreateConfig conf;
 			Holder<ScheduleStatistics> stats;
 			SchedulerImpl *schr = nullptr;
+			SchedulerImpl *asyncSchr = nullptr;
 			uint64 sched = m;
+			uint64 asyncStart = 0;
+			uint64 asyncEnd = 0;
 			sint32 pri = 0;
 			std::atomic<bool> active = false;
+			std::atomic<bool> finished = false; // the dispatched action has returned (or thrown)
+			bool running = false; // dispatched to the tasks executor
 
 			explicit ScheduleImpl(SchedulerImpl *schr, const ScheduleCreateConfig &config) : conf(config), schr(schr)
 			{
@@ -49,17 +60,28 @@ namespace cage
 			}
 		};
 
+		void scheduleAsyncEntry(ScheduleImpl &s, uint32);
+
+		struct InflightSchedule
+		{
+			Holder<ScheduleImpl> sched; // keeps the schedule alive even if detached while running
+			Holder<AsyncTask> task;
+		};
+
 		class SchedulerImpl : public Scheduler
 		{
 		public:
 			const SchedulerCreateConfig conf;
 			std::vector<Holder<ScheduleImpl>> scheds;
 			std::vector<ScheduleImpl*> tmp;
+			std::vector<InflightSchedule> inflight;
+			Holder<Semaphore> inflightWake = newSemaphore(0, 1000000); // posted by each dispatched action when it finishes
 			Holder<Timer> realTimer;
 			uint64 realDrift = 0; // offset for the real timer, this happens when switching lockstep mode
 			uint64 t = 0; // current time for scheduling events
 			uint64 lastTime = 0; // time at which the last schedule was run
 			sint32 lastPriority = 0;
+			uint64 runThreadId = m;
 			std::atomic<bool> stopping = false;
 			bool lockstepApi = false;
 			bool lockstepEffective = false;
@@ -110,7 +132,7 @@ namespace cage
 				{
 					if (it->conf.type == ScheduleTypeEnum::Empty)
 						continue;
-					if (it->sched > t)
+					if (it->sched > t || it->running)
 						continue;
 					if (it->conf.type == ScheduleTypeEnum::External && !it->active)
 						continue;
@@ -125,7 +147,7 @@ namespace cage
 				{
 					if (it->conf.type != ScheduleTypeEnum::Empty)
 						continue;
-					if (it->sched > t)
+					if (it->sched > t || it->running)
 						continue;
 					if (!it->active)
 						continue;
@@ -133,6 +155,11 @@ namespace cage
 				}
 			}
 
+			bool validThread() const
+			{
+				return runThreadId == m || runThreadId == currentThreadId();
+			}
+
 			uint64 adjustedRealTime()
 			{
 				return realTimer->duration() + realDrift;
@@ -152,6 +179,8 @@ namespace cage
 						continue;
 					if (it->conf.type == ScheduleTypeEnum::External && !it->active)
 						continue;
+					if (it->running)
+						continue;
 					res = min(res, it->sched);
 				}
 				return res;
@@ -165,7 +194,13 @@ namespace cage
 				s = min(s, conf.maxSleepDuration);
 				s = max(s, (uint64)1000); // some systems do not have higher precision sleeps; this will prevent busy looping
 				//CAGE_LOG(SeverityEnum::Info, "scheduler", stringizer() + "scheduler is going to sleep for " + s + " us");
-				threadSleep(s);
+				if (inflight.empty())
+					return threadSleep(s);
+				if (inflightWake->tryLock(s))
+				{
+					// multiple actions may have finished, they are all collected in the next iteration
+					while (inflightWake->tryLock(0));
+				}
 			}
 
 			void sortSchedulesByPriority()
@@ -173,23 +208,95 @@ namespace cage
 				for (const auto &it : tmp)
 					it->pri++;
 				std::stable_sort(tmp.begin(), tmp.end(), [](const ScheduleImpl *a, const ScheduleImpl *b) {
-					return a->pri > b->pri; // higher priority goes first
+					if (a->pri != b->pri)
+						return a->pri > b->pri; // higher priority goes first
+					return deadline(a) < deadline(b); // earlier deadline goes first
 				});
 			}
 
-			void runSchedule()
+			static uint64 deadline(const ScheduleImpl *s)
+			{
+				return s->conf.deadline ? s->sched + s->conf.deadline : (uint64)m;
+			}
+
+			void beginSchedule(ScheduleImpl *s)
 			{
-				ScheduleImpl *s = tmp[0];
 				//CAGE_LOG(SeverityEnum::Info, "scheduler", stringizer() + "running schedule: " + s->conf.name);
 				lastTime = s->sched;
 				lastPriority = s->pri;
 				s->pri = s->conf.priority;
 				s->active = false;
+			}
+
+			void runSchedule(ScheduleImpl *s)
+			{
+				beginSchedule(s);
 				const uint64 start = currentTime();
 				s->run(); // likely to throw
 				const uint64 end = currentTime();
+				finishSchedule(s, start, end);
+			}
+
+			void dispatchSchedule(ScheduleImpl *s)
+			{
+				beginSchedule(s);
+				s->running = true;
+				s->finished = false;
+				s->asyncSchr = this;
+				InflightSchedule f;
+				f.sched = std::find_if(scheds.begin(), scheds.end(), [&](const auto &a) { return +a == s; })->share();
+				f.task = tasksRunAsync<ScheduleImpl>(s->conf.name, Delegate<void(ScheduleImpl &, uint32)>().bind<&scheduleAsyncEntry>(), f.sched.share());
+				inflight.push_back(std::move(f));
+			}
+
+			void completeInflight(InflightSchedule &f)
+			{
+				ScheduleImpl *s = +f.sched;
+				s->running = false;
+				f.task->wait(); // rethrows exception from the action
+				finishSchedule(s, s->asyncStart, s->asyncEnd);
+			}
+
+			void collectInflight()
+			{
+				for (uint32 i = 0; i < inflight.size();)
+				{
+					if (!inflight[i].sched->finished)
+					{
+						i++;
+						continue;
+					}
+					InflightSchedule f = std::move(inflight[i]);
+					inflight.erase(inflight.begin() + i);
+					completeInflight(f);
+				}
+			}
+
+			void waitInflight()
+			{
+				std::exception_ptr exptr;
+				while (!inflight.empty())
+				{
+					InflightSchedule f = std::move(inflight.front());
+					inflight.erase(inflight.begin());
+					try
+					{
+						completeInflight(f);
+					}
+					catch (...)
+					{
+						if (!exptr)
+							exptr = std::current_exception();
+					}
+				}
+				if (exptr)
+					std::rethrow_exception(exptr);
+			}
+
+			void finishSchedule(ScheduleImpl *s, uint64 start, uint64 end)
+			{
 				if (s->stats)
-					s->stats->add(start - s->sched, end - start);
+					s->stats->add(start - s->sched, end - start, s->conf.deadline, s->conf.budget);
 				switch (s->conf.type)
 				{
 				case ScheduleTypeEnum::Once:
@@ -220,8 +327,12 @@ namespace cage
 				CAGE_ASSERT(!scheds.empty());
 				tmp.clear();
 				tmp.reserve(scheds.size());
+				collectInflight();
+				if (scheds.empty())
+					return; // the last schedule was once and has just finished
 				if (lockstepEffective != lockstepApi)
 				{
+					waitInflight(); // lockstep runs everything in this thread
 					if (!lockstepApi)
 					{
 						realDrift = t;
@@ -236,7 +347,16 @@ namespace cage
 				if (tmp.empty())
 					return goSleep();
 				sortSchedulesByPriority();
-				runSchedule();
+				if (conf.threaded && !lockstepEffective)
+				{
+					for (ScheduleImpl *s : tmp)
+						if (s->conf.independent)
+							dispatchSchedule(s);
+					std::erase_if(tmp, [](const ScheduleImpl *s) { return s->running; });
+					if (tmp.empty())
+						return;
+				}
+				runSchedule(tmp[0]);
 			}
 
 			void run()
@@ -244,10 +364,51 @@ namespace cage
 				reset();
 				checkNewSchedules();
 				stopping = false;
-				while (!stopping && !scheds.empty())
-					runIteration();
+				runThreadId = currentThreadId();
+				struct ThreadReset
+				{
+					uint64 &id;
+					~ThreadReset() { id = m; }
+				} threadReset{ runThreadId };
+				try
+				{
+					while (!stopping && !scheds.empty())
+						runIteration();
+				}
+				catch (...)
+				{
+					try
+					{
+						waitInflight();
+					}
+					catch (...)
+					{
+						// the first exception is propagated
+					}
+					throw;
+				}
+				waitInflight();
 			}
 		};
+
+		void scheduleAsyncEntry(ScheduleImpl &s, uint32)
+		{
+			SchedulerImpl *schr = s.asyncSchr;
+			s.asyncStart = schr->currentTime();
+			try
+			{
+				s.run();
+			}
+			catch (...)
+			{
+				s.finished = true;
+				schr->inflightWake->unlock();
+				throw;
+			}
+			s.asyncEnd = schr->currentTime();
+			s.finished = true;
+			schr->inflightWake->unlock(); // wake the scheduler thread
+		}
 	}
 
 	void Schedule::trigger()
@@ -286,6 +447,7 @@ namespace cage
 		ScheduleImpl *impl = (ScheduleImpl *)this;
 		if (!impl->schr)
 			return; // already detached
+		CAGE_ASSERT(impl->schr->validThread());
 		auto &vec = impl->schr->scheds;
 		impl->schr = nullptr;
 		auto it = std::find_if(vec.begin(), vec.end(), [&](const auto &a) { return +a == impl; });
@@ -310,6 +472,7 @@ namespace cage
 	void Schedule::priority(sint32 p)
 	{
 		ScheduleImpl *impl = (ScheduleImpl *)this;
+		CAGE_ASSERT(!impl->schr || impl->schr->validThread());
 		impl->pri = p;
 	}
 
@@ -346,6 +509,7 @@ namespace cage
 	Holder<Schedule> Scheduler::newSchedule(const ScheduleCreateConfig &config)
 	{
 		SchedulerImpl *impl = (SchedulerImpl *)this;
+		CAGE_ASSERT(impl->validThread());
 		auto sch = systemMemory().createHolder<ScheduleImpl>(impl, config);
 		impl->scheds.push_back(sch.share());
 		return std::move(sch).cast<Schedule>();
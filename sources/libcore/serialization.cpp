@@ -1,16 +1,21 @@
 #include <cage-core/memoryBuffer.h>
 #include <cage-core/serialization.h>
 #include <cage-core/lineReader.h>
+#include <cage-core/math.h>
+
+#include <exception> // std::uncaught_exceptions
 
 namespace cage
 {
-	Serializer::Serializer(PointerRange<char> buffer) : data(buffer.data()), size(buffer.size())
+	Serializer::Serializer(PointerRange<char> buffer) : data(buffer.data()), size(buffer.size()), capacity(buffer.size())
 	{}
 
-	Serializer::Serializer(MemoryBuffer &buffer, uintPtr size) : buffer(&buffer), size(size == m && buffer.size() != 0 ? buffer.size() : size)
-	{}
+	Serializer::Serializer(MemoryBuffer &buffer, uintPtr size) : buffer(&buffer), data(buffer.data()), size(size == m && buffer.size() != 0 ? buffer.size() : size)
+	{
+		capacity = min(this->size, buffer.capacity());
+	}
 
-	Serializer::Serializer(MemoryBuffer *buffer, char *data, uintPtr offset, uintPtr size) : buffer(buffer), data(data), offset(offset), size(size)
+	Serializer::Serializer(MemoryBuffer *buffer, char *data, uintPtr offset, uintPtr size) : buffer(buffer), data(data), offset(offset), size(size), capacity(size)
 	{}
 
 	uintPtr Serializer::available() const
@@ -19,17 +24,6 @@ namespace cage
 		return size - offset;
 	}
 
-	void Serializer::write(PointerRange<const char> buffer)
-	{
-		auto dst = advance(buffer.size());
-		detail::memcpy(dst.data(), buffer.data(), buffer.size());
-	}
-
-	PointerRange<char> Serializer::write(uintPtr size)
-	{
-		return advance(size);
-	}
-
 	void Serializer::writeLine(const String &line)
 	{
 		write(line);
@@ -43,16 +37,34 @@ namespace cage
 		return Serializer(buffer, data, o, offset);
 	}
 
-	PointerRange<char> Serializer::advance(uintPtr s)
+	void Serializer::writeVarint(uint64 value)
 	{
-		if (available() < s)
-			CAGE_THROW_ERROR(Exception, "serialization beyond available space");
-		if (!data)
+		char tmp[10];
+		uint32 n = 0;
+		while (value >= 0x80)
 		{
-			if (buffer->size() < offset + s)
-				buffer->resizeSmart(offset + s);
+			tmp[n++] = (char)((value & 0x7F) | 0x80);
+			value >>= 7;
 		}
-		char *dst = (data ? data : buffer->data()) + offset;
+		tmp[n++] = (char)value;
+		write({ tmp, tmp + n });
+	}
+
+	void Serializer::writeZigzag(sint64 value)
+	{
+		writeVarint((uint64(value) << 1) ^ uint64(value >> 63));
+	}
+
+	PointerRange<char> Serializer::advanceSlow(uintPtr s)
+	{
+		if (available() < s)
+			CAGE_THROW_ERROR(Exception, "serialization beyond available space");
+		CAGE_ASSERT(buffer);
+		if (buffer->size() < offset + s)
+			buffer->resizeSmart(offset + s);
+		data = buffer->data();
+		capacity = min(size, buffer->capacity());
+		char *dst = data + offset;
 		offset += s;
 		return { dst, dst + s };
 	}
@@ -69,19 +81,32 @@ namespace cage
 		return size - offset;
 	}
 
-	void Deserializer::read(PointerRange<char> buffer)
+	void Deserializer::outOfSpace()
 	{
-		auto src = read(buffer.size());
-		detail::memcpy(buffer.data(), src.data(), buffer.size());
+		CAGE_THROW_ERROR(Exception, "deserialization beyond available space");
 	}
 
-	PointerRange<const char> Deserializer::read(uintPtr s)
+	uint64 Deserializer::readVarint()
 	{
-		if (available() < s)
-			CAGE_THROW_ERROR(Exception, "deserialization beyond available space");
-		const char *dst = data + offset;
-		offset += s;
-		return { dst, dst + s };
+		uint64 value = 0;
+		for (uint32 shift = 0; shift < 64; shift += 7)
+		{
+			const uint8 b = (uint8)advance(1)[0];
+			value |= uint64(b & 0x7F) << shift;
+			if ((b & 0x80) == 0)
+			{
+				if (shift == 63 && b > 1)
+					break;
+				return value;
+			}
+		}
+		CAGE_THROW_ERROR(Exception, "invalid varint encoding");
+	}
+
+	sint64 Deserializer::readZigzag()
+	{
+		const uint64 v = readVarint();
+		return sint64(v >> 1) ^ -sint64(v & 1);
 	}
 
 	bool Deserializer::readLine(PointerRange<const char> &line)
@@ -121,4 +146,170 @@ namespace cage
 	{
 		return Deserializer(data, offset, size);
 	}
+
+	namespace
+	{
+		constexpr Real QuatRange = 0.70710678118654752440; // 1 / sqrt(2)
+
+		CAGE_FORCE_INLINE uint64 maxQuantized(uint32 bits)
+		{
+			CAGE_ASSERT(bits > 0 && bits <= 32);
+			return (uint64(1) << bits) - 1;
+		}
+	}
+
+	uint32 quantize(Real value, Real min, Real max, uint32 bits)
+	{
+		CAGE_ASSERT(max > min);
+		CAGE_ASSERT(value.valid());
+		const double t = (double(clamp(value, min, max).value) - min.value) / (double(max.value) - min.value);
+		return uint32(t * maxQuantized(bits) + 0.5);
+	}
+
+	Real dequantize(uint32 value, Real min, Real max, uint32 bits)
+	{
+		CAGE_ASSERT(max > min);
+		CAGE_ASSERT(value <= maxQuantized(bits));
+		const double t = double(value) / maxQuantized(bits);
+		return Real(min.value + t * (double(max.value) - min.value));
+	}
+
+	BitSerializer::BitSerializer(Serializer &ser) : ser(&ser)
+	{}
+
+	BitSerializer::~BitSerializer()
+	{
+		CAGE_ASSERT(count == 0 || std::uncaught_exceptions() > 0); // flush was not called
+	}
+
+	void BitSerializer::write(uint64 value, uint32 bits)
+	{
+		CAGE_ASSERT(bits <= 64);
+		if (bits > 32)
+		{
+			write(value & 0xFFFFFFFF, 32);
+			write(value >> 32, bits - 32);
+			return;
+		}
+		value &= (uint64(1) << bits) - 1;
+		accum |= value << count;
+		count += bits;
+		if (count >= 32)
+		{
+			const uint32 out = uint32(accum);
+			const char bytes[4] = { (char)out, (char)(out >> 8), (char)(out >> 16), (char)(out >> 24) };
+			ser->write({ bytes, bytes + 4 });
+			accum >>= 32;
+			count -= 32;
+		}
+	}
+
+	void BitSerializer::write(bool value)
+	{
+		write(uint64(value), 1);
+	}
+
+	void BitSerializer::writeQuantized(Real value, Real min, Real max, uint32 bits)
+	{
+		write(quantize(value, min, max, bits), bits);
+	}
+
+	void BitSerializer::writeNormalized(Vec3 value, uint32 bits)
+	{
+		CAGE_ASSERT(abs(lengthSquared(value) - 1) < 1e-3);
+		Vec2 p = Vec2(value[0], value[1]) / (abs(value[0]) + abs(value[1]) + abs(value[2]));
+		if (value[2] < 0)
+		{
+			const Vec2 s = Vec2(p[0] >= 0 ? 1 : -1, p[1] >= 0 ? 1 : -1);
+			p = (1 - Vec2(abs(p[1]), abs(p[0]))) * s;
+		}
+		writeQuantized(p[0], -1, 1, bits);
+		writeQuantized(p[1], -1, 1, bits);
+	}
+
+	void BitSerializer::writeNormalized(Quat value, uint32 bits)
+	{
+		CAGE_ASSERT(abs(lengthSquared(value) - 1) < 1e-3);
+		uint32 largest = 0;
+		for (uint32 i = 1; i < 4; i++)
+			if (abs(value[i]) > abs(value[largest]))
+				largest = i;
+		if (value[largest] < 0)
+			value = -value;
+		write(largest, 2);
+		for (uint32 i = 0; i < 4; i++)
+			if (i != largest)
+				writeQuantized(value[i], -QuatRange, QuatRange, bits);
+	}
+
+	void BitSerializer::flush()
+	{
+		while (count > 0)
+		{
+			const char b = (char)accum;
+			ser->write({ &b, &b + 1 });
+			accum >>= 8;
+			count = count > 8 ? count - 8 : 0;
+		}
+		accum = 0;
+	}
+
+	BitDeserializer::BitDeserializer(Deserializer &des) : des(&des)
+	{}
+
+	uint64 BitDeserializer::read(uint32 bits)
+	{
+		CAGE_ASSERT(bits <= 64);
+		if (bits > 32)
+		{
+			const uint64 low = read(32);
+			return low | (read(bits - 32) << 32);
+		}
+		while (count < bits)
+		{
+			accum |= uint64((uint8)des->read(1)[0]) << count;
+			count += 8;
+		}
+		const uint64 r = bits == 0 ? 0 : accum & ((uint64(1) << bits) - 1);
+		accum >>= bits;
+		count -= bits;
+		return r;
+	}
+
+	bool BitDeserializer::readBool()
+	{
+		return read(1) != 0;
+	}
+
+	Real BitDeserializer::readQuantized(Real min, Real max, uint32 bits)
+	{
+		return dequantize(numeric_cast<uint32>(read(bits)), min, max, bits);
+	}
+
+	Vec3 BitDeserializer::readNormalizedVec3(uint32 bits)
+	{
+		const Real x = readQuantized(-1, 1, bits);
+		const Real y = readQuantized(-1, 1, bits);
+		Vec3 v = Vec3(x, y, 1 - abs(x) - abs(y));
+		const Real t = max(-v[2], 0);
+		v[0] += v[0] >= 0 ? -t : t;
+		v[1] += v[1] >= 0 ? -t : t;
+		return normalize(v);
+	}
+
+	Quat BitDeserializer::readNormalizedQuat(uint32 bits)
+	{
+		const uint32 largest = numeric_cast<uint32>(read(2));
+		Quat q;
+		Real sum = 0;
+		for (uint32 i = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+			q[i] = readQuantized(-QuatRange, QuatRange, bits);
+			sum += sqr(q[i]);
+		}
+		q[largest] = sqrt(max(1 - sum, 0));
+		return normalize(q);
+	}
 }
@@ -1,4 +1,5 @@
 #include <cage-core/math.h>
+#include <cage-core/mat3x4.h>
 #include <cage-core/memoryBuffer.h>
 #include <cage-core/serialization.h>
 #include <cage-core/pointerRangeHolder.h>
@@ -12,6 +13,55 @@ namespace cage
 {
 	namespace
 	{
+		constexpr float KeyQuantization = 65535;
+
+		// keyframes of one track with times and values quantized to 16 bits
+		struct CompressedTrack
+		{
+			std::vector<uint16> times; // coefficient multiplied by KeyQuantization
+			std::vector<uint16> values; // all components of all keyframes
+			Vec4 offset;
+			Vec4 extent;
+
+			template<uint32 Components>
+			CAGE_FORCE_INLINE Vec4 value(uint32 key) const
+			{
+				Vec4 r;
+				const uint16 *v = values.data() + key * Components;
+				for (uint32 i = 0; i < Components; i++)
+					r[i] = offset[i] + extent[i] * (v[i] / KeyQuantization);
+				return r;
+			}
+		};
+
+		template<class T>
+		constexpr uint32 componentsCount()
+		{
+			if constexpr (std::is_same_v<T, Quat>)
+				return 4;
+			else
+				return 3;
+		}
+
+		CAGE_FORCE_INLINE Vec4 toVec4(const Vec3 &v)
+		{
+			return Vec4(v, 0);
+		}
+
+		CAGE_FORCE_INLINE Vec4 toVec4(const Quat &q)
+		{
+			return Vec4(q[0], q[1], q[2], q[3]);
+		}
+
+		template<class T>
+		CAGE_FORCE_INLINE T fromVec4(const Vec4 &v)
+		{
+			if constexpr (std::is_same_v<T, Quat>)
+				return normalize(Quat(v[0], v[1], v[2], v[3]));
+			else
+				return Vec3(v);
+		}
+
 		class SkeletalAnimationImpl : public SkeletalAnimation
 		{
 		public:
@@ -26,19 +76,38 @@ namespace cage
 			std::vector<std::vector<Real>> scaleTimes;
 			std::vector<std::vector<Vec3>> scaleValues;
 
+			// used instead of the raw data above when compressed
+			std::vector<CompressedTrack> positionTracks;
+			std::vector<CompressedTrack> rotationTracks;
+			std::vector<CompressedTrack> scaleTracks;
+			bool compressed = false;
+
 			uint64 duration = 0;
 			uint32 skeletonName = 0;
 
-			static uint16 findFrameIndex(Real coef, const std::vector<Real> &times)
+			uint32 channels() const
+			{
+				return numeric_cast<uint32>(compressed ? positionTracks.size() : positionTimes.size());
+			}
+
+			// hint is the frame found by previous evaluation of the same channel
+			// consecutive evaluations usually land in the same or the following frame, avoiding the binary search
+			template<class Time>
+			static uint16 findFrameIndex(Real coef, PointerRange<const Time> times, uint16 &hint)
 			{
-				CAGE_ASSERT(coef >= 0 && coef <= 1);
 				CAGE_ASSERT(!times.empty());
-				if (coef <= times[0])
-					return 0;
-				if (coef >= times[times.size() - 1])
-					return numeric_cast<uint16>(times.size() - 1);
-				auto it = std::lower_bound(times.begin(), times.end(), coef);
-				return numeric_cast<uint16>(it - times.begin() - 1);
+				const uint32 frames = numeric_cast<uint32>(times.size());
+				if (coef <= Real(times[0]))
+					return hint = 0;
+				if (coef >= Real(times[frames - 1]))
+					return hint = numeric_cast<uint16>(frames - 1);
+				// same predicate as the lower_bound below: times[i] < coef <= times[i + 1]
+				if (hint + 1u < frames && Real(times[hint]) < coef && coef <= Real(times[hint + 1]))
+					return hint;
+				if (hint + 2u < frames && Real(times[hint + 1]) < coef && coef <= Real(times[hint + 2]))
+					return ++hint;
+				auto it = std::lower_bound(times.begin(), times.end(), coef, [](const Time &a, Real b) { return Real(a) < b; });
+				return hint = numeric_cast<uint16>(it - times.begin() - 1);
 			}
 
 			static Real amount(Real a, Real b, Real c)
@@ -54,7 +123,7 @@ namespace cage
 			}
 
 			template<class Type>
-			static Type evaluateMatrix(Real coef, const std::vector<Real> &times, const std::vector<Type> &values)
+			static Type evaluateMatrix(Real coef, const std::vector<Real> &times, const std::vector<Type> &values, uint16 &hint)
 			{
 				const uint32 frames = numeric_cast<uint32>(times.size());
 				switch (frames)
@@ -63,7 +132,7 @@ namespace cage
 				case 1: return values[0];
 				default:
 				{
-					uint16 frameIndex = findFrameIndex(coef, times);
+					uint16 frameIndex = findFrameIndex<Real>(coef, times, hint);
 					if (frameIndex + 1 == frames)
 						return values[frameIndex];
 					else
@@ -75,19 +144,194 @@ namespace cage
 				}
 			}
 
-			Mat4 evaluateBone(uint16 bone, Real coef, const Mat4 &fallback) const
+			// decompresses the two neighboring keyframes only
+			template<class Type>
+			static Type evaluateCompressed(Real coef, const CompressedTrack &track, uint16 &hint)
+			{
+				constexpr uint32 N = componentsCount<Type>();
+				const uint32 frames = numeric_cast<uint32>(track.times.size());
+				switch (frames)
+				{
+				case 0: return Type();
+				case 1: return fromVec4<Type>(track.value<N>(0));
+				default:
+				{
+					const Real c = coef * KeyQuantization;
+					uint16 frameIndex = findFrameIndex<uint16>(c, track.times, hint);
+					if (frameIndex + 1 == frames)
+						return fromVec4<Type>(track.value<N>(frameIndex));
+					else
+					{
+						Real a = amount(track.times[frameIndex], track.times[frameIndex + 1], c);
+						return interpolate(fromVec4<Type>(track.value<N>(frameIndex)), fromVec4<Type>(track.value<N>(frameIndex + 1)), a);
+					}
+				}
+				}
+			}
+
+			// hints: three frame indices (position, rotation, scale) per channel
+			void evaluateChannel(uint16 ch, Real coef, uint16 *hints, Vec3 &position, Quat &rotation, Vec3 &scale) const
 			{
 				CAGE_ASSERT(coef >= 0 && coef <= 1);
-				CAGE_ASSERT(bone < channelsMapping.size());
-				const uint16 ch = channelsMapping[bone];
-				if (ch == m)
-					return fallback; // this bone is not animated
-				const Mat4 S = Mat4::scale(evaluateMatrix(coef, scaleTimes[ch], scaleValues[ch]));
-				const Mat4 R = Mat4(evaluateMatrix(coef, rotationTimes[ch], rotationValues[ch]));
-				const Mat4 T = Mat4(evaluateMatrix(coef, positionTimes[ch], positionValues[ch]));
-				return T * R * S;
+				hints += ch * 3;
+				if (compressed)
+				{
+					position = evaluateCompressed<Vec3>(coef, positionTracks[ch], hints[0]);
+					rotation = evaluateCompressed<Quat>(coef, rotationTracks[ch], hints[1]);
+					scale = evaluateCompressed<Vec3>(coef, scaleTracks[ch], hints[2]);
+				}
+				else
+				{
+					position = evaluateMatrix(coef, positionTimes[ch], positionValues[ch], hints[0]);
+					rotation = evaluateMatrix(coef, rotationTimes[ch], rotationValues[ch], hints[1]);
+					scale = evaluateMatrix(coef, scaleTimes[ch], scaleValues[ch], hints[2]);
+				}
+			}
+
+			void decompress();
+		};
+
+		class SkeletalAnimationCursorImpl : public SkeletalAnimationCursor
+		{
+		public:
+			std::vector<uint16> hints; // three per channel
+			const SkeletalAnimation *animation = nullptr;
+
+			uint16 *prepare(const SkeletalAnimationImpl *anim)
+			{
+				const uint32 cnt = anim->channels() * 3;
+				if (animation != anim || hints.size() != cnt)
+				{
+					// hints are validated before use, so a stale cursor is only slower, never wrong
+					animation = anim;
+					hints.clear();
+					hints.resize(cnt, 0);
+				}
+				return hints.data();
 			}
 		};
+
+		CAGE_FORCE_INLINE bool withinTolerance(const Vec3 &a, const Vec3 &b, Real tolerance)
+		{
+			return distance(a, b) <= tolerance;
+		}
+
+		CAGE_FORCE_INLINE bool withinTolerance(const Quat &a, const Quat &b, Real tolerance)
+		{
+			return abs(dot(a, b)) >= cos(Rads(tolerance * 0.5));
+		}
+
+		// indices of keyframes needed to reproduce the track with piecewise interpolation within the tolerance
+		template<class T>
+		std::vector<uint32> reduceKeyframes(const std::vector<Real> &times, const std::vector<T> &values, Real tolerance)
+		{
+			const uint32 cnt = numeric_cast<uint32>(times.size());
+			std::vector<uint32> keep;
+			if (cnt == 0)
+				return keep;
+			keep.push_back(0);
+			uint32 anchor = 0;
+			while (anchor + 1 < cnt)
+			{
+				uint32 end = anchor + 1;
+				while (end + 1 < cnt)
+				{
+					const uint32 candidate = end + 1;
+					const Real span = times[candidate] - times[anchor];
+					bool ok = span > 0;
+					for (uint32 k = anchor + 1; k < candidate && ok; k++)
+						ok = withinTolerance(interpolate(values[anchor], values[candidate], (times[k] - times[anchor]) / span), values[k], tolerance);
+					if (!ok)
+						break;
+					end = candidate;
+				}
+				keep.push_back(end);
+				anchor = end;
+			}
+			if (keep.size() == 2)
+			{
+				bool constant = true;
+				for (uint32 k = 1; k < cnt && constant; k++)
+					constant = withinTolerance(values[0], values[k], tolerance);
+				if (constant)
+					keep.pop_back();
+			}
+			return keep;
+		}
+
+		template<class T>
+		CompressedTrack compressTrack(const std::vector<Real> &times, std::vector<T> values, Real tolerance)
+		{
+			constexpr uint32 N = componentsCount<T>();
+			if constexpr (N == 4)
+			{
+				// keep consecutive rotations in the same hemisphere so that their components are continuous
+				for (uint32 i = 1; i < values.size(); i++)
+					if (dot(values[i - 1], values[i]) < 0)
+						values[i] = values[i] * -1;
+			}
+			const std::vector<uint32> keep = reduceKeyframes(times, values, tolerance);
+			CompressedTrack t;
+			if (keep.empty())
+				return t;
+			Vec4 a = toVec4(values[keep[0]]), b = a;
+			for (uint32 k : keep)
+			{
+				a = min(a, toVec4(values[k]));
+				b = max(b, toVec4(values[k]));
+			}
+			t.offset = a;
+			t.extent = b - a;
+			t.times.reserve(keep.size());
+			t.values.reserve(keep.size() * N);
+			for (uint32 k : keep)
+			{
+				t.times.push_back(numeric_cast<uint16>(round(saturate(times[k]) * KeyQuantization).value));
+				const Vec4 v = toVec4(values[k]);
+				for (uint32 i = 0; i < N; i++)
+				{
+					const Real q = t.extent[i] > 0 ? saturate((v[i] - t.offset[i]) / t.extent[i]) : Real(0);
+					t.values.push_back(numeric_cast<uint16>(round(q * KeyQuantization).value));
+				}
+			}
+			return t;
+		}
+
+		template<class T>
+		void decompressTrack(const CompressedTrack &track, std::vector<Real> &times, std::vector<T> &values)
+		{
+			constexpr uint32 N = componentsCount<T>();
+			times.clear();
+			values.clear();
+			for (uint32 k = 0; k < track.times.size(); k++)
+			{
+				times.push_back(track.times[k] / KeyQuantization);
+				values.push_back(fromVec4<T>(track.value<N>(k)));
+			}
+		}
+
+		void SkeletalAnimationImpl::decompress()
+		{
+			if (!compressed)
+				return;
+			const uint32 cnt = channels();
+			positionTimes.resize(cnt);
+			positionValues.resize(cnt);
+			rotationTimes.resize(cnt);
+			rotationValues.resize(cnt);
+			scaleTimes.resize(cnt);
+			scaleValues.resize(cnt);
+			for (uint32 i = 0; i < cnt; i++)
+			{
+				decompressTrack(positionTracks[i], positionTimes[i], positionValues[i]);
+				decompressTrack(rotationTracks[i], rotationTimes[i], rotationValues[i]);
+				decompressTrack(scaleTracks[i], scaleTimes[i], scaleValues[i]);
+			}
+			positionTracks.clear();
+			rotationTracks.clear();
+			scaleTracks.clear();
+			compressed = false;
+		}
 	}
 
 	void SkeletalAnimation::clear()
@@ -100,6 +344,10 @@ namespace cage
 		impl->rotationValues.clear();
 		impl->scaleTimes.clear();
 		impl->scaleValues.clear();
+		impl->positionTracks.clear();
+		impl->rotationTracks.clear();
+		impl->scaleTracks.clear();
+		impl->compressed = false;
 	}
 
 	Holder<SkeletalAnimation> SkeletalAnimation::copy() const
@@ -140,6 +388,32 @@ namespace cage
 			return des;
 		}
 
+		Serializer &operator << (Serializer &ser, CompressedTrack &track)
+		{
+			ser << track.times;
+			ser << track.values;
+			ser << track.offset;
+			ser << track.extent;
+			return ser;
+		}
+
+		Deserializer &operator >> (Deserializer &des, CompressedTrack &track)
+		{
+			des >> track.times;
+			des >> track.values;
+			des >> track.offset;
+			des >> track.extent;
+			return des;
+		}
+
+		template<class T>
+		void serializeCompressed(SkeletalAnimationImpl *impl, T &ser)
+		{
+			ser << impl->positionTracks;
+			ser << impl->rotationTracks;
+			ser << impl->scaleTracks;
+		}
+
 		template<class T>
 		void serialize(SkeletalAnimationImpl *impl, T &ser)
 		{
@@ -161,6 +435,12 @@ namespace cage
 		MemoryBuffer buff;
 		Serializer ser(buff);
 		cage::serialize(impl, ser);
+		if (impl->compressed)
+		{
+			// appended after the raw data (which are empty) to keep uncompressed buffers in the original format
+			ser << uint8(1);
+			serializeCompressed(impl, ser);
+		}
 		return PointerRangeHolder<char>(PointerRange<char>(buff));
 	}
 
@@ -170,6 +450,17 @@ namespace cage
 		impl->clear();
 		Deserializer des(buffer);
 		cage::serialize(impl, des);
+		if (des.available() > 0)
+		{
+			uint8 format = 0;
+			des >> format;
+			if (format != 1)
+				CAGE_THROW_ERROR(Exception, "unknown skeletal animation format");
+			serializeCompressed(impl, des);
+			impl->compressed = true;
+			CAGE_ASSERT(impl->positionTracks.size() == impl->rotationTracks.size());
+			CAGE_ASSERT(impl->positionTracks.size() == impl->scaleTracks.size());
+		}
 		CAGE_ASSERT(des.available() == 0);
 	}
 
@@ -196,6 +487,7 @@ namespace cage
 	{
 		SkeletalAnimationImpl *impl = (SkeletalAnimationImpl *)this;
 		CAGE_ASSERT(times.size() == values.size());
+		impl->decompress();
 		assign<Real>(impl->positionTimes, times);
 		assign<Vec3>(impl->positionValues, values);
 	}
@@ -204,6 +496,7 @@ namespace cage
 	{
 		SkeletalAnimationImpl *impl = (SkeletalAnimationImpl *)this;
 		CAGE_ASSERT(times.size() == values.size());
+		impl->decompress();
 		assign<Real>(impl->rotationTimes, times);
 		assign<Quat>(impl->rotationValues, values);
 	}
@@ -212,6 +505,7 @@ namespace cage
 	{
 		SkeletalAnimationImpl *impl = (SkeletalAnimationImpl *)this;
 		CAGE_ASSERT(times.size() == values.size());
+		impl->decompress();
 		assign<Real>(impl->scaleTimes, times);
 		assign<Vec3>(impl->scaleValues, values);
 	}
@@ -225,7 +519,37 @@ namespace cage
 	uint32 SkeletalAnimation::channelsCount() const
 	{
 		const SkeletalAnimationImpl *impl = (const SkeletalAnimationImpl *)this;
-		return numeric_cast<uint32>(impl->positionTimes.size());
+		return impl->channels();
+	}
+
+	void SkeletalAnimation::compress(const SkeletalAnimationCompressionConfig &config)
+	{
+		SkeletalAnimationImpl *impl = (SkeletalAnimationImpl *)this;
+		impl->decompress(); // recompression starts from the already quantized data
+		const uint32 cnt = impl->channels();
+		CAGE_ASSERT(impl->rotationTimes.size() == cnt && impl->scaleTimes.size() == cnt);
+		impl->positionTracks.reserve(cnt);
+		impl->rotationTracks.reserve(cnt);
+		impl->scaleTracks.reserve(cnt);
+		for (uint32 i = 0; i < cnt; i++)
+		{
+			impl->positionTracks.push_back(compressTrack(impl->positionTimes[i], impl->positionValues[i], config.positionTolerance));
+			impl->rotationTracks.push_back(compressTrack(impl->rotationTimes[i], impl->rotationValues[i], config.rotationTolerance.value));
+			impl->scaleTracks.push_back(compressTrack(impl->scaleTimes[i], impl->scaleValues[i], config.scaleTolerance));
+		}
+		impl->positionTimes.clear();
+		impl->positionValues.clear();
+		impl->rotationTimes.clear();
+		impl->rotationValues.clear();
+		impl->scaleTimes.clear();
+		impl->scaleValues.clear();
+		impl->compressed = true;
+	}
+
+	bool SkeletalAnimation::compressed() const
+	{
+		const SkeletalAnimationImpl *impl = (const SkeletalAnimationImpl *)this;
+		return impl->compressed;
 	}
 
 	void SkeletalAnimation::duration(uint64 duration)
@@ -257,6 +581,18 @@ namespace cage
 		return systemMemory().createImpl<SkeletalAnimation, SkeletalAnimationImpl>();
 	}
 
+	void SkeletalAnimationCursor::reset()
+	{
+		SkeletalAnimationCursorImpl *impl = (SkeletalAnimationCursorImpl *)this;
+		impl->hints.clear();
+		impl->animation = nullptr;
+	}
+
+	Holder<SkeletalAnimationCursor> newSkeletalAnimationCursor()
+	{
+		return systemMemory().createImpl<SkeletalAnimationCursor, SkeletalAnimationCursorImpl>();
+	}
+
 	namespace
 	{
 		class SkeletonRigImpl : public SkeletonRig
@@ -266,6 +602,61 @@ namespace cage
 			std::vector<uint16> boneParents;
 			std::vector<Mat4> baseMatrices;
 			std::vector<Mat4> invRestMatrices;
+
+			// affine copies of the above, used by the fast path
+			Mat3x4 globalInverseAffine;
+			std::vector<Mat3x4> baseAffine;
+			std::vector<Mat3x4> invRestAffine;
+			bool affine = false;
+
+			// base matrices decomposed, used by additive layers on bones without other animation
+			std::vector<Vec3> basePositions;
+			std::vector<Quat> baseRotations;
+			std::vector<Vec3> baseScales;
+
+			static bool isAffine(const Mat4 &m)
+			{
+				return abs(m[3]) < 1e-5 && abs(m[7]) < 1e-5 && abs(m[11]) < 1e-5 && abs(m[15] - 1) < 1e-5;
+			}
+
+			void updateCaches()
+			{
+				basePositions.clear();
+				baseRotations.clear();
+				baseScales.clear();
+				for (const Mat4 &m : baseMatrices)
+				{
+					basePositions.push_back(Vec3(m[12], m[13], m[14]));
+					Mat3 r = Mat3(m);
+					Vec3 sc;
+					for (uint32 c = 0; c < 3; c++)
+					{
+						sc[c] = length(Vec3(r[c * 3 + 0], r[c * 3 + 1], r[c * 3 + 2]));
+						if (sc[c] > 0)
+							for (uint32 k = 0; k < 3; k++)
+								r[c * 3 + k] /= sc[c];
+					}
+					baseRotations.push_back(Quat(r));
+					baseScales.push_back(sc);
+				}
+
+				baseAffine.clear();
+				invRestAffine.clear();
+				affine = isAffine(globalInverse);
+				for (const Mat4 &m : baseMatrices)
+					affine = affine && isAffine(m);
+				for (const Mat4 &m : invRestMatrices)
+					affine = affine && isAffine(m);
+				if (!affine)
+					return;
+				globalInverseAffine = Mat3x4(globalInverse);
+				baseAffine.reserve(baseMatrices.size());
+				for (const Mat4 &m : baseMatrices)
+					baseAffine.push_back(Mat3x4(m));
+				invRestAffine.reserve(invRestMatrices.size());
+				for (const Mat4 &m : invRestMatrices)
+					invRestAffine.push_back(Mat3x4(m));
+			}
 		};
 	}
 
@@ -275,6 +666,12 @@ namespace cage
 		impl->boneParents.clear();
 		impl->baseMatrices.clear();
 		impl->invRestMatrices.clear();
+		impl->baseAffine.clear();
+		impl->invRestAffine.clear();
+		impl->affine = false;
+		impl->basePositions.clear();
+		impl->baseRotations.clear();
+		impl->baseScales.clear();
 	}
 
 	Holder<SkeletonRig> SkeletonRig::copy() const
@@ -314,6 +711,7 @@ namespace cage
 		CAGE_ASSERT(impl->boneParents.size() == impl->baseMatrices.size());
 		CAGE_ASSERT(impl->boneParents.size() == impl->invRestMatrices.size());
 		CAGE_ASSERT(des.available() == 0);
+		impl->updateCaches();
 	}
 
 	void SkeletonRig::skeletonData(const Mat4 &globalInverse, PointerRange<const uint16> parents, PointerRange<const Mat4> bases, PointerRange<const Mat4> invRests)
@@ -326,6 +724,7 @@ namespace cage
 		impl->boneParents = std::vector(parents.begin(), parents.end());
 		impl->baseMatrices = std::vector(bases.begin(), bases.end());
 		impl->invRestMatrices = std::vector(invRests.begin(), invRests.end());
+		impl->updateCaches();
 	}
 
 	uint32 SkeletonRig::bonesCount() const
@@ -365,48 +764,365 @@ namespace cage
 
 	namespace
 	{
-		void animateTemporary(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> temporary)
+		// affine product, the implicit last row of both matrices is (0, 0, 0, 1)
+		CAGE_FORCE_INLINE void multiply(const Mat3x4 &a, const Mat3x4 &b, Mat3x4 &r)
 		{
-			CAGE_ASSERT(coef >= 0 && coef <= 1);
-			const SkeletonRigImpl *impl = (const SkeletonRigImpl *)skeleton;
-			const SkeletalAnimationImpl *anim = (const SkeletalAnimationImpl *)animation;
-			const uint32 totalBones = skeleton->bonesCount();
+			for (uint32 i = 0; i < 3; i++)
+				r.data[i] = b.data[0] * a.data[i][0] + b.data[1] * a.data[i][1] + b.data[2] * a.data[i][2] + Vec4(0, 0, 0, a.data[i][3]);
+		}
+
+		struct AnimationScratch
+		{
+			SkeletalAnimationCursorImpl cursor; // shared by layers without their own cursor
+
+			// local transformations of all bones as structure of arrays: position xyz, rotation xyzw, scale xyz
+			std::vector<float> components;
+			std::vector<Real> weights;
+			std::vector<Real> baseWeights; // summed weights of regular layers that do not animate the bone
+			std::vector<uint32> contributions; // zero -> the bone uses its base matrix
+
+			std::vector<Mat3x4> locals;
+			std::vector<Mat3x4> globals;
+			std::vector<Mat4> generic;
+
+			uint32 bones = 0;
+
+			CAGE_FORCE_INLINE float *component(uint32 index)
+			{
+				return components.data() + index * bones;
+			}
+
+			CAGE_FORCE_INLINE void load(uint32 i, Vec3 &p, Quat &r, Vec3 &s)
+			{
+				for (uint32 k = 0; k < 3; k++)
+					p[k] = component(k)[i];
+				for (uint32 k = 0; k < 4; k++)
+					r[k] = component(3 + k)[i];
+				for (uint32 k = 0; k < 3; k++)
+					s[k] = component(7 + k)[i];
+			}
+
+			CAGE_FORCE_INLINE void store(uint32 i, const Vec3 &p, const Quat &r, const Vec3 &s)
+			{
+				for (uint32 k = 0; k < 3; k++)
+					component(k)[i] = p[k].value;
+				for (uint32 k = 0; k < 4; k++)
+					component(3 + k)[i] = r[k].value;
+				for (uint32 k = 0; k < 3; k++)
+					component(7 + k)[i] = s[k].value;
+			}
+		};
+
+		AnimationScratch &animationScratch()
+		{
+			static thread_local AnimationScratch scratch;
+			return scratch;
+		}
+
+		// evaluates and blends all layers in single pass over the bones
+		void sampleLayers(const SkeletonRigImpl *rig, PointerRange<const SkeletalAnimationLayer> layers, AnimationScratch &s)
+		{
+			const uint32 totalBones = numeric_cast<uint32>(rig->boneParents.size());
+			s.bones = totalBones;
+			s.components.resize(totalBones * 10);
+			s.weights.clear();
+			s.weights.resize(totalBones, 0);
+			s.baseWeights.clear();
+			s.baseWeights.resize(totalBones, 0);
+			s.contributions.clear();
+			s.contributions.resize(totalBones, 0);
+
+			// regular layers are averaged by their weights
+			for (const SkeletalAnimationLayer &l : layers)
+			{
+				if (l.additive || !(l.weight > 0))
+					continue;
+				const SkeletalAnimationImpl *anim = (const SkeletalAnimationImpl *)l.animation;
+				CAGE_ASSERT(anim->channelsMapping.size() == totalBones);
+				uint16 *hints = (l.cursor ? (SkeletalAnimationCursorImpl *)l.cursor : &s.cursor)->prepare(anim);
+				for (uint32 i = 0; i < totalBones; i++)
+				{
+					const uint16 ch = anim->channelsMapping[i];
+					if (ch == m)
+					{
+						s.baseWeights[i] += l.weight;
+						continue;
+					}
+					Vec3 p, sc;
+					Quat r;
+					anim->evaluateChannel(ch, l.coefficient, hints, p, r, sc);
+					if (s.contributions[i] == 0)
+					{
+						// stored unweighted so that a single layer is not affected by rounding
+						s.store(i, p, r, sc);
+						s.weights[i] = l.weight;
+					}
+					else
+					{
+						Vec3 ap, as;
+						Quat ar;
+						s.load(i, ap, ar, as);
+						if (s.contributions[i] == 1)
+						{
+							const Real w = s.weights[i];
+							ap *= w;
+							ar = ar * w;
+							as *= w;
+						}
+						if (dot(ar, r) < 0)
+							r = r * -1;
+						s.store(i, ap + p * l.weight, ar + r * l.weight, as + sc * l.weight);
+						s.weights[i] += l.weight;
+					}
+					s.contributions[i]++;
+				}
+			}
+
+			// layers that do not animate a bone hold it in the base pose with their weight
+			// bones not animated by any regular layer keep using the base matrix directly
+			for (uint32 i = 0; i < totalBones; i++)
+			{
+				if (s.contributions[i] == 0 || !(s.baseWeights[i] > 0))
+					continue;
+				Vec3 ap, as;
+				Quat ar;
+				s.load(i, ap, ar, as);
+				if (s.contributions[i] == 1)
+				{
+					const Real w = s.weights[i];
+					ap *= w;
+					ar = ar * w;
+					as *= w;
+				}
+				const Real bw = s.baseWeights[i];
+				Quat r = rig->baseRotations[i];
+				if (dot(ar, r) < 0)
+					r = r * -1;
+				s.store(i, ap + rig->basePositions[i] * bw, ar + r * bw, as + rig->baseScales[i] * bw);
+				s.weights[i] += bw;
+				s.contributions[i]++;
+			}
+
+			for (uint32 i = 0; i < totalBones; i++)
+			{
+				if (s.contributions[i] < 2)
+					continue;
+				Vec3 p, sc;
+				Quat r;
+				s.load(i, p, r, sc);
+				const Real w = s.weights[i];
+				s.store(i, p / w, normalize(r), sc / w);
+			}
+
+			// additive layers are applied on top of the blended pose
+			for (const SkeletalAnimationLayer &l : layers)
+			{
+				if (!l.additive || l.weight == 0)
+					continue;
+				const SkeletalAnimationImpl *anim = (const SkeletalAnimationImpl *)l.animation;
+				CAGE_ASSERT(anim->channelsMapping.size() == totalBones);
+				uint16 *hints = (l.cursor ? (SkeletalAnimationCursorImpl *)l.cursor : &s.cursor)->prepare(anim);
+				for (uint32 i = 0; i < totalBones; i++)
+				{
+					const uint16 ch = anim->channelsMapping[i];
+					if (ch == m)
+						continue;
+					if (s.contributions[i] == 0)
+					{
+						s.store(i, rig->basePositions[i], rig->baseRotations[i], rig->baseScales[i]);
+						s.contributions[i] = 1;
+					}
+					Vec3 dp, ds, p, sc;
+					Quat dr, r;
+					anim->evaluateChannel(ch, l.coefficient, hints, dp, dr, ds);
+					s.load(i, p, r, sc);
+					s.store(i, p + dp * l.weight, normalize(r * slerp(Quat(), dr, l.weight)), sc * interpolate(Vec3(1), ds, l.weight));
+				}
+			}
+		}
+
+		// local matrices T * R * S of all bones, branchless so that it vectorizes
+		void composeLocals(AnimationScratch &s)
+		{
+			const uint32 totalBones = s.bones;
+			const float *const tx = s.component(0), *const ty = s.component(1), *const tz = s.component(2);
+			const float *const qx = s.component(3), *const qy = s.component(4), *const qz = s.component(5), *const qw = s.component(6);
+			const float *const sx = s.component(7), *const sy = s.component(8), *const sz = s.component(9);
+			s.locals.resize(totalBones);
+			static_assert(sizeof(Mat3x4) == 12 * sizeof(float));
+			float *const out = (float *)s.locals.data();
+			for (uint32 j = 0; j < totalBones; j++)
+			{
+				const float x = qx[j], y = qy[j], z = qz[j], w = qw[j];
+				const float x2 = x * x, y2 = y * y, z2 = z * z;
+				const float xy = x * y, xz = x * z, yz = y * z;
+				const float wx = w * x, wy = w * y, wz = w * z;
+				float *o = out + j * 12;
+				o[0] = (1 - 2 * (y2 + z2)) * sx[j];
+				o[1] = 2 * (xy - wz) * sy[j];
+				o[2] = 2 * (xz + wy) * sz[j];
+				o[3] = tx[j];
+				o[4] = 2 * (xy + wz) * sx[j];
+				o[5] = (1 - 2 * (x2 + z2)) * sy[j];
+				o[6] = 2 * (yz - wx) * sz[j];
+				o[7] = ty[j];
+				o[8] = 2 * (xz - wy) * sx[j];
+				o[9] = 2 * (yz + wx) * sy[j];
+				o[10] = (1 - 2 * (x2 + y2)) * sz[j];
+				o[11] = tz[j];
+			}
+		}
+
+		void animateTemporary(const SkeletonRigImpl *rig, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat3x4> temporary, AnimationScratch &s)
+		{
+			CAGE_ASSERT(rig->affine);
+			sampleLayers(rig, layers, s);
+			composeLocals(s);
+			// accumulate the hierarchy, parents always precede their children
+			const uint32 totalBones = s.bones;
+			for (uint32 i = 0; i < totalBones; i++)
+			{
+				const Mat3x4 &local = s.contributions[i] ? s.locals[i] : rig->baseAffine[i];
+				const uint16 p = rig->boneParents[i];
+				if (p == m)
+					temporary[i] = local;
+				else
+				{
+					CAGE_ASSERT(p < i);
+					multiply(temporary[p], local, temporary[i]);
+				}
+			}
+		}
+
+		void animateTemporary(const SkeletonRigImpl *rig, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat4> temporary, AnimationScratch &s)
+		{
+			sampleLayers(rig, layers, s);
+			const uint32 totalBones = s.bones;
 			for (uint32 i = 0; i < totalBones; i++)
 			{
-				const uint16 p = impl->boneParents[i];
+				Mat4 local = rig->baseMatrices[i];
+				if (s.contributions[i])
+				{
+					Vec3 p, sc;
+					Quat r;
+					s.load(i, p, r, sc);
+					local = Mat4(p) * Mat4(r) * Mat4::scale(sc);
+				}
+				const uint16 p = rig->boneParents[i];
 				if (p == m)
-					temporary[i] = Mat4();
+					temporary[i] = local;
 				else
 				{
 					CAGE_ASSERT(p < i);
-					temporary[i] = temporary[p];
+					temporary[i] = temporary[p] * local;
 				}
-				temporary[i] = temporary[i] * anim->evaluateBone(i, coef, impl->baseMatrices[i]);
 				CAGE_ASSERT(temporary[i].valid());
 			}
 		}
-	}
 
-	void animateSkin(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output)
-	{
-		CAGE_ASSERT(coef >= 0 && coef <= 1);
-		const SkeletonRigImpl *impl = (const SkeletonRigImpl *)skeleton;
-		const uint32 totalBones = skeleton->bonesCount();
-		animateTemporary(skeleton, animation, coef, output);
-		for (uint32 i = 0; i < totalBones; i++)
+		template<class M>
+		void animateSkinImpl(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<M> output)
 		{
-			output[i] = impl->globalInverse * output[i] * impl->invRestMatrices[i];
-			CAGE_ASSERT(output[i].valid());
+			const SkeletonRigImpl *impl = (const SkeletonRigImpl *)skeleton;
+			const uint32 totalBones = skeleton->bonesCount();
+			CAGE_ASSERT(output.size() >= totalBones);
+			AnimationScratch &s = animationScratch();
+			if (impl->affine)
+			{
+				Mat3x4 *tmp = nullptr;
+				if constexpr (std::is_same_v<M, Mat3x4>)
+					tmp = output.data();
+				else
+				{
+					s.globals.resize(totalBones);
+					tmp = s.globals.data();
+				}
+				animateTemporary(impl, layers, { tmp, tmp + totalBones }, s);
+				Mat3x4 a;
+				for (uint32 i = 0; i < totalBones; i++)
+				{
+					multiply(impl->globalInverseAffine, tmp[i], a);
+					multiply(a, impl->invRestAffine[i], tmp[i]);
+				}
+				if constexpr (!std::is_same_v<M, Mat3x4>)
+				{
+					for (uint32 i = 0; i < totalBones; i++)
+						output[i] = Mat4(tmp[i]);
+				}
+			}
+			else
+			{
+				s.generic.resize(totalBones);
+				animateTemporary(impl, layers, s.generic, s);
+				for (uint32 i = 0; i < totalBones; i++)
+				{
+					const Mat4 r = impl->globalInverse * s.generic[i] * impl->invRestMatrices[i];
+					CAGE_ASSERT(r.valid());
+					output[i] = M(r);
+				}
+			}
+		}
+
+		CAGE_FORCE_INLINE SkeletalAnimationLayer singleLayer(const SkeletalAnimation *animation, Real coef, SkeletalAnimationCursor *cursor)
+		{
+			CAGE_ASSERT(coef >= 0 && coef <= 1);
+			SkeletalAnimationLayer l;
+			l.animation = animation;
+			l.cursor = cursor;
+			l.coefficient = coef;
+			return l;
 		}
 	}
 
-	void animateSkeleton(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output)
+	void animateSkin(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output, SkeletalAnimationCursor *cursor)
+	{
+		const SkeletalAnimationLayer l = singleLayer(animation, coef, cursor);
+		animateSkinImpl<Mat4>(skeleton, { &l, &l + 1 }, output);
+	}
+
+	void animateSkin(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat3x4> output, SkeletalAnimationCursor *cursor)
+	{
+		const SkeletalAnimationLayer l = singleLayer(animation, coef, cursor);
+		animateSkinImpl<Mat3x4>(skeleton, { &l, &l + 1 }, output);
+	}
+
+	void animateSkin(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat4> output)
+	{
+		animateSkinImpl<Mat4>(skeleton, layers, output);
+	}
+
+	void animateSkin(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat3x4> output)
+	{
+		animateSkinImpl<Mat3x4>(skeleton, layers, output);
+	}
+
+	void animateSkeleton(const SkeletonRig *skeleton, const SkeletalAnimation *animation, Real coef, PointerRange<Mat4> output, SkeletalAnimationCursor *cursor)
+	{
+		const SkeletalAnimationLayer l = singleLayer(animation, coef, cursor);
+		animateSkeleton(skeleton, { &l, &l + 1 }, output);
+	}
+
+	void animateSkeleton(const SkeletonRig *skeleton, PointerRange<const SkeletalAnimationLayer> layers, PointerRange<Mat4> output)
 	{
 		const SkeletonRigImpl *impl = (const SkeletonRigImpl *)skeleton;
 		const uint32 totalBones = skeleton->bonesCount();
-		std::vector<Mat4> tmp;
-		tmp.resize(totalBones);
-		animateTemporary(skeleton, animation, coef, tmp);
+		AnimationScratch &s = animationScratch();
+		std::vector<Vec3> positions;
+		positions.reserve(totalBones);
+		if (impl->affine)
+		{
+			s.globals.resize(totalBones);
+			animateTemporary(impl, layers, s.globals, s);
+			for (const Mat3x4 &t : s.globals)
+				positions.push_back(Vec3(t.data[0][3], t.data[1][3], t.data[2][3]));
+		}
+		else
+		{
+			s.generic.resize(totalBones);
+			animateTemporary(impl, layers, s.generic, s);
+			for (const Mat4 &t : s.generic)
+				positions.push_back(Vec3(t * Vec4(0, 0, 0, 1)));
+		}
 		for (uint32 i = 0; i < totalBones; i++)
 		{
 			const uint16 p = impl->boneParents[i];
@@ -414,8 +1130,8 @@ namespace cage
 				output[i] = Mat4::scale(0); // degenerate
 			else
 			{
-				const Vec3 a = Vec3(tmp[p] * Vec4(0, 0, 0, 1));
-				const Vec3 b = Vec3(tmp[i] * Vec4(0, 0, 0, 1));
+				const Vec3 a = positions[p];
+				const Vec3 b = positions[i];
 				Transform tr;
 				tr.position = a;
 				tr.scale = distance(a, b);
@@ -2,6 +2,7 @@
 #include <cage-core/concurrent.h>
 #include <cage-core/assetManager.h>
 #include <cage-core/memoryAlloca.h>
+#include <cage-core/mat3x4.h>
 #include <cage-core/skeletalAnimation.h>
 #include <cage-core/skeletalAnimationPreparator.h>
 
@@ -19,8 +20,16 @@ namespace cage
 			explicit SkeletalAnimationPreparatorCollectionImpl(AssetManager *assets, bool animateSkeletonsInsteadOfSkins) : assets(assets), animateSkeletonsInsteadOfSkins(animateSkeletonsInsteadOfSkins)
 			{}
 
-			robin_hood::unordered_map<void *, Holder<class SkeletalAnimationPreparatorInstanceImpl>> objects;
+			struct CursorEntry
+			{
+				Holder<SkeletalAnimationCursor> cursor;
+				uint32 lastUse = 0;
+			};
+
+			robin_hood::unordered_map<void *, Holder<class SkeletalAnimationPreparatorInstanceImpl>> objects; // cleared every frame
+			robin_hood::unordered_map<void *, CursorEntry> cursors; // persist across frames
 			Holder<Mutex> mutex = newMutex();
+			uint32 frame = 0;
 			AssetManager *assets = nullptr;
 			bool animateSkeletonsInsteadOfSkins = false;
 		};
@@ -28,7 +37,7 @@ namespace cage
 		class SkeletalAnimationPreparatorInstanceImpl : public SkeletalAnimationPreparatorInstance
 		{
 		public:
-			explicit SkeletalAnimationPreparatorInstanceImpl(Holder<SkeletalAnimation> animation, Real coefficient, SkeletalAnimationPreparatorCollectionImpl *impl) : animation(std::move(animation)), coefficient(coefficient), impl(impl)
+			explicit SkeletalAnimationPreparatorInstanceImpl(Holder<SkeletalAnimation> animation, Real coefficient, Holder<SkeletalAnimationCursor> cursor, SkeletalAnimationPreparatorCollectionImpl *impl) : animation(std::move(animation)), cursor(std::move(cursor)), coefficient(coefficient), impl(impl)
 			{}
 
 			void prepare()
@@ -48,19 +57,25 @@ namespace cage
 				const uint32 bonesCount = skeleton->bonesCount();
 				CAGE_ASSERT(bonesCount > 0);
 				CAGE_ASSERT(animation->bonesCount() == bonesCount);
-				Mat4 *tmpArmature = (Mat4 *)CAGE_ALLOCA(sizeof(Mat4) * bonesCount);
 				if (impl->animateSkeletonsInsteadOfSkins)
-					animateSkeleton(+skeleton, +animation, coefficient, { tmpArmature, tmpArmature + bonesCount });
+				{
+					Mat4 *tmpArmature = (Mat4 *)CAGE_ALLOCA(sizeof(Mat4) * bonesCount);
+					animateSkeleton(+skeleton, +animation, coefficient, { tmpArmature, tmpArmature + bonesCount }, +cursor);
+					armature.reserve(bonesCount);
+					for (uint32 i = 0; i < bonesCount; i++)
+						armature.emplace_back(tmpArmature[i]);
+				}
 				else
-					animateSkin(+skeleton, +animation, coefficient, { tmpArmature, tmpArmature + bonesCount });
-				armature.reserve(bonesCount);
-				for (uint32 i = 0; i < bonesCount; i++)
-					armature.emplace_back(tmpArmature[i]);
+				{
+					armature.resize(bonesCount);
+					animateSkin(+skeleton, +animation, coefficient, armature, +cursor);
+				}
 			}
 
 			std::vector<Mat3x4> armature;
 			Holder<AsyncTask> task;
 			Holder<SkeletalAnimation> animation;
+			Holder<SkeletalAnimationCursor> cursor; // shared with the collection, keeps the keyframes found in previous frames
 			Real coefficient = Real::Nan();
 			SkeletalAnimationPreparatorCollectionImpl *impl = nullptr;
 		};
@@ -92,7 +107,11 @@ namespace cage
 			CAGE_ASSERT(it->second->coefficient == coefficient);
 			return it->second.share().cast<SkeletalAnimationPreparatorInstance>();
 		}
-		Holder<SkeletalAnimationPreparatorInstanceImpl> inst = systemMemory().createHolder<SkeletalAnimationPreparatorInstanceImpl>(std::move(animation), coefficient, impl);
+		auto &cur = impl->cursors[object];
+		if (!cur.cursor)
+			cur.cursor = newSkeletalAnimationCursor();
+		cur.lastUse = impl->frame;
+		Holder<SkeletalAnimationPreparatorInstanceImpl> inst = systemMemory().createHolder<SkeletalAnimationPreparatorInstanceImpl>(std::move(animation), coefficient, cur.cursor.share(), impl);
 		impl->objects[object] = inst.share();
 		return std::move(inst).cast<SkeletalAnimationPreparatorInstance>();
 	}
@@ -102,6 +121,22 @@ namespace cage
 		SkeletalAnimationPreparatorCollectionImpl *impl = (SkeletalAnimationPreparatorCollectionImpl *)this;
 		ScopeLock lock(impl->mutex);
 		impl->objects.clear();
+		// cursors of objects not seen since the previous clear are released
+		for (auto it = impl->cursors.begin(); it != impl->cursors.end();)
+		{
+			if (impl->frame - it->second.lastUse > 1)
+				it = impl->cursors.erase(it);
+			else
+				it++;
+		}
+		impl->frame++;
+	}
+
+	uint32 SkeletalAnimationPreparatorCollection::cursorsCount() const
+	{
+		const SkeletalAnimationPreparatorCollectionImpl *impl = (const SkeletalAnimationPreparatorCollectionImpl *)this;
+		ScopeLock lock(impl->mutex);
+		return numeric_cast<uint32>(impl->cursors.size());
 	}
 
 	Holder<SkeletalAnimationPreparatorCollection> newSkeletalAnimationPreparatorCollection(AssetManager *assets, bool animateSkeletonsInsteadOfSkins)
@@ -0,0 +1,199 @@
+#include <cage-core/spatialCulling.h>
+#include <cage-core/spatialStructure.h>
+#include <cage-core/pointerRangeHolder.h>
+
+#include <robin_hood.h>
+
+#include <vector>
+
+namespace cage
+{
+	namespace
+	{
+		struct Item
+		{
+			Aabb box;
+			uint32 changed = 0; // commit index of last change
+			bool isStatic = false; // present in the structure with up-to-date box
+		};
+
+		bool finite(const Aabb &box)
+		{
+			for (uint32 i = 0; i < 3; i++)
+				if (!box.a[i].finite() || !box.b[i].finite())
+					return false;
+			return true;
+		}
+
+		class SpatialCullingImpl : public SpatialCulling
+		{
+		public:
+			const SpatialCullingCreateConfig config;
+			Holder<SpatialStructure> structure = newSpatialStructure({});
+			robin_hood::unordered_map<uint32, Item> items;
+			robin_hood::unordered_set<uint32> dynamic;
+			std::vector<std::pair<uint32, Aabb>> dynamicBoxes;
+			uint32 staticCount = 0;
+			uint32 stale = 0; // items in the structure which have changed or were removed since
+			uint32 commitIndex = 0;
+			bool committed = true;
+
+			SpatialCullingImpl(const SpatialCullingCreateConfig &config) : config(config), commitIndex(config.settleCommits)
+			{}
+
+			bool settled(const Item &it) const
+			{
+				return it.changed + config.settleCommits <= commitIndex && finite(it.box);
+			}
+
+			void update(uint32 name, const Aabb &box)
+			{
+				committed = false;
+				auto it = items.find(name);
+				if (it == items.end())
+				{
+					// new items are expected to be static
+					items[name].box = box;
+					dynamic.insert(name);
+					return;
+				}
+				Item &i = it->second;
+				if (i.box == box)
+					return;
+				i.box = box;
+				i.changed = commitIndex;
+				if (i.isStatic)
+				{
+					i.isStatic = false;
+					stale++;
+				}
+				dynamic.insert(name);
+			}
+
+			void remove(uint32 name)
+			{
+				committed = false;
+				auto it = items.find(name);
+				if (it == items.end())
+					return;
+				if (it->second.isStatic)
+					stale++;
+				dynamic.erase(name);
+				items.erase(it);
+			}
+
+			void clear()
+			{
+				items.clear();
+				dynamic.clear();
+				dynamicBoxes.clear();
+				structure->clear();
+				structure->rebuild();
+				staticCount = stale = 0;
+				committed = true;
+			}
+
+			void rebuild()
+			{
+				structure->clear();
+				staticCount = 0;
+				for (auto &it : items)
+				{
+					if (!it.second.isStatic && !settled(it.second))
+						continue;
+					if (!it.second.box.empty())
+						structure->update(it.first, it.second.box);
+					it.second.isStatic = true;
+					staticCount++;
+					dynamic.erase(it.first);
+				}
+				structure->rebuild();
+				stale = 0;
+			}
+
+			void commit()
+			{
+				uint32 settledCount = 0;
+				for (uint32 name : dynamic)
+					settledCount += settled(items[name]);
+				if (settledCount + stale > 64 + staticCount / 8)
+					rebuild();
+				dynamicBoxes.clear();
+				dynamicBoxes.reserve(dynamic.size());
+				for (uint32 name : dynamic)
+					dynamicBoxes.emplace_back(name, items[name].box);
+				commitIndex++;
+				committed = true;
+			}
+
+			Holder<PointerRange<uint32>> cull(const Frustum &frustum) const
+			{
+				CAGE_ASSERT(committed);
+				PointerRangeHolder<uint32> res;
+				if (staticCount)
+				{
+					Holder<SpatialQuery> query = newSpatialQuery(structure.share());
+					query->intersection(frustum);
+					res.reserve(query->result().size() + dynamicBoxes.size());
+					for (uint32 name : query->result())
+					{
+						const auto it = items.find(name);
+						if (it != items.end() && it->second.isStatic)
+							res.push_back(name);
+					}
+				}
+				for (const auto &it : dynamicBoxes)
+					if (intersects(it.second, frustum))
+						res.push_back(it.first);
+				return res;
+			}
+		};
+	}
+
+	void SpatialCulling::update(uint32 name, const Aabb &box)
+	{
+		SpatialCullingImpl *impl = (SpatialCullingImpl *)this;
+		impl->update(name, box);
+	}
+
+	void SpatialCulling::remove(uint32 name)
+	{
+		SpatialCullingImpl *impl = (SpatialCullingImpl *)this;
+		impl->remove(name);
+	}
+
+	void SpatialCulling::clear()
+	{
+		SpatialCullingImpl *impl = (SpatialCullingImpl *)this;
+		impl->clear();
+	}
+
+	void SpatialCulling::commit()
+	{
+		SpatialCullingImpl *impl = (SpatialCullingImpl *)this;
+		impl->commit();
+	}
+
+	Holder<PointerRange<uint32>> SpatialCulling::cull(const Frustum &frustum) const
+	{
+		const SpatialCullingImpl *impl = (const SpatialCullingImpl *)this;
+		return impl->cull(frustum);
+	}
+
+	uint32 SpatialCulling::count() const
+	{
+		const SpatialCullingImpl *impl = (const SpatialCullingImpl *)this;
+		return numeric_cast<uint32>(impl->items.size());
+	}
+
+	uint32 SpatialCulling::dynamicCount() const
+	{
+		const SpatialCullingImpl *impl = (const SpatialCullingImpl *)this;
+		return numeric_cast<uint32>(impl->dynamicBoxes.size());
+	}
+
+	Holder<SpatialCulling> newSpatialCulling(const SpatialCullingCreateConfig &config)
+	{
+		return systemMemory().createImpl<SpatialCulling, SpatialCullingImpl>(config);
+	}
+}
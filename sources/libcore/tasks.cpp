@@ -2,6 +2,8 @@
 #include <cage-core/debug.h>
 #include <cage-core/concurrent.h>
 #include <cage-core/profiling.h>
+#include <cage-core/config.h>
+#include <cage-core/systemInformation.h>
 
 #include <plf_list.h>
 
@@ -14,6 +16,8 @@ namespace cage
 {
 	namespace
 	{
+		const ConfigString confAffinity("cage/tasks/affinity", "none"); // none, spread, compact, performance, efficiency
+
 		struct TaskImpl;
 
 		struct TasksQueueTerminated : public Exception
@@ -108,6 +112,7 @@ namespace cage
 			Executor()
 			{
 				threads.resize(processorsCount());
+				affinities = threadsAffinityPlan(processorsTopology(), threadAffinityPolicyFromString(confAffinity), numeric_cast<uint32>(threads.size()));
 				uint32 index = 0;
 				for (auto &t : threads)
 				{
@@ -130,6 +135,11 @@ namespace cage
 			void threadEntry()
 			{
 				thrData.executorThread = true;
+				{
+					const auto &a = affinities[threadIndexInitializer++];
+					if (!a.empty())
+						currentThreadAffinity(a);
+				}
 				try
 				{
 					while (true)
@@ -142,7 +152,9 @@ namespace cage
 			}
 
 			TasksQueue queue;
+			std::vector<std::vector<uint32>> affinities;
 			std::vector<Holder<Thread>> threads;
+			std::atomic<uint32> threadIndexInitializer = 0;
 		};
 
 		Executor &executor()
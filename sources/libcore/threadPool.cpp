@@ -17,12 +17,14 @@ namespace cage
 			Holder<Mutex> mutex = newMutex();
 			std::exception_ptr exptr;
 			std::vector<Holder<Thread>> thrs;
+			std::vector<std::vector<uint32>> affinities;
 			uint32 threadIndexInitializer = 0;
 			const uint32 threadsCount = 0;
 			bool ending = false;
 
-			explicit ThreadPoolImpl(const String &threadNames, uint32 threads) : threadsCount(threads == m ? processorsCount() : threads)
+			explicit ThreadPoolImpl(const String &threadNames, uint32 threads, ThreadAffinityPolicyEnum affinity) : threadsCount(threads == m ? processorsCount() : threads)
 			{
+				affinities = threadsAffinityPlan(processorsTopology(), affinity, threadsCount);
 				barrier1 = newBarrier(threadsCount + 1);
 				barrier2 = newBarrier(threadsCount + 1);
 				thrs.resize(threadsCount);
@@ -44,6 +46,8 @@ namespace cage
 					ScopeLock l(mutex);
 					thrIndex = threadIndexInitializer++;
 				}
+				if (!affinities[thrIndex].empty())
+					currentThreadAffinity(affinities[thrIndex]);
 				while (true)
 				{
 					{ ScopeLock l(barrier1); }
@@ -96,8 +100,8 @@ namespace cage
 		impl->run();
 	}
 
-	Holder<ThreadPool> newThreadPool(const String &threadNames, uint32 threadsCount)
+	Holder<ThreadPool> newThreadPool(const String &threadNames, uint32 threadsCount, ThreadAffinityPolicyEnum affinity)
 	{
-		return systemMemory().createImpl<ThreadPool, ThreadPoolImpl>(threadNames, threadsCount);
+		return systemMemory().createImpl<ThreadPool, ThreadPoolImpl>(threadNames, threadsCount, affinity);
 	}
 }
@@ -21,26 +21,27 @@ namespace cage
 	{
 		const uint32 MaxCharacters = 512;
 
-		struct Instance
-		{
-			Vec4 wrld;
-			Vec4 text;
+		const uint32 CharmapDirectLimit = 0x3000; // covers most alphabetic scripts
 
-			Instance(Real x, Real y, const FontHeader::GlyphData &g)
-			{
-				text = g.texUv;
-				wrld[0] = x + g.bearing[0];
-				wrld[1] = y + g.bearing[1] - g.size[1];
-				wrld[2] = g.size[0];
-				wrld[3] = g.size[1];
-			}
-		};
+		using Instance = FontLayout::Instance;
+
+		Instance makeInstance(Real x, Real y, const FontHeader::GlyphData &g)
+		{
+			Instance r;
+			r.text = g.texUv;
+			r.wrld[0] = x + g.bearing[0];
+			r.wrld[1] = y + g.bearing[1] - g.size[1];
+			r.wrld[2] = g.size[0];
+			r.wrld[3] = g.size[1];
+			return r;
+		}
 
 		struct ProcessData
 		{
 			Holder<Model> model;
 			Holder<ShaderProgram> shader;
 			RenderQueue *renderQueue = nullptr;
+			bool collectInstances = false;
 			std::vector<Instance> instances;
 			PointerRange<const uint32> glyphs;
 			Vec2 mousePosition = Vec2::Nan();
@@ -57,8 +58,9 @@ namespace cage
 			std::vector<Real> kerning;
 			std::vector<uint32> charmapChars;
 			std::vector<uint32> charmapGlyphs;
+			std::vector<uint32> charmapDirect; // glyph indices of characters below the limit, without searching
 
-			Holder<Texture> tex;
+			Holder<Texture> tex; // created with the image, fonts that are only used for layouting need no opengl
 
 			Vec2i resolution;
 			uint32 spaceGlyph = 0;
@@ -67,11 +69,6 @@ namespace cage
 			Real lineHeight = 0;
 			Real firstLineOffset = 0;
 
-			FontImpl()
-			{
-				tex = newTexture();
-			}
-
 			FontHeader::GlyphData getGlyph(uint32 glyphIndex, Real size) const
 			{
 				FontHeader::GlyphData r = glyphsArray[glyphIndex];
@@ -92,19 +89,21 @@ namespace cage
 
 			uint32 findGlyphIndex(uint32 character) const
 			{
+				if (character < charmapDirect.size())
+					return charmapDirect[character];
 				CAGE_ASSERT(charmapChars.size());
 				auto it = std::lower_bound(charmapChars.begin(), charmapChars.end(), character);
-				if (*it != character)
+				if (it == charmapChars.end() || *it != character)
 					return 0;
 				return charmapGlyphs[it - charmapChars.begin()];
 			}
 
 			void processCursor(ProcessData &data, const uint32 *begin, Real x, Real lineY) const
 			{
-				if (data.renderQueue && begin == data.glyphs.data() + data.cursor)
+				if (data.collectInstances && begin == data.glyphs.data() + data.cursor)
 				{
 					FontHeader::GlyphData g = getGlyph(cursorGlyph, data.format->size);
-					data.instances.emplace_back(x, lineY, g);
+					data.instances.push_back(makeInstance(x, lineY, g));
 				}
 			}
 
@@ -121,7 +120,7 @@ namespace cage
 
 				Vec2 mousePos = data.mousePosition + Vec2(-x, lineY + lineHeight * data.format->size);
 				bool mouseInLine = mousePos[1] >= 0 && mousePos[1] <= (lineHeight + data.format->lineSpacing) * data.format->size;
-				if (!data.renderQueue && !mouseInLine)
+				if (!data.collectInstances && !mouseInLine)
 					return;
 				if (mouseInLine)
 				{
@@ -138,8 +137,8 @@ namespace cage
 					FontHeader::GlyphData g = getGlyph(*begin, data.format->size);
 					Real k = findKerning(prev, *begin, data.format->size);
 					prev = *begin++;
-					if (data.renderQueue)
-						data.instances.emplace_back(x + k, lineY, g);
+					if (data.collectInstances)
+						data.instances.push_back(makeInstance(x + k, lineY, g));
 					if (mouseInLine && data.mousePosition[0] >= x && data.mousePosition[0] < x + k + g.advance)
 						data.outCursor = numeric_cast<uint32>(begin - data.glyphs.data());
 					x += k + g.advance;
@@ -152,7 +151,8 @@ namespace cage
 				CAGE_ASSERT(data.format->align <= TextAlignEnum::Center);
 				CAGE_ASSERT(data.format->wrapWidth > 0);
 				CAGE_ASSERT(data.format->size > 0);
-				data.instances.reserve(data.glyphs.size() + 1);
+				if (data.collectInstances)
+					data.instances.reserve(data.glyphs.size() + 1);
 				const uint32 *const totalEnd = data.glyphs.end();
 				const uint32 *it = data.glyphs.begin();
 				const Real actualLineHeight = (lineHeight + data.format->lineSpacing) * data.format->size;
@@ -216,26 +216,30 @@ namespace cage
 				}
 
 				if (data.renderQueue)
+					renderInstances(data.renderQueue, data.model, data.shader, data.instances);
+			}
+
+			void renderInstances(RenderQueue *queue, const Holder<Model> &model, const Holder<ShaderProgram> &shader, PointerRange<const Instance> instances) const
+			{
+				CAGE_ASSERT(tex);
+				queue->bind(tex, 0);
+				queue->bind(shader);
+				const uint32 s = numeric_cast<uint32>(instances.size());
+				const uint32 a = s / MaxCharacters;
+				const uint32 b = s - a * MaxCharacters;
+				for (uint32 i = 0; i < a; i++)
 				{
-					data.renderQueue->bind(tex, 0);
-					data.renderQueue->bind(data.shader);
-					const uint32 s = numeric_cast<uint32>(data.instances.size());
-					const uint32 a = s / MaxCharacters;
-					const uint32 b = s - a * MaxCharacters;
-					for (uint32 i = 0; i < a; i++)
-					{
-						const auto p = data.instances.data() + i * MaxCharacters;
-						PointerRange<Instance> r = { p, p + MaxCharacters };
-						data.renderQueue->universalUniformArray<Instance>(r, 2);
-						data.renderQueue->draw(data.model, MaxCharacters);
-					}
-					if (b)
-					{
-						const auto p = data.instances.data() + a * MaxCharacters;
-						PointerRange<Instance> r = { p, p + b };
-						data.renderQueue->universalUniformArray<Instance>(r, 2);
-						data.renderQueue->draw(data.model, b);
-					}
+					const auto p = instances.data() + i * MaxCharacters;
+					PointerRange<const Instance> r = { p, p + MaxCharacters };
+					queue->universalUniformArray<Instance>(r, 2);
+					queue->draw(model, MaxCharacters);
+				}
+				if (b)
+				{
+					const auto p = instances.data() + a * MaxCharacters;
+					PointerRange<const Instance> r = { p, p + b };
+					queue->universalUniformArray<Instance>(r, 2);
+					queue->draw(model, b);
 				}
 			}
 		};
@@ -247,6 +251,8 @@ namespace cage
 		debugName = name;
 #endif // CAGE_DEBUG
 		FontImpl *impl = (FontImpl *)this;
+		if (!impl->tex)
+			impl->tex = newTexture();
 		impl->tex->setDebugName(name);
 	}
 
@@ -261,6 +267,8 @@ namespace cage
 	{
 		FontImpl *impl = (FontImpl *)this;
 		impl->resolution = resolution;
+		if (!impl->tex)
+			impl->tex = newTexture();
 		impl->tex->filters(GL_LINEAR, GL_LINEAR, 0);
 		impl->tex->wraps(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 		const uint32 bpp = numeric_cast<uint32>(buffer.size() / (resolution[0] * resolution[1]));
@@ -322,6 +330,14 @@ namespace cage
 		impl->charmapGlyphs.resize(chars.size());
 		detail::memcpy(impl->charmapChars.data(), chars.data(), chars.size() * sizeof(uint32));
 		detail::memcpy(impl->charmapGlyphs.data(), glyphs.data(), glyphs.size() * sizeof(uint32));
+		impl->charmapDirect.clear();
+		if (!chars.empty())
+		{
+			CAGE_ASSERT(std::is_sorted(chars.begin(), chars.end()));
+			impl->charmapDirect.resize(min(chars[chars.size() - 1] + 1, CharmapDirectLimit), 0);
+			for (uint32 i = 0; i < chars.size() && chars[i] < CharmapDirectLimit; i++)
+				impl->charmapDirect[chars[i]] = glyphs[i];
+		}
 		impl->returnGlyph = impl->findGlyphIndex('\n');
 		impl->spaceGlyph = impl->findGlyphIndex(' ');
 	}
@@ -407,12 +423,35 @@ namespace cage
 		data.model = model.share();
 		data.shader = shader.share();
 		data.renderQueue = queue;
+		data.collectInstances = true;
 		data.format = &format;
 		data.glyphs = glyphs;
 		data.cursor = applicationTime() % 1000000 < 300000 ? m : cursor;
 		impl->processText(data);
 	}
 
+	FontLayout Font::layout(PointerRange<const uint32> glyphs, const FontFormat &format) const
+	{
+		const FontImpl *impl = (const FontImpl *)this;
+		ProcessData data;
+		data.collectInstances = true;
+		data.format = &format;
+		data.glyphs = glyphs;
+		impl->processText(data);
+		FontLayout res;
+		res.glyphs = PointerRangeHolder<uint32>(glyphs.begin(), glyphs.end());
+		res.instances = PointerRangeHolder<Instance>(std::move(data.instances));
+		res.format = format;
+		res.size = data.outSize;
+		return res;
+	}
+
+	void Font::render(RenderQueue *queue, const Holder<Model> &model, const Holder<ShaderProgram> &shader, const FontLayout &layout) const
+	{
+		const FontImpl *impl = (const FontImpl *)this;
+		impl->renderInstances(queue, model, shader, layout.instances);
+	}
+
 	Holder<Font> newFont()
 	{
 		return systemMemory().createImpl<Font, FontImpl>();
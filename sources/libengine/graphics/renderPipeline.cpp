@@ -1,17 +1,19 @@
 #include <cage-core/skeletalAnimationPreparator.h>
 #include <cage-core/pointerRangeHolder.h>
 #include <cage-core/skeletalAnimation.h>
+#include <cage-core/instancesGrouping.h>
 #include <cage-core/entitiesVisitor.h>
+#include <cage-core/spatialCulling.h>
 #include <cage-core/assetManager.h>
 #include <cage-core/hashString.h>
 #include <cage-core/meshImport.h>
 #include <cage-core/profiling.h>
-#include <cage-core/textPack.h>
 #include <cage-core/geometry.h>
 #include <cage-core/camera.h>
 #include <cage-core/config.h>
 #include <cage-core/color.h>
 #include <cage-core/tasks.h>
+#include <cage-core/concurrent.h>
 
 #include <cage-engine/provisionalGraphics.h>
 #include <cage-engine/provisionalHandles.h>
@@ -34,6 +36,8 @@
 #include <map>
 #include <array>
 
+#include <robin_hood.h>
+
 namespace cage
 {
 	namespace
@@ -75,20 +79,17 @@ namespace cage
 			Vec4 time; // frame index (loops at 10000), time (loops every second), time (loops every 1000 seconds)
 		};
 
-		struct ModelShared
+		struct ModelShared : public InstancesSortKey
 		{
 			Holder<Model> mesh;
-			bool skeletal = false;
 
-			auto cmp() const
+			void updateSortKey()
 			{
-				// reduce switching shaders, then depth test/writes and other states, then meshes
-				return std::tuple{ mesh->shaderName, mesh->flags, +mesh, skeletal };
-			}
-
-			bool operator < (const ModelShared &other) const
-			{
-				return cmp() < other.cmp();
+				shader = mesh->shaderName;
+				flags = (uint32)mesh->flags;
+				for (uint32 i = 0; i < 3; i++)
+					textures[i] = mesh->textureNames[i];
+				meshId = (uintPtr)+mesh;
 			}
 		};
 
@@ -134,16 +135,31 @@ namespace cage
 		{
 			Mat4 model;
 			Holder<const Font> font;
-			std::vector<uint32> glyphs;
-			FontFormat format;
+			Holder<const FontLayout> layout;
 			Vec3 color;
 		};
 
 		struct DataLayer
 		{
-			std::map<ModelShared, std::vector<ModelInstance>> opaque;
+			InstancesGrouping<ModelShared, ModelInstance, InstancesSortKeyHasher> opaque;
 			std::vector<ModelTranslucent> translucent;
+			std::vector<std::pair<Real, uint32>> translucentOrder; // depth and index into translucent
 			std::vector<TextPrepare> texts;
+
+			void clear()
+			{
+				opaque.clear();
+				translucent.clear();
+				translucentOrder.clear();
+				texts.clear();
+			}
+		};
+
+		// layers are reused across frames to keep their allocated storage
+		struct DataLayersPool
+		{
+			Holder<Mutex> mutex = newMutex();
+			std::vector<Holder<DataLayer>> layers;
 		};
 
 		// camera or light
@@ -161,7 +177,7 @@ namespace cage
 				bool orthographic = false;
 			} lodSelection;
 
-			std::map<sint32, DataLayer> layers;
+			std::vector<std::pair<sint32, Holder<DataLayer>>> layers; // sorted by layer
 			PointerRangeHolder<RenderPipelineDebugVisualization> debugVisualizations;
 			Holder<RenderQueue> renderQueue;
 
@@ -304,11 +320,41 @@ namespace cage
 			Holder<ShaderProgram> shaderFont;
 
 			Holder<SkeletalAnimationPreparatorCollection> skeletonPreparatorCollection;
+			Holder<DataLayersPool> layersPool = systemMemory().createHolder<DataLayersPool>();
+			Holder<TextLayoutCache> textsCache = newTextLayoutCache({});
 			EntityComponent *transformComponent = nullptr;
 			EntityComponent *prevTransformComponent = nullptr;
 			bool cnfRenderMissingModels = false;
 			bool cnfRenderSkeletonBones = false;
 
+			// world-space boxes of renderable entities, shared by all cameras and shadowmaps within a frame
+			// the scene is recreated every frame, therefore changes are detected by comparing the values that the box was computed from
+			struct CullingEntity
+			{
+				Entity *e = nullptr;
+				void *key = nullptr;
+				Transform transform, prevTransform;
+				Real interpolation;
+				uint32 object = 0;
+				uint32 generation = 0;
+				bool hasPrev = false;
+				bool resolved = false; // false -> the assets were not loaded yet, the box is universe
+			};
+			struct CullingBounds
+			{
+				Aabb box;
+				const void *object = nullptr; // detects reloaded assets
+			};
+			Holder<Mutex> cullingMutex = newMutex();
+			Holder<SpatialCulling> culling = newSpatialCulling({});
+			robin_hood::unordered_map<void *, uint32> cullingIds; // entityKey -> id
+			robin_hood::unordered_map<uint32, CullingBounds> cullingBounds; // local boxes of render objects by asset name
+			std::vector<CullingEntity> cullingEntities; // indexed by id
+			std::vector<uint32> cullingFreeIds;
+			uint64 cullingTime = m;
+			uint32 cullingFrame = m;
+			uint32 cullingGeneration = 0;
+
 			RenderPipelineImpl(const RenderPipelineCreateConfig &config) : RenderPipelineCreateConfig(config)
 			{}
 
@@ -338,7 +384,10 @@ namespace cage
 				shaderFont = defaultProgram(assets->get<AssetSchemeIndexShaderProgram, MultiShaderProgram>(HashString("cage/shader/gui/font.glsl")));
 				CAGE_ASSERT(shaderBlit);
 
-				skeletonPreparatorCollection = newSkeletalAnimationPreparatorCollection(assets, confRenderSkeletonBones);
+				if (!skeletonPreparatorCollection || cnfRenderSkeletonBones != confRenderSkeletonBones)
+					skeletonPreparatorCollection = newSkeletalAnimationPreparatorCollection(assets, confRenderSkeletonBones);
+				else
+					skeletonPreparatorCollection->clear(); // keeps animation cursors from previous frames
 				transformComponent = scene->component<TransformComponent>();
 				prevTransformComponent = scene->componentsByType(detail::typeIndex<TransformComponent>())[1];
 				cnfRenderMissingModels = confRenderMissingModels;
@@ -347,6 +396,15 @@ namespace cage
 				return true;
 			}
 
+			// the scene is recreated every frame, the entity name is stable across frames and keeps per-entity caches (animation cursors, culling)
+			// odd keys never collide with pointers to entities
+			static void *entityKey(Entity *e)
+			{
+				if (e->name())
+					return (void *)(((uintPtr)e->name() << 1) | 1);
+				return e;
+			}
+
 			Mat4 modelTransform(Entity *e) const
 			{
 				CAGE_ASSERT(e->has(transformComponent));
@@ -360,6 +418,135 @@ namespace cage
 					return Mat4(e->value<TransformComponent>(transformComponent));
 			}
 
+			DataLayer &dataLayer(CameraData &data, sint32 layer) const
+			{
+				auto it = std::lower_bound(data.layers.begin(), data.layers.end(), layer, [](const auto &a, sint32 b) { return a.first < b; });
+				if (it != data.layers.end() && it->first == layer)
+					return *it->second;
+				Holder<DataLayer> l;
+				{
+					ScopeLock<Mutex> lock(layersPool->mutex);
+					if (!layersPool->layers.empty())
+					{
+						l = std::move(layersPool->layers.back());
+						layersPool->layers.pop_back();
+					}
+				}
+				if (!l)
+					l = systemMemory().createHolder<DataLayer>();
+				return *data.layers.insert(it, { layer, std::move(l) })->second;
+			}
+
+			void releaseDataLayers(CameraData &data) const
+			{
+				for (auto &it : data.layers)
+					it.second->clear();
+				ScopeLock<Mutex> lock(layersPool->mutex);
+				for (auto &it : data.layers)
+					layersPool->layers.push_back(std::move(it.second));
+				data.layers.clear();
+			}
+
+			Aabb localBoundingBox(uint32 object)
+			{
+				if (Holder<RenderObject> obj = assets->tryGet<AssetSchemeIndexRenderObject, RenderObject>(object))
+				{
+					CullingBounds &cb = cullingBounds[object];
+					if (cb.object == +obj)
+						return cb.box;
+					Aabb box;
+					for (uint32 lod = 0; lod < obj->lodsCount(); lod++)
+					{
+						for (uint32 it : obj->models(lod))
+						{
+							Holder<Model> mesh = assets->tryGet<AssetSchemeIndexModel, Model>(it);
+							if (!mesh)
+								return Aabb::Universe();
+							box += mesh->boundingBox();
+						}
+					}
+					cb.box = box;
+					cb.object = +obj;
+					return box;
+				}
+				if (Holder<Model> mesh = assets->tryGet<AssetSchemeIndexModel, Model>(object))
+					return mesh->boundingBox();
+				return Aabb::Universe(); // missing or not yet loaded assets
+			}
+
+			void updateCulling()
+			{
+				ScopeLock<Mutex> lock(cullingMutex);
+				if (cullingFrame == frameIndex && cullingTime == currentTime)
+					return;
+				ProfilingScope profiling("update culling");
+				cullingFrame = frameIndex;
+				cullingTime = currentTime;
+				cullingGeneration++;
+				textsCache->nextFrame();
+
+				entitiesVisitor([&](Entity *e, const RenderComponent &rc) {
+					uint32 id = m;
+					{
+						void *key = entityKey(e);
+						auto it = cullingIds.find(key);
+						if (it == cullingIds.end())
+						{
+							if (cullingFreeIds.empty())
+							{
+								id = numeric_cast<uint32>(cullingEntities.size());
+								cullingEntities.emplace_back();
+							}
+							else
+							{
+								id = cullingFreeIds.back();
+								cullingFreeIds.pop_back();
+							}
+							cullingIds[key] = id;
+							cullingEntities[id] = {};
+							cullingEntities[id].key = key;
+						}
+						else
+							id = it->second;
+					}
+					CullingEntity &ce = cullingEntities[id];
+					ce.e = e;
+					ce.generation = cullingGeneration;
+
+					const Entity *ent = e; // reads only
+					const Transform transform = ent->value<TransformComponent>(transformComponent);
+					const bool hasPrev = ent->has(prevTransformComponent);
+					const Transform prevTransform = hasPrev ? Transform(ent->value<TransformComponent>(prevTransformComponent)) : Transform();
+					const bool moving = hasPrev && prevTransform != transform;
+					if (ce.resolved && ce.object == rc.object && ce.transform == transform && ce.hasPrev == hasPrev && ce.prevTransform == prevTransform && (!moving || ce.interpolation == interpolationFactor))
+						return; // the box is up to date
+					ce.transform = transform;
+					ce.prevTransform = prevTransform;
+					ce.interpolation = interpolationFactor;
+					ce.object = rc.object;
+					ce.hasPrev = hasPrev;
+
+					const Aabb local = localBoundingBox(rc.object);
+					ce.resolved = local != Aabb::Universe();
+					culling->update(id, ce.resolved ? local * modelTransform(e) : local);
+				}, +scene, false);
+
+				// forget destroyed entities
+				for (uint32 id = 0; id < cullingEntities.size(); id++)
+				{
+					CullingEntity &ce = cullingEntities[id];
+					if (!ce.e || ce.generation == cullingGeneration)
+						continue;
+					culling->remove(id);
+					cullingIds.erase(ce.key);
+					ce.e = nullptr;
+					ce.key = nullptr;
+					cullingFreeIds.push_back(id);
+				}
+
+				culling->commit();
+			}
+
 			template<RenderModeEnum RenderMode>
 			void renderModelsImpl(const CameraData &data, const ModelShared &sh, const PointerRange<const UniMesh> uniMeshes, const PointerRange<const Mat3x4> uniArmatures, bool translucent) const
 			{
@@ -456,7 +643,7 @@ namespace cage
 				const Holder<RenderQueue> &renderQueue = data.renderQueue;
 				renderQueue->uniform(shaderFont, 0, data.viewProj * text.model);
 				renderQueue->uniform(shaderFont, 4, text.color);
-				text.font->render(+renderQueue, modelSquare, shaderFont, text.glyphs, text.format);
+				text.font->render(+renderQueue, modelSquare, shaderFont, *text.layout);
 			}
 
 			template<RenderModeEnum RenderMode>
@@ -466,23 +653,25 @@ namespace cage
 
 				{
 					const auto graphicsDebugScope = renderQueue->namedScope("opaque");
-					for (const auto &shit : layer.opaque)
+					std::vector<UniMesh> uniMeshes;
+					std::vector<Mat3x4> uniArmatures;
+					for (const auto &shit : layer.opaque.result())
 					{
-						const ModelShared &sh = shit.first;
+						const ModelShared &sh = shit.key;
 						if constexpr (RenderMode == RenderModeEnum::DepthPrepass)
 						{
 							if (none(sh.mesh->flags & MeshRenderFlags::DepthWrite))
 								continue;
 						}
-						std::vector<UniMesh> uniMeshes;
-						uniMeshes.reserve(shit.second.size());
-						for (const ModelInstance &inst : shit.second)
+						uniMeshes.clear();
+						uniMeshes.reserve(shit.instances.size());
+						for (const ModelInstance &inst : shit.instances)
 							uniMeshes.push_back(inst.uni);
-						std::vector<Mat3x4> uniArmatures;
+						uniArmatures.clear();
 						if (sh.skeletal)
 						{
-							uniArmatures.reserve(shit.second.size() * sh.mesh->bones);
-							for (const ModelInstance &inst : shit.second)
+							uniArmatures.reserve(shit.instances.size() * sh.mesh->bones);
+							for (const ModelInstance &inst : shit.instances)
 							{
 								const auto armature = inst.skeletalAnimation->armature();
 								CAGE_ASSERT(armature.size() == sh.mesh->bones);
@@ -499,8 +688,9 @@ namespace cage
 				if constexpr (RenderMode == RenderModeEnum::Color)
 				{
 					const auto graphicsDebugScope = renderQueue->namedScope("translucent");
-					for (const auto &it : layer.translucent)
+					for (const auto &ord : layer.translucentOrder)
 					{
+						const ModelTranslucent &it = layer.translucent[ord.second];
 						PointerRange<const UniMesh> uniMeshes = { &it.uni, &it.uni + 1 };
 						PointerRange<const Mat3x4> uniArmatures;
 						if (it.skeletal)
@@ -535,23 +725,25 @@ namespace cage
 			void renderModels(const CameraData &data) const
 			{
 				for (const auto &it : data.layers)
-					renderLayer<RenderMode>(data, it.second);
+					renderLayer<RenderMode>(data, *it.second);
 			}
 
 			template<PrepareModeEnum PrepareMode>
 			void prepareModelImpl(CameraData &data, ModelPrepare &prepare) const
 			{
-				DataLayer &layer = data.layers[prepare.mesh->layer];
+				DataLayer &layer = dataLayer(data, prepare.mesh->layer);
 				if (PrepareMode == PrepareModeEnum::Camera && prepare.translucent)
 				{
 					ModelTranslucent &tr = (ModelTranslucent &)prepare;
+					layer.translucentOrder.emplace_back(tr.depth, numeric_cast<uint32>(layer.translucent.size()));
 					layer.translucent.push_back(std::move(tr));
 				}
 				else
 				{
 					ModelShared &sh = (ModelShared &)prepare;
 					ModelInstance &inst = (ModelInstance &)prepare;
-					layer.opaque[std::move(sh)].push_back(std::move(inst));
+					sh.updateSortKey();
+					layer.opaque.add(std::move(sh), std::move(inst));
 				}
 			}
 
@@ -666,7 +858,7 @@ namespace cage
 					if (anim)
 					{
 						Real coefficient = detail::evalCoefficientForSkeletalAnimation(+anim, currentTime, ps->startTime, ps->speed, ps->offset);
-						pr.skeletalAnimation = skeletonPreparatorCollection->create(pr.e, std::move(anim), coefficient);
+						pr.skeletalAnimation = skeletonPreparatorCollection->create(entityKey(pr.e), std::move(anim), coefficient);
 						pr.skeletalAnimation->prepare();
 						pr.skeletal = true;
 					}
@@ -713,9 +905,12 @@ namespace cage
 			template<PrepareModeEnum PrepareMode>
 			void prepareEntities(CameraData &data) const
 			{
-				entitiesVisitor([&](Entity *e, const RenderComponent &rc) {
+				for (uint32 id : culling->cull(Frustum(data.viewProj)))
+				{
+					Entity *e = cullingEntities[id].e;
+					const RenderComponent &rc = e->value<RenderComponent>();
 					if ((rc.sceneMask & data.camera.sceneMask) == 0)
-						return;
+						continue;
 					ModelPrepare prepare;
 					prepare.e = e;
 					prepare.render = rc;
@@ -725,27 +920,26 @@ namespace cage
 					if (Holder<RenderObject> obj = assets->tryGet<AssetSchemeIndexRenderObject, RenderObject>(rc.object))
 					{
 						prepareObject<PrepareMode>(data, prepare, std::move(obj));
-						return;
+						continue;
 					}
 					if (Holder<Model> mesh = assets->tryGet<AssetSchemeIndexModel, Model>(rc.object))
 					{
 						prepare.mesh = std::move(mesh);
 						prepareModel<PrepareMode>(data, prepare);
-						return;
+						continue;
 					}
 					if (cnfRenderMissingModels)
 					{
 						prepare.mesh = assets->tryGet<AssetSchemeIndexModel, Model>(HashString("cage/model/fake.obj"));
 						prepareModel<PrepareMode>(data, prepare);
-						return;
+						continue;
 					}
-				}, +scene, false);
+				}
 
 				if constexpr (PrepareMode == PrepareModeEnum::Camera)
 				{
-					// sort translucent back-to-front
 					for (auto &it : data.layers)
-						std::sort(it.second.translucent.begin(), it.second.translucent.end(), [](const auto &a, const auto &b) { return a.depth > b.depth; });
+						instancesSortBackToFront(it.second->translucentOrder);
 
 					entitiesVisitor([&](Entity *e, const TextComponent &tc_) {
 						if ((tc_.sceneMask & data.camera.sceneMask) == 0)
@@ -757,20 +951,20 @@ namespace cage
 						prepare.font = assets->tryGet<AssetSchemeIndexFont, Font>(pt.font);
 						if (!prepare.font)
 							return;
-						const String str = loadFormattedString(assets, pt.assetName, pt.textName, pt.value);
-						const uint32 count = prepare.font->glyphsCount(str);
-						if (count == 0)
+						FontFormat format;
+						format.size = 1;
+						prepare.layout = textsCache->get(prepare.font, assets, pt.assetName, pt.textName, pt.value, format);
+						if (prepare.layout->glyphs.empty())
 							return;
-						prepare.glyphs.resize(count);
-						prepare.font->transcript(str, prepare.glyphs);
 						prepare.color = colorGammaToLinear(pt.color) * pt.intensity;
-						prepare.format.size = 1;
-						const Vec2 size = prepare.font->size(prepare.glyphs, prepare.format);
-						prepare.format.wrapWidth = size[0];
+						const Vec2 size = prepare.layout->size;
 						prepare.model = modelTransform(e) * Mat4(Vec3(size * Vec2(-0.5, 0.5), 0));
-						data.layers[0].texts.push_back(std::move(prepare));
+						dataLayer(data, 0).texts.push_back(std::move(prepare));
 					}, +scene, false);
 				}
+
+				for (auto &it : data.layers)
+					it.second->opaque.finish();
 			}
 
 			void taskShadowmap(ShadowmapData &data, uint32) const
@@ -1221,9 +1415,10 @@ namespace cage
 				return tasksRunAsync<ShadowmapData>("render shadowmap task", Delegate<void(ShadowmapData&, uint32)>().bind<RenderPipelineImpl, &RenderPipelineImpl::taskShadowmap>(this), Holder<ShadowmapData>(&data, nullptr), 1, tasksCurrentPriority() + 9);
 			}
 
-			RenderPipelineResult prepareCamera(const RenderPipelineCamera &camera) const
+			RenderPipelineResult prepareCamera(const RenderPipelineCamera &camera)
 			{
 				CAGE_ASSERT(!camera.name.empty());
+				updateCulling();
 
 				CameraData data;
 				(RenderPipelineCamera &)data = camera;
@@ -1266,6 +1461,10 @@ namespace cage
 
 				queue->enqueue(std::move(data.renderQueue));
 
+				for (auto &shm : data.shadowmaps)
+					releaseDataLayers(shm.second);
+				releaseDataLayers(data);
+
 				RenderPipelineResult result;
 				result.debugVisualizations = std::move(data.debugVisualizations);
 				result.renderQueue = std::move(queue);
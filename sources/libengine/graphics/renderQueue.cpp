@@ -1,9 +1,9 @@
-#include <cage-core/blockContainer.h>
-#include <cage-core/memoryAllocators.h>
+#include <cage-core/commandBuffer.h>
 #include <cage-core/memoryUtils.h>
 #include <cage-core/memoryBuffer.h>
 #include <cage-core/profiling.h>
 #include <cage-core/memoryAlloca.h>
+#include <cage-core/pointerRangeHolder.h>
 
 #include <cage-engine/opengl.h>
 #include <cage-engine/model.h>
@@ -13,8 +13,11 @@
 #include <cage-engine/uniformBuffer.h>
 #include <cage-engine/shaderProgram.h>
 #include <cage-engine/graphicsError.h>
+#include <cage-engine/shaderConventions.h>
 #include <cage-engine/provisionalGraphics.h>
 
+#include <robin_hood.h>
+
 #include <vector> // namesStack
 #include <array>
 
@@ -22,27 +25,373 @@ namespace cage
 {
 	namespace
 	{
-		class RenderQueueImpl;
+		enum class CmdTypeEnum : uint32
+		{
+			BindlessSetup, // setup only
+			UubBind,
+			UniformBufferBind,
+			UniformBufferBindRange,
+			UniformBufferWriteWhole,
+			UniformBufferWriteRange,
+			ShaderBind,
+			Uniform,
+			FrameBufferBind,
+			FrameBufferDepthTexture,
+			FrameBufferColorTexture,
+			FrameBufferActiveAttachments,
+			FrameBufferClear,
+			FrameBufferCheck,
+			FrameBufferReset,
+			TextureBind,
+			TextureImage2d,
+			TextureImage3d,
+			TextureFilters,
+			TextureWraps2,
+			TextureWraps3,
+			TextureGenerateMipmaps,
+			TexturesReset,
+			TextureBindImage,
+			BindlessUniform,
+			BindlessResident,
+			ModelBind,
+			Draw,
+			Compute,
+			MemoryBarrier,
+			Viewport,
+			Scissors,
+			CullFace,
+			DepthFunc,
+			DepthWrite,
+			ColorWrite,
+			BlendFunc,
+			ClearColor,
+			Clear,
+			Enable,
+			Disable,
+			PushScope,
+			PopScope,
+			Enqueue,
+			CheckGlErrorDebug,
+			CheckGlError,
+		};
+
+		StringLiteral commandName(CmdTypeEnum type)
+		{
+			switch (type)
+			{
+			case CmdTypeEnum::BindlessSetup: return "bindless setup";
+			case CmdTypeEnum::UubBind: return "uub bind";
+			case CmdTypeEnum::UniformBufferBind: return "uniform buffer bind";
+			case CmdTypeEnum::UniformBufferBindRange: return "uniform buffer bind range";
+			case CmdTypeEnum::UniformBufferWriteWhole: return "uniform buffer write whole";
+			case CmdTypeEnum::UniformBufferWriteRange: return "uniform buffer write range";
+			case CmdTypeEnum::ShaderBind: return "shader bind";
+			case CmdTypeEnum::Uniform: return "uniform";
+			case CmdTypeEnum::FrameBufferBind: return "frame buffer bind";
+			case CmdTypeEnum::FrameBufferDepthTexture: return "frame buffer depth texture";
+			case CmdTypeEnum::FrameBufferColorTexture: return "frame buffer color texture";
+			case CmdTypeEnum::FrameBufferActiveAttachments: return "frame buffer active attachments";
+			case CmdTypeEnum::FrameBufferClear: return "frame buffer clear";
+			case CmdTypeEnum::FrameBufferCheck: return "frame buffer check";
+			case CmdTypeEnum::FrameBufferReset: return "frame buffer reset";
+			case CmdTypeEnum::TextureBind: return "texture bind";
+			case CmdTypeEnum::TextureImage2d: return "texture image 2d";
+			case CmdTypeEnum::TextureImage3d: return "texture image 3d";
+			case CmdTypeEnum::TextureFilters: return "texture filters";
+			case CmdTypeEnum::TextureWraps2: return "texture wraps 2";
+			case CmdTypeEnum::TextureWraps3: return "texture wraps 3";
+			case CmdTypeEnum::TextureGenerateMipmaps: return "texture generate mipmaps";
+			case CmdTypeEnum::TexturesReset: return "textures reset";
+			case CmdTypeEnum::TextureBindImage: return "texture bind image";
+			case CmdTypeEnum::BindlessUniform: return "bindless uniform";
+			case CmdTypeEnum::BindlessResident: return "bindless resident";
+			case CmdTypeEnum::ModelBind: return "model bind";
+			case CmdTypeEnum::Draw: return "draw";
+			case CmdTypeEnum::Compute: return "compute";
+			case CmdTypeEnum::MemoryBarrier: return "memory barrier";
+			case CmdTypeEnum::Viewport: return "viewport";
+			case CmdTypeEnum::Scissors: return "scissors";
+			case CmdTypeEnum::CullFace: return "cull face";
+			case CmdTypeEnum::DepthFunc: return "depth func";
+			case CmdTypeEnum::DepthWrite: return "depth write";
+			case CmdTypeEnum::ColorWrite: return "color write";
+			case CmdTypeEnum::BlendFunc: return "blend func";
+			case CmdTypeEnum::ClearColor: return "clear color";
+			case CmdTypeEnum::Clear: return "clear";
+			case CmdTypeEnum::Enable: return "enable";
+			case CmdTypeEnum::Disable: return "disable";
+			case CmdTypeEnum::PushScope: return "push scope";
+			case CmdTypeEnum::PopScope: return "pop scope";
+			case CmdTypeEnum::Enqueue: return "enqueue";
+			case CmdTypeEnum::CheckGlErrorDebug: return "check gl error debug";
+			case CmdTypeEnum::CheckGlError: return "check gl error";
+			default: CAGE_THROW_CRITICAL(Exception, "invalid render queue command type");
+			}
+		}
+
+		enum class UniformTypeEnum : uint32
+		{
+			Sint32,
+			Uint32,
+			Vec2i,
+			Vec3i,
+			Vec4i,
+			Real,
+			Vec2,
+			Vec3,
+			Vec4,
+			Quat,
+			Mat3,
+			Mat4,
+		};
+
+		template<class T> constexpr UniformTypeEnum uniformType();
+#define GCHL_GENERATE(TYPE, ENUM) template<> constexpr UniformTypeEnum uniformType<TYPE>() { return UniformTypeEnum::ENUM; }
+		GCHL_GENERATE(sint32, Sint32);
+		GCHL_GENERATE(uint32, Uint32);
+		GCHL_GENERATE(Vec2i, Vec2i);
+		GCHL_GENERATE(Vec3i, Vec3i);
+		GCHL_GENERATE(Vec4i, Vec4i);
+		GCHL_GENERATE(Real, Real);
+		GCHL_GENERATE(Vec2, Vec2);
+		GCHL_GENERATE(Vec3, Vec3);
+		GCHL_GENERATE(Vec4, Vec4);
+		GCHL_GENERATE(Quat, Quat);
+		GCHL_GENERATE(Mat3, Mat3);
+		GCHL_GENERATE(Mat4, Mat4);
+#undef GCHL_GENERATE
+
+		// commands are plain data, resources are referenced by indices into the arrays in the queue
+
+		struct CmdNone
+		{};
+
+		struct CmdIndex
+		{
+			uint32 index = m;
+		};
+
+		struct CmdUubBind
+		{
+			UubRange range;
+			uint32 bindingPoint = m;
+		};
+
+		struct CmdUniformBufferBind
+		{
+			uint32 buffer = m;
+			uint32 bindingPoint = m;
+			uint32 offset = 0;
+			uint32 size = 0;
+		};
+
+		struct CmdUniformBufferWrite
+		{
+			uint32 buffer = m;
+			uint32 param = 0; // usage or offset
+		};
+
+		struct CmdUniform
+		{
+			uint32 shader = m;
+			uint32 name = 0;
+			UniformTypeEnum type = UniformTypeEnum::Sint32;
+			uint32 count = 0;
+			bool array = false;
+		};
+
+		struct CmdFrameBufferTexture
+		{
+			uint32 frameBuffer = m;
+			uint32 texture = m;
+			uint32 index = 0;
+			uint32 mipmapLevel = 0;
+		};
+
+		struct CmdFrameBufferMask
+		{
+			uint32 frameBuffer = m;
+			uint32 mask = 0;
+		};
+
+		struct CmdTextureBind
+		{
+			uint32 texture = m;
+			uint32 bindingPoint = m;
+		};
+
+		struct CmdTextureImage
+		{
+			uint32 texture = m;
+			Vec3i resolution;
+			uint32 mipmapLevels = 0;
+			uint32 internalFormat = 0;
+		};
+
+		struct CmdTextureParams
+		{
+			uint32 texture = m;
+			uint32 a = 0, b = 0, c = 0;
+		};
+
+		struct CmdTextureBindImage
+		{
+			uint32 texture = m;
+			uint32 bindingPoint = 0;
+			bool read = false;
+			bool write = false;
+		};
+
+		struct CmdBindless
+		{
+			uint32 index = m;
+			uint32 bindingPoint = m;
+			bool flag = false; // make resident or resident
+		};
+
+		struct CmdDraw
+		{
+			uint32 model = m;
+			uint32 instances = 0;
+		};
+
+		struct CmdCompute
+		{
+			uint32 shader = m;
+			Vec3i groupsCounts;
+		};
 
-		struct CmdBase : private Immovable
+		struct CmdRect
 		{
-			CmdBase *next = nullptr;
-			virtual ~CmdBase() = default;
-			virtual void dispatch(RenderQueueImpl *impl) const = 0;
+			Vec2i origin;
+			Vec2i size;
+		};
+
+		struct CmdValue
+		{
+			uint32 value = 0;
 		};
 
+		struct CmdPair
+		{
+			uint32 a = 0, b = 0;
+		};
+
+		struct CmdClearColor
+		{
+			Vec4 rgba;
+		};
+
+		struct CmdScope
+		{
+			StringLiteral name;
+		};
+
+		// tracks gl state changed by the queue to skip redundant state changes
+		// null means unknown state
+		struct DispatchState
+		{
+			struct Block
+			{
+				const void *buffer = nullptr;
+				uint32 offset = m;
+				uint32 size = m;
+			};
+
+			const void *program = nullptr;
+			const void *model = nullptr;
+			std::array<const void *, 32> textures = {};
+			std::array<Block, 16> blocks = {};
+			uint32 redundant = 0;
+
+			bool changeTexture(uint32 bindingPoint, const void *texture)
+			{
+				if (bindingPoint >= textures.size())
+					return true;
+				if (textures[bindingPoint] == texture)
+					return false;
+				textures[bindingPoint] = texture;
+				return true;
+			}
+
+			bool changeBlock(uint32 bindingPoint, const void *buffer, uint32 offset, uint32 size)
+			{
+				if (bindingPoint == CAGE_SHADER_UNIBLOCK_MATERIAL)
+					model = nullptr; // models bind their material to this binding point
+				if (bindingPoint >= blocks.size())
+					return true;
+				Block &b = blocks[bindingPoint];
+				if (b.buffer == buffer && b.offset == offset && b.size == size)
+					return false;
+				b.buffer = buffer;
+				b.offset = offset;
+				b.size = size;
+				return true;
+			}
+
+			void invalidateBlock(uint32 bindingPoint)
+			{
+				if (bindingPoint == CAGE_SHADER_UNIBLOCK_MATERIAL)
+					model = nullptr;
+				if (bindingPoint < blocks.size())
+					blocks[bindingPoint] = {};
+			}
+		};
+
+		struct InspectionData
+		{
+			PointerRangeHolder<StringLiteral> commands;
+			uint32 redundant = 0;
+		};
+
+		template<class T>
+		void uniformDispatch(ShaderProgram *shader, const CmdUniform &cmd, PointerRange<const char> data)
+		{
+			const T *values = (const T *)data.data();
+			CAGE_ASSERT(data.size() == cmd.count * sizeof(T));
+			if (cmd.array)
+				shader->uniform(cmd.name, PointerRange<const T>(values, values + cmd.count));
+			else
+				shader->uniform(cmd.name, *values);
+		}
+
 		// available during setting up - reset by explicit call
 		struct RenderQueueContent
 		{
-			BlockContainer<CmdBase *> cmdsAllocs;
-			BlockContainer<void *> memAllocs;
-
-			CmdBase *setupHead = nullptr, *setupTail = nullptr;
-			CmdBase *head = nullptr, *tail = nullptr;
+			CommandBuffer setup, cmds;
+
+			std::vector<Holder<ShaderProgram>> shaders;
+			std::vector<Holder<Model>> models;
+			std::vector<TextureHandle> textures;
+			std::vector<FrameBufferHandle> frameBuffers;
+			std::vector<UniformBufferHandle> uniformBuffers;
+			std::vector<Holder<PointerRange<TextureHandle>>> bindless;
+			std::vector<UubRange> bindlessRanges;
+			std::vector<Holder<RenderQueue>> queues;
+			robin_hood::unordered_map<const void *, uint32> resourcesIndices;
 
 			uint32 commandsCount = 0;
 			uint32 drawsCount = 0;
 			uint32 primitivesCount = 0;
+
+			void clear()
+			{
+				// retains allocated storage
+				setup.clear();
+				cmds.clear();
+				shaders.clear();
+				models.clear();
+				textures.clear();
+				frameBuffers.clear();
+				uniformBuffers.clear();
+				bindless.clear();
+				bindlessRanges.clear();
+				queues.clear();
+				resourcesIndices.clear();
+				commandsCount = 0;
+				drawsCount = 0;
+				primitivesCount = 0;
+			}
 		};
 
 		class RenderQueueImpl : public RenderQueueContent, public RenderQueue
@@ -54,7 +403,6 @@ namespace cage
 
 			const String queueName;
 			ProvisionalGraphics *const provisionalGraphics = nullptr;
-			Holder<MemoryArena> arena = newMemoryAllocatorStream({});
 			MemoryBuffer uubStaging;
 			UniformBuffer *uubObject = nullptr;
 
@@ -66,117 +414,70 @@ namespace cage
 #endif // CAGE_PROFILING_ENABLED
 
 			RenderQueueImpl(const String &name, ProvisionalGraphics *provisionalGraphics) : queueName(name), provisionalGraphics(provisionalGraphics)
+			{}
+
+			void resetQueue()
 			{
-				initHeads();
+				ProfilingScope profiling("queue reset");
+				RenderQueueContent::clear();
+				uubStaging.resize(0);
 			}
 
-			~RenderQueueImpl()
+			template<class Resource, class Key>
+			uint32 resourceIndex(std::vector<Resource> &resources, const Key *key, const Resource &resource)
 			{
-				resetQueue(); // make sure to properly destroy all the commands, they may hold some assets
+				auto it = resourcesIndices.find(key);
+				if (it != resourcesIndices.end())
+					return it->second;
+				const uint32 index = numeric_cast<uint32>(resources.size());
+				resources.push_back(resource.share());
+				resourcesIndices[key] = index;
+				return index;
 			}
 
-			void initHeads()
+			uint32 shaderIndex(const Holder<ShaderProgram> &shader)
 			{
-				struct Cmd : public CmdBase
-				{
-					void dispatch(RenderQueueImpl *) const override
-					{}
-				};
-				setupHead = setupTail = arena->createObject<Cmd>();
-				cmdsAllocs.push_back(setupHead);
-				head = tail = arena->createObject<Cmd>();
-				cmdsAllocs.push_back(head);
+				return resourceIndex(shaders, +shader, shader);
 			}
 
-			void resetQueue()
+			uint32 modelIndex(const Holder<Model> &model)
 			{
-				ProfilingScope profiling("queue reset");
-				for (const auto &it1 : cmdsAllocs)
-					for (CmdBase *it2 : it1)
-						arena->destroy<CmdBase>(it2);
-				for (const auto &it1 : memAllocs)
-					for (void *it2 : it1)
-						arena->deallocate(it2);
-				*(RenderQueueContent *)this = RenderQueueContent();
-				uubStaging.resize(0);
-				initHeads();
+				return resourceIndex(models, +model, model);
 			}
 
-			void dispatch()
+			template<class Handle>
+			uint32 handleIndex(std::vector<Handle> &handles, Handle &&handle)
 			{
-#ifdef CAGE_DEBUG
-				namesStack.clear();
-#endif // CAGE_DEBUG
-#ifdef CAGE_PROFILING_ENABLED
-				profilingStack.clear();
-#endif // CAGE_PROFILING_ENABLED
-
-				for (const CmdBase *cmd = setupHead; cmd; cmd = cmd->next)
-					cmd->dispatch(this);
-				
-				Holder<UniformBuffer> uub; // make sure the uub is destroyed on the opengl thread
-				if (uubStaging.size() > 0)
-				{
-					ProfilingScope profiling("UUB upload");
-					if (provisionalGraphics)
-					{
-						uub = provisionalGraphics->uniformBuffer(Stringizer() + "UUB_" + queueName)->resolve();
-						uub->bind();
-						if (uub->size() >= uubStaging.size())
-							uub->writeRange(uubStaging, 0);
-						else
-							uub->writeWhole(uubStaging);
-					}
-					else
-					{
-						uub = newUniformBuffer();
-						uub->setDebugName("UUB");
-						uub->writeWhole(uubStaging);
-					}
-				}
-				uubObject = +uub;
-
-				for (const CmdBase *cmd = head; cmd; cmd = cmd->next)
-					cmd->dispatch(this);
-
-				uubObject = nullptr;
-
-				CAGE_CHECK_GL_ERROR_DEBUG();
+				const void *key = handle.pointer();
+				auto it = resourcesIndices.find(key);
+				if (it != resourcesIndices.end())
+					return it->second;
+				const uint32 index = numeric_cast<uint32>(handles.size());
+				handles.push_back(std::move(handle));
+				resourcesIndices[key] = index;
+				return index;
 			}
 
 			// setup commands are run on opengl thread before the universal uniform buffer is dispatched
 			template<class T>
-			T &addSetup()
+			void addSetup(CmdTypeEnum type, const T &cmd)
 			{
 				commandsCount++;
-				T *cmd = arena->createObject<T>();
-				cmdsAllocs.push_back(cmd);
-				setupTail->next = cmd;
-				setupTail = cmd;
-				return *cmd;
+				setup.add((uint32)type, cmd);
 			}
 
 			template<class T>
-			T &addCmd()
+			void addCmd(CmdTypeEnum type, const T &cmd, PointerRange<const char> extra = {})
 			{
 				commandsCount++;
-				T *cmd = arena->createObject<T>();
-				cmdsAllocs.push_back(cmd);
-				tail->next = cmd;
-				tail = cmd;
-				return *cmd;
+				cmds.add((uint32)type, cmd, extra);
 			}
 
+			// state change implied by another command, it is not counted separately
 			template<class T>
-			PointerRange<T> copyMem(PointerRange<T> values)
+			void addImplicit(CmdTypeEnum type, const T &cmd)
 			{
-				static_assert(std::is_trivially_copyable_v<T>);
-				static_assert(std::is_trivially_destructible_v<T>);
-				static_assert(!std::is_pointer_v<T>);
-				void *blck = arena->allocate(values.size() * sizeof(T), alignof(T));
-				memAllocs.push_back(blck);
-				detail::memcpy(blck, values.data(), values.size() * sizeof(T));
-				return { (T *)blck, ((T *)blck) + values.size() };
+				cmds.add((uint32)type, cmd);
 			}
 
 			UubRange universalUniformBuffer(PointerRange<const char> data, uint32 bindingPoint)
@@ -192,98 +493,450 @@ namespace cage
 			}
 
 			template<class T>
-			void uniformImpl(const Holder<ShaderProgram> &shader, uint32 name, const T &value)
+			void uniformImpl(const Holder<ShaderProgram> &shader, uint32 name, PointerRange<const T> values, bool array)
 			{
 				CAGE_ASSERT(shader);
+				static_assert(std::is_trivially_copyable_v<T>);
+				static_assert(std::is_trivially_destructible_v<T>);
+				CmdUniform cmd;
+				cmd.shader = shaderIndex(shader);
+				cmd.name = name;
+				cmd.type = uniformType<T>();
+				cmd.count = numeric_cast<uint32>(values.size());
+				cmd.array = array;
+				addCmd(CmdTypeEnum::Uniform, cmd, { (const char *)values.data(), (const char *)(values.data() + values.size()) });
+			}
 
-				struct Cmd : public CmdBase
-				{
-					Holder<ShaderProgram> shader;
-					T value = {};
-					uint32 name = 0;
-					void dispatch(RenderQueueImpl *) const override
-					{
-						shader->uniform(name, value);
-					}
-				};
+			void pushNamedScope(StringLiteral name)
+			{
+#ifdef CAGE_PROFILING_ENABLED
+				profilingStack.push_back(profilingEventBegin(name));
+#endif // CAGE_PROFILING_ENABLED
+				addCmd(CmdTypeEnum::PushScope, CmdScope{ name });
+			}
 
-				Cmd &cmd = addCmd<Cmd>();
-				cmd.shader = shader.share();
-				cmd.value = value;
-				cmd.name = name;
+			void popNamedScope()
+			{
+#ifdef CAGE_PROFILING_ENABLED
+				profilingEventEnd(profilingStack.back());
+				profilingStack.pop_back();
+#endif // CAGE_PROFILING_ENABLED
+				addCmd(CmdTypeEnum::PopScope, CmdNone());
 			}
 
-			template<class T>
-			void uniformImpl(const Holder<ShaderProgram> &shader, uint32 name, PointerRange<const T> values)
+			const void *uubIdentity() const
 			{
-				CAGE_ASSERT(shader);
+				return uubObject ? (const void *)uubObject : (const void *)this;
+			}
 
-				struct Cmd : public CmdBase
+			// updates the tracked state and returns true if the command would not change anything
+			bool redundant(DispatchState &state, const CommandBuffer::Command &c) const
+			{
+				switch ((CmdTypeEnum)c.type)
 				{
-					Holder<ShaderProgram> shader;
-					PointerRange<const T> values;
-					uint32 name = 0;
-					void dispatch(RenderQueueImpl *) const override
-					{
-						shader->uniform(name, values);
-					}
-				};
-
-				Cmd &cmd = addCmd<Cmd>();
-				cmd.shader = shader.share();
-				cmd.values = copyMem(values);
-				cmd.name = name;
+				case CmdTypeEnum::UubBind:
+				{
+					const CmdUubBind &cmd = c.as<CmdUubBind>();
+					return !state.changeBlock(cmd.bindingPoint, uubIdentity(), cmd.range.offset, cmd.range.size);
+				}
+				case CmdTypeEnum::UniformBufferBind:
+				{
+					const CmdUniformBufferBind &cmd = c.as<CmdUniformBufferBind>();
+					return !state.changeBlock(cmd.bindingPoint, uniformBuffers[cmd.buffer].pointer(), m, m);
+				}
+				case CmdTypeEnum::UniformBufferBindRange:
+				{
+					const CmdUniformBufferBind &cmd = c.as<CmdUniformBufferBind>();
+					return !state.changeBlock(cmd.bindingPoint, uniformBuffers[cmd.buffer].pointer(), cmd.offset, cmd.size);
+				}
+				case CmdTypeEnum::BindlessUniform:
+				{
+					state.invalidateBlock(c.as<CmdBindless>().bindingPoint);
+					return false;
+				}
+				case CmdTypeEnum::ShaderBind:
+				{
+					const void *p = +shaders[c.as<CmdIndex>().index];
+					if (state.program == p)
+						return true;
+					state.program = p;
+					return false;
+				}
+				case CmdTypeEnum::TextureBind:
+				{
+					const CmdTextureBind &cmd = c.as<CmdTextureBind>();
+					return !state.changeTexture(cmd.bindingPoint, textures[cmd.texture].pointer());
+				}
+				case CmdTypeEnum::TexturesReset:
+				{
+					state.textures = {};
+					return false;
+				}
+				case CmdTypeEnum::ModelBind:
+				{
+					const void *p = +models[c.as<CmdIndex>().index];
+					if (state.model == p)
+						return true;
+					state.invalidateBlock(CAGE_SHADER_UNIBLOCK_MATERIAL); // the model binds its material there
+					state.model = p;
+					return false;
+				}
+				default:
+					return false;
+				}
 			}
 
-			void pushNamedScope(StringLiteral name)
+			void execute(DispatchState &state, const CommandBuffer::Command &c)
 			{
+				switch ((CmdTypeEnum)c.type)
+				{
+				case CmdTypeEnum::UubBind:
+				{
+					const CmdUubBind &cmd = c.as<CmdUubBind>();
+					uubObject->bind(cmd.bindingPoint, cmd.range.offset, cmd.range.size);
+				} break;
+				case CmdTypeEnum::UniformBufferBind:
+				{
+					const CmdUniformBufferBind &cmd = c.as<CmdUniformBufferBind>();
+					uniformBuffers[cmd.buffer].resolve()->bind(cmd.bindingPoint);
+				} break;
+				case CmdTypeEnum::UniformBufferBindRange:
+				{
+					const CmdUniformBufferBind &cmd = c.as<CmdUniformBufferBind>();
+					uniformBuffers[cmd.buffer].resolve()->bind(cmd.bindingPoint, cmd.offset, cmd.size);
+				} break;
+				case CmdTypeEnum::UniformBufferWriteWhole:
+				{
+					const CmdUniformBufferWrite &cmd = c.as<CmdUniformBufferWrite>();
+					uniformBuffers[cmd.buffer].resolve()->writeWhole(c.extra<CmdUniformBufferWrite>(), cmd.param);
+				} break;
+				case CmdTypeEnum::UniformBufferWriteRange:
+				{
+					const CmdUniformBufferWrite &cmd = c.as<CmdUniformBufferWrite>();
+					uniformBuffers[cmd.buffer].resolve()->writeRange(c.extra<CmdUniformBufferWrite>(), cmd.param);
+				} break;
+				case CmdTypeEnum::ShaderBind:
+					shaders[c.as<CmdIndex>().index]->bind();
+					break;
+				case CmdTypeEnum::Uniform:
+				{
+					const CmdUniform &cmd = c.as<CmdUniform>();
+					ShaderProgram *shader = +shaders[cmd.shader];
+					const PointerRange<const char> data = c.extra<CmdUniform>();
+					switch (cmd.type)
+					{
+					case UniformTypeEnum::Sint32: uniformDispatch<sint32>(shader, cmd, data); break;
+					case UniformTypeEnum::Uint32: uniformDispatch<uint32>(shader, cmd, data); break;
+					case UniformTypeEnum::Vec2i: uniformDispatch<Vec2i>(shader, cmd, data); break;
+					case UniformTypeEnum::Vec3i: uniformDispatch<Vec3i>(shader, cmd, data); break;
+					case UniformTypeEnum::Vec4i: uniformDispatch<Vec4i>(shader, cmd, data); break;
+					case UniformTypeEnum::Real: uniformDispatch<Real>(shader, cmd, data); break;
+					case UniformTypeEnum::Vec2: uniformDispatch<Vec2>(shader, cmd, data); break;
+					case UniformTypeEnum::Vec3: uniformDispatch<Vec3>(shader, cmd, data); break;
+					case UniformTypeEnum::Vec4: uniformDispatch<Vec4>(shader, cmd, data); break;
+					case UniformTypeEnum::Quat: uniformDispatch<Quat>(shader, cmd, data); break;
+					case UniformTypeEnum::Mat3: uniformDispatch<Mat3>(shader, cmd, data); break;
+					case UniformTypeEnum::Mat4: uniformDispatch<Mat4>(shader, cmd, data); break;
+					}
+				} break;
+				case CmdTypeEnum::FrameBufferBind:
+					frameBuffers[c.as<CmdIndex>().index].resolve()->bind();
+					break;
+				case CmdTypeEnum::FrameBufferDepthTexture:
+				{
+					const CmdFrameBufferTexture &cmd = c.as<CmdFrameBufferTexture>();
+					frameBuffers[cmd.frameBuffer].resolve()->depthTexture(cmd.texture == m ? nullptr : +textures[cmd.texture].resolve());
+				} break;
+				case CmdTypeEnum::FrameBufferColorTexture:
+				{
+					const CmdFrameBufferTexture &cmd = c.as<CmdFrameBufferTexture>();
+					frameBuffers[cmd.frameBuffer].resolve()->colorTexture(cmd.index, cmd.texture == m ? nullptr : +textures[cmd.texture].resolve(), cmd.mipmapLevel);
+				} break;
+				case CmdTypeEnum::FrameBufferActiveAttachments:
+				{
+					const CmdFrameBufferMask &cmd = c.as<CmdFrameBufferMask>();
+					frameBuffers[cmd.frameBuffer].resolve()->activeAttachments(cmd.mask);
+				} break;
+				case CmdTypeEnum::FrameBufferClear:
+					frameBuffers[c.as<CmdIndex>().index].resolve()->clear();
+					break;
+				case CmdTypeEnum::FrameBufferCheck:
+					frameBuffers[c.as<CmdIndex>().index].resolve()->checkStatus();
+					break;
+				case CmdTypeEnum::FrameBufferReset:
+					glBindFramebuffer(GL_FRAMEBUFFER, 0);
+					break;
+				case CmdTypeEnum::TextureBind:
+				{
+					const CmdTextureBind &cmd = c.as<CmdTextureBind>();
+					textures[cmd.texture].resolve()->bind(cmd.bindingPoint);
+				} break;
+				case CmdTypeEnum::TextureImage2d:
+				{
+					const CmdTextureImage &cmd = c.as<CmdTextureImage>();
+					textures[cmd.texture].resolve()->initialize(Vec2i(cmd.resolution[0], cmd.resolution[1]), cmd.mipmapLevels, cmd.internalFormat);
+				} break;
+				case CmdTypeEnum::TextureImage3d:
+				{
+					const CmdTextureImage &cmd = c.as<CmdTextureImage>();
+					textures[cmd.texture].resolve()->initialize(cmd.resolution, cmd.mipmapLevels, cmd.internalFormat);
+				} break;
+				case CmdTypeEnum::TextureFilters:
+				{
+					const CmdTextureParams &cmd = c.as<CmdTextureParams>();
+					textures[cmd.texture].resolve()->filters(cmd.a, cmd.b, cmd.c);
+				} break;
+				case CmdTypeEnum::TextureWraps2:
+				{
+					const CmdTextureParams &cmd = c.as<CmdTextureParams>();
+					textures[cmd.texture].resolve()->wraps(cmd.a, cmd.b);
+				} break;
+				case CmdTypeEnum::TextureWraps3:
+				{
+					const CmdTextureParams &cmd = c.as<CmdTextureParams>();
+					textures[cmd.texture].resolve()->wraps(cmd.a, cmd.b, cmd.c);
+				} break;
+				case CmdTypeEnum::TextureGenerateMipmaps:
+					textures[c.as<CmdIndex>().index].resolve()->generateMipmaps();
+					break;
+				case CmdTypeEnum::TexturesReset:
+				{
+					for (uint32 i = 0; i < 16; i++)
+					{
+						glActiveTexture(GL_TEXTURE0 + i);
+						glBindTexture(GL_TEXTURE_1D, 0);
+						glBindTexture(GL_TEXTURE_1D_ARRAY, 0);
+						glBindTexture(GL_TEXTURE_2D, 0);
+						glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+						glBindTexture(GL_TEXTURE_RECTANGLE, 0);
+						glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+						glBindTexture(GL_TEXTURE_3D, 0);
+					}
+					glActiveTexture(GL_TEXTURE0 + 0);
+				} break;
+				case CmdTypeEnum::TextureBindImage:
+				{
+					const CmdTextureBindImage &cmd = c.as<CmdTextureBindImage>();
+					textures[cmd.texture].resolve()->bindImage(cmd.bindingPoint, cmd.read, cmd.write);
+				} break;
+				case CmdTypeEnum::BindlessUniform:
+				{
+					const CmdBindless &cmd = c.as<CmdBindless>();
+					if (cmd.flag)
+					{
+						for (auto &it : bindless[cmd.index])
+						{
+							if (!it)
+								continue;
+							Holder<Texture> tex = it.resolve();
+							tex->makeResident(true);
+						}
+					}
+					const UubRange &range = bindlessRanges[cmd.index];
+					uubObject->bind(cmd.bindingPoint, range.offset, range.size);
+				} break;
+				case CmdTypeEnum::BindlessResident:
+				{
+					const CmdBindless &cmd = c.as<CmdBindless>();
+					for (auto &it : bindless[cmd.index])
+					{
+						Holder<Texture> tex = it.resolve();
+						tex->makeResident(cmd.flag);
+					}
+				} break;
+				case CmdTypeEnum::ModelBind:
+					models[c.as<CmdIndex>().index]->bind();
+					break;
+				case CmdTypeEnum::Draw:
+				{
+					const CmdDraw &cmd = c.as<CmdDraw>();
+					models[cmd.model]->dispatch(cmd.instances);
+				} break;
+				case CmdTypeEnum::Compute:
+				{
+					const CmdCompute &cmd = c.as<CmdCompute>();
+					shaders[cmd.shader]->compute(cmd.groupsCounts);
+				} break;
+				case CmdTypeEnum::MemoryBarrier:
+					glMemoryBarrier(c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::Viewport:
+				{
+					const CmdRect &cmd = c.as<CmdRect>();
+					glViewport(cmd.origin[0], cmd.origin[1], cmd.size[0], cmd.size[1]);
+					glScissor(cmd.origin[0], cmd.origin[1], cmd.size[0], cmd.size[1]);
+				} break;
+				case CmdTypeEnum::Scissors:
+				{
+					const CmdRect &cmd = c.as<CmdRect>();
+					glScissor(cmd.origin[0], cmd.origin[1], cmd.size[0], cmd.size[1]);
+				} break;
+				case CmdTypeEnum::CullFace:
+					glCullFace(c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::DepthFunc:
+					glDepthFunc(c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::DepthWrite:
+					glDepthMask(!!c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::ColorWrite:
+				{
+					const bool enable = !!c.as<CmdValue>().value;
+					glColorMask(enable, enable, enable, enable);
+				} break;
+				case CmdTypeEnum::BlendFunc:
+				{
+					const CmdPair &cmd = c.as<CmdPair>();
+					glBlendFunc(cmd.a, cmd.b);
+				} break;
+				case CmdTypeEnum::ClearColor:
+				{
+					const Vec4 &rgba = c.as<CmdClearColor>().rgba;
+					glClearColor(rgba[0].value, rgba[1].value, rgba[2].value, rgba[3].value);
+				} break;
+				case CmdTypeEnum::Clear:
+					glClear(c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::Enable:
+					glEnable(c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::Disable:
+					glDisable(c.as<CmdValue>().value);
+					break;
+				case CmdTypeEnum::PushScope:
+				{
+					const StringLiteral name = c.as<CmdScope>().name;
+#ifdef CAGE_DEBUG
+					namesStack.push_back(name);
+#endif // CAGE_DEBUG
 #ifdef CAGE_PROFILING_ENABLED
-				profilingStack.push_back(profilingEventBegin(name));
+					profilingStack.push_back(profilingEventBegin(name));
 #endif // CAGE_PROFILING_ENABLED
-
-				struct Cmd : public CmdBase
+					glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+				} break;
+				case CmdTypeEnum::PopScope:
 				{
-					StringLiteral name;
-					void dispatch(RenderQueueImpl *impl) const override
-					{
 #ifdef CAGE_DEBUG
-						impl->namesStack.push_back(name);
+					CAGE_ASSERT(!namesStack.empty());
+					namesStack.pop_back();
 #endif // CAGE_DEBUG
 #ifdef CAGE_PROFILING_ENABLED
-						impl->profilingStack.push_back(profilingEventBegin(name));
+					profilingEventEnd(profilingStack.back());
+					profilingStack.pop_back();
 #endif // CAGE_PROFILING_ENABLED
-						glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+					glPopDebugGroup();
+				} break;
+				case CmdTypeEnum::Enqueue:
+					((RenderQueueImpl *)+queues[c.as<CmdIndex>().index])->dispatch(state);
+					break;
+				case CmdTypeEnum::CheckGlErrorDebug:
+				{
+					try
+					{
+						cage::checkGlError();
 					}
-				};
-
-				Cmd &cmd = addCmd<Cmd>();
-				cmd.name = name;
+					catch (const GraphicsError &)
+					{
+						CAGE_LOG(SeverityEnum::Error, "exception", Stringizer() + "uncaught opengl error");
+					}
+				} break;
+				case CmdTypeEnum::CheckGlError:
+					cage::checkGlError();
+					break;
+				default:
+					CAGE_THROW_CRITICAL(Exception, "invalid render queue command type");
+				}
 			}
 
-			void popNamedScope()
+			void setupBindless(uint32 index)
 			{
-#ifdef CAGE_PROFILING_ENABLED
-				profilingEventEnd(profilingStack.back());
-				profilingStack.pop_back();
-#endif // CAGE_PROFILING_ENABLED
-
-				struct Cmd : public CmdBase
+				const auto &handles = bindless[index];
+				uint64 *arr = (uint64 *)CAGE_ALLOCA(sizeof(uint64) * handles.size());
+				uint64 *arrit = arr;
+				for (auto &it : handles)
 				{
-					void dispatch(RenderQueueImpl *impl) const override
+					if (!it)
 					{
+						*arrit++ = 0;
+						continue;
+					}
+					Holder<Texture> tex = it.resolve();
+					BindlessHandle hnd = tex->bindlessHandle();
+					*arrit++ = hnd.handle;
+				}
+				bindlessRanges[index] = universalUniformArray<uint64>(PointerRange<uint64>(arr, arr + handles.size()));
+			}
+
+			void dispatch(DispatchState &state)
+			{
 #ifdef CAGE_DEBUG
-						CAGE_ASSERT(!impl->namesStack.empty());
-						impl->namesStack.pop_back();
+				namesStack.clear();
 #endif // CAGE_DEBUG
 #ifdef CAGE_PROFILING_ENABLED
-						profilingEventEnd(impl->profilingStack.back());
-						impl->profilingStack.pop_back();
+				profilingStack.clear();
 #endif // CAGE_PROFILING_ENABLED
-						glPopDebugGroup();
+
+				for (const auto &c : setup)
+				{
+					CAGE_ASSERT((CmdTypeEnum)c.type == CmdTypeEnum::BindlessSetup);
+					setupBindless(c.as<CmdIndex>().index);
+				}
+
+				Holder<UniformBuffer> uub; // make sure the uub is destroyed on the opengl thread
+				if (uubStaging.size() > 0)
+				{
+					ProfilingScope profiling("UUB upload");
+					if (provisionalGraphics)
+					{
+						uub = provisionalGraphics->uniformBuffer(Stringizer() + "UUB_" + queueName)->resolve();
+						uub->bind();
+						if (uub->size() >= uubStaging.size())
+							uub->writeRange(uubStaging, 0);
+						else
+							uub->writeWhole(uubStaging);
+					}
+					else
+					{
+						uub = newUniformBuffer();
+						uub->setDebugName("UUB");
+						uub->writeWhole(uubStaging);
+					}
+				}
+				uubObject = +uub;
+
+				for (const auto &c : cmds)
+				{
+					if (redundant(state, c))
+					{
+						state.redundant++;
+						continue;
 					}
-				};
+					execute(state, c);
+				}
+
+				// the uub is destroyed with this dispatch, its bindings must not be reused
+				for (auto &b : state.blocks)
+					if (b.buffer == uubObject)
+						b = {};
+				uubObject = nullptr;
 
-				addCmd<Cmd>();
+				CAGE_CHECK_GL_ERROR_DEBUG();
+			}
+
+			void inspect(DispatchState &state, InspectionData &data) const
+			{
+				for (const auto &c : cmds)
+				{
+					if (redundant(state, c))
+					{
+						data.redundant++;
+						continue;
+					}
+					data.commands.push_back(commandName((CmdTypeEnum)c.type));
+					if ((CmdTypeEnum)c.type == CmdTypeEnum::Enqueue)
+						((const RenderQueueImpl *)+queues[c.as<CmdIndex>().index])->inspect(state, data);
+				}
 			}
 		};
 	}
@@ -297,137 +950,70 @@ namespace cage
 
 	void RenderQueue::bind(UubRange uubRange, uint32 bindingPoint)
 	{
-		struct Cmd : public CmdBase, public UubRange
-		{
-			uint32 bindingPoint = 0;
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				impl->uubObject->bind(bindingPoint, offset, size);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
 		CAGE_ASSERT(uubRange.size <= 16384);
 		CAGE_ASSERT(uubRange.offset + uubRange.size <= impl->uubStaging.size());
 		CAGE_ASSERT((uubRange.offset % UniformBuffer::alignmentRequirement()) == 0);
-		Cmd &cmd = impl->addCmd<Cmd>();
-		(UubRange &)cmd = uubRange;
-		cmd.bindingPoint = bindingPoint;
+		impl->addCmd(CmdTypeEnum::UubBind, CmdUubBind{ uubRange, bindingPoint });
 	}
 
 	void RenderQueue::bind(UniformBufferHandle uniformBuffer, uint32 bindingPoint)
 	{
 		CAGE_ASSERT(uniformBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			UniformBufferHandle uniformBuffer;
-			uint32 bindingPoint = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				Holder<UniformBuffer> ub = uniformBuffer.resolve();
-				ub->bind(bindingPoint);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.uniformBuffer = std::move(uniformBuffer);
+		CmdUniformBufferBind cmd;
+		cmd.buffer = impl->handleIndex(impl->uniformBuffers, std::move(uniformBuffer));
 		cmd.bindingPoint = bindingPoint;
+		impl->addCmd(CmdTypeEnum::UniformBufferBind, cmd);
 	}
 
 	void RenderQueue::bind(UniformBufferHandle uniformBuffer, uint32 bindingPoint, uint32 offset, uint32 size)
 	{
 		CAGE_ASSERT(uniformBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			UniformBufferHandle uniformBuffer;
-			uint32 bindingPoint = 0;
-			uint32 offset = 0;
-			uint32 size = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				Holder<UniformBuffer> ub = uniformBuffer.resolve();
-				ub->bind(bindingPoint, offset, size);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.uniformBuffer = std::move(uniformBuffer);
+		CmdUniformBufferBind cmd;
+		cmd.buffer = impl->handleIndex(impl->uniformBuffers, std::move(uniformBuffer));
 		cmd.bindingPoint = bindingPoint;
 		cmd.offset = offset;
 		cmd.size = size;
+		impl->addCmd(CmdTypeEnum::UniformBufferBindRange, cmd);
 	}
 
 	void RenderQueue::writeWhole(UniformBufferHandle uniformBuffer, PointerRange<const char> data, uint32 usage)
 	{
-		struct Cmd : public CmdBase
-		{
-			UniformBufferHandle uniformBuffer;
-			PointerRange<const char> data;
-			uint32 usage = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				uniformBuffer.resolve()->writeWhole(data, usage);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.uniformBuffer = std::move(uniformBuffer);
-		cmd.data = impl->copyMem(data);
-		cmd.usage = usage;
+		CmdUniformBufferWrite cmd;
+		cmd.buffer = impl->handleIndex(impl->uniformBuffers, std::move(uniformBuffer));
+		cmd.param = usage;
+		impl->addCmd(CmdTypeEnum::UniformBufferWriteWhole, cmd, data);
 	}
 
 	void RenderQueue::writeRange(UniformBufferHandle uniformBuffer, PointerRange<const char> data, uint32 offset)
 	{
-		struct Cmd : public CmdBase
-		{
-			UniformBufferHandle uniformBuffer;
-			PointerRange<const char> data;
-			uint32 offset = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				uniformBuffer.resolve()->writeRange(data, offset);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.uniformBuffer = std::move(uniformBuffer);
-		cmd.data = impl->copyMem(data);
-		cmd.offset = offset;
+		CmdUniformBufferWrite cmd;
+		cmd.buffer = impl->handleIndex(impl->uniformBuffers, std::move(uniformBuffer));
+		cmd.param = offset;
+		impl->addCmd(CmdTypeEnum::UniformBufferWriteRange, cmd, data);
 	}
 
 	void RenderQueue::bind(const Holder<ShaderProgram> &shader)
 	{
 		CAGE_ASSERT(shader);
-
-		struct Cmd : public CmdBase
-		{
-			Holder<ShaderProgram> shaderProgram;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				shaderProgram->bind();
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().shaderProgram = shader.share();
+		impl->addCmd(CmdTypeEnum::ShaderBind, CmdIndex{ impl->shaderIndex(shader) });
 	}
 
 #define GCHL_GENERATE(TYPE) \
 	void RenderQueue::uniform(const Holder<ShaderProgram> &shader, uint32 name, const TYPE &value) \
 	{ \
 		RenderQueueImpl *impl = (RenderQueueImpl *)this; \
-		impl->uniformImpl<TYPE>(shader, name, value); \
+		impl->uniformImpl<TYPE>(shader, name, { &value, &value + 1 }, false); \
 	} \
 	void RenderQueue::uniform(const Holder<ShaderProgram> &shader, uint32 name, PointerRange<const TYPE> values) \
 	{ \
 		RenderQueueImpl *impl = (RenderQueueImpl *)this; \
-		impl->uniformImpl<TYPE>(shader, name, values); \
+		impl->uniformImpl<TYPE>(shader, name, values, true); \
 	}
 	GCHL_GENERATE(sint32);
 	GCHL_GENERATE(uint32);
@@ -443,153 +1029,75 @@ namespace cage
 	GCHL_GENERATE(Mat4);
 #undef GCHL_GENERATE
 
-	void RenderQueue::bind(FrameBufferHandle frameBuffer)
-	{
-		CAGE_ASSERT(frameBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			FrameBufferHandle frameBuffer;
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				frameBuffer.resolve()->bind();
-			}
-		};
-
+	void RenderQueue::bind(FrameBufferHandle frameBuffer)
+	{
+		CAGE_ASSERT(frameBuffer);
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().frameBuffer = std::move(frameBuffer);
+		impl->addCmd(CmdTypeEnum::FrameBufferBind, CmdIndex{ impl->handleIndex(impl->frameBuffers, std::move(frameBuffer)) });
 	}
 
 	void RenderQueue::depthTexture(FrameBufferHandle frameBuffer, TextureHandle texture)
 	{
 		CAGE_ASSERT(frameBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			FrameBufferHandle frameBuffer;
-			TextureHandle texture;
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				frameBuffer.resolve()->depthTexture(+texture.resolve());
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.frameBuffer = std::move(frameBuffer);
-		cmd.texture = std::move(texture);
+		CmdFrameBufferTexture cmd;
+		cmd.frameBuffer = impl->handleIndex(impl->frameBuffers, std::move(frameBuffer));
+		if (texture)
+			cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
+		impl->addCmd(CmdTypeEnum::FrameBufferDepthTexture, cmd);
 	}
 
 	void RenderQueue::colorTexture(FrameBufferHandle frameBuffer, uint32 index, TextureHandle texture, uint32 mipmapLevel)
 	{
 		CAGE_ASSERT(frameBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			FrameBufferHandle frameBuffer;
-			TextureHandle texture;
-			uint32 index = 0;
-			uint32 mipmapLevel = 0;
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				frameBuffer.resolve()->colorTexture(index, +texture.resolve(), mipmapLevel);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.frameBuffer = std::move(frameBuffer);
-		cmd.texture = std::move(texture);
+		CmdFrameBufferTexture cmd;
+		cmd.frameBuffer = impl->handleIndex(impl->frameBuffers, std::move(frameBuffer));
+		if (texture)
+			cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
 		cmd.index = index;
 		cmd.mipmapLevel = mipmapLevel;
+		impl->addCmd(CmdTypeEnum::FrameBufferColorTexture, cmd);
 	}
 
 	void RenderQueue::activeAttachments(FrameBufferHandle frameBuffer, uint32 mask)
 	{
 		CAGE_ASSERT(frameBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			FrameBufferHandle frameBuffer;
-			uint32 mask = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				frameBuffer.resolve()->activeAttachments(mask);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.frameBuffer = std::move(frameBuffer);
+		CmdFrameBufferMask cmd;
+		cmd.frameBuffer = impl->handleIndex(impl->frameBuffers, std::move(frameBuffer));
 		cmd.mask = mask;
+		impl->addCmd(CmdTypeEnum::FrameBufferActiveAttachments, cmd);
 	}
 
 	void RenderQueue::clearFrameBuffer(FrameBufferHandle frameBuffer)
 	{
 		CAGE_ASSERT(frameBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			FrameBufferHandle frameBuffer;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				frameBuffer.resolve()->clear();
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().frameBuffer = std::move(frameBuffer);
+		impl->addCmd(CmdTypeEnum::FrameBufferClear, CmdIndex{ impl->handleIndex(impl->frameBuffers, std::move(frameBuffer)) });
 	}
 
 	void RenderQueue::checkFrameBuffer(FrameBufferHandle frameBuffer)
 	{
 		CAGE_ASSERT(frameBuffer);
-
-		struct Cmd : public CmdBase
-		{
-			FrameBufferHandle frameBuffer;
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				frameBuffer.resolve()->checkStatus();
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().frameBuffer = std::move(frameBuffer);
+		impl->addCmd(CmdTypeEnum::FrameBufferCheck, CmdIndex{ impl->handleIndex(impl->frameBuffers, std::move(frameBuffer)) });
 	}
 
 	void RenderQueue::resetFrameBuffer()
 	{
-		struct Cmd : public CmdBase
-		{
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>();
+		impl->addCmd(CmdTypeEnum::FrameBufferReset, CmdNone());
 	}
 
 	void RenderQueue::bind(TextureHandle texture, uint32 bindingPoint)
 	{
 		CAGE_ASSERT(texture);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			uint32 bindingPoint = m;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->bind(bindingPoint);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = std::move(texture);
+		CmdTextureBind cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
 		cmd.bindingPoint = bindingPoint;
+		impl->addCmd(CmdTypeEnum::TextureBind, cmd);
 	}
 
 	void RenderQueue::image2d(TextureHandle texture, Vec2i resolution, uint32 mipmapLevels, uint32 internalFormat)
@@ -597,25 +1105,13 @@ namespace cage
 		CAGE_ASSERT(texture);
 		CAGE_ASSERT(mipmapLevels > 0);
 		CAGE_ASSERT(internalFormat != 0);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			Vec2i resolution;
-			uint32 mipmapLevels = 0;
-			uint32 internalFormat = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->initialize(resolution, mipmapLevels, internalFormat);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = std::move(texture);
-		cmd.resolution = resolution;
+		CmdTextureImage cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
+		cmd.resolution = Vec3i(resolution, 1);
 		cmd.mipmapLevels = mipmapLevels;
 		cmd.internalFormat = internalFormat;
+		impl->addCmd(CmdTypeEnum::TextureImage2d, cmd);
 	}
 
 	void RenderQueue::image3d(TextureHandle texture, Vec3i resolution, uint32 mipmapLevels, uint32 internalFormat)
@@ -623,334 +1119,138 @@ namespace cage
 		CAGE_ASSERT(texture);
 		CAGE_ASSERT(mipmapLevels > 0);
 		CAGE_ASSERT(internalFormat != 0);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			Vec3i resolution;
-			uint32 mipmapLevels = 0;
-			uint32 internalFormat = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->initialize(resolution, mipmapLevels, internalFormat);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = std::move(texture);
+		CmdTextureImage cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
 		cmd.resolution = resolution;
 		cmd.mipmapLevels = mipmapLevels;
 		cmd.internalFormat = internalFormat;
+		impl->addCmd(CmdTypeEnum::TextureImage3d, cmd);
 	}
 
 	void RenderQueue::filters(TextureHandle texture, uint32 mig, uint32 mag, uint32 aniso)
 	{
 		CAGE_ASSERT(texture);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			uint32 mig = 0, mag = 0, aniso = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->filters(mig, mag, aniso);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = std::move(texture);
-		cmd.mig = mig;
-		cmd.mag = mag;
-		cmd.aniso = aniso;
+		CmdTextureParams cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
+		cmd.a = mig;
+		cmd.b = mag;
+		cmd.c = aniso;
+		impl->addCmd(CmdTypeEnum::TextureFilters, cmd);
 	}
 
 	void RenderQueue::wraps(TextureHandle texture, uint32 s, uint32 t)
 	{
 		CAGE_ASSERT(texture);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			uint32 s = 0, t = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->wraps(s, t);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = std::move(texture);
-		cmd.s = s;
-		cmd.t = t;
+		CmdTextureParams cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
+		cmd.a = s;
+		cmd.b = t;
+		impl->addCmd(CmdTypeEnum::TextureWraps2, cmd);
 	}
 
 	void RenderQueue::wraps(TextureHandle texture, uint32 s, uint32 t, uint32 r)
 	{
 		CAGE_ASSERT(texture);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			uint32 s = 0, t = 0, r = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->wraps(s, t, r);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = std::move(texture);
-		cmd.s = s;
-		cmd.t = t;
-		cmd.r = r;
+		CmdTextureParams cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
+		cmd.a = s;
+		cmd.b = t;
+		cmd.c = r;
+		impl->addCmd(CmdTypeEnum::TextureWraps3, cmd);
 	}
 
 	void RenderQueue::generateMipmaps(TextureHandle texture)
 	{
 		CAGE_ASSERT(texture);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->generateMipmaps();
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().texture = std::move(texture);
+		impl->addCmd(CmdTypeEnum::TextureGenerateMipmaps, CmdIndex{ impl->handleIndex(impl->textures, std::move(texture)) });
 	}
 
 	void RenderQueue::resetAllTextures()
 	{
-		struct Cmd : public CmdBase
-		{
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				for (uint32 i = 0; i < 16; i++)
-				{
-					glActiveTexture(GL_TEXTURE0 + i);
-					glBindTexture(GL_TEXTURE_1D, 0);
-					glBindTexture(GL_TEXTURE_1D_ARRAY, 0);
-					glBindTexture(GL_TEXTURE_2D, 0);
-					glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-					glBindTexture(GL_TEXTURE_RECTANGLE, 0);
-					glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-					glBindTexture(GL_TEXTURE_3D, 0);
-				}
-				glActiveTexture(GL_TEXTURE0 + 0);
-			}
-		};
-
 		const auto scopedName = namedScope("reset all textures");
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>();
+		impl->addCmd(CmdTypeEnum::TexturesReset, CmdNone());
 	}
 
 	void RenderQueue::bindImage(TextureHandle texture, uint32 bindingPoint, bool read, bool write)
 	{
 		CAGE_ASSERT(read || write);
-
-		struct Cmd : public CmdBase
-		{
-			TextureHandle texture;
-			uint32 bindingPoint = 0;
-			bool read = false;
-			bool write = false;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				texture.resolve()->bindImage(bindingPoint, read, write);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.texture = texture;
+		CmdTextureBindImage cmd;
+		cmd.texture = impl->handleIndex(impl->textures, std::move(texture));
 		cmd.bindingPoint = bindingPoint;
 		cmd.read = read;
 		cmd.write = write;
+		impl->addCmd(CmdTypeEnum::TextureBindImage, cmd);
 	}
 
 	void RenderQueue::bindlessUniform(Holder<PointerRange<TextureHandle>> bindlessHandles, uint32 bindingPoint, bool makeResident)
 	{
-		struct CmdSetup : public CmdBase
-		{
-			Holder<PointerRange<TextureHandle>> bindlessHandles;
-			UubRange range;
-
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				uint64 *arr = (uint64 *)CAGE_ALLOCA(sizeof(uint64) * bindlessHandles.size());
-				uint64 *arrit = arr;
-				for (auto &it : bindlessHandles)
-				{
-					if (!it)
-					{
-						*arrit++ = 0;
-						continue;
-					}
-					Holder<Texture> tex = it.resolve();
-					BindlessHandle hnd = tex->bindlessHandle();
-					*arrit++ = hnd.handle;
-				}
-				const_cast<CmdSetup *>(this)->range = impl->universalUniformArray<uint64>(PointerRange<uint64>(arr, arr + bindlessHandles.size()));
-			}
-		};
-
-		struct CmdDispatch : public CmdBase
-		{
-			const CmdSetup *setup = nullptr;
-			uint32 bindingPoint = m;
-			bool makeResident = false;
-
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				if (makeResident)
-				{
-					for (auto &it : setup->bindlessHandles)
-					{
-						if (!it)
-							continue;
-						Holder<Texture> tex = it.resolve();
-						tex->makeResident(true);
-					}
-				}
-
-				impl->uubObject->bind(bindingPoint, setup->range.offset, setup->range.size);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		CmdSetup &setup = impl->addSetup<CmdSetup>();
-		setup.bindlessHandles = std::move(bindlessHandles);
-		CmdDispatch &cmd = impl->addCmd<CmdDispatch>();
-		cmd.setup = &setup;
+		const uint32 index = numeric_cast<uint32>(impl->bindless.size());
+		impl->bindless.push_back(std::move(bindlessHandles));
+		impl->bindlessRanges.push_back({});
+		impl->addSetup(CmdTypeEnum::BindlessSetup, CmdIndex{ index });
+		CmdBindless cmd;
+		cmd.index = index;
 		cmd.bindingPoint = bindingPoint;
-		cmd.makeResident = makeResident;
+		cmd.flag = makeResident;
+		impl->addCmd(CmdTypeEnum::BindlessUniform, cmd);
 	}
 
 	void RenderQueue::bindlessResident(Holder<PointerRange<TextureHandle>> bindlessHandles, bool resident)
 	{
-		struct Cmd : public CmdBase
-		{
-			Holder<PointerRange<TextureHandle>> bindlessHandles;
-			bool resident = false;
-
-			void dispatch(RenderQueueImpl *) const override
-			{
-				for (auto &it : bindlessHandles)
-				{
-					Holder<Texture> tex = it.resolve();
-					tex->makeResident(resident);
-				}
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.bindlessHandles = std::move(bindlessHandles);
-		cmd.resident = resident;
+		const uint32 index = numeric_cast<uint32>(impl->bindless.size());
+		impl->bindless.push_back(std::move(bindlessHandles));
+		impl->bindlessRanges.push_back({});
+		CmdBindless cmd;
+		cmd.index = index;
+		cmd.flag = resident;
+		impl->addCmd(CmdTypeEnum::BindlessResident, cmd);
 	}
 
 	void RenderQueue::draw(const Holder<Model> &model, uint32 instances)
 	{
 		CAGE_ASSERT(model);
-
-		struct Cmd : public CmdBase
-		{
-			Holder<Model> model;
-			uint32 instances = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				model->bind();
-				model->dispatch(instances);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
 		impl->drawsCount++;
 		impl->primitivesCount += instances * model->primitivesCount();
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.model = model.share();
-		cmd.instances = instances;
+		const uint32 index = impl->modelIndex(model);
+		impl->addImplicit(CmdTypeEnum::ModelBind, CmdIndex{ index });
+		impl->addCmd(CmdTypeEnum::Draw, CmdDraw{ index, instances });
 	}
 
 	void RenderQueue::compute(const Holder<ShaderProgram> &shader, const Vec3i &groupsCounts)
 	{
-		struct Cmd : public CmdBase
-		{
-			Holder<ShaderProgram> shader;
-			Vec3i groupsCounts;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				shader->bind();
-				shader->compute(groupsCounts);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
 		impl->drawsCount++;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.shader = shader.share();
-		cmd.groupsCounts = groupsCounts;
+		const uint32 index = impl->shaderIndex(shader);
+		impl->addImplicit(CmdTypeEnum::ShaderBind, CmdIndex{ index });
+		impl->addCmd(CmdTypeEnum::Compute, CmdCompute{ index, groupsCounts });
 	}
 
 	void RenderQueue::memoryBarrier(uint32 bits)
 	{
-		struct Cmd : public CmdBase
-		{
-			uint32 bits = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glMemoryBarrier(bits);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.bits = bits;
+		impl->addCmd(CmdTypeEnum::MemoryBarrier, CmdValue{ bits });
 	}
 
 	void RenderQueue::viewport(Vec2i origin, Vec2i size)
 	{
-		struct Cmd : public CmdBase
-		{
-			Vec2i origin;
-			Vec2i size;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glViewport(origin[0], origin[1], size[0], size[1]);
-				glScissor(origin[0], origin[1], size[0], size[1]);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.origin = origin;
-		cmd.size = size;
+		impl->addCmd(CmdTypeEnum::Viewport, CmdRect{ origin, size });
 	}
 
 	void RenderQueue::scissors(Vec2i origin, Vec2i size)
 	{
-		struct Cmd : public CmdBase
-		{
-			Vec2i origin;
-			Vec2i size;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glScissor(origin[0], origin[1], size[0], size[1]);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.origin = origin;
-		cmd.size = size;
+		impl->addCmd(CmdTypeEnum::Scissors, CmdRect{ origin, size });
 	}
 
 	void RenderQueue::scissors(bool enable)
@@ -960,17 +1260,8 @@ namespace cage
 
 	void RenderQueue::cullFace(bool front)
 	{
-		struct Cmd : public CmdBase
-		{
-			uint32 key = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glCullFace(key);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().key = front ? GL_FRONT : GL_BACK;
+		impl->addCmd(CmdTypeEnum::CullFace, CmdValue{ front ? GL_FRONT : GL_BACK });
 	}
 
 	void RenderQueue::culling(bool enable)
@@ -980,17 +1271,8 @@ namespace cage
 
 	void RenderQueue::depthFunc(uint32 func)
 	{
-		struct Cmd : public CmdBase
-		{
-			uint32 func = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glDepthFunc(func);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().func = func;
+		impl->addCmd(CmdTypeEnum::DepthFunc, CmdValue{ func });
 	}
 
 	void RenderQueue::depthFuncLess()
@@ -1020,49 +1302,20 @@ namespace cage
 
 	void RenderQueue::depthWrite(bool enable)
 	{
-		struct Cmd : public CmdBase
-		{
-			bool enable = false;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glDepthMask(enable);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().enable = enable;
+		impl->addCmd(CmdTypeEnum::DepthWrite, CmdValue{ enable });
 	}
 
 	void RenderQueue::colorWrite(bool enable)
 	{
-		struct Cmd : public CmdBase
-		{
-			bool enable = false;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glColorMask(enable, enable, enable, enable);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().enable = enable;
+		impl->addCmd(CmdTypeEnum::ColorWrite, CmdValue{ enable });
 	}
 
 	void RenderQueue::blendFunc(uint32 s, uint32 d)
 	{
-		struct Cmd : public CmdBase
-		{
-			uint32 s = 0, d = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glBlendFunc(s, d);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		cmd.s = s;
-		cmd.d = d;
+		impl->addCmd(CmdTypeEnum::BlendFunc, CmdPair{ s, d });
 	}
 
 	void RenderQueue::blendFuncNone()
@@ -1092,64 +1345,24 @@ namespace cage
 
 	void RenderQueue::clearColor(const Vec4 &rgba)
 	{
-		struct Cmd : public CmdBase
-		{
-			Vec4 rgba;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glClearColor(rgba[0].value, rgba[1].value, rgba[2].value, rgba[3].value);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>().rgba = rgba;
+		impl->addCmd(CmdTypeEnum::ClearColor, CmdClearColor{ rgba });
 	}
 
 	void RenderQueue::clear(bool color, bool depth, bool stencil)
 	{
-		struct Cmd : public CmdBase
-		{
-			uint32 mask = 0;
-			void dispatch(RenderQueueImpl *) const override
-			{
-				glClear(mask);
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		Cmd &cmd = impl->addCmd<Cmd>();
-		if (color) cmd.mask |= GL_COLOR_BUFFER_BIT;
-		if (depth) cmd.mask |= GL_DEPTH_BUFFER_BIT;
-		if (stencil) cmd.mask |= GL_STENCIL_BUFFER_BIT;
+		CmdValue cmd;
+		if (color) cmd.value |= GL_COLOR_BUFFER_BIT;
+		if (depth) cmd.value |= GL_DEPTH_BUFFER_BIT;
+		if (stencil) cmd.value |= GL_STENCIL_BUFFER_BIT;
+		impl->addCmd(CmdTypeEnum::Clear, cmd);
 	}
 
 	void RenderQueue::genericEnable(uint32 key, bool enable)
 	{
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		if (enable)
-		{
-			struct Cmd : public CmdBase
-			{
-				uint32 key = 0;
-				void dispatch(RenderQueueImpl *) const override
-				{
-					glEnable(key);
-				}
-			};
-			impl->addCmd<Cmd>().key = key;
-		}
-		else
-		{
-			struct Cmd : public CmdBase
-			{
-				uint32 key = 0;
-				void dispatch(RenderQueueImpl *) const override
-				{
-					glDisable(key);
-				}
-			};
-			impl->addCmd<Cmd>().key = key;
-		}
+		impl->addCmd(enable ? CmdTypeEnum::Enable : CmdTypeEnum::Disable, CmdValue{ key });
 	}
 
 	void RenderQueue::resetAllState()
@@ -1176,58 +1389,27 @@ namespace cage
 	void RenderQueue::enqueue(Holder<RenderQueue> queue)
 	{
 		CAGE_ASSERT(queue);
-
-		struct Cmd : public CmdBase
-		{
-			Holder<RenderQueue> queue;
-			void dispatch(RenderQueueImpl *impl) const override
-			{
-				queue->dispatch();
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
 		impl->commandsCount += queue->commandsCount();
 		impl->drawsCount += queue->drawsCount();
 		impl->primitivesCount += queue->primitivesCount();
-		impl->addCmd<Cmd>().queue = queue.share();
+		const uint32 index = numeric_cast<uint32>(impl->queues.size());
+		impl->queues.push_back(std::move(queue));
+		impl->addCmd(CmdTypeEnum::Enqueue, CmdIndex{ index });
 	}
 
 #ifdef CAGE_DEBUG
 	void RenderQueue::checkGlErrorDebug()
 	{
-		struct Cmd : public CmdBase
-		{
-			void dispatch(RenderQueueImpl *) const override
-			{
-				try
-				{
-					cage::checkGlError();
-				}
-				catch (const GraphicsError &)
-				{
-					CAGE_LOG(SeverityEnum::Error, "exception", Stringizer() + "uncaught opengl error");
-				}
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>();
+		impl->addCmd(CmdTypeEnum::CheckGlErrorDebug, CmdNone());
 	}
 #endif // CAGE_DEBUG
 
 	void RenderQueue::checkGlError()
 	{
-		struct Cmd : public CmdBase
-		{
-			void dispatch(RenderQueueImpl *) const override
-			{
-				cage::checkGlError();
-			}
-		};
-
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->addCmd<Cmd>();
+		impl->addCmd(CmdTypeEnum::CheckGlError, CmdNone());
 	}
 
 	void RenderQueue::resetQueue()
@@ -1239,7 +1421,20 @@ namespace cage
 	void RenderQueue::dispatch()
 	{
 		RenderQueueImpl *impl = (RenderQueueImpl *)this;
-		impl->dispatch();
+		DispatchState state;
+		impl->dispatch(state);
+	}
+
+	RenderQueueInspection RenderQueue::inspect() const
+	{
+		const RenderQueueImpl *impl = (const RenderQueueImpl *)this;
+		DispatchState state;
+		InspectionData data;
+		impl->inspect(state, data);
+		RenderQueueInspection res;
+		res.commands = std::move(data.commands);
+		res.redundant = data.redundant;
+		return res;
 	}
 
 	uint32 RenderQueue::commandsCount() const
@@ -0,0 +1,189 @@
+#include <cage-core/concurrent.h>
+#include <cage-core/assetManager.h>
+#include <cage-core/hashes.h>
+#include <cage-core/textPack.h>
+#include <cage-core/string.h>
+#include <cage-core/heapString.h>
+
+#include <cage-engine/font.h>
+
+#include <robin_hood.h>
+
+#include <vector>
+
+namespace cage
+{
+	namespace
+	{
+		struct KeyBase
+		{
+			const Font *font = nullptr;
+			const TextPack *pack = nullptr;
+			uint32 textName = 0;
+			FontFormat format;
+			uint64 textHash = 0;
+		};
+
+		// stored in the map
+		struct Key : public KeyBase
+		{
+			HeapString text;
+		};
+
+		// used for lookups, does not copy the text
+		struct KeyView : public KeyBase
+		{
+			StringView text;
+		};
+
+		struct KeyHasher
+		{
+			using is_transparent = void;
+
+			uint64 operator () (const KeyBase &k) const
+			{
+				uint64 h = k.textHash;
+				h = h * 31 + (uintPtr)k.font;
+				h = h * 31 + (uintPtr)k.pack;
+				h = h * 31 + k.textName;
+				h = h * 31 + std::hash<float>()(k.format.size.value);
+				h = h * 31 + std::hash<float>()(k.format.wrapWidth.value);
+				h = h * 31 + std::hash<float>()(k.format.lineSpacing.value);
+				h = h * 31 + (uint32)k.format.align;
+				return h;
+			}
+		};
+
+		struct KeyEqual
+		{
+			using is_transparent = void;
+
+			template<class A, class B>
+			bool operator () (const A &a, const B &b) const
+			{
+				return a.textHash == b.textHash && a.font == b.font && a.pack == b.pack && a.textName == b.textName && a.format.size == b.format.size && a.format.wrapWidth == b.format.wrapWidth && a.format.lineSpacing == b.format.lineSpacing && a.format.align == b.format.align && StringView(a.text) == StringView(b.text);
+			}
+		};
+
+		struct Entry
+		{
+			Holder<const FontLayout> layout;
+			Holder<const Font> font; // keeps the font alive so that its address is not reused
+			Holder<const TextPack> pack;
+			uint32 lastUse = 0;
+		};
+
+		class TextLayoutCacheImpl : public TextLayoutCache
+		{
+		public:
+			const TextLayoutCacheCreateConfig config;
+			Holder<Mutex> mutex = newMutex();
+			robin_hood::unordered_node_map<Key, Entry, KeyHasher, KeyEqual> entries;
+			uint32 frame = 0;
+
+			TextLayoutCacheImpl(const TextLayoutCacheCreateConfig &config) : config(config)
+			{}
+
+			Holder<const FontLayout> get(const Holder<const Font> &font, Holder<const TextPack> &&pack, uint32 textName, const String &text, const FontFormat &format)
+			{
+				CAGE_ASSERT(font);
+				KeyView view;
+				view.font = +font;
+				view.pack = +pack;
+				view.textName = textName;
+				view.format = format;
+				view.textHash = hash64(text);
+				view.text = text;
+
+				{
+					ScopeLock lock(mutex);
+					auto it = entries.find(view);
+					if (it != entries.end())
+					{
+						it->second.lastUse = frame;
+						return it->second.layout.share();
+					}
+				}
+
+				// the layout is computed without holding the lock
+				String str = text;
+				if (pack)
+				{
+					std::vector<String> ps;
+					while (!str.empty())
+						ps.push_back(split(str, "|"));
+					str = pack->format(textName, ps);
+				}
+				const uint32 count = font->glyphsCount(str);
+				std::vector<uint32> glyphs;
+				glyphs.resize(count);
+				font->transcript(str, glyphs);
+				Holder<FontLayout> layout = systemMemory().createHolder<FontLayout>(font->layout(glyphs, format));
+
+				Key key;
+				(KeyBase &)key = view;
+				key.text = HeapString(view.text);
+				ScopeLock lock(mutex);
+				Entry &e = entries[std::move(key)];
+				if (!e.layout)
+				{
+					e.layout = std::move(layout).cast<const FontLayout>();
+					e.font = font.share();
+					e.pack = std::move(pack);
+				}
+				e.lastUse = frame;
+				return e.layout.share();
+			}
+		};
+	}
+
+	Holder<const FontLayout> TextLayoutCache::get(const Holder<const Font> &font, const String &text, const FontFormat &format)
+	{
+		TextLayoutCacheImpl *impl = (TextLayoutCacheImpl *)this;
+		return impl->get(font, {}, 0, text, format);
+	}
+
+	Holder<const FontLayout> TextLayoutCache::get(const Holder<const Font> &font, AssetManager *assets, uint32 assetName, uint32 textName, const String &params, const FontFormat &format)
+	{
+		TextLayoutCacheImpl *impl = (TextLayoutCacheImpl *)this;
+		if (assetName == 0 || textName == 0)
+			return impl->get(font, {}, 0, params, format);
+		Holder<const TextPack> pack = assets->tryGet<AssetSchemeIndexTextPack, TextPack>(assetName);
+		if (!pack)
+			return impl->get(font, {}, 0, "", format);
+		return impl->get(font, std::move(pack), textName, params, format);
+	}
+
+	void TextLayoutCache::nextFrame()
+	{
+		TextLayoutCacheImpl *impl = (TextLayoutCacheImpl *)this;
+		ScopeLock lock(impl->mutex);
+		impl->frame++;
+		for (auto it = impl->entries.begin(); it != impl->entries.end();)
+		{
+			if (impl->frame - it->second.lastUse > impl->config.unusedFramesLimit)
+				it = impl->entries.erase(it);
+			else
+				it++;
+		}
+	}
+
+	void TextLayoutCache::clear()
+	{
+		TextLayoutCacheImpl *impl = (TextLayoutCacheImpl *)this;
+		ScopeLock lock(impl->mutex);
+		impl->entries.clear();
+	}
+
+	uint32 TextLayoutCache::count() const
+	{
+		const TextLayoutCacheImpl *impl = (const TextLayoutCacheImpl *)this;
+		ScopeLock lock(impl->mutex);
+		return numeric_cast<uint32>(impl->entries.size());
+	}
+
+	Holder<TextLayoutCache> newTextLayoutCache(const TextLayoutCacheCreateConfig &config)
+	{
+		return systemMemory().createImpl<TextLayoutCache, TextLayoutCacheImpl>(config);
+	}
+}
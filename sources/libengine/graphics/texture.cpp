@@ -25,7 +25,7 @@ namespace cage
 			{
 				glCreateTextures(target, 1, &id);
 				CAGE_CHECK_GL_ERROR_DEBUG();
-				bind(0);
+				// not bound, that would disturb texture units tracked by render queues (provisional textures are created during dispatch)
 			}
 
 			~TextureImpl()
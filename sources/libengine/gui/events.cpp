@@ -54,8 +54,9 @@ namespace cage
 					return true;
 			}
 			// if nothing has focus, pass the event to anything under the cursor
-			for (const auto &it : impl->mouseEventReceivers)
+			for (uint32 i : impl->mouseEventReceiversGrid.candidates(pt))
 			{
+				const auto &it = impl->mouseEventReceivers[i];
 				if (it.pointInside(pt))
 				{
 					if (it.widget->widgetState.disabled || (it.widget->*F)(a, m, pt))
@@ -65,6 +66,14 @@ namespace cage
 			return false;
 		}
 
+		// widgets that handled an event may have changed their internal state
+		bool markChanged(GuiImpl *impl, bool handled)
+		{
+			if (handled)
+				impl->retainedDirty = true;
+			return handled;
+		}
+
 		template<bool (WidgetItem::*F)(uint32, ModifiersFlags)>
 		bool passKeyEvent(GuiImpl *impl, uint32 key, ModifiersFlags m)
 		{
@@ -112,22 +121,25 @@ namespace cage
 	bool GuiImpl::mousePress(InputMouse in)
 	{
 		focusName = 0;
-		return passMouseEvent<MouseButtonsFlags, &WidgetItem::mousePress>(this, in.buttons, in.mods, in.position);
+		return markChanged(this, passMouseEvent<MouseButtonsFlags, &WidgetItem::mousePress>(this, in.buttons, in.mods, in.position));
 	}
 
 	bool GuiImpl::mouseDoublePress(InputMouse in)
 	{
-		return passMouseEvent<MouseButtonsFlags, &WidgetItem::mouseDouble>(this, in.buttons, in.mods, in.position);
+		return markChanged(this, passMouseEvent<MouseButtonsFlags, &WidgetItem::mouseDouble>(this, in.buttons, in.mods, in.position));
 	}
 
 	bool GuiImpl::mouseRelease(InputMouse in)
 	{
-		return passMouseEvent<MouseButtonsFlags, &WidgetItem::mouseRelease>(this, in.buttons, in.mods, in.position);
+		return markChanged(this, passMouseEvent<MouseButtonsFlags, &WidgetItem::mouseRelease>(this, in.buttons, in.mods, in.position));
 	}
 
 	bool GuiImpl::mouseMove(InputMouse in)
 	{
-		return passMouseEvent<MouseButtonsFlags, &WidgetItem::mouseMove>(this, in.buttons, in.mods, in.position);
+		const bool res = passMouseEvent<MouseButtonsFlags, &WidgetItem::mouseMove>(this, in.buttons, in.mods, in.position);
+		if (in.buttons == MouseButtonsFlags::None)
+			return res; // plain hovering does not change any widget
+		return markChanged(this, res);
 	}
 
 	bool GuiImpl::mouseWheel(InputMouseWheel in)
@@ -135,12 +147,13 @@ namespace cage
 		Vec2 pt;
 		if (!eventPoint(in.position, pt))
 			return false;
-		for (const auto &it : mouseEventReceivers)
+		for (uint32 i : mouseEventReceiversGrid.candidates(pt))
 		{
+			const auto &it = mouseEventReceivers[i];
 			if (it.pointInside(pt, 1 | (1 << 31))) // also accept wheel events
 			{
 				if (it.widget->widgetState.disabled || it.widget->mouseWheel(in.wheel, in.mods, pt))
-					return true;
+					return markChanged(this, true);
 			}
 		}
 		return false;
@@ -148,17 +161,17 @@ namespace cage
 
 	bool GuiImpl::keyPress(InputKey in)
 	{
-		return passKeyEvent<&WidgetItem::keyPress>(this, in.key, in.mods);
+		return markChanged(this, passKeyEvent<&WidgetItem::keyPress>(this, in.key, in.mods));
 	}
 
 	bool GuiImpl::keyRepeat(InputKey in)
 	{
-		return passKeyEvent<&WidgetItem::keyRepeat>(this, in.key, in.mods);
+		return markChanged(this, passKeyEvent<&WidgetItem::keyRepeat>(this, in.key, in.mods));
 	}
 
 	bool GuiImpl::keyRelease(InputKey in)
 	{
-		return passKeyEvent<&WidgetItem::keyRelease>(this, in.key, in.mods);
+		return markChanged(this, passKeyEvent<&WidgetItem::keyRelease>(this, in.key, in.mods));
 	}
 
 	bool GuiImpl::keyChar(InputKey in)
@@ -172,7 +185,7 @@ namespace cage
 			if (f->widgetState.disabled || f->keyChar(in.key))
 				res = true;
 		}
-		return res;
+		return markChanged(this, res);
 	}
 
 	void HierarchyItem::fireWidgetEvent() const
@@ -1,4 +1,5 @@
 #include <cage-core/memoryAllocators.h>
+#include <cage-core/assetManager.h>
 #include <cage-core/macros.h>
 
 #include <cage-engine/renderQueue.h>
@@ -7,6 +8,7 @@
 
 #include <unordered_map>
 #include <algorithm>
+#include <numeric> // iota
 
 namespace cage
 {
@@ -15,6 +17,7 @@ namespace cage
 #define GCHL_GENERATE(T) entityMgr->defineComponent(CAGE_JOIN(Gui, CAGE_JOIN(T, Component))());
 		CAGE_EVAL_SMALL(CAGE_EXPAND_ARGS(GCHL_GENERATE, GCHL_GUI_COMMON_COMPONENTS, GCHL_GUI_WIDGET_COMPONENTS, GCHL_GUI_LAYOUT_COMPONENTS));
 #undef GCHL_GENERATE
+		entityMgr->dirtyTracking(true);
 
 		inputsListeners.attach(&inputsDispatchers);
 		inputsListeners.windowResize.bind<GuiImpl, &GuiImpl::windowResize>(this);
@@ -290,8 +293,9 @@ namespace cage
 		void findHover(GuiImpl *impl)
 		{
 			impl->hover = nullptr;
-			for (const auto &it : impl->mouseEventReceivers)
+			for (uint32 i : impl->mouseEventReceiversGrid.candidates(impl->outputMouse))
 			{
+				const auto &it = impl->mouseEventReceivers[i];
 				if (it.pointInside(impl->outputMouse))
 				{
 					impl->hover = it.widget;
@@ -299,42 +303,88 @@ namespace cage
 				}
 			}
 		}
-	}
-
-	void GuiManager::prepare()
-	{
-		GuiImpl *impl = (GuiImpl *)this;
 
-		impl->mouseEventReceivers.clear();
-		impl->root.clear();
-		impl->eventsEnabled = true;
-
-		generateHierarchy(impl);
-		generateItems(+impl->root);
+		template<class T>
+		void snapshotWrite(std::vector<char> &snapshot, const T &value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const char *p = (const char *)&value;
+			snapshot.insert(snapshot.end(), p, p + sizeof(T));
+		}
 
-		{ // propagate widget state
-			GuiWidgetStateComponent ws;
-			ws.skinIndex = 0;
-			propagateWidgetState(+impl->root, ws);
+		// serializes inputs of the hierarchy and its layout that are not stored in the entities
+		void takeSnapshot(GuiImpl *impl)
+		{
+			std::vector<char> &s = impl->snapshot;
+			s.clear();
+			snapshotWrite(s, impl->outputSize);
+			snapshotWrite(s, impl->pointsScale);
+			snapshotWrite(s, impl->focusName);
+			snapshotWrite(s, impl->focusParts);
+			for (const SkinData &skin : impl->skins)
+				snapshotWrite<GuiSkinConfig>(s, skin);
 		}
 
-		{ // initialize
-			impl->root->initialize();
-			// make sure that items added during initialization are initialized too
-			std::size_t i = 0;
-			while (i < impl->root->children.size())
-				callInitialize(+impl->root->children[i++]);
+		// entities are tracked as they are written to, destroyed entities are detected by their count
+		bool entitiesChanged(GuiImpl *impl)
+		{
+			return !impl->entityMgr->dirtyEntities().empty() || impl->entityMgr->count() != impl->retainedEntitiesCount;
 		}
 
-		{ // layouting
-			impl->root->findRequestedSize();
-			FinalPosition u;
-			u.renderPos = u.clipPos = Vec2();
-			u.renderSize = u.clipSize = impl->outputSize;
-			impl->root->findFinalPosition(u);
+		void regenerate(GuiImpl *impl)
+		{
+			impl->mouseEventReceivers.clear();
+			impl->root.clear();
+			impl->hover = nullptr;
+			impl->retainedDirty = false;
+			impl->retainedAssetsProcessing = impl->assetMgr->processing();
+
+			generateHierarchy(impl);
+			generateItems(+impl->root);
+
+			{ // propagate widget state
+				GuiWidgetStateComponent ws;
+				ws.skinIndex = 0;
+				propagateWidgetState(+impl->root, ws);
+			}
+
+			{ // initialize
+				impl->root->initialize();
+				// make sure that items added during initialization are initialized too
+				std::size_t i = 0;
+				while (i < impl->root->children.size())
+					callInitialize(+impl->root->children[i++]);
+			}
+
+			{ // layouting
+				impl->root->findRequestedSize();
+				FinalPosition u;
+				u.renderPos = u.clipPos = Vec2();
+				u.renderSize = u.clipSize = impl->outputSize;
+				impl->root->findFinalPosition(u);
+			}
+
+			impl->root->generateEventReceivers();
+			impl->mouseEventReceiversGrid.build(impl->mouseEventReceivers, impl->outputSize);
+
+			// the components were accessed (and possibly updated) by the widgets
+			impl->entityMgr->clearDirty();
+			impl->retainedEntitiesCount = impl->entityMgr->count();
 		}
+	}
 
-		impl->root->generateEventReceivers();
+	void GuiManager::prepare()
+	{
+		GuiImpl *impl = (GuiImpl *)this;
+		impl->eventsEnabled = true;
+
+		std::swap(impl->snapshot, impl->snapshotPrevious);
+		takeSnapshot(impl);
+		if (!impl->root || impl->retainedDirty || impl->retainedAssetsProcessing || impl->assetMgr->processing() || impl->snapshot != impl->snapshotPrevious || entitiesChanged(impl))
+		{
+			regenerate(impl);
+			takeSnapshot(impl); // initialization may have updated the focus
+		}
 
 		findHover(impl);
 	}
@@ -342,15 +392,67 @@ namespace cage
 	Holder<RenderQueue> GuiManager::finish()
 	{
 		GuiImpl *impl = (GuiImpl *)this;
-		Holder<RenderQueue> q = impl->emit();
-		cleanUp();
-		return q;
+		return impl->emit();
 	}
 
 	void GuiManager::cleanUp()
 	{
 		GuiImpl *impl = (GuiImpl *)this;
+		impl->mouseEventReceivers.clear();
+		impl->mouseEventReceiversGrid.build({}, Vec2());
 		impl->root.clear();
+		impl->hover = nullptr;
+		impl->snapshot.clear();
+		impl->snapshotPrevious.clear();
+		impl->retainedDirty = true;
+	}
+
+	void EventReceiversGrid::build(PointerRange<const EventReceiver> receivers, Vec2 size)
+	{
+		const uint32 n = numeric_cast<uint32>(receivers.size());
+		all.resize(n);
+		std::iota(all.begin(), all.end(), 0u);
+		side = 0;
+		if (n < 16 || !size.valid() || size[0] <= 0 || size[1] <= 0)
+			return; // use linear search
+		side = min(uint32(sqrt(Real(n)).value) / 2 + 1, 64u);
+		invCellSize = Vec2(side) / size;
+		const auto &range = [&](const EventReceiver &r, uint32 a) {
+			const sint32 b = clamp(sint32(floor(r.pos[a] * invCellSize[a]).value), 0, sint32(side - 1));
+			const sint32 e = clamp(sint32(floor((r.pos[a] + r.size[a]) * invCellSize[a]).value), 0, sint32(side - 1));
+			return std::pair<uint32, uint32>(b, e + 1);
+		};
+		offsets.clear();
+		offsets.resize(side * side + 1, 0);
+		for (const EventReceiver &r : receivers)
+		{
+			const auto xs = range(r, 0), ys = range(r, 1);
+			for (uint32 y = ys.first; y < ys.second; y++)
+				for (uint32 x = xs.first; x < xs.second; x++)
+					offsets[y * side + x + 1]++;
+		}
+		for (uint32 i = 0; i < side * side; i++)
+			offsets[i + 1] += offsets[i];
+		indices.resize(offsets.back());
+		cursors.assign(offsets.begin(), offsets.end() - 1);
+		for (uint32 i = 0; i < n; i++)
+		{
+			const auto xs = range(receivers[i], 0), ys = range(receivers[i], 1);
+			for (uint32 y = ys.first; y < ys.second; y++)
+				for (uint32 x = xs.first; x < xs.second; x++)
+					indices[cursors[y * side + x]++] = i;
+		}
+	}
+
+	PointerRange<const uint32> EventReceiversGrid::candidates(Vec2 point) const
+	{
+		if (side == 0 || !point.valid())
+			return all;
+		const Real fx = floor(point[0] * invCellSize[0]), fy = floor(point[1] * invCellSize[1]);
+		if (fx < 0 || fy < 0 || fx >= side || fy >= side)
+			return all;
+		const uint32 c = uint32(fy.value) * side + uint32(fx.value);
+		return { indices.data() + offsets[c], indices.data() + offsets[c + 1] };
 	}
 
 	Holder<GuiManager> newGuiManager(const GuiManagerCreateConfig &config)
@@ -265,6 +265,18 @@ namespace cage
 		bool pointInside(Vec2 point, uint32 maskRequests = 1) const;
 	};
 
+	// uniform grid over the event receivers for fast hit-testing
+	struct EventReceiversGrid
+	{
+		void build(PointerRange<const EventReceiver> receivers, Vec2 size);
+		PointerRange<const uint32> candidates(Vec2 point) const; // indices of receivers that may contain the point, in the original order
+
+	private:
+		std::vector<uint32> offsets, indices, cursors, all;
+		Vec2 invCellSize;
+		uint32 side = 0;
+	};
+
 	class GuiImpl : public GuiManager
 	{
 	public:
@@ -315,8 +327,15 @@ namespace cage
 		InputsListeners inputsListeners;
 
 		std::vector<EventReceiver> mouseEventReceivers;
+		EventReceiversGrid mouseEventReceiversGrid;
 		bool eventsEnabled = false;
 
+		// the hierarchy is retained across frames and regenerated only when any entity was marked dirty or the snapshot of other inputs changes
+		std::vector<char> snapshot, snapshotPrevious;
+		uint32 retainedEntitiesCount = 0;
+		bool retainedDirty = true; // widgets may have changed their internal state, regenerate the hierarchy in next prepare
+		bool retainedAssetsProcessing = false; // assets were loading during last regeneration
+
 		std::vector<SkinData> skins;
 
 		explicit GuiImpl(const GuiManagerCreateConfig &config);
@@ -9,7 +9,8 @@ namespace cage
 	void graphicsDestroy();
 	void graphicsInitialize(); // opengl thread
 	void graphicsFinalize(); // opengl thread
-	void graphicsEmit(uint64 time); // control thread
+	void graphicsPace(); // opengl thread
+	void graphicsEmit(uint64 time, uint64 inputTimestamp); // control thread
 	void graphicsPrepare(uint64 time, uint32 &drawCalls, uint32 &drawPrimitives); // prepare thread
 	void graphicsDispatch(); // opengl thread
 	void graphicsSwap(); // opengl thread
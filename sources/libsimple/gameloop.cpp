@@ -134,10 +134,12 @@ namespace cage
 			Holder<Thread> graphicsDispatchThreadHolder;
 			Holder<Thread> graphicsPrepareThreadHolder;
 			Holder<Thread> soundThreadHolder;
+			std::vector<std::vector<uint32>> threadsAffinities; // graphics dispatch, graphics prepare, sound
 
 			std::atomic<uint32> engineStarted = 0;
 			std::atomic<bool> stopping = false;
 			uint64 controlTime = 0;
+			uint64 inputTimestamp = 0; // real time of last processed inputs
 
 			Holder<Scheduler> controlScheduler;
 			Holder<Schedule> controlUpdateSchedule;
@@ -151,12 +153,20 @@ namespace cage
 
 			~EngineData();
 
+			void threadAffinity(uint32 index)
+			{
+				if (!threadsAffinities[index].empty())
+					currentThreadAffinity(threadsAffinities[index]);
+			}
+
 			//////////////////////////////////////
 			// graphics PREPARE
 			//////////////////////////////////////
 
 			void graphicsPrepareInitializeStage()
-			{}
+			{
+				threadAffinity(1);
+			}
 
 			void graphicsPrepareStep()
 			{
@@ -196,12 +206,17 @@ namespace cage
 
 			void graphicsDispatchInitializeStage()
 			{
+				threadAffinity(0);
 				window->makeCurrent();
 				graphicsInitialize();
 			}
 
 			void graphicsDispatchStep()
 			{
+				{
+					ProfilingScope profiling("graphics pacing");
+					graphicsPace();
+				}
 				ProfilingScope profiling("graphics dispatch", ProfilingFrameTag());
 				ScopedTimer timing(profilingBufferFrameTime);
 				{
@@ -258,6 +273,7 @@ namespace cage
 
 			void soundInitializeStage()
 			{
+				threadAffinity(2);
 				speaker->start();
 			}
 
@@ -300,12 +316,7 @@ namespace cage
 
 			void updateHistoryComponents()
 			{
-				for (Entity *e : engineEntities()->component<TransformComponent>()->entities())
-				{
-					TransformComponent &ts = e->value<TransformComponent>();
-					TransformComponent &hs = e->value<TransformComponent>(transformHistoryComponent);
-					hs = ts;
-				}
+				engineEntities()->component<TransformComponent>()->copyValuesTo(transformHistoryComponent);
 			}
 
 			void controlInputs()
@@ -320,6 +331,7 @@ namespace cage
 				{
 					ProfilingScope profiling("window events");
 					window->processEvents();
+					inputTimestamp = applicationTime();
 				}
 				{
 					ProfilingScope profiling("gui finish");
@@ -350,7 +362,7 @@ namespace cage
 				}
 				{
 					ProfilingScope profiling("graphics emit");
-					graphicsEmit(controlTime);
+					graphicsEmit(controlTime, inputTimestamp);
 				}
 				profilingBufferEntities.add(entities->group()->count());
 			}
@@ -466,6 +478,7 @@ namespace cage
 				}
 
 				{ // create threads
+					threadsAffinities = threadsAffinityPlan(processorsTopology(), config.threadsAffinity, 3);
 					graphicsDispatchThreadHolder = newThread(Delegate<void()>().bind<EngineData, &EngineData::graphicsDispatchEntry>(this), "engine graphics dispatch");
 					graphicsPrepareThreadHolder = newThread(Delegate<void()>().bind<EngineData, &EngineData::graphicsPrepareEntry>(this), "engine graphics prepare");
 					soundThreadHolder = newThread(Delegate<void()>().bind<EngineData, &EngineData::soundEntry>(this), "engine sound");
@@ -816,6 +829,14 @@ namespace cage
 			add(engineData->controlUpdateSchedule->statistics().durations);
 		if (any(flags & StatisticsGuiFlags::Sound))
 			add(engineData->soundUpdateSchedule->statistics().durations);
+		if (any(flags & (StatisticsGuiFlags::FrameLatency | StatisticsGuiFlags::FrameJitter)))
+		{
+			const FramePacingStatistics stats = engineFramePacingStatistics();
+			if (any(flags & StatisticsGuiFlags::FrameLatency))
+				add(stats.latencies);
+			if (any(flags & StatisticsGuiFlags::FrameJitter))
+				add(stats.frameJitters);
+		}
 
 #define GCHL_GENERATE(NAME) \
 		if (any(flags & StatisticsGuiFlags::NAME)) \
@@ -4,6 +4,7 @@
 #include <cage-core/entitiesCopy.h>
 #include <cage-core/hashString.h>
 #include <cage-core/entities.h>
+#include <cage-core/framePacing.h>
 #include <cage-core/config.h>
 #include <cage-core/tasks.h>
 
@@ -29,12 +30,15 @@ namespace cage
 	{
 		const ConfigSint32 confVisualizeBuffer("cage/graphics/visualizeBuffer", 0);
 		const ConfigFloat confRenderGamma("cage/graphics/gamma", 2.2);
+		const ConfigUint32 confFrameRateLimit("cage/graphics/frameRateLimit", 0); // 0 = unlimited
 
 		struct EmitBuffer : private Immovable
 		{
 			Holder<RenderPipeline> pipeline;
 			Holder<EntityManager> scene = newEntityManager();
 			uint64 emitTime = 0;
+			uint64 inputTimestamp = 0; // real time
+			uint64 emitTimestamp = 0; // real time
 		};
 
 		struct CameraData
@@ -79,6 +83,7 @@ namespace cage
 				cfg.buffersCount = 3;
 				cfg.repeatedReads = true;
 				emitBuffersGuard = newSwapBufferGuard(cfg);
+				pacer = newFramePacer({});
 			}
 
 			void initialize() // opengl thread
@@ -103,7 +108,14 @@ namespace cage
 				provisionalData.clear();
 			}
 
-			void emit(uint64 emitTime) // control thread
+			void pace() // opengl thread
+			{
+				const uint32 fps = confFrameRateLimit;
+				pacer->targetFrameTime(fps ? 1000000 / fps : 0);
+				pacer->wait();
+			}
+
+			void emit(uint64 emitTime, uint64 inputTimestamp) // control thread
 			{
 				if (auto lock = emitBuffersGuard->write())
 				{
@@ -112,6 +124,8 @@ namespace cage
 					cfg.destination = +emitBuffers[lock.index()].scene;
 					entitiesCopy(cfg);
 					emitBuffers[lock.index()].emitTime = emitTime;
+					emitBuffers[lock.index()].inputTimestamp = inputTimestamp;
+					emitBuffers[lock.index()].emitTimestamp = applicationTime();
 				}
 			}
 
@@ -182,10 +196,15 @@ namespace cage
 
 			void prepare(uint64 dispatchTime) // prepare thread
 			{
+				preparedFrameIndex = m;
 				if (auto lock = emitBuffersGuard->read())
 				{
 					const EmitBuffer &eb = emitBuffers[lock.index()];
-					eb.pipeline->currentTime = itc(eb.emitTime, dispatchTime, controlThread().updatePeriod());
+					if (eb.inputTimestamp)
+						pacer->stage(frameIndex, FrameStageEnum::Input, eb.inputTimestamp);
+					pacer->stage(frameIndex, FrameStageEnum::Emit, eb.emitTimestamp);
+					pacer->stage(frameIndex, FrameStageEnum::PrepareStart, dispatchTime);
+					eb.pipeline->currentTime = itc(eb.emitTime, dispatchTime + pacer->presentDelay(), controlThread().updatePeriod());
 					eb.pipeline->elapsedTime = dispatchTime - lastDispatchTime;
 					eb.pipeline->interpolationFactor = saturate(Real(eb.pipeline->currentTime - eb.emitTime) / controlThread().updatePeriod());
 					eb.pipeline->frameIndex = frameIndex;
@@ -198,6 +217,8 @@ namespace cage
 
 					outputDrawCalls = renderQueue->drawsCount();
 					outputDrawPrimitives = renderQueue->primitivesCount();
+					pacer->stage(frameIndex, FrameStageEnum::PrepareEnd);
+					preparedFrameIndex = frameIndex;
 					frameIndex++;
 					lastDispatchTime = dispatchTime;
 				}
@@ -205,6 +226,9 @@ namespace cage
 
 			void dispatch() // opengl thread
 			{
+				dispatchedFrameIndex = preparedFrameIndex;
+				if (dispatchedFrameIndex != m)
+					pacer->stage(dispatchedFrameIndex, FrameStageEnum::DispatchStart);
 				renderQueue->dispatch();
 				provisionalData->reset();
 
@@ -218,6 +242,9 @@ namespace cage
 						// nothing
 					}
 				}
+
+				if (dispatchedFrameIndex != m)
+					pacer->stage(dispatchedFrameIndex, FrameStageEnum::DispatchEnd);
 			}
 
 			void swap() // opengl thread
@@ -225,6 +252,8 @@ namespace cage
 				CAGE_CHECK_GL_ERROR_DEBUG();
 				engineWindow()->swapBuffers();
 				glFinish(); // this is where the engine should be waiting for the gpu
+				if (dispatchedFrameIndex != m)
+					pacer->stage(dispatchedFrameIndex, FrameStageEnum::Present);
 			}
 
 			Holder<RenderQueue> renderQueue;
@@ -233,11 +262,14 @@ namespace cage
 			Holder<SwapBufferGuard> emitBuffersGuard;
 			EmitBuffer emitBuffers[3];
 			InterpolationTimingCorrector itc;
+			Holder<FramePacer> pacer;
 
 			uint64 lastDispatchTime = 0;
 			uint32 outputDrawCalls = 0;
 			uint32 outputDrawPrimitives = 0;
 			uint32 frameIndex = 0;
+			uint32 preparedFrameIndex = m; // synchronized by the graphics semaphores
+			uint32 dispatchedFrameIndex = m;
 		};
 
 		Graphics *graphics;
@@ -265,9 +297,14 @@ namespace cage
 		graphics->finalize();
 	}
 
-	void graphicsEmit(uint64 emitTime)
+	void graphicsPace()
+	{
+		graphics->pace();
+	}
+
+	void graphicsEmit(uint64 emitTime, uint64 inputTimestamp)
 	{
-		graphics->emit(emitTime);
+		graphics->emit(emitTime, inputTimestamp);
 	}
 
 	void graphicsPrepare(uint64 dispatchTime, uint32 &drawCalls, uint32 &drawPrimitives)
@@ -286,4 +323,9 @@ namespace cage
 	{
 		graphics->swap();
 	}
+
+	FramePacingStatistics engineFramePacingStatistics()
+	{
+		return graphics->pacer->statistics();
+	}
 }
@@ -8,15 +8,28 @@ namespace cage
 {
 	struct InterpolationTimingCorrector
 	{
-		uint64 operator() (uint64 emit, uint64 dispatch, uint64 step)
+		// emit: control time of the newest state
+		// present: predicted real time when the frame will be presented
+		// step: control update period
+		uint64 operator() (uint64 emit, uint64 present, uint64 step)
 		{
 			CAGE_ASSERT(step > 0);
-			corrections.add((sint64)emit - (sint64)dispatch);
-			sint64 c = corrections.smooth();
-			return max(emit, dispatch + c + step / 2);
+			const sint64 d = (sint64)emit - (sint64)present;
+			if (!seeded)
+			{
+				corrections.seed(d);
+				seeded = true;
+			}
+			corrections.add(d);
+			const sint64 c = corrections.smooth();
+			// the lead keeps the interpolation behind the newest state; it adapts to the observed variation of the corrections instead of being fixed to half step
+			const sint64 spread = corrections.max() - corrections.min();
+			const sint64 lead = min(spread, (sint64)step) / 2;
+			return max(emit, present + c + lead);
 		}
 
 		VariableSmoothingBuffer<sint64, 60> corrections;
+		bool seeded = false;
 	};
 }
 
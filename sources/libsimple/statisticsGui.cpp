@@ -62,6 +62,8 @@ namespace cage
 					StatisticsGuiFlags::GraphicsPrepare,
 					StatisticsGuiFlags::GraphicsDispatch,
 					StatisticsGuiFlags::FrameTime,
+					StatisticsGuiFlags::FrameLatency,
+					StatisticsGuiFlags::FrameJitter,
 					StatisticsGuiFlags::DrawCalls,
 					StatisticsGuiFlags::DrawPrimitives,
 					StatisticsGuiFlags::Entities,
@@ -72,6 +74,8 @@ namespace cage
 					"Graphics Prepare: ",
 					"Graphics Dispatch: ",
 					"Frame Time: ",
+					"Frame Latency: ",
+					"Frame Jitter: ",
 					"Draw Calls: ",
 					"Draw Primitives: ",
 					"Entities: ",
@@ -205,7 +209,7 @@ namespace cage
 				for (uint32 i = 0; i < labelsCount; i++)
 				{
 					setTextLabel(i * 2 + 0, labelNames[i]);
-					if (labelFlags[i] <= StatisticsGuiFlags::FrameTime)
+					if (labelFlags[i] <= StatisticsGuiFlags::FrameTime || labelFlags[i] == StatisticsGuiFlags::FrameLatency || labelFlags[i] == StatisticsGuiFlags::FrameJitter)
 						setTextLabel(i * 2 + 1, Stringizer() + (engineStatisticsValues(labelFlags[i], statisticsMode) / 1000) + " ms");
 					else
 						setTextLabel(i * 2 + 1, Stringizer() + (engineStatisticsValues(labelFlags[i], statisticsMode)));
@@ -0,0 +1,242 @@
+#include "main.h"
+
+#include <cage-core/commandBuffer.h>
+#include <cage-core/timer.h>
+#include <cage-core/math.h>
+
+#include <vector>
+#include <memory>
+
+namespace
+{
+	enum class CmdType : uint32
+	{
+		Add,
+		Multiply,
+		Sum,
+		Empty,
+	};
+
+	struct CmdAdd
+	{
+		uint32 value = 0;
+	};
+
+	struct CmdMultiply
+	{
+		uint64 value = 0;
+		uint8 padding = 0;
+	};
+
+	struct CmdSum
+	{
+		uint32 count = 0;
+	};
+
+	struct CmdEmpty
+	{};
+
+	uint64 run(const CommandBuffer &buffer)
+	{
+		uint64 acc = 0;
+		for (const auto &c : buffer)
+		{
+			switch ((CmdType)c.type)
+			{
+			case CmdType::Add:
+				acc += c.as<CmdAdd>().value;
+				break;
+			case CmdType::Multiply:
+				acc *= c.as<CmdMultiply>().value;
+				break;
+			case CmdType::Sum:
+			{
+				const auto extra = c.extra<CmdSum>();
+				CAGE_ASSERT(extra.size() == c.as<CmdSum>().count * sizeof(uint32));
+				const PointerRange<const uint32> values = { (const uint32 *)extra.begin(), (const uint32 *)extra.end() };
+				for (uint32 v : values)
+					acc += v;
+			} break;
+			case CmdType::Empty:
+				break;
+			default:
+				CAGE_THROW_CRITICAL(Exception, "invalid command type");
+			}
+		}
+		return acc;
+	}
+
+	struct VirtualBase
+	{
+		std::unique_ptr<VirtualBase> next;
+		virtual ~VirtualBase() = default;
+		virtual void dispatch(uint64 &acc) const = 0;
+	};
+
+	struct VirtualAdd : public VirtualBase
+	{
+		uint32 value = 0;
+		void dispatch(uint64 &acc) const override { acc += value; }
+	};
+
+	struct VirtualMultiply : public VirtualBase
+	{
+		uint64 value = 0;
+		void dispatch(uint64 &acc) const override { acc *= value; }
+	};
+}
+
+void testCommandBuffer()
+{
+	CAGE_TESTCASE("command buffer");
+
+	{
+		CAGE_TESTCASE("basics");
+		CommandBuffer buffer;
+		CAGE_TEST(buffer.empty());
+		CAGE_TEST(buffer.begin() == buffer.end());
+		buffer.add((uint32)CmdType::Add, CmdAdd{ 5 });
+		buffer.add((uint32)CmdType::Empty, CmdEmpty{});
+		buffer.add((uint32)CmdType::Multiply, CmdMultiply{ 3 });
+		{
+			const uint32 values[] = { 1, 2, 3 };
+			buffer.add((uint32)CmdType::Sum, CmdSum{ 3 }, PointerRange<const char>((const char *)values, (const char *)(values + 3)));
+		}
+		CAGE_TEST(buffer.count() == 4);
+		CAGE_TEST((buffer.size() % 8) == 0);
+		uint32 cnt = 0;
+		for (const auto &c : buffer)
+		{
+			CAGE_TEST(((uintPtr)c.payload.data() % 8) == 0);
+			cnt++;
+		}
+		CAGE_TEST(cnt == 4);
+		CAGE_TEST(run(buffer) == (5 * 3 + 6));
+		buffer.clear();
+		CAGE_TEST(buffer.empty());
+		CAGE_TEST(run(buffer) == 0);
+		buffer.add((uint32)CmdType::Add, CmdAdd{ 42 });
+		CAGE_TEST(run(buffer) == 42);
+	}
+
+	{
+		CAGE_TESTCASE("randomized extra sizes");
+		CommandBuffer buffer;
+		std::vector<std::vector<char>> expected;
+		for (uint32 i = 0; i < 1000; i++)
+		{
+			std::vector<char> e;
+			e.resize(randomRange(0u, 50u));
+			for (char &c : e)
+				c = (char)randomRange(0u, 256u);
+			buffer.add(i, CmdAdd{ i }, e);
+			expected.push_back(std::move(e));
+		}
+		uint32 i = 0;
+		for (const auto &c : buffer)
+		{
+			CAGE_TEST(c.type == i);
+			CAGE_TEST(c.as<CmdAdd>().value == i);
+			const auto extra = c.extra<CmdAdd>();
+			CAGE_TEST(extra.size() == expected[i].size());
+			CAGE_TEST(std::equal(extra.begin(), extra.end(), expected[i].begin()));
+			i++;
+		}
+		CAGE_TEST(i == 1000);
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 count = 100000;
+#else
+		constexpr uint32 count = 1000000;
+#endif
+		constexpr uint32 repeats = 10;
+		Holder<Timer> tmr = newTimer();
+
+		std::unique_ptr<VirtualBase> head;
+		{
+			VirtualBase *tail = nullptr;
+			for (uint32 i = 0; i < count; i++)
+			{
+				std::unique_ptr<VirtualBase> c;
+				if (i % 3)
+				{
+					auto a = std::make_unique<VirtualAdd>();
+					a->value = i;
+					c = std::move(a);
+				}
+				else
+				{
+					auto a = std::make_unique<VirtualMultiply>();
+					a->value = 3;
+					c = std::move(a);
+				}
+				if (tail)
+				{
+					tail->next = std::move(c);
+					tail = tail->next.get();
+				}
+				else
+				{
+					head = std::move(c);
+					tail = head.get();
+				}
+			}
+		}
+		const uint64 timeVirtualRecord = tmr->duration();
+		tmr->reset();
+		uint64 acc1 = 0;
+		for (uint32 r = 0; r < repeats; r++)
+		{
+			uint64 b = 0;
+			for (const VirtualBase *c = head.get(); c; c = c->next.get())
+				c->dispatch(b);
+			acc1 += b;
+		}
+		const uint64 timeVirtualDispatch = tmr->duration();
+		{
+			// avoid recursion in destructors
+			std::unique_ptr<VirtualBase> it = std::move(head);
+			while (it)
+				it = std::move(it->next);
+		}
+
+		tmr->reset();
+		CommandBuffer buffer;
+		for (uint32 i = 0; i < count; i++)
+		{
+			if (i % 3)
+				buffer.add((uint32)CmdType::Add, CmdAdd{ i });
+			else
+				buffer.add((uint32)CmdType::Multiply, CmdMultiply{ 3 });
+		}
+		const uint64 timePackedRecord = tmr->duration();
+		tmr->reset();
+		uint64 acc2 = 0;
+		for (uint32 r = 0; r < repeats; r++)
+			acc2 += run(buffer);
+		const uint64 timePackedDispatch = tmr->duration();
+
+		{
+			uint64 a = 0;
+			for (uint32 r = 0; r < repeats; r++)
+			{
+				uint64 b = 0;
+				for (uint32 i = 0; i < count; i++)
+				{
+					if (i % 3)
+						b += i;
+					else
+						b *= 3;
+				}
+				a += b;
+			}
+			CAGE_TEST(acc1 == a);
+			CAGE_TEST(acc2 == a);
+		}
+
+		CAGE_LOG(SeverityEnum::Info, "command buffer performance", Stringizer() + "commands: " + count + ", virtual record: " + timeVirtualRecord + " us, dispatch: " + (timeVirtualDispatch / repeats) + " us; packed record: " + timePackedRecord + " us, dispatch: " + (timePackedDispatch / repeats) + " us");
+	}
+}
@@ -160,4 +160,16 @@ void testConcurrent()
 			CAGE_TEST(counterGlobal == 40);
 		}
 	}
+
+	{
+		CAGE_TESTCASE("semaphore with timeout");
+		Holder<Semaphore> sem = newSemaphore(0, 2);
+		CAGE_TEST(!sem->tryLock(0));
+		CAGE_TEST(!sem->tryLock(2000));
+		sem->unlock();
+		sem->unlock();
+		CAGE_TEST(sem->tryLock(2000));
+		CAGE_TEST(sem->tryLock(0));
+		CAGE_TEST(!sem->tryLock(0));
+	}
 }
@@ -3,6 +3,8 @@
 #include <cage-core/concurrent.h>
 #include <cage-core/concurrentQueue.h>
 #include <cage-core/threadPool.h>
+#include <cage-core/timer.h>
+
 #include <atomic>
 
 namespace
@@ -61,10 +63,11 @@ namespace
 		bool final;
 	};
 
-	class Tester
+	template<class Queue>
+	class QueueTester
 	{
 	public:
-		Tester() : produceItems(1000), produceFinals(1), queue(10)
+		QueueTester() : produceItems(1000), produceFinals(1), queue(10)
 		{}
 
 		void consumeBlocking()
@@ -177,8 +180,129 @@ namespace
 
 		const uint32 produceItems;
 		const uint32 produceFinals;
-		ConcurrentQueue<Task> queue;
+		Queue queue;
+	};
+
+	template<class Queue>
+	void testQueue(bool multi)
+	{
+		using Tester = QueueTester<Queue>;
+
+		{
+			CAGE_TESTCASE("single producer single consumer (blocking)");
+			Tester t;
+			Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumeBlocking>(&t), "consumer");
+			Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::produceBlocking>(&t), "producer");
+			t1->wait();
+			t2->wait();
+		}
+		CAGE_TEST(itemsCounter == 0);
+
+		{
+			CAGE_TESTCASE("single producer single consumer (polling)");
+			Tester t;
+			Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumePolling>(&t), "consumer");
+			Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::producePolling>(&t), "producer");
+			t1->wait();
+			t2->wait();
+		}
+		CAGE_TEST(itemsCounter == 0);
+
+		{
+			CAGE_TESTCASE("termination (blocking)");
+			Tester t;
+			Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumeBlocking>(&t), "consumer");
+			Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::produceBlocking>(&t), "producer");
+			threadSleep(10);
+			t.queue.terminate();
+			t1->wait();
+			t2->wait();
+		}
+		CAGE_TEST(itemsCounter == 0);
+
+		{
+			CAGE_TESTCASE("termination (polling)");
+			Tester t;
+			Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumePolling>(&t), "consumer");
+			Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::producePolling>(&t), "producer");
+			threadSleep(10);
+			t.queue.terminate();
+			t1->wait();
+			t2->wait();
+		}
+		CAGE_TEST(itemsCounter == 0);
+
+		if (!multi)
+			return;
+
+		{
+			CAGE_TESTCASE("multiple producers multiple consumers (blocking)");
+			Tester t;
+			Holder<ThreadPool> t1 = newThreadPool("pool_", 6);
+			t1->function = Delegate<void(uint32, uint32)>().bind<Tester, &Tester::poolBlocking>(&t);
+			t1->run();
+		}
+		CAGE_TEST(itemsCounter == 0);
+
+		{
+			CAGE_TESTCASE("multiple producers multiple consumers (polling)");
+			Tester t;
+			Holder<ThreadPool> t1 = newThreadPool("pool_", 6);
+			t1->function = Delegate<void(uint32, uint32)>().bind<Tester, &Tester::poolPolling>(&t);
+			t1->run();
+		}
+		CAGE_TEST(itemsCounter == 0);
+	}
+
+	template<class Queue>
+	struct Throughput
+	{
+		Queue queue;
+		std::atomic<uint64> sum = 0;
+		uint32 producers = 0;
+		uint32 itemsPerProducer = 0;
+
+		Throughput(uint32 capacity) : queue(capacity) {}
+
+		void run(uint32 index, uint32)
+		{
+			if (index < producers)
+			{
+				for (uint32 i = 0; i < itemsPerProducer; i++)
+					queue.push(i + 1);
+				queue.push(0); // end marker
+			}
+			else
+			{
+				uint64 s = 0;
+				while (true)
+				{
+					uint32 v = 0;
+					queue.pop(v);
+					if (v == 0)
+						break;
+					s += v;
+				}
+				sum += s;
+			}
+		}
 	};
+
+	template<class Queue>
+	uint64 throughput(uint32 pairs, uint32 items)
+	{
+		Throughput<Queue> t(1024);
+		t.producers = pairs;
+		t.itemsPerProducer = items;
+		Holder<Timer> tmr = newTimer();
+		Holder<ThreadPool> pool = newThreadPool("bench_", pairs * 2);
+		pool->function = Delegate<void(uint32, uint32)>().bind<Throughput<Queue>, &Throughput<Queue>::run>(&t);
+		pool->run();
+		const uint64 duration = tmr->duration();
+		CAGE_TEST(t.sum == uint64(items) * (items + 1) / 2 * pairs);
+		CAGE_TEST(t.queue.estimatedSize() == 0);
+		return duration;
+	}
 }
 
 void testConcurrentQueue()
@@ -187,64 +311,76 @@ void testConcurrentQueue()
 	CAGE_TEST(itemsCounter == 0); // sanity check
 
 	{
-		CAGE_TESTCASE("single producer single consumer (blocking)");
-		Tester t;
-		Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumeBlocking>(&t), "consumer");
-		Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::produceBlocking>(&t), "producer");
-		t1->wait();
-		t2->wait();
+		CAGE_TESTCASE("mutex queue");
+		testQueue<ConcurrentQueue<Task>>(true);
 	}
-	CAGE_TEST(itemsCounter == 0);
 
 	{
-		CAGE_TESTCASE("single producer single consumer (polling)");
-		Tester t;
-		Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumePolling>(&t), "consumer");
-		Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::producePolling>(&t), "producer");
-		t1->wait();
-		t2->wait();
+		CAGE_TESTCASE("lock-free mpmc queue");
+		testQueue<ConcurrentQueueMpmc<Task>>(true);
 	}
-	CAGE_TEST(itemsCounter == 0);
 
 	{
-		CAGE_TESTCASE("multiple producers multiple consumers (blocking)");
-		Tester t;
-		Holder<ThreadPool> t1 = newThreadPool("pool_", 6);
-		t1->function = Delegate<void(uint32, uint32)>().bind<Tester, &Tester::poolBlocking>(&t);
-		t1->run();
+		CAGE_TESTCASE("lock-free spsc queue");
+		testQueue<ConcurrentQueueSpsc<Task>>(false);
 	}
-	CAGE_TEST(itemsCounter == 0);
 
 	{
-		CAGE_TESTCASE("multiple producers multiple consumers (polling)");
-		Tester t;
-		Holder<ThreadPool> t1 = newThreadPool("pool_", 6);
-		t1->function = Delegate<void(uint32, uint32)>().bind<Tester, &Tester::poolPolling>(&t);
-		t1->run();
-	}
-	CAGE_TEST(itemsCounter == 0);
-
-	{
-		CAGE_TESTCASE("termination (blocking)");
-		Tester t;
-		Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumeBlocking>(&t), "consumer");
-		Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::produceBlocking>(&t), "producer");
-		threadSleep(10);
-		t.queue.terminate();
-		t1->wait();
-		t2->wait();
+		CAGE_TESTCASE("lock-free queues basics");
+		ConcurrentQueueMpmc<Task> a(5);
+		CAGE_TEST(a.capacity() == 8);
+		ConcurrentQueueSpsc<Task> b(8);
+		CAGE_TEST(b.capacity() == 8);
+		for (uint32 i = 0; i < 8; i++)
+		{
+			CAGE_TEST(a.tryPush(Task(i)));
+			CAGE_TEST(b.tryPush(Task(i)));
+		}
+		CAGE_TEST(!a.tryPush(Task(8)));
+		CAGE_TEST(!b.tryPush(Task(8)));
+		CAGE_TEST(a.estimatedSize() == 8);
+		CAGE_TEST(b.estimatedSize() == 8);
+		for (uint32 i = 0; i < 4; i++)
+		{
+			Task t(0);
+			CAGE_TEST(a.tryPop(t));
+			CAGE_TEST(t.id == i);
+			CAGE_TEST(b.tryPop(t));
+			CAGE_TEST(t.id == i);
+		}
+		CAGE_TEST(a.estimatedSize() == 4);
+		CAGE_TEST(b.estimatedSize() == 4);
+		a.terminate();
+		b.terminate();
+		CAGE_TEST(a.stopped());
+		CAGE_TEST(b.stopped());
+		{
+			Task t(0);
+			CAGE_TEST_THROWN(a.pop(t));
+			CAGE_TEST_THROWN(b.tryPop(t));
+			CAGE_TEST_THROWN(a.push(t));
+			CAGE_TEST_THROWN(b.tryPush(t));
+		}
+		// remaining items are destroyed with the queues
 	}
 	CAGE_TEST(itemsCounter == 0);
 
 	{
-		CAGE_TESTCASE("termination (polling)");
-		Tester t;
-		Holder<Thread> t1 = newThread(Delegate<void()>().bind<Tester, &Tester::consumePolling>(&t), "consumer");
-		Holder<Thread> t2 = newThread(Delegate<void()>().bind<Tester, &Tester::producePolling>(&t), "producer");
-		threadSleep(10);
-		t.queue.terminate();
-		t1->wait();
-		t2->wait();
+		CAGE_TESTCASE("contention performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 items = 20000;
+#else
+		constexpr uint32 items = 200000;
+#endif
+		for (uint32 pairs : { 1u, 2u, 4u })
+		{
+			const uint64 a = throughput<ConcurrentQueue<uint32>>(pairs, items);
+			const uint64 b = throughput<ConcurrentQueueMpmc<uint32>>(pairs, items);
+			Stringizer str;
+			str + "producers and consumers: " + pairs + ", items: " + (pairs * items) + ", mutex: " + a + " us, mpmc: " + b + " us";
+			if (pairs == 1)
+				str + ", spsc: " + throughput<ConcurrentQueueSpsc<uint32>>(pairs, items) + " us";
+			CAGE_LOG(SeverityEnum::Info, "concurrent queue performance", str);
+		}
 	}
-	CAGE_TEST(itemsCounter == 0);
 }
@@ -361,6 +361,115 @@ namespace
 		}
 	}
 
+	void copyValues()
+	{
+		CAGE_TESTCASE("copy values between components");
+
+		for (uint32 threshold : { 0u, 1u, 10u, 1000u })
+		{
+			CAGE_TESTCASE(Stringizer() + "parallel threshold: " + threshold);
+			Holder<EntityManager> man = newEntityManager();
+			EntityComponent *cur = man->defineComponent(Vec3());
+			EntityComponent *prev = man->defineComponent(Vec3());
+			for (uint32 i = 0; i < 500; i++)
+			{
+				Entity *e = man->createUnique();
+				if (i % 5 != 0)
+					e->value<Vec3>(cur) = Vec3(i, i * 2, i * 3);
+				if (i % 3 == 0)
+					e->value<Vec3>(prev) = Vec3(-1);
+			}
+			CAGE_TEST(cur->count() == 400);
+			CAGE_TEST(cur->copyValuesTo(prev, threshold) == 400);
+			CAGE_TEST(prev->count() == 400 + 34); // entities with only the destination component
+			for (Entity *e : man->entities())
+			{
+				if (e->has(cur))
+				{
+					CAGE_TEST(e->value<Vec3>(prev) == e->value<Vec3>(cur));
+				}
+				else if (e->has(prev))
+				{
+					CAGE_TEST(e->value<Vec3>(prev) == Vec3(-1)); // not in source, left untouched
+				}
+			}
+			CAGE_TEST(cur->copyValuesTo(prev, threshold) == 0); // nothing changed
+
+			uint32 modified = 0;
+			for (Entity *e : cur->entities())
+			{
+				if (e->name() % 7 == 0)
+				{
+					e->value<Vec3>(cur)[1] += 1;
+					modified++;
+				}
+			}
+			CAGE_TEST(modified > 0);
+			man->dirtyTracking(true);
+			CAGE_TEST(man->dirtyEntities().empty());
+			CAGE_TEST(cur->copyValuesTo(prev, threshold) == modified);
+			CAGE_TEST(man->dirtyEntities().size() == modified);
+			for (Entity *e : man->dirtyEntities())
+			{
+				CAGE_TEST(e->dirty(prev));
+				CAGE_TEST(!e->dirty(cur));
+				CAGE_TEST(e->value<Vec3>(prev) == e->value<Vec3>(cur));
+			}
+		}
+	}
+
+	void performanceCopyValues()
+	{
+		CAGE_TESTCASE("performance copy values");
+
+#ifdef CAGE_DEBUG
+		constexpr uint32 EntitiesCount = 100000;
+#else
+		constexpr uint32 EntitiesCount = 250000;
+#endif
+
+		Holder<EntityManager> man = newEntityManager();
+		EntityComponent *cur = man->defineComponent(Transform());
+		EntityComponent *prev = man->defineComponent(Transform());
+		for (uint32 i = 0; i < EntitiesCount; i++)
+		{
+			Entity *e = man->createAnonymous();
+			e->value<Transform>(cur).position = Vec3(i, 0, 0);
+			e->value<Transform>(prev);
+		}
+
+		const auto &moveSome = [&](uint32 every)
+		{
+			uint32 i = 0;
+			for (Entity *e : cur->entities())
+				if (i++ % every == 0)
+					e->value<Transform>(cur).position[1] += 1;
+		};
+
+		for (uint32 round = 0; round < 3; round++)
+		{
+			moveSome(1);
+			Holder<Timer> tmr = newTimer();
+			for (Entity *e : cur->entities())
+				e->value<Transform>(prev) = e->value<Transform>(cur);
+			const uint64 serial = tmr->duration();
+
+			moveSome(1);
+			tmr->reset();
+			const uint32 all = cur->copyValuesTo(prev);
+			const uint64 parallel = tmr->duration();
+			CAGE_TEST(all == EntitiesCount);
+
+			moveSome(100);
+			tmr->reset();
+			const uint32 few = cur->copyValuesTo(prev);
+			const uint64 unchanged = tmr->duration();
+			CAGE_TEST(few == EntitiesCount / 100);
+
+			CAGE_LOG(SeverityEnum::Info, "entities performance", Stringizer() + "copy values of " + EntitiesCount + " entities: serial: " + serial + " us, parallel: " + parallel + " us, with 1% changed: " + unchanged + " us");
+		}
+	}
+
 	void performanceTypeVsComponent()
 	{
 		CAGE_TESTCASE("performance type vs component");
@@ -525,7 +634,9 @@ void testEntities()
 	multipleComponentsOfSameType();
 	callbacks();
 	randomizedTests();
+	copyValues();
 	performanceTypeVsComponent();
+	performanceCopyValues();
 	performanceSimulationTest();
 }
 
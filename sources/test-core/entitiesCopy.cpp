@@ -3,6 +3,9 @@
 #include <cage-core/math.h>
 #include <cage-core/entities.h>
 #include <cage-core/entitiesCopy.h>
+#include <cage-core/entitiesVisitor.h>
+#include <cage-core/timer.h>
+#include <cage-core/tasks.h>
 #include <map>
 
 namespace
@@ -49,6 +52,72 @@ namespace
 		}
 	}
 
+	void modifyEntities(EntityManager *man)
+	{
+		for (Entity *e : man->entities())
+		{
+			if (randomChance() < 0.8)
+				continue;
+			for (EntityComponent *c : man->components())
+			{
+				if (!e->has(c))
+					continue;
+				if (c->typeIndex() == detail::typeIndex<float>())
+					e->value<float>(c) += 1;
+				else if (c->typeIndex() == detail::typeIndex<int>())
+					e->value<int>(c) -= 1;
+				else if (c->typeIndex() == detail::typeIndex<Vec3>())
+					e->value<Vec3>(c) += Vec3(0.5);
+			}
+		}
+	}
+
+	struct ParallelWrites
+	{
+		std::vector<Entity *> ents;
+		EntityComponent *component = nullptr;
+		static constexpr uint32 Groups = 4;
+
+		void operator () (uint32 idx)
+		{
+			const auto r = tasksSplit(idx, Groups, numeric_cast<uint32>(ents.size()));
+			for (uint32 i = r.first; i < r.second; i++)
+				ents[i]->value<int>(component) = i;
+		}
+	};
+
+	template<uint32 I>
+	struct VisitedValue
+	{
+		uint32 value = 0;
+	};
+
+	// each task visits and writes its own component of all entities
+	struct ParallelVisitors
+	{
+		EntityManager *man = nullptr;
+		static constexpr uint32 Groups = 4;
+
+		template<uint32 I>
+		void visit()
+		{
+			entitiesVisitor([](Entity *e, VisitedValue<I> &v) {
+				v.value = e->name() + I;
+			}, man, false);
+		}
+
+		void operator () (uint32 idx)
+		{
+			switch (idx)
+			{
+			case 0: return visit<0>();
+			case 1: return visit<1>();
+			case 2: return visit<2>();
+			case 3: return visit<3>();
+			}
+		}
+	};
+
 	uint32 indexOfComponentByType(EntityManager *m, EntityComponent *c)
 	{
 		uint32 i = 0;
@@ -133,10 +202,218 @@ void testEntitiesCopy()
 	am->defineComponent(int());
 	am->defineComponent(Vec3());
 
-	for (uint32 round = 0; round < 20; round++)
 	{
-		changeEntities(+am);
-		entitiesCopy({ +am, +bm });
-		check(+am, +bm);
+		CAGE_TESTCASE("full copy");
+		for (uint32 round = 0; round < 20; round++)
+		{
+			changeEntities(+am);
+			entitiesCopy({ +am, +bm });
+			check(+am, +bm);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("dirty tracking");
+		Holder<EntityManager> man = newEntityManager();
+		EntityComponent *fc = man->defineComponent(float());
+		EntityComponent *ic = man->defineComponent(int());
+		Entity *a = man->create(1);
+		a->value<float>(fc) = 1;
+		CAGE_TEST(!man->dirtyTracking());
+		CAGE_TEST(man->dirtyEntities().empty());
+		CAGE_TEST(!a->dirty(fc));
+		man->dirtyTracking(true);
+		CAGE_TEST(man->dirtyTracking());
+		CAGE_TEST(man->dirtyEntities().empty());
+		a->value<float>(fc) = 2;
+		CAGE_TEST(man->dirtyEntities().size() == 1);
+		CAGE_TEST(a->dirty(fc));
+		CAGE_TEST(!a->dirty(ic));
+		a->value<float>(fc) = 3;
+		CAGE_TEST(man->dirtyEntities().size() == 1);
+		Entity *b = man->create(2);
+		CAGE_TEST(man->dirtyEntities().size() == 2);
+		CAGE_TEST(!b->dirty(fc) && !b->dirty(ic));
+		b->add(ic);
+		CAGE_TEST(b->dirty(ic));
+		man->clearDirty();
+		CAGE_TEST(man->dirtyEntities().empty());
+		CAGE_TEST(!a->dirty(fc));
+		CAGE_TEST(!b->dirty(ic));
+		CAGE_TEST(a->has(fc)); // reading does not mark dirty
+		CAGE_TEST(((const Entity *)a)->value<float>(fc) == 3);
+		CAGE_TEST(((const Entity *)b)->value<int>() == 0);
+		uint32 visited = 0;
+		entitiesVisitor([&](const float &f, const int &i) { visited++; }, +man, false);
+		entitiesVisitor([&](Entity *e, const int &i) { visited++; }, +man, false);
+		CAGE_TEST(visited == 1);
+		CAGE_TEST(man->dirtyEntities().empty());
+		CAGE_TEST(!a->dirty(fc));
+		CAGE_TEST(!b->dirty(ic));
+		entitiesVisitor([&](int &i) { i++; }, +man, false);
+		CAGE_TEST(b->dirty(ic));
+		CAGE_TEST(man->dirtyEntities().size() == 1);
+		man->clearDirty();
+		a->remove(fc);
+		CAGE_TEST(a->dirty(fc));
+		b->value<int>(ic) = 5;
+		CAGE_TEST(man->dirtyEntities().size() == 2);
+		a->destroy();
+		CAGE_TEST(man->dirtyEntities().size() == 1);
+		CAGE_TEST(man->dirtyEntities()[0] == b);
+		man->dirtyTracking(false);
+		CAGE_TEST(man->dirtyEntities().empty());
+		b->value<int>(ic) = 6;
+		CAGE_TEST(man->dirtyEntities().empty());
+	}
+
+	{
+		CAGE_TESTCASE("dirty tracking with writes from multiple threads");
+		Holder<EntityManager> man = newEntityManager();
+		ParallelWrites pw;
+		pw.component = man->defineComponent(int());
+		for (uint32 i = 0; i < 5000; i++)
+			pw.ents.push_back(man->createAnonymous());
+		man->dirtyTracking(true);
+		tasksRunBlocking<ParallelWrites>("parallel writes", pw, ParallelWrites::Groups);
+		CAGE_TEST(man->dirtyEntities().size() == pw.ents.size());
+		for (Entity *e : pw.ents)
+			CAGE_TEST(e->dirty(pw.component));
+		man->clearDirty();
+		for (Entity *e : pw.ents)
+			CAGE_TEST(!e->dirty(pw.component));
+	}
+
+	{
+		CAGE_TESTCASE("dirty tracking with writes from multiple visitors");
+		Holder<EntityManager> man = newEntityManager();
+		EntityComponent *cs[ParallelVisitors::Groups] = { man->defineComponent(VisitedValue<0>()), man->defineComponent(VisitedValue<1>()), man->defineComponent(VisitedValue<2>()), man->defineComponent(VisitedValue<3>()) };
+		for (uint32 i = 1; i <= 3000; i++)
+		{
+			Entity *e = man->create(i);
+			for (EntityComponent *c : cs)
+				e->add(c);
+		}
+		man->dirtyTracking(true);
+		ParallelVisitors pv;
+		pv.man = +man;
+		for (uint32 round = 0; round < 2; round++)
+		{
+			// the second round writes into already dirty values
+			tasksRunBlocking<ParallelVisitors>("parallel visitors", pv, ParallelVisitors::Groups);
+			CAGE_TEST(man->dirtyEntities().size() == man->count());
+		}
+		std::vector<Entity *> listed(man->dirtyEntities().begin(), man->dirtyEntities().end());
+		std::sort(listed.begin(), listed.end());
+		CAGE_TEST(std::unique(listed.begin(), listed.end()) == listed.end());
+		for (Entity *e : man->entities())
+		{
+			for (uint32 i = 0; i < ParallelVisitors::Groups; i++)
+			{
+				CAGE_TEST(e->dirty(cs[i]));
+				CAGE_TEST(((const VisitedValue<0> *)((const Entity *)e)->unsafeValue(cs[i]))->value == e->name() + i); // all VisitedValue have same layout
+			}
+		}
+		man->clearDirty();
+		tasksRunBlocking<ParallelVisitors>("parallel visitors", pv, 2);
+		CAGE_TEST(man->dirtyEntities().size() == man->count());
+		for (Entity *e : man->entities())
+		{
+			CAGE_TEST(e->dirty(cs[0]) && e->dirty(cs[1]));
+			CAGE_TEST(!e->dirty(cs[2]) && !e->dirty(cs[3]));
+		}
+	}
+
+	{
+		CAGE_TESTCASE("incremental copy");
+		Holder<EntityManager> cm = newEntityManager();
+		Holder<EntitiesCopier> copier = newEntitiesCopier({ +am, +cm });
+		for (uint32 round = 0; round < 20; round++)
+		{
+			changeEntities(+am);
+			modifyEntities(+am);
+			copier->copy();
+			CAGE_TEST(am->dirtyEntities().empty());
+			check(+am, +cm);
+		}
+		copier->reset();
+		copier->copy();
+		check(+am, +cm);
+		am->destroy();
+		copier->copy();
+		CAGE_TEST(cm->count() == 0);
+		for (uint32 round = 0; round < 5; round++)
+		{
+			changeEntities(+am);
+			copier->copy();
+			check(+am, +cm);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("incremental copy in parallel");
+		Holder<EntityManager> cm = newEntityManager();
+		EntitiesCopierCreateConfig cfg;
+		cfg.source = +am;
+		cfg.destination = +cm;
+		cfg.parallelThreshold = 10;
+		Holder<EntitiesCopier> copier = newEntitiesCopier(cfg);
+		for (uint32 round = 0; round < 10; round++)
+		{
+			changeEntities(+am);
+			modifyEntities(+am);
+			copier->copy();
+			check(+am, +cm);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 count = 10000;
+#else
+		constexpr uint32 count = 100000;
+#endif
+		constexpr uint32 rounds = 5;
+		Holder<EntityManager> src = newEntityManager();
+		EntityComponent *pc = src->defineComponent(Vec3());
+		EntityComponent *vc = src->defineComponent(Vec3());
+		EntityComponent *fc = src->defineComponent(float());
+		for (uint32 i = 0; i < count; i++)
+		{
+			Entity *e = src->create(i + 1);
+			e->value<Vec3>(pc) = randomDirection3();
+			e->value<Vec3>(vc) = randomDirection3();
+			e->value<float>(fc) = i;
+		}
+		Holder<EntityManager> fullDst = newEntityManager();
+		Holder<EntityManager> incDst = newEntityManager();
+		Holder<EntitiesCopier> copier = newEntitiesCopier({ +src, +incDst });
+		copier->copy();
+		uint64 fullTime = 0, incTime = 0;
+		Holder<Timer> tmr = newTimer();
+		for (uint32 round = 0; round < rounds; round++)
+		{
+			// simulate a tick that moves a small part of the world
+			for (uint32 i = 0; i < count / 100; i++)
+				if (Entity *e = src->tryGet(randomRange(0u, count) + 1))
+					e->value<Vec3>(pc) += Vec3(1, 0, 0);
+			for (uint32 i = 0; i < count / 1000; i++)
+			{
+				if (Entity *e = src->tryGet(randomRange(0u, count) + 1))
+					e->destroy();
+				Entity *e = src->createUnique();
+				e->value<Vec3>(pc) = randomDirection3();
+			}
+			tmr->reset();
+			entitiesCopy({ +src, +fullDst });
+			fullTime += tmr->duration();
+			tmr->reset();
+			copier->copy();
+			incTime += tmr->duration();
+		}
+		CAGE_TEST(incDst->count() == src->count());
+		CAGE_TEST(fullDst->count() == src->count());
+		CAGE_LOG(SeverityEnum::Info, "entities copy performance", Stringizer() + "entities: " + count + ", full copy: " + (fullTime / rounds) + " us, incremental copy: " + (incTime / rounds) + " us");
 	}
 }
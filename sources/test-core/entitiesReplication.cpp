@@ -0,0 +1,223 @@
+#include <vector>
+
+#include "main.h"
+
+#include <cage-core/entities.h>
+#include <cage-core/entitiesReplication.h>
+#include <cage-core/math.h>
+
+namespace
+{
+	struct Big
+	{
+		uint32 values[200] = {};
+	};
+
+	void defineManager(EntityManager *man)
+	{
+		man->defineComponent<float>(0);
+		man->defineComponent<int>(0);
+		man->defineComponent(Vec3());
+		man->defineComponent(Big());
+	}
+
+	void generateEntity(Entity *e)
+	{
+		if (randomChance() < 0.5)
+			e->value<float>(e->manager()->componentByDefinition(0)) = randomChance().value;
+		if (randomChance() < 0.5)
+			e->value<int>(e->manager()->componentByDefinition(1)) = randomRange(-100, 100);
+		if (randomChance() < 0.5)
+			e->value<Vec3>(e->manager()->componentByDefinition(2)) = randomDirection3();
+		if (randomChance() < 0.2)
+			e->value<Big>(e->manager()->componentByDefinition(3)).values[randomRange(0, 200)] = randomRange(0, 1000);
+	}
+
+	void changeEntities(EntityManager *man)
+	{
+		for (uint32 round = 0; round < 30; round++)
+		{
+			const uint32 a = randomRange(1, 300);
+			if (man->has(a))
+			{
+				if (randomChance() < 0.3)
+					man->get(a)->destroy();
+				else
+				{
+					Entity *e = man->get(a);
+					if (randomChance() < 0.3)
+						e->remove(man->componentByDefinition(randomRange(0, 4)));
+					generateEntity(e);
+				}
+			}
+			else
+				generateEntity(man->create(a));
+		}
+		generateEntity(man->createAnonymous());
+	}
+
+	void check(EntityManager *a, EntityManager *b)
+	{
+		uint32 named = 0;
+		for (Entity *ea : a->entities())
+		{
+			const uint32 aName = ea->name();
+			if (aName == 0)
+				continue;
+			named++;
+			CAGE_TEST(b->has(aName));
+			Entity *eb = b->get(aName);
+			for (uint32 i = 0; i < 4; i++)
+			{
+				EntityComponent *ca = a->componentByDefinition(i);
+				EntityComponent *cb = b->componentByDefinition(i);
+				CAGE_TEST(ea->has(ca) == eb->has(cb));
+				if (ea->has(ca))
+					CAGE_TEST(detail::memcmp(ea->unsafeValue(ca), eb->unsafeValue(cb), detail::typeSizeByIndex(ca->typeIndex())) == 0);
+			}
+		}
+		CAGE_TEST(b->count() == named);
+	}
+}
+
+void testEntitiesReplication()
+{
+	CAGE_TESTCASE("entities replication");
+
+	{
+		CAGE_TESTCASE("reliable transfer");
+		Holder<EntityManager> manA = newEntityManager();
+		defineManager(+manA);
+		Holder<EntityManager> manB = newEntityManager();
+		defineManager(+manB);
+		EntitiesReplicationServerCreateConfig scfg;
+		scfg.entities = manA->group();
+		Holder<EntitiesReplicationServer> server = newEntitiesReplicationServer(scfg);
+		EntitiesReplicationClientCreateConfig ccfg;
+		ccfg.manager = +manB;
+		Holder<EntitiesReplicationClient> client = newEntitiesReplicationClient(ccfg);
+		CAGE_TEST(!client->acknowledgement());
+		for (uint32 round = 0; round < 20; round++)
+		{
+			changeEntities(+manA);
+			server->capture();
+			Holder<PointerRange<char>> msg = server->encode(0);
+			CAGE_TEST(client->apply(msg));
+			CAGE_TEST(!client->apply(msg)); // duplicate
+			CAGE_TEST(client->snapshotId() == server->snapshotId());
+			server->acknowledge(0, client->acknowledgement());
+			CAGE_TEST(server->baselineId(0) == server->snapshotId());
+			check(+manA, +manB);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("unchanged entities are not sent");
+		Holder<EntityManager> manA = newEntityManager();
+		defineManager(+manA);
+		Holder<EntityManager> manB = newEntityManager();
+		defineManager(+manB);
+		for (uint32 i = 0; i < 200; i++)
+			generateEntity(manA->create(i + 1));
+		EntitiesReplicationServerCreateConfig scfg;
+		scfg.entities = manA->group();
+		Holder<EntitiesReplicationServer> server = newEntitiesReplicationServer(scfg);
+		EntitiesReplicationClientCreateConfig ccfg;
+		ccfg.manager = +manB;
+		Holder<EntitiesReplicationClient> client = newEntitiesReplicationClient(ccfg);
+		server->capture();
+		Holder<PointerRange<char>> full = server->encode(0);
+		CAGE_TEST(client->apply(full));
+		server->acknowledge(0, client->acknowledgement());
+		server->capture();
+		Holder<PointerRange<char>> empty = server->encode(0);
+		CAGE_TEST(empty.size() < 100);
+		CAGE_TEST(client->apply(empty));
+		server->acknowledge(0, client->acknowledgement());
+		manA->get(42)->value<Big>(manA->componentByDefinition(3)).values[100] = 13;
+		server->capture();
+		Holder<PointerRange<char>> single = server->encode(0);
+		CAGE_TEST(single.size() < empty.size() + 30);
+		CAGE_TEST(client->apply(single));
+		check(+manA, +manB);
+		CAGE_TEST(server->encode(1).size() >= full.size()); // new client receives everything
+	}
+
+	{
+		CAGE_TESTCASE("lossy and reordered transfer with multiple clients");
+		Holder<EntityManager> manA = newEntityManager();
+		defineManager(+manA);
+		EntitiesReplicationServerCreateConfig scfg;
+		scfg.entities = manA->group();
+		scfg.historySize = 10;
+		Holder<EntitiesReplicationServer> server = newEntitiesReplicationServer(scfg);
+		std::vector<Holder<EntityManager>> mans;
+		std::vector<Holder<EntitiesReplicationClient>> clients;
+		for (uint32 i = 0; i < 3; i++)
+		{
+			mans.push_back(newEntityManager());
+			defineManager(+mans[i]);
+			EntitiesReplicationClientCreateConfig ccfg;
+			ccfg.manager = +mans[i];
+			ccfg.historySize = 5;
+			clients.push_back(newEntitiesReplicationClient(ccfg));
+		}
+		std::vector<Holder<PointerRange<char>>> delayed[3];
+		for (uint32 round = 0; round < 100; round++)
+		{
+			changeEntities(+manA);
+			server->capture();
+			for (uint32 i = 0; i < 3; i++)
+			{
+				Holder<PointerRange<char>> msg = server->encode(i);
+				if (randomChance() < 0.2)
+					continue; // lost
+				if (randomChance() < 0.2)
+				{
+					delayed[i].push_back(std::move(msg));
+					continue;
+				}
+				if (!delayed[i].empty() && randomChance() < 0.5)
+				{
+					clients[i]->apply(delayed[i].back()); // arrives late
+					delayed[i].pop_back();
+				}
+				clients[i]->apply(msg);
+				if (randomChance() < 0.3)
+					continue; // lost acknowledgement
+				if (clients[i]->acknowledgement())
+					server->acknowledge(i, clients[i]->acknowledgement());
+			}
+		}
+		for (uint32 i = 0; i < 3; i++)
+		{
+			for (const auto &msg : delayed[i])
+				clients[i]->apply(msg);
+			// final delivery without loss
+			if (clients[i]->acknowledgement())
+				server->acknowledge(i, clients[i]->acknowledgement());
+			if (clients[i]->snapshotId() != server->snapshotId())
+				CAGE_TEST(clients[i]->apply(server->encode(i)));
+			CAGE_TEST(clients[i]->snapshotId() == server->snapshotId());
+			check(+manA, +mans[i]);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("component mismatch");
+		Holder<EntityManager> manA = newEntityManager();
+		defineManager(+manA);
+		generateEntity(manA->create(1));
+		Holder<EntityManager> manB = newEntityManager();
+		manB->defineComponent<float>(0);
+		manB->defineComponent<double>(0);
+		EntitiesReplicationServerCreateConfig scfg;
+		scfg.entities = manA->group();
+		Holder<EntitiesReplicationServer> server = newEntitiesReplicationServer(scfg);
+		EntitiesReplicationClientCreateConfig ccfg;
+		ccfg.manager = +manB;
+		Holder<EntitiesReplicationClient> client = newEntitiesReplicationClient(ccfg);
+		server->capture();
+		CAGE_TEST_THROWN(client->apply(server->encode(0)));
+	}
+}
@@ -0,0 +1,213 @@
+#include "main.h"
+
+#include <cage-core/framePacing.h>
+
+namespace
+{
+	struct SimulatedClock
+	{
+		uint64 now = 1000000;
+		uint64 oversleep = 0;
+		uint64 jitter = 0; // every other sleep oversleeps less
+		uint32 sleeps = 0;
+		uint32 yields = 0;
+
+		uint64 clock()
+		{
+			return now;
+		}
+
+		void sleep(uint64 duration)
+		{
+			if (duration)
+			{
+				now += duration + oversleep - (sleeps % 2) * jitter;
+				sleeps++;
+			}
+			else
+			{
+				now += 10;
+				yields++;
+			}
+		}
+	};
+
+	Holder<FramePacer> newSimulatedPacer(SimulatedClock &sim, uint64 target)
+	{
+		FramePacerCreateConfig cfg;
+		cfg.clock.bind<SimulatedClock, &SimulatedClock::clock>(&sim);
+		cfg.sleep.bind<SimulatedClock, &SimulatedClock::sleep>(&sim);
+		cfg.targetFrameTime = target;
+		return newFramePacer(cfg);
+	}
+
+	void simulateFrame(FramePacer *pacer, SimulatedClock &sim, uint32 frameIndex, uint64 work)
+	{
+		pacer->stage(frameIndex, FrameStageEnum::Input);
+		sim.now += work / 4;
+		pacer->stage(frameIndex, FrameStageEnum::Emit);
+		pacer->stage(frameIndex, FrameStageEnum::PrepareStart);
+		sim.now += work / 4;
+		pacer->stage(frameIndex, FrameStageEnum::PrepareEnd);
+		pacer->stage(frameIndex, FrameStageEnum::DispatchStart);
+		sim.now += work / 4;
+		pacer->stage(frameIndex, FrameStageEnum::DispatchEnd);
+		sim.now += work / 4;
+		pacer->stage(frameIndex, FrameStageEnum::Present);
+	}
+}
+
+void testFramePacing()
+{
+	CAGE_TESTCASE("frame pacing");
+
+	{
+		CAGE_TESTCASE("unlimited");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 0);
+		const uint64 start = sim.now;
+		for (uint32 i = 0; i < 10; i++)
+			pacer->wait();
+		CAGE_TEST(sim.now == start);
+		CAGE_TEST(sim.sleeps == 0 && sim.yields == 0);
+	}
+
+	{
+		CAGE_TESTCASE("steady cadence");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 10000);
+		pacer->wait(); // starts the cadence
+		const uint64 start = sim.now;
+		for (uint32 i = 1; i <= 20; i++)
+		{
+			sim.now += 3000; // work
+			pacer->wait();
+			CAGE_TEST(sim.now >= start + i * 10000);
+			CAGE_TEST(sim.now < start + i * 10000 + 100);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("oversleep prediction");
+		SimulatedClock sim;
+		sim.oversleep = 2500;
+		sim.jitter = 1000;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 16000);
+		pacer->wait();
+		const uint64 start = sim.now;
+		uint32 late = 0;
+		for (uint32 i = 1; i <= 50; i++)
+		{
+			sim.now += 2000;
+			pacer->wait();
+			if (sim.now > start + i * 16000 + 100)
+				late++;
+		}
+		CAGE_TEST(late <= 2); // only until the oversleep is learned
+		CAGE_TEST(pacer->predictedOversleep() >= 2500);
+		CAGE_TEST(sim.sleeps > 0 && sim.yields > 0);
+	}
+
+	{
+		CAGE_TESTCASE("resynchronize when late");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 10000);
+		pacer->wait();
+		sim.now += 55000; // long hitch
+		const uint64 hitch = sim.now;
+		pacer->wait();
+		CAGE_TEST(sim.now == hitch); // no waiting after hitch
+		pacer->wait();
+		CAGE_TEST(sim.now >= hitch + 10000 && sim.now < hitch + 10100); // no burst of frames to catch up
+	}
+
+	{
+		CAGE_TESTCASE("changing target restarts cadence");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 10000);
+		pacer->wait();
+		pacer->wait();
+		CAGE_TEST(pacer->targetFrameTime() == 10000);
+		pacer->targetFrameTime(20000);
+		CAGE_TEST(pacer->targetFrameTime() == 20000);
+		const uint64 t = sim.now;
+		pacer->wait();
+		CAGE_TEST(sim.now == t);
+		pacer->wait();
+		CAGE_TEST(sim.now >= t + 20000 && sim.now < t + 20100);
+	}
+
+	{
+		CAGE_TESTCASE("stage statistics");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 10000);
+		for (uint32 i = 0; i < 200; i++)
+		{
+			pacer->wait();
+			simulateFrame(+pacer, sim, i, 4000);
+		}
+		const FramePacingStatistics st = pacer->statistics();
+		CAGE_TEST(st.frames == 200);
+		CAGE_TEST(st.missedFrames == 0);
+		CAGE_TEST(st.latest.frameIndex == 199);
+		CAGE_TEST(st.latencies.smooth() == 4000);
+		CAGE_TEST(st.presentDelays.smooth() == 3000);
+		CAGE_TEST(pacer->presentDelay() == 3000);
+		CAGE_TEST(st.stageDelays[(uint32)FrameStageEnum::Emit].smooth() == 1000);
+		CAGE_TEST(st.stageDelays[(uint32)FrameStageEnum::PrepareStart].smooth() == 0);
+		CAGE_TEST(st.stageDelays[(uint32)FrameStageEnum::Present].smooth() == 1000);
+		CAGE_TEST(st.frameTimes.min() >= 10000 && st.frameTimes.max() < 10100);
+		CAGE_TEST(st.frameJitters.max() < 100);
+	}
+
+	{
+		CAGE_TESTCASE("missed frames");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 10000);
+		for (uint32 i = 0; i < 10; i++)
+		{
+			pacer->wait();
+			simulateFrame(+pacer, sim, i, i == 5 ? 30000 : 2000);
+		}
+		const FramePacingStatistics st = pacer->statistics();
+		CAGE_TEST(st.frames == 10);
+		CAGE_TEST(st.missedFrames == 1);
+		CAGE_TEST(st.frameJitters.max() >= 20000);
+	}
+
+	{
+		CAGE_TESTCASE("interleaved frames");
+		SimulatedClock sim;
+		Holder<FramePacer> pacer = newSimulatedPacer(sim, 0);
+		// control thread emits next frame while graphics is still working on the previous one
+		pacer->stage(0, FrameStageEnum::Input, 100);
+		pacer->stage(0, FrameStageEnum::Emit, 200);
+		pacer->stage(0, FrameStageEnum::PrepareStart, 300);
+		pacer->stage(1, FrameStageEnum::Input, 400);
+		pacer->stage(0, FrameStageEnum::DispatchStart, 500);
+		pacer->stage(1, FrameStageEnum::Emit, 600);
+		pacer->stage(0, FrameStageEnum::Present, 700);
+		pacer->stage(1, FrameStageEnum::PrepareStart, 800);
+		pacer->stage(1, FrameStageEnum::Present, 1200);
+		const FramePacingStatistics st = pacer->statistics();
+		CAGE_TEST(st.frames == 2);
+		CAGE_TEST(st.latest.frameIndex == 1);
+		CAGE_TEST(st.latencies.current() == 800);
+		CAGE_TEST(st.presentDelays.current() == 400);
+		CAGE_TEST(st.frameTimes.current() == 500);
+		CAGE_TEST(st.stageDelays[(uint32)FrameStageEnum::Present].current() == 400); // dispatch was not recorded, measured from prepare start
+	}
+
+	{
+		CAGE_TESTCASE("statistics without pacer");
+		FramePacingStatistics st;
+		FrameTimestamps ts;
+		ts.frameIndex = 0;
+		ts.stages[(uint32)FrameStageEnum::Input] = 10;
+		ts.stages[(uint32)FrameStageEnum::Present] = 50;
+		st.add(ts);
+		CAGE_TEST(st.frames == 1);
+		CAGE_TEST(st.latencies.current() == 40);
+		CAGE_TEST(st.frameTimes.current() == 0);
+	}
+}
@@ -1,6 +1,25 @@
 #include "main.h"
 
 #include <cage-core/hashes.h>
+#include <cage-core/hashBuffer.h>
+#include <cage-core/config.h>
+#include <cage-core/math.h>
+#include <cage-core/string.h>
+#include <cage-core/timer.h>
+
+#include <vector>
+
+namespace
+{
+	std::vector<char> randomBuffer(uint32 size)
+	{
+		std::vector<char> r;
+		r.resize(size);
+		for (char &c : r)
+			c = (char)randomRange(0u, 256u);
+		return r;
+	}
+}
 
 void testHashes()
 {
@@ -26,5 +45,96 @@ void testHashes()
 			CAGE_TEST(hashToHexadecimal(r) == "de9f2c7fd25e1b3afad3e85a0bd17d9b100db4b3");
 			CAGE_TEST(hashToBase64(r) == "3p8sf9JeGzr60+haC9F9mxANtLM=");
 		}
+
+		{
+			const auto r = hashSha1("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq");
+			CAGE_TEST(hashToHexadecimal(r) == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+		}
+	}
+
+	{
+		CAGE_TESTCASE("sha256");
+		CAGE_TEST(hashToHexadecimal(hashSha256("")) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+		CAGE_TEST(hashToHexadecimal(hashSha256("abc")) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+		CAGE_TEST(hashToHexadecimal(hashSha256("The quick brown fox jumps over the lazy dog")) == "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592");
+		CAGE_TEST(hashToHexadecimal(hashSha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")) == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	}
+
+	{
+		CAGE_TESTCASE("sha hardware and software paths give same results");
+		for (uint32 size : { 0u, 1u, 55u, 56u, 63u, 64u, 65u, 119u, 120u, 128u, 1000u, 4099u })
+		{
+			const auto buf = randomBuffer(size);
+			configSetBool("cage/hashes/hardware", true);
+			const auto a1 = hashSha1(buf);
+			const auto a2 = hashSha256(buf);
+			configSetBool("cage/hashes/hardware", false);
+			const auto b1 = hashSha1(buf);
+			const auto b2 = hashSha256(buf);
+			CAGE_TEST(a1 == b1);
+			CAGE_TEST(a2 == b2);
+		}
+		configSetBool("cage/hashes/hardware", true);
+	}
+
+	{
+		CAGE_TESTCASE("hash64");
+		CAGE_TEST(hash64("") == 0xEF46DB3751D8E999ull);
+		CAGE_TEST(hash64("a") == 0xD24EC4F1A98C6E5Bull);
+		CAGE_TEST(hash64("abc") == 0x44BC2CF5AD770999ull);
+		CAGE_TEST(hash64("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ull);
+		CAGE_TEST(hash64("abc", 1) != hash64("abc"));
+		CAGE_TEST(hash64("hello") != hash64("hellp"));
+	}
+
+	{
+		CAGE_TESTCASE("hash128");
+		const auto a = hash128("The quick brown fox jumps over the lazy dog");
+		const auto b = hash128("The quick brown fox jumps over the lazy cog");
+		CAGE_TEST(a != b);
+		CAGE_TEST(hash128("") != hash128("", 1));
+		CAGE_TEST(subString(hashToHexadecimal(hash128("abc")), 0, 16) == "44bc2cf5ad770999"); // first half is same as hash64
+		const auto c = hash128("abc");
+		CAGE_TEST(std::equal(c.begin(), c.begin() + 8, c.begin() + 8) == false);
+	}
+
+	{
+		CAGE_TESTCASE("streaming");
+		for (uint32 size : { 0u, 3u, 31u, 32u, 33u, 100u, 1000u })
+		{
+			const auto buf = randomBuffer(size);
+			for (uint32 chunk : { 1u, 5u, 32u, 64u })
+			{
+				HashStream s(13);
+				for (uint32 i = 0; i < size; i += chunk)
+					s.update({ buf.data() + i, buf.data() + min(i + chunk, size) });
+				CAGE_TEST(s.hash64() == hash64(buf, 13));
+				CAGE_TEST(s.hash128() == hash128(buf, 13));
+			}
+		}
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 size = 4 * 1024 * 1024;
+#else
+		constexpr uint32 size = 64 * 1024 * 1024;
+#endif
+		const auto buf = randomBuffer(size);
+		Holder<Timer> tmr = newTimer();
+		const uint32 r1 = hashBuffer(buf);
+		const uint64 t1 = tmr->duration();
+		tmr->reset();
+		const uint64 r2 = hash64(buf);
+		const uint64 t2 = tmr->duration();
+		tmr->reset();
+		const auto r3 = hashSha1(buf);
+		const uint64 t3 = tmr->duration();
+		tmr->reset();
+		const auto r4 = hashSha256(buf);
+		const uint64 t4 = tmr->duration();
+		CAGE_TEST(r1 != 0 && r2 != 0 && r3[0] + r4[0] >= 0);
+		CAGE_LOG(SeverityEnum::Info, "hashes performance", Stringizer() + "bytes: " + size + ", fnv: " + t1 + " us, hash64: " + t2 + " us, sha1: " + t3 + " us, sha256: " + t4 + " us");
 	}
 }
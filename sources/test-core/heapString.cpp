@@ -0,0 +1,188 @@
+#include "main.h"
+
+#include <cage-core/heapString.h>
+#include <cage-core/stdHash.h>
+#include <cage-core/string.h>
+#include <cage-core/memoryBuffer.h>
+#include <cage-core/timer.h>
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+void testHeapString()
+{
+	CAGE_TESTCASE("heap string");
+
+	{
+		CAGE_TESTCASE("string view");
+		const String s = "hello";
+		StringView v = s;
+		CAGE_TEST(v.size() == 5);
+		CAGE_TEST(v == "hello");
+		CAGE_TEST(v != "hell");
+		CAGE_TEST(v < "world");
+		CAGE_TEST(StringView("abc") < StringView("abd"));
+		CAGE_TEST(StringView() == "");
+		CAGE_TEST(StringView().empty());
+		const auto z = Stringizer() + "x" + 42;
+		CAGE_TEST(StringView(z) == "x42");
+		CAGE_TEST(String(Stringizer() + StringView(s) + "!") == "hello!");
+	}
+
+	{
+		CAGE_TESTCASE("inline and heap storage");
+		HeapString a;
+		CAGE_TEST(a.empty());
+		CAGE_TEST(a.c_str()[0] == 0);
+		a = "short";
+		CAGE_TEST(a.size() == 5);
+		CAGE_TEST(a.capacity() == HeapString::InlineCapacity);
+		CAGE_TEST(a == "short");
+		String big;
+		for (uint32 i = 0; i < 50; i++)
+			big += "abcdefghij";
+		HeapString b = big;
+		CAGE_TEST(b.size() == 500);
+		CAGE_TEST(b.capacity() >= 500);
+		CAGE_TEST(b == big);
+		CAGE_TEST(b.c_str()[500] == 0);
+		b.clear();
+		CAGE_TEST(b.empty());
+		CAGE_TEST(b.capacity() >= 500);
+		HeapString c;
+		c.reserve(100);
+		CAGE_TEST(c.capacity() >= 100);
+		c = "abc";
+		CAGE_TEST(c == "abc");
+	}
+
+	{
+		CAGE_TESTCASE("longer than String");
+		HeapString a;
+		for (uint32 i = 0; i < 1000; i++)
+			a += "0123456789";
+		CAGE_TEST(a.size() == 10000);
+		CAGE_TEST(a[9999] == '9');
+		CAGE_TEST(a[5000] == '0');
+	}
+
+	{
+		CAGE_TESTCASE("copy and move");
+		HeapString a = "inline";
+		HeapString b = "this text is long enough to not fit inline";
+		HeapString c = a;
+		HeapString d = b;
+		CAGE_TEST(c == a && d == b);
+		CAGE_TEST(d.data() != b.data());
+		const char *p = d.data();
+		HeapString e = std::move(d);
+		CAGE_TEST(e.data() == p); // heap storage is stolen
+		CAGE_TEST(d.empty());
+		HeapString f = std::move(c);
+		CAGE_TEST(f == "inline");
+		CAGE_TEST(c.empty());
+		f = e;
+		CAGE_TEST(f == e);
+		e = std::move(a);
+		CAGE_TEST(e == "inline");
+		const HeapString &alias = f;
+		f = alias;
+		CAGE_TEST(f == b);
+	}
+
+	{
+		CAGE_TESTCASE("appending self");
+		HeapString a = "abc";
+		a += a;
+		CAGE_TEST(a == "abcabc");
+		for (uint32 i = 0; i < 5; i++)
+			a += a;
+		CAGE_TEST(a.size() == 6 * 32);
+		CAGE_TEST(a + "x" == String(a) + "x");
+	}
+
+	{
+		CAGE_TESTCASE("comparisons");
+		const HeapString a = "apple";
+		const HeapString b = "banana";
+		CAGE_TEST(a < b);
+		CAGE_TEST(a == String("apple"));
+		CAGE_TEST(a != String("banana"));
+		CAGE_TEST(a == StringView("apple"));
+		CAGE_TEST(String(a) == "apple");
+		CAGE_TEST(StringComparatorFast()(a, b) == StringComparatorFast()(String(a), String(b)));
+		CAGE_TEST(StringComparatorNatural()(HeapString("a2"), HeapString("a10")));
+	}
+
+	{
+		CAGE_TESTCASE("hashing");
+		const HeapString a = "hello";
+		CAGE_TEST(std::hash<HeapString>()(a) == std::hash<String>()(String("hello")));
+		CAGE_TEST(std::hash<StringView>()(a) == std::hash<String>()(String("hello")));
+		std::unordered_map<HeapString, uint32> m;
+		m["a"] = 1;
+		m["b"] = 2;
+		CAGE_TEST(m.at("a") == 1);
+		CAGE_TEST(m.at("b") == 2);
+	}
+
+	{
+		CAGE_TESTCASE("serialization compatible with String");
+		MemoryBuffer buf;
+		Serializer ser(buf);
+		ser << HeapString("first") << String("second");
+		Deserializer des(buf);
+		String a;
+		HeapString b;
+		des >> a >> b;
+		CAGE_TEST(a == "first");
+		CAGE_TEST(b == "second");
+	}
+
+	{
+		CAGE_TESTCASE("map with transparent comparator");
+		std::map<HeapString, uint32, StringComparatorFast> m;
+		m["abc"] = 1;
+		m["def"] = 2;
+		CAGE_TEST(m.find(String("abc")) != m.end());
+		CAGE_TEST(m.find(StringView("def"))->second == 2);
+		CAGE_TEST(m.find("ghi") == m.end());
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 count = 2000;
+#else
+		constexpr uint32 count = 20000;
+#endif
+		std::vector<String> names;
+		names.reserve(count);
+		for (uint32 i = 0; i < count; i++)
+			names.push_back(Stringizer() + "some/asset/path/" + i + ".asset");
+		Holder<Timer> tmr = newTimer();
+		uint64 sum1 = 0, sum2 = 0;
+		{
+			std::map<String, uint32, StringComparatorFast> m;
+			for (uint32 i = 0; i < count; i++)
+				m[names[i]] = i;
+			std::map<String, uint32, StringComparatorFast> c = m;
+			for (const String &n : names)
+				sum1 += c.find(n)->second;
+		}
+		const uint64 t1 = tmr->duration();
+		tmr->reset();
+		{
+			std::map<HeapString, uint32, StringComparatorFast> m;
+			for (uint32 i = 0; i < count; i++)
+				m[names[i]] = i;
+			std::map<HeapString, uint32, StringComparatorFast> c = m;
+			for (const String &n : names)
+				sum2 += c.find(n)->second;
+		}
+		const uint64 t2 = tmr->duration();
+		CAGE_TEST(sum1 == sum2);
+		CAGE_LOG(SeverityEnum::Info, "heap string performance", Stringizer() + "items: " + count + ", String keys: " + t1 + " us, HeapString keys: " + t2 + " us");
+	}
+}
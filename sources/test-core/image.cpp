@@ -4,9 +4,12 @@
 #include <cage-core/image.h>
 #include <cage-core/imageAlgorithms.h>
 #include <cage-core/imageBlocks.h>
+#include <cage-core/imageImport.h>
+#include <cage-core/pointerRangeHolder.h>
 #include <cage-core/color.h>
 #include <cage-core/timer.h>
 #include <initializer_list>
+#include <vector>
 
 void test(Real, Real);
 void test(const Vec2 &, const Vec2 &);
@@ -352,6 +355,64 @@ namespace
 			compare(+img, +res);
 			res->exportFile("images/formats/bc7-403x301.png");
 		}
+
+		{
+			CAGE_TESTCASE("bc7 - parallel encoding is deterministic");
+			Holder<Image> img = newImage();
+			img->initialize(223, 301, 4);
+			drawCircle(+img);
+			ImageKtxEncodeConfig cfg;
+			cfg.parallelize = false;
+			const auto serial = imageBc7Encode(+img, cfg);
+			cfg.parallelize = true;
+			const auto parallel = imageBc7Encode(+img, cfg);
+			CAGE_TEST(serial.size() == parallel.size());
+			CAGE_TEST(detail::memcmp(serial.data(), parallel.data(), serial.size()) == 0);
+			CAGE_TEST(serial.size() == 56 * 76 * 16);
+
+			{
+				CAGE_TESTCASE("matches whole image encoding");
+				const Image *imgs[1] = { +img };
+				ImageKtxTranscodeConfig tcfg;
+				tcfg.format = ImageKtxTranscodeFormatEnum::Bc7;
+				const auto whole = imageKtxTranscode(imgs, {}, tcfg);
+				CAGE_TEST(whole.size() == 1);
+				CAGE_TEST(whole[0].data.size() == serial.size());
+				CAGE_TEST(detail::memcmp(whole[0].data.data(), serial.data(), serial.size()) == 0);
+			}
+
+			{
+				CAGE_TESTCASE("matches image import conversion");
+				ImageImportResult result;
+				{
+					PointerRangeHolder<ImageImportPart> parts;
+					for (uint32 face = 0; face < 2; face++)
+					{
+						ImageImportPart part;
+						part.image = img->copy();
+						if (face)
+							imageVerticalFlip(+part.image);
+						part.cubeFace = face;
+						parts.push_back(std::move(part));
+					}
+					result.parts = std::move(parts);
+				}
+				imageImportGenerateMipmaps(result);
+				CAGE_TEST(result.parts.size() > 2);
+				std::vector<Holder<PointerRange<char>>> expected;
+				for (const ImageImportPart &part : result.parts)
+					expected.push_back(imageBc7Encode(+part.image, cfg));
+				imageImportConvertImagesToBcn(result);
+				for (uint32 i = 0; i < result.parts.size(); i++)
+				{
+					const ImageImportPart &part = result.parts[i];
+					CAGE_TEST(!part.image && part.raw);
+					CAGE_TEST(part.raw->format == "bc7");
+					CAGE_TEST(part.raw->data.size() == expected[i].size());
+					CAGE_TEST(detail::memcmp(part.raw->data.data(), expected[i].data(), expected[i].size()) == 0);
+				}
+			}
+		}
 	}
 
 	void conversions()
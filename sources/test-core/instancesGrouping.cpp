@@ -0,0 +1,204 @@
+#include "main.h"
+
+#include <cage-core/instancesGrouping.h>
+#include <cage-core/timer.h>
+#include <cage-core/math.h>
+
+#include <map>
+#include <vector>
+
+namespace
+{
+	struct MoveOnlyKey
+	{
+		Holder<uint32> ptr; // move-only
+		uint32 shader = 0;
+		uint32 texture = 0;
+
+		auto cmp() const
+		{
+			return std::tuple{ shader, texture, *ptr };
+		}
+
+		bool operator < (const MoveOnlyKey &other) const
+		{
+			return cmp() < other.cmp();
+		}
+
+		bool operator == (const MoveOnlyKey &other) const
+		{
+			return cmp() == other.cmp();
+		}
+	};
+
+	struct MoveOnlyKeyHash
+	{
+		uint64 operator () (const MoveOnlyKey &k) const
+		{
+			return (uint64(k.shader) * 31 + k.texture) * 31 + *k.ptr;
+		}
+	};
+
+	MoveOnlyKey makeKey(uint32 a, uint32 b, uint32 c)
+	{
+		MoveOnlyKey k;
+		k.ptr = systemMemory().createHolder<uint32>(c);
+		k.shader = a;
+		k.texture = b;
+		return k;
+	}
+
+	struct Instance
+	{
+		uint32 value = m;
+		uint32 payload[15] = {};
+	};
+}
+
+void testInstancesGrouping()
+{
+	CAGE_TESTCASE("instances grouping");
+
+	{
+		CAGE_TESTCASE("basics");
+		InstancesGrouping<MoveOnlyKey, uint32, MoveOnlyKeyHash> grouping;
+		CAGE_TEST(grouping.empty());
+		grouping.add(makeKey(2, 1, 1), 10);
+		grouping.add(makeKey(1, 5, 1), 20);
+		grouping.add(makeKey(2, 1, 1), 30);
+		grouping.add(makeKey(1, 5, 0), 40);
+		grouping.add(makeKey(2, 1, 1), 50);
+		CAGE_TEST(grouping.groupsCount() == 3);
+		CAGE_TEST(grouping.instancesCount() == 5);
+		const auto groups = grouping.finish();
+		CAGE_TEST(groups.size() == 3);
+		CAGE_TEST(groups[0].key.shader == 1 && *groups[0].key.ptr == 0);
+		CAGE_TEST(groups[0].instances.size() == 1 && groups[0].instances[0] == 40);
+		CAGE_TEST(groups[1].key.shader == 1 && *groups[1].key.ptr == 1);
+		CAGE_TEST(groups[1].instances.size() == 1 && groups[1].instances[0] == 20);
+		CAGE_TEST(groups[2].key.shader == 2);
+		CAGE_TEST(groups[2].instances.size() == 3);
+		CAGE_TEST(groups[2].instances[0] == 10 && groups[2].instances[1] == 30 && groups[2].instances[2] == 50); // insertion order is preserved within group
+		CAGE_TEST(grouping.result().size() == 3);
+		grouping.clear();
+		CAGE_TEST(grouping.empty());
+		CAGE_TEST(grouping.finish().empty());
+	}
+
+	{
+		CAGE_TESTCASE("randomized against std::map");
+		InstancesGrouping<MoveOnlyKey, uint32, MoveOnlyKeyHash> grouping;
+		for (uint32 round = 0; round < 5; round++)
+		{
+			grouping.clear();
+			std::map<std::tuple<uint32, uint32, uint32>, std::vector<uint32>> expected;
+			const uint32 n = randomRange(0u, 3000u);
+			for (uint32 i = 0; i < n; i++)
+			{
+				const uint32 a = randomRange(0u, 5u), b = randomRange(0u, 5u), c = randomRange(0u, 20u);
+				expected[{ a, b, c }].push_back(i);
+				grouping.add(makeKey(a, b, c), uint32(i));
+			}
+			const auto groups = grouping.finish();
+			CAGE_TEST(groups.size() == expected.size());
+			uint32 i = 0;
+			for (const auto &it : expected)
+			{
+				CAGE_TEST(groups[i].key.cmp() == it.first);
+				CAGE_TEST(groups[i].instances.size() == it.second.size());
+				for (uint32 j = 0; j < it.second.size(); j++)
+					CAGE_TEST(groups[i].instances[j] == it.second[j]);
+				i++;
+			}
+		}
+	}
+
+	{
+		CAGE_TESTCASE("opaque sort key ordering");
+		const auto &key = [](uint32 shader, uint32 flags, uint32 texture, uintPtr mesh) {
+			InstancesSortKey k;
+			k.shader = shader;
+			k.flags = flags;
+			k.textures[0] = texture;
+			k.meshId = mesh;
+			return k;
+		};
+		InstancesGrouping<InstancesSortKey, uint32, InstancesSortKeyHasher> grouping;
+		grouping.add(key(2, 0, 0, 10), 0);
+		grouping.add(key(1, 1, 0, 20), 1);
+		grouping.add(key(1, 0, 5, 30), 2);
+		grouping.add(key(1, 0, 3, 40), 3);
+		grouping.add(key(1, 0, 3, 35), 4);
+		grouping.add(key(1, 0, 3, 40), 5);
+		InstancesSortKey skeletal = key(1, 0, 3, 40);
+		skeletal.skeletal = true;
+		grouping.add(std::move(skeletal), 6);
+		const auto groups = grouping.finish();
+		CAGE_TEST(groups.size() == 6);
+		CAGE_TEST(groups[0].key.meshId == 35); // textures, then meshes
+		CAGE_TEST(groups[1].key.meshId == 40 && !groups[1].key.skeletal);
+		CAGE_TEST(groups[1].instances.size() == 2 && groups[1].instances[0] == 3 && groups[1].instances[1] == 5);
+		CAGE_TEST(groups[2].key.meshId == 40 && groups[2].key.skeletal);
+		CAGE_TEST(groups[3].key.meshId == 30);
+		CAGE_TEST(groups[4].key.meshId == 20); // flags after shader
+		CAGE_TEST(groups[5].key.meshId == 10); // shaders first
+		CAGE_TEST(key(1, 0, 0, 7) == key(2, 3, 4, 7)); // identity by mesh
+		CAGE_TEST(InstancesSortKeyHasher()(key(1, 0, 0, 7)) == InstancesSortKeyHasher()(key(2, 3, 4, 7)));
+	}
+
+	{
+		CAGE_TESTCASE("translucent back-to-front ordering");
+		std::vector<std::pair<Real, uint32>> order = { { 5, 0 }, { 10, 1 }, { 5, 2 }, { 1, 3 }, { 10, 4 } };
+		instancesSortBackToFront(order);
+		const uint32 expected[] = { 1, 4, 0, 2, 3 }; // farther first, equal depths keep their order
+		for (uint32 i = 0; i < 5; i++)
+			CAGE_TEST(order[i].second == expected[i]);
+		instancesSortBackToFront(order); // already sorted
+		for (uint32 i = 0; i < 5; i++)
+			CAGE_TEST(order[i].second == expected[i]);
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 count = 20000;
+#else
+		constexpr uint32 count = 200000;
+#endif
+		constexpr uint32 frames = 10;
+		std::vector<uint32> keys;
+		keys.reserve(count);
+		for (uint32 i = 0; i < count; i++)
+			keys.push_back(randomRange(0u, 300u));
+
+		Holder<Timer> tmr = newTimer();
+		uint64 sum1 = 0;
+		for (uint32 frame = 0; frame < frames; frame++)
+		{
+			std::map<uint32, std::vector<Instance>> map;
+			for (uint32 k : keys)
+				map[k].push_back(Instance{ k });
+			for (const auto &it : map)
+				for (const Instance &inst : it.second)
+					sum1 += inst.value;
+		}
+		const uint64 timeMap = tmr->duration();
+
+		tmr->reset();
+		uint64 sum2 = 0;
+		InstancesGrouping<uint32, Instance> grouping;
+		for (uint32 frame = 0; frame < frames; frame++)
+		{
+			grouping.clear();
+			for (uint32 k : keys)
+				grouping.add(uint32(k), Instance{ k });
+			for (const auto &it : grouping.finish())
+				for (const Instance &inst : it.instances)
+					sum2 += inst.value;
+		}
+		const uint64 timeGrouping = tmr->duration();
+
+		CAGE_TEST(sum1 == sum2);
+		CAGE_LOG(SeverityEnum::Info, "instances grouping performance", Stringizer() + "instances: " + count + ", std::map: " + (timeMap / frames) + " us per frame, grouping: " + (timeGrouping / frames) + " us per frame");
+	}
+}
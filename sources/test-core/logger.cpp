@@ -4,6 +4,28 @@
 #include <cage-core/files.h>
 #include <cage-core/memoryBuffer.h>
 #include <cage-core/string.h>
+#include <cage-core/concurrent.h>
+
+#include <atomic>
+
+namespace
+{
+	std::atomic<bool> gateOpen = true;
+	std::atomic<bool> gateBlocked = false;
+	std::atomic<uint32> gateCount = 0;
+
+	void gateOutput(const String &message)
+	{
+		if (!isPattern(message, "gate ", "", ""))
+			return;
+		gateCount++;
+		while (!gateOpen)
+		{
+			gateBlocked = true;
+			threadSleep(1000);
+		}
+	}
+}
 
 void testLogger()
 {
@@ -23,5 +45,80 @@ void testLogger()
 		f->seek(0);
 		CAGE_TEST(isPattern(f->readLine(), "", "Alea iacta est", ""));
 	}
-}
 
+	{
+		CAGE_TESTCASE("asynchronous logging");
+		MemoryBuffer buff;
+		Holder<File> f = newFileBuffer(Holder<MemoryBuffer>(&buff, nullptr));
+		{
+			Holder<LoggerOutputFile> output = newLoggerOutputFile(f.share());
+			Holder<Logger> logger = newLogger();
+			logger->output.bind<LoggerOutputFile, &LoggerOutputFile::output>(+output);
+			LoggerAsyncConfig cfg;
+			cfg.capacityPerThread = 10;
+			loggerAsyncEnable(cfg);
+			for (uint32 i = 0; i < 100; i++)
+				CAGE_LOG(SeverityEnum::Info, "loggerTest", Stringizer() + "async " + i);
+			loggerAsyncFlush();
+			CAGE_TEST(buff.size() > 0);
+			loggerAsyncDisable();
+		}
+		f->seek(0);
+		uint32 i = 0;
+		String line;
+		while (f->readLine(line))
+			if (isPattern(line, "async ", "", ""))
+				CAGE_TEST(line == String(Stringizer() + "async " + i++));
+		CAGE_TEST(i == 100);
+	}
+
+	{
+		CAGE_TESTCASE("asynchronous logging with dropping");
+		MemoryBuffer buff;
+		Holder<File> f = newFileBuffer(Holder<MemoryBuffer>(&buff, nullptr));
+		{
+			Holder<LoggerOutputFile> output = newLoggerOutputFile(f.share());
+			Holder<Logger> logger = newLogger();
+			logger->output.bind<LoggerOutputFile, &LoggerOutputFile::output>(+output);
+			LoggerAsyncConfig cfg;
+			cfg.capacityPerThread = 10;
+			cfg.overflow = LoggerAsyncOverflowEnum::Drop;
+			loggerAsyncEnable(cfg);
+			for (uint32 i = 0; i < 100; i++)
+				CAGE_LOG(SeverityEnum::Info, "loggerTest", Stringizer() + "async " + i);
+			loggerAsyncDisable();
+		}
+		f->seek(0);
+		uint32 i = 0;
+		String line;
+		while (f->readLine(line))
+			if (isPattern(line, "async ", "", ""))
+				i++;
+		CAGE_TEST(i >= 10 && i <= 100);
+	}
+
+	{
+		CAGE_TESTCASE("asynchronous logging with changed capacity");
+		Holder<Logger> logger = newLogger();
+		logger->output.bind<&gateOutput>();
+		LoggerAsyncConfig cfg;
+		cfg.capacityPerThread = 4;
+		loggerAsyncEnable(cfg);
+		CAGE_LOG(SeverityEnum::Info, "loggerTest", "gate small"); // creates the ring of this thread
+		loggerAsyncDisable();
+		cfg.capacityPerThread = 200;
+		cfg.overflow = LoggerAsyncOverflowEnum::Drop;
+		loggerAsyncEnable(cfg);
+		gateCount = 0;
+		gateOpen = false;
+		gateBlocked = false;
+		CAGE_LOG(SeverityEnum::Info, "loggerTest", "gate first");
+		while (!gateBlocked)
+			threadSleep(1000); // the writer thread is now stuck in the output
+		for (uint32 i = 0; i < 150; i++)
+			CAGE_LOG(SeverityEnum::Info, "loggerTest", Stringizer() + "gate " + i); // must fit into the new ring
+		gateOpen = true;
+		loggerAsyncDisable();
+		CAGE_TEST(gateCount == 151);
+	}
+}
@@ -1,6 +1,11 @@
 #include "main.h"
 
 #include <cage-core/lruCache.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/tasks.h>
+#include <cage-core/timer.h>
+
+#include <atomic>
 
 namespace
 {
@@ -28,6 +33,62 @@ namespace
 		uint32 v;
 		Value(uint32 v = 0) : v(v) {}
 	};
+
+#ifdef CAGE_DEBUG
+	constexpr uint32 LookupsCount = 20000;
+#else
+	constexpr uint32 LookupsCount = 500000;
+#endif
+	constexpr uint32 KeysCount = 2000;
+	constexpr uint32 ThreadsCount = 8;
+
+	struct LockedCacheTester
+	{
+		LruCache<uint32, uint32> cache = LruCache<uint32, uint32>(KeysCount / 2);
+		Holder<Mutex> mutex = newMutex();
+		std::atomic<uint32> hits = 0;
+
+		void operator () (uint32 idx)
+		{
+			uint32 h = 0;
+			for (uint32 i = 0; i < LookupsCount / ThreadsCount; i++)
+			{
+				const uint32 k = (i * 7919 + idx * 104729) % KeysCount;
+				ScopeLock lock(mutex);
+				if (auto v = cache.find(k))
+				{
+					CAGE_TEST(*v == k * 3);
+					h++;
+				}
+				else
+					cache.set(k, k * 3);
+			}
+			hits += h;
+		}
+	};
+
+	struct ShardedCacheTester
+	{
+		ConcurrentLruCache<uint32, uint32> cache = ConcurrentLruCache<uint32, uint32>(ConcurrentLruCacheCreateConfig{ m, KeysCount / 2 });
+		std::atomic<uint32> hits = 0;
+
+		void operator () (uint32 idx)
+		{
+			uint32 h = 0;
+			for (uint32 i = 0; i < LookupsCount / ThreadsCount; i++)
+			{
+				const uint32 k = (i * 7919 + idx * 104729) % KeysCount;
+				if (auto v = cache.find(k))
+				{
+					CAGE_TEST(*v == k * 3);
+					h++;
+				}
+				else
+					cache.set(k, k * 3);
+			}
+			hits += h;
+		}
+	};
 }
 
 void testLruCache()
@@ -162,4 +223,111 @@ void testLruCache()
 		CAGE_TEST(!cache.find(4));
 		CAGE_TEST(cache.find(5));
 	}
+
+	{
+		CAGE_TESTCASE("concurrent basics");
+		ConcurrentLruCache<uint32, uint32> cache;
+		CAGE_TEST(!cache.find(13));
+		CAGE_TEST(cache.set(13, 42) == 42);
+		std::optional<uint32> findResult = cache.find(13);
+		CAGE_TEST(findResult);
+		CAGE_TEST(*findResult == 42);
+		cache.set(13, 43);
+		CAGE_TEST(*cache.find(13) == 43);
+		CAGE_TEST(cache.count() == 1);
+		cache.erase(13);
+		cache.erase(14);
+		CAGE_TEST(!cache.find(13));
+		cache.set(13, 44);
+		cache.set(15, 45);
+		CAGE_TEST(cache.count() == 2);
+		cache.clear();
+		CAGE_TEST(cache.count() == 0);
+		CAGE_TEST(!cache.find(13));
+		CAGE_TEST(*findResult == 42);
+	}
+
+	{
+		CAGE_TESTCASE("concurrent with custom types and holder");
+		ConcurrentLruCache<Key, Value, Hasher> cache;
+		cache.set(13, 42);
+		CAGE_TEST(cache.find(13)->v == 42);
+		ConcurrentLruCache<uint32, Holder<uint32>> holders;
+		CAGE_TEST(!holders.find(13));
+		Holder<uint32> setResult = holders.set(13, systemMemory().createHolder<uint32>(42));
+		CAGE_TEST(setResult && *setResult == 42);
+		Holder<uint32> findResult = holders.find(13);
+		CAGE_TEST(+findResult == +setResult);
+		holders.clear();
+		CAGE_TEST(!holders.find(13));
+		CAGE_TEST(*findResult == 42);
+	}
+
+	{
+		CAGE_TESTCASE("concurrent approximate lru");
+		ConcurrentLruCacheCreateConfig cfg;
+		cfg.shards = 1;
+		cfg.maxItems = 3;
+		ConcurrentLruCache<uint32, uint32> cache(cfg);
+		cache.set(1, 1);
+		cache.set(2, 2);
+		cache.set(3, 3);
+		cache.set(4, 4); // all items were recently used, the first one loses its second chance
+		CAGE_TEST(!cache.find(1));
+		CAGE_TEST(cache.count() == 3);
+		CAGE_TEST(cache.find(2));
+		cache.set(5, 5); // 2 was used since, 3 was not
+		CAGE_TEST(cache.find(2));
+		CAGE_TEST(!cache.find(3));
+		CAGE_TEST(cache.find(4));
+		CAGE_TEST(cache.find(5));
+		CAGE_TEST(cache.count() == 3);
+	}
+
+	{
+		CAGE_TESTCASE("concurrent cost limit");
+		ConcurrentLruCacheCreateConfig cfg;
+		cfg.shards = 1;
+		cfg.maxItems = m;
+		cfg.maxCost = 1000;
+		ConcurrentLruCache<uint32, uint32> cache(cfg);
+		for (uint32 i = 0; i < 10; i++)
+			cache.set(i, i, 100);
+		CAGE_TEST(cache.count() == 10);
+		CAGE_TEST(cache.cost() == 1000);
+		cache.set(10, 10, 350);
+		CAGE_TEST(cache.cost() <= 1000);
+		CAGE_TEST(cache.count() == 7);
+		CAGE_TEST(cache.find(10));
+		cache.set(11, 11, 5000); // larger than whole cache, everything else is evicted
+		CAGE_TEST(cache.count() == 1);
+		CAGE_TEST(cache.find(11));
+		cache.erase(11);
+		CAGE_TEST(cache.cost() == 0);
+	}
+
+	{
+		CAGE_TESTCASE("concurrent limits split among shards");
+		ConcurrentLruCacheCreateConfig cfg;
+		cfg.maxItems = 100;
+		ConcurrentLruCache<uint32, uint32> cache(cfg);
+		for (uint32 i = 0; i < 10000; i++)
+			cache.set(i, i);
+		CAGE_TEST(cache.count() <= 100 + cfg.shards);
+		CAGE_TEST(cache.count() > 50);
+	}
+
+	{
+		CAGE_TESTCASE("concurrent performance");
+		Holder<Timer> tmr = newTimer();
+		LockedCacheTester locked;
+		tasksRunBlocking<LockedCacheTester>("locked cache", locked, ThreadsCount);
+		const uint64 lockedTime = tmr->duration();
+		tmr->reset();
+		ShardedCacheTester sharded;
+		tasksRunBlocking<ShardedCacheTester>("sharded cache", sharded, ThreadsCount);
+		const uint64 shardedTime = tmr->duration();
+		CAGE_TEST(sharded.cache.count() <= KeysCount / 2 + 16);
+		CAGE_LOG(SeverityEnum::Info, "lru cache performance", Stringizer() + "lookups: " + LookupsCount + ", locked: " + lockedTime + " us (hits: " + locked.hits + "), sharded: " + shardedTime + " us (hits: " + sharded.hits + ")");
+	}
 }
@@ -9,6 +9,7 @@ void testExceptions();
 void testNumericTypes();
 void testTypeIndex();
 void testStrings();
+void testHeapString();
 void testPaths();
 void testDelegates();
 void testHolder();
@@ -33,6 +34,8 @@ void testConcurrentQueue();
 void testProfiling();
 void testTasks();
 void testLruCache();
+void testCommandBuffer();
+void testInstancesGrouping();
 void testFlatSet();
 void testFiles();
 void testArchives();
@@ -45,7 +48,9 @@ void testColor();
 void testImage();
 void testNoise();
 void testSpatialStructure();
+void testSpatialCulling();
 void testMesh();
+void testSkeletalAnimation();
 void testMarchingCubes();
 void testSignedDistanceFunctions();
 void testAudio();
@@ -54,6 +59,7 @@ void testColliders();
 void testCollisionStructure();
 void testEntities();
 void testEntitiesSerialization();
+void testEntitiesReplication();
 void testEntitiesVisitor();
 void testEntitiesCopy();
 void testVariableInterpolatingBuffer();
@@ -62,6 +68,7 @@ void testCopyAndMove();
 void testAssetManager();
 void testSwapBufferGuard();
 void testScheduler();
+void testFramePacing();
 void testNetworkTcp();
 void testNetworkWebsocket();
 void testNetworkGinnel();
@@ -84,6 +91,7 @@ int main()
 	testNumericTypes();
 	testTypeIndex();
 	testStrings();
+	testHeapString();
 	testPaths();
 	testDelegates();
 	testHolder();
@@ -108,6 +116,8 @@ int main()
 	testProfiling();
 	testTasks();
 	testLruCache();
+	testCommandBuffer();
+	testInstancesGrouping();
 	testFlatSet();
 	testFiles();
 	testArchives();
@@ -120,7 +130,9 @@ int main()
 	testImage();
 	testNoise();
 	testSpatialStructure();
+	testSpatialCulling();
 	testMesh();
+	testSkeletalAnimation();
 	testMarchingCubes();
 	testSignedDistanceFunctions();
 	testAudio();
@@ -129,6 +141,7 @@ int main()
 	testCollisionStructure();
 	testEntities();
 	testEntitiesSerialization();
+	testEntitiesReplication();
 	testEntitiesVisitor();
 	testEntitiesCopy();
 	testVariableInterpolatingBuffer();
@@ -137,6 +150,7 @@ int main()
 	testAssetManager();
 	testSwapBufferGuard();
 	testScheduler();
+	testFramePacing();
 	testNetworkTcp();
 	testNetworkWebsocket();
 	testNetworkGinnel();
@@ -5,6 +5,7 @@
 #include <cage-core/timer.h>
 #include <cage-core/macros.h>
 #include <cmath>
+#include <vector>
 
 void test(Real a, Real b)
 {
@@ -961,6 +962,21 @@ namespace
 			Mat4 b = inverse(a);
 			constexpr Mat4 c(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, -50, 20, -9, 1);
 			test(b, c);
+
+			// general (non-affine) matrices
+			constexpr Mat4 d(2, 0, 0, 1, 0, 3, 0, 0, 0, 0, 4, 0, 1, 0, 0, 1);
+			test(inverse(d), Mat4(1, 0, 0, -1, 0, 1.0 / 3, 0, 0, 0, 0, 0.25, 0, -1, 0, 0, 2));
+			for (uint32 round = 0; round < 10; round++)
+			{
+				Mat4 e;
+				for (uint32 i = 0; i < 16; i++)
+					e[i] = randomRange(-1, 1);
+				for (uint32 i = 0; i < 4; i++)
+					e[i * 5] += 3; // diagonally dominant, therefore well conditioned
+				test(e * inverse(e), Mat4());
+				test(inverse(e) * e, Mat4());
+				test(inverse(inverse(e)), e);
+			}
 		}
 
 		{
@@ -1310,6 +1326,132 @@ namespace
 			CAGE_LOG(SeverityEnum::Note, "test", Stringizer() + "duration: " + tmr->duration());
 		}
 	}
+
+	Mat4 referenceMultiply(const Mat4 &l, const Mat4 &r)
+	{
+		Mat4 res = Mat4::Zero();
+		for (uint32 x = 0; x < 4; x++)
+			for (uint32 y = 0; y < 4; y++)
+				for (uint32 z = 0; z < 4; z++)
+					res[y * 4 + x] += l[z * 4 + x] * r[y * 4 + z];
+		return res;
+	}
+
+	void testMathBatch()
+	{
+		CAGE_TESTCASE("batch operations");
+
+		{
+			CAGE_TESTCASE("consistency with single operations");
+			for (uint32 round = 0; round < 10; round++)
+			{
+				const Transform t = Transform(randomRange3(-10, 10), randomDirectionQuat(), randomRange(0.5, 2.0));
+				const Mat4 m = Mat4(t);
+				const Mat4 n = Mat4(randomRange3(-10, 10), randomDirectionQuat(), randomRange3(0.5, 2));
+				test(m * n, referenceMultiply(m, n));
+				for (uint32 i = 0; i < 10; i++)
+				{
+					const Vec3 p = randomRange3(-100, 100);
+					test(Vec3(m * Vec4(p, 1)), t * p);
+					const Vec4 v = randomRange4(-100, 100);
+					test(v * m, transpose(m) * v);
+				}
+
+				Vec3 points[17];
+				Vec3 pointsOut[17];
+				for (Vec3 &p : points)
+					p = randomRange3(-100, 100);
+				transformPoints(m, points, pointsOut);
+				for (uint32 i = 0; i < 17; i++)
+					CAGE_TEST(pointsOut[i] == Vec3(m * Vec4(points[i], 1))); // bitwise same as single operation
+				transformPoints(t, points, pointsOut);
+				for (uint32 i = 0; i < 17; i++)
+					test(pointsOut[i], t * points[i]);
+				transformPoints(m, points, points); // in place
+				for (uint32 i = 0; i < 17; i++)
+					test(points[i], pointsOut[i]);
+
+				Vec4 vecs[9];
+				Vec4 vecsOut[9];
+				for (Vec4 &v : vecs)
+					v = randomRange4(-100, 100);
+				transformVectors(m, vecs, vecsOut);
+				for (uint32 i = 0; i < 9; i++)
+					test(vecsOut[i], m * vecs[i]);
+
+				Mat4 mats[5];
+				Mat4 matsOut[5];
+				Transform trs[5];
+				for (uint32 i = 0; i < 5; i++)
+				{
+					trs[i] = Transform(randomRange3(-10, 10), randomDirectionQuat(), randomRange(0.5, 2.0));
+					mats[i] = Mat4(trs[i]);
+				}
+				transformsToMatrices(trs, matsOut);
+				for (uint32 i = 0; i < 5; i++)
+					test(matsOut[i], mats[i]);
+				multiplyMatrices(m, mats, matsOut);
+				for (uint32 i = 0; i < 5; i++)
+					test(matsOut[i], referenceMultiply(m, mats[i]));
+				multiplyMatrices(mats, matsOut, matsOut); // in place
+				for (uint32 i = 0; i < 5; i++)
+					test(matsOut[i], referenceMultiply(mats[i], referenceMultiply(m, mats[i])));
+			}
+			{
+				Vec3 a[3], b[2];
+				CAGE_TEST_THROWN(transformPoints(Mat4(), a, b));
+			}
+		}
+
+		{
+			CAGE_TESTCASE("performance");
+#if defined (CAGE_DEBUG)
+			constexpr uint32 count = 10000;
+#else
+			constexpr uint32 count = 1000000;
+#endif
+			std::vector<Transform> trs;
+			std::vector<Vec3> points;
+			trs.reserve(count);
+			points.reserve(count);
+			for (uint32 i = 0; i < count; i++)
+			{
+				trs.push_back(Transform(randomRange3(-10, 10), randomDirectionQuat(), randomRange(0.5, 2.0)));
+				points.push_back(randomRange3(-100, 100));
+			}
+			std::vector<Mat4> mats, mats2;
+			mats.resize(count);
+			mats2.resize(count);
+			std::vector<Vec3> points2;
+			points2.resize(count);
+			const Mat4 vp = Mat4(trs[0]);
+
+			Holder<Timer> tmr = newTimer();
+			for (uint32 i = 0; i < count; i++)
+				mats[i] = Mat4(trs[i]);
+			const uint64 singleConvert = tmr->duration();
+			tmr->reset();
+			transformsToMatrices(trs, mats2);
+			const uint64 batchConvert = tmr->duration();
+			tmr->reset();
+			for (uint32 i = 0; i < count; i++)
+				mats2[i] = referenceMultiply(vp, mats[i]);
+			const uint64 referenceMul = tmr->duration();
+			tmr->reset();
+			multiplyMatrices(vp, mats, mats);
+			const uint64 batchMul = tmr->duration();
+			for (uint32 i = 0; i < count; i += count / 100)
+				test(mats[i], mats2[i]);
+			tmr->reset();
+			for (uint32 i = 0; i < count; i++)
+				points2[i] = trs[0] * points[i];
+			const uint64 singlePoints = tmr->duration();
+			tmr->reset();
+			transformPoints(vp, points, points);
+			const uint64 batchPoints = tmr->duration();
+			CAGE_LOG(SeverityEnum::Info, "test", Stringizer() + "count: " + count + ", transform to matrix single: " + singleConvert + " us, batch: " + batchConvert + " us; matrix multiplication reference: " + referenceMul + " us, batch: " + batchMul + " us; points single: " + singlePoints + " us, batch: " + batchPoints + " us");
+		}
+	}
 }
 
 void testMath()
@@ -1331,5 +1473,6 @@ void testMath()
 	testMathFunctions();
 	testMathStrings();
 	testMathMatrixMultiplication();
+	testMathBatch();
 }
 
@@ -5,6 +5,7 @@
 #include <cage-core/concurrent.h>
 #include <cage-core/math.h>
 #include <cage-core/memoryBuffer.h>
+#include <cage-core/random.h>
 #include <vector>
 #include <algorithm>
 #include <atomic>
@@ -123,12 +124,121 @@ namespace
 				threadSleep(5000);
 		}
 	};
+
+	GinnelSimulatorStatistics runSimulated(const GinnelSimulatorCreateConfig &config)
+	{
+		Holder<GinnelSimulator> sim = newGinnelSimulator(config);
+		Holder<GinnelServer> server = newGinnelServer(3210, +sim);
+		std::vector<Holder<GinnelConnection>> serverConns;
+
+		struct Client
+		{
+			Holder<GinnelConnection> conn;
+			std::vector<MemoryBuffer> sends;
+			uint32 si = 0, ri = 0;
+		};
+		std::vector<Client> clients;
+		clients.resize(3);
+		RandomGenerator rng(config.seed, 42);
+		for (Client &c : clients)
+		{
+			for (uint32 i = 0; i < 10; i++)
+			{
+				MemoryBuffer b(rng.randomRange(100u, 5000u));
+				for (uint32 j = 0; j < b.size(); j++)
+					b.data()[j] = (char)rng.randomRange(0u, 256u);
+				c.sends.push_back(std::move(b));
+			}
+			c.conn = newGinnelConnection("", 3210, 0, +sim);
+		}
+
+		for (uint32 step = 0; step < 20000; step++)
+		{
+			while (auto c = server->accept())
+				serverConns.push_back(std::move(c));
+			for (auto &c : serverConns)
+			{
+				while (c->available())
+				{
+					uint32 ch;
+					bool r;
+					Holder<PointerRange<char>> b = c->read(ch, r);
+					c->write(b, ch, r);
+				}
+				c->update();
+			}
+			bool done = true;
+			for (Client &c : clients)
+			{
+				while (c.conn->available())
+				{
+					Holder<PointerRange<char>> r = c.conn->read();
+					const MemoryBuffer &b = c.sends[c.ri++];
+					CAGE_TEST(r.size() == b.size());
+					CAGE_TEST(detail::memcmp(r.data(), b.data(), b.size()) == 0);
+				}
+				if (c.si < c.ri + 2 && c.si < c.sends.size())
+					c.conn->write(c.sends[c.si++], 13, true);
+				c.conn->update();
+				done &= c.ri == c.sends.size();
+			}
+			if (done)
+				break;
+			sim->advance(5000);
+		}
+		for (const Client &c : clients)
+			CAGE_TEST(c.ri == c.sends.size());
+		CAGE_TEST(serverConns.size() == clients.size());
+		return sim->statistics();
+	}
 }
 
 void testNetworkGinnel()
 {
 	CAGE_TESTCASE("network ginnel");
 
+	{
+		CAGE_TESTCASE("simulated impairments");
+		GinnelSimulatorCreateConfig cfg;
+		cfg.seed = 13;
+		cfg.latency = 20000;
+		cfg.jitter = 10000;
+		cfg.bandwidth = 500000;
+		cfg.packetLoss = 0.1;
+		cfg.duplication = 0.05;
+		cfg.reordering = 0.05;
+		cfg.manualTime = true;
+		const GinnelSimulatorStatistics a = runSimulated(cfg);
+		CAGE_TEST(a.packetsLost > 0);
+		CAGE_TEST(a.packetsDuplicated > 0);
+		CAGE_TEST(a.packetsReordered > 0);
+		CAGE_TEST(a.packetsDelivered > 0);
+		const GinnelSimulatorStatistics b = runSimulated(cfg); // deterministic
+		CAGE_TEST(a.packetsSent == b.packetsSent);
+		CAGE_TEST(a.bytesDelivered == b.bytesDelivered);
+		CAGE_TEST(a.packetsLost == b.packetsLost);
+		configSetFloat("cage/ginnel/simulatedPacketLoss", 0.3f); // must not affect the simulator
+		const GinnelSimulatorStatistics c = runSimulated(cfg);
+		configSetFloat("cage/ginnel/simulatedPacketLoss", 0);
+		CAGE_TEST(a.packetsSent == c.packetsSent);
+		CAGE_TEST(a.bytesDelivered == c.bytesDelivered);
+		CAGE_TEST(a.packetsLost == c.packetsLost);
+	}
+
+	{
+		CAGE_TESTCASE("simulated bandwidth limit");
+		GinnelSimulatorCreateConfig cfg;
+		cfg.seed = 42;
+		cfg.latency = 5000;
+		cfg.bandwidth = 50000;
+		cfg.queueDuration = 20000;
+		cfg.manualTime = true;
+		const GinnelSimulatorStatistics a = runSimulated(cfg);
+		CAGE_TEST(a.packetsLost == 0);
+	}
+
+	CAGE_TESTCASE("real network");
+
 	configSetUint32("cage/udp/logLevel", 2);
 	configSetFloat("cage/udp/simulatedPacketLoss", 0.1f);
 
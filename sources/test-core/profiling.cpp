@@ -2,7 +2,18 @@
 
 #include <cage-core/profiling.h>
 #include <cage-core/config.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/logger.h>
+#include <cage-core/files.h>
+#include <cage-core/networkWebsocket.h>
+#include <cage-core/string.h>
 #include <atomic>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <map>
+#include <set>
+#include <cctype>
 
 namespace
 {
@@ -12,6 +23,175 @@ namespace
 		for (uint32 i = 0; i < 1000; i++)
 			v += i;
 	}
+
+#ifdef CAGE_PROFILING_ENABLED
+	constexpr uint32 TimestampsPerThread = 10000;
+	std::vector<uint64> timestamps[4];
+
+	void timestampsThread(uint32 index)
+	{
+		std::vector<uint64> &ts = timestamps[index];
+		ts.reserve(TimestampsPerThread);
+		for (uint32 i = 0; i < TimestampsPerThread; i++)
+		{
+			auto evt = profilingEventBegin("timestamps test");
+			ts.push_back(evt.startTime);
+			profilingEventEnd(evt);
+		}
+	}
+
+	void timestampsThread0() { timestampsThread(0); }
+	void timestampsThread1() { timestampsThread(1); }
+	void timestampsThread2() { timestampsThread(2); }
+	void timestampsThread3() { timestampsThread(3); }
+
+	// the dispatcher reports through the log
+	struct LogCapture
+	{
+		Holder<Mutex> mutex = newMutex();
+		uint16 serverPort = 0;
+		uint32 droppedEvents = 0;
+
+		bool filter(const detail::LoggerInfo &info)
+		{
+			if (String(info.component) != "profiling")
+				return false;
+			ScopeLock lock(mutex);
+			String msg = info.message;
+			if (isPattern(msg, "profiling server listens on port ", "", ""))
+				serverPort = toUint32(subString(msg, 33, m));
+			if (isPattern(msg, "dropped ", "", "profiling events in thread: profiling drops"))
+			{
+				split(msg);
+				droppedEvents += toUint32(split(msg));
+			}
+			return false;
+		}
+	};
+
+	constexpr uint32 TraceEventsPerThread = 100;
+	constexpr uint32 DropsEvents = 100000;
+
+	void traceThread()
+	{
+		for (uint32 i = 0; i < TraceEventsPerThread; i++)
+		{
+			ProfilingScope profiling("trace event");
+			profiling.set(Stringizer() + "quote \" and \\ backslash " + i);
+		}
+	}
+
+	void dropsThread()
+	{
+		for (uint32 i = 0; i < DropsEvents; i++)
+			ProfilingScope profiling("drop event");
+	}
+
+	// value of a key in a single json object written on one line
+	std::string jsonField(const std::string &line, const std::string &key)
+	{
+		const std::string k = "\"" + key + "\":";
+		auto p = line.find(k);
+		if (p == std::string::npos)
+			return {};
+		p += k.size();
+		std::string r;
+		if (line[p] != '"')
+		{
+			while (p < line.size() && line[p] != ',' && line[p] != '}')
+				r += line[p++];
+			return r;
+		}
+		p++;
+		while (p < line.size() && line[p] != '"')
+		{
+			if (line[p] == '\\')
+				p++;
+			r += line[p++];
+		}
+		return r;
+	}
+
+	std::vector<std::string> lines(const std::string &s)
+	{
+		std::vector<std::string> r;
+		std::string::size_type a = 0;
+		while (a < s.size())
+		{
+			auto b = s.find('\n', a);
+			if (b == std::string::npos)
+				b = s.size();
+			r.push_back(s.substr(a, b - a));
+			a = b + 1;
+		}
+		return r;
+	}
+
+	void startTraceFile(const String &path)
+	{
+		if (pathIsFile(path))
+			pathRemove(path);
+		configSetString("cage/profiling/traceFile", path);
+		configSetBool("cage/profiling/enabled", true);
+		{
+			ProfilingScope profiling("start trace file");
+		}
+		for (uint32 attempt = 0; attempt < 500 && !pathIsFile(path); attempt++)
+			threadSleep(10000);
+		CAGE_TEST(pathIsFile(path)); // the dispatcher has opened the file
+	}
+
+	// disabling the profiling flushes the pending events and closes the trace file
+	std::string finishTraceFile(const String &path)
+	{
+		configSetBool("cage/profiling/enabled", false);
+		for (uint32 attempt = 0; attempt < 500; attempt++)
+		{
+			threadSleep(10000);
+			if (!pathIsFile(path))
+				continue;
+			Holder<File> f = readFile(path);
+			if (f->size() < 2)
+				continue;
+			auto buf = f->readAll();
+			std::string str(buf->data(), buf->size());
+			if (str.substr(str.size() - 2) == "]\n")
+				return str;
+		}
+		CAGE_TEST(false); // the trace file was not closed in time
+		return {};
+	}
+
+	// names array and indices of events (by their data) from one message sent to the live client
+	bool parseClientMessage(const std::string &msg, std::vector<std::string> &names, std::map<std::string, uint32> &events)
+	{
+		names.clear();
+		events.clear();
+		const std::string prefix = "{\"names\":[";
+		if (msg.compare(0, prefix.size(), prefix) != 0)
+			return false;
+		std::string::size_type p = prefix.size();
+		while (msg[p] == '"')
+		{
+			const auto e = msg.find('"', p + 1);
+			names.push_back(msg.substr(p + 1, e - p - 1));
+			p = msg.find_first_not_of(", \n", e + 1);
+		}
+		// events are [nameIndex,"data",start,duration]
+		while ((p = msg.find("[", p)) != std::string::npos)
+		{
+			p++;
+			if (!std::isdigit(msg[p]))
+				continue;
+			const auto comma = msg.find(',', p);
+			if (comma == std::string::npos || msg[comma + 1] != '"')
+				continue;
+			const auto e = msg.find('"', comma + 2);
+			events[msg.substr(comma + 2, e - comma - 2)] = std::stoul(msg.substr(p, comma - p));
+		}
+		return true;
+	}
+#endif // CAGE_PROFILING_ENABLED
 }
 
 void testProfiling()
@@ -24,13 +204,6 @@ void testProfiling()
 	CAGE_LOG(SeverityEnum::Info, "test", "profiling was disabled at compile time");
 #endif // CAGE_PROFILING_ENABLED
 
-	{
-		// this causes warnings in thread sanitizer, we will keep the profiler disabled and test the interface only
-		//CAGE_TESTCASE("enabling profiling in configuration");
-		//configSetBool("cage/profiling/autoStartClient", false);
-		//configSetBool("cage/profiling/enabled", true);
-	}
-
 	{
 		CAGE_TESTCASE("scope");
 		ProfilingScope profiling("scoped test");
@@ -45,4 +218,159 @@ void testProfiling()
 		someMeaninglessWork();
 		profilingEventEnd(evt);
 	}
+
+#ifdef CAGE_PROFILING_ENABLED
+	{
+		CAGE_TESTCASE("timestamps are ordered and globally unique");
+		{
+			Holder<Thread> thrs[4];
+			thrs[0] = newThread(Delegate<void()>().bind<&timestampsThread0>(), "profiling timestamps 0");
+			thrs[1] = newThread(Delegate<void()>().bind<&timestampsThread1>(), "profiling timestamps 1");
+			thrs[2] = newThread(Delegate<void()>().bind<&timestampsThread2>(), "profiling timestamps 2");
+			thrs[3] = newThread(Delegate<void()>().bind<&timestampsThread3>(), "profiling timestamps 3");
+			for (auto &t : thrs)
+				t->wait();
+		}
+		std::vector<uint64> all;
+		for (const auto &ts : timestamps)
+		{
+			CAGE_TEST(ts.size() == TimestampsPerThread);
+			for (uint32 i = 1; i < ts.size(); i++)
+				CAGE_TEST(ts[i] > ts[i - 1]);
+			all.insert(all.end(), ts.begin(), ts.end());
+		}
+		std::sort(all.begin(), all.end());
+		CAGE_TEST(std::adjacent_find(all.begin(), all.end()) == all.end());
+	}
+
+	LogCapture capture;
+	Holder<Logger> logger = newLogger();
+	logger->filter.bind<LogCapture, &LogCapture::filter>(&capture);
+	configSetBool("cage/profiling/autoStartClient", false);
+
+	{
+		CAGE_TESTCASE("names are interned in messages for the live client");
+		static constexpr const char nameA[] = "interned name";
+		static constexpr const char nameB[] = "interned name"; // same text, different address
+		CAGE_TEST((const char *)nameA != (const char *)nameB);
+		configSetString("cage/profiling/traceFile", "");
+		configSetBool("cage/profiling/enabled", true);
+		{
+			ProfilingScope profiling("start dispatcher");
+		}
+		uint16 port = 0;
+		for (uint32 attempt = 0; attempt < 500 && !port; attempt++)
+		{
+			threadSleep(10000);
+			ScopeLock lock(capture.mutex);
+			port = capture.serverPort;
+		}
+		CAGE_TEST(port != 0);
+		Holder<WebsocketConnection> conn = newWebsocketConnection("localhost", port);
+		bool found = false;
+		for (uint32 attempt = 0; attempt < 50 && !found; attempt++)
+		{
+			{
+				ProfilingScope profiling(nameA);
+				profiling.set("intern a");
+			}
+			{
+				ProfilingScope profiling(nameB);
+				profiling.set("intern b");
+			}
+			{
+				ProfilingScope profiling("other name");
+				profiling.set("intern c");
+			}
+			for (uint32 wait = 0; wait < 20 && !found; wait++)
+			{
+				threadSleep(10000);
+				if (conn->size() == 0)
+					continue;
+				auto buf = conn->readAll();
+				std::vector<std::string> names;
+				std::map<std::string, uint32> events;
+				if (!parseClientMessage(std::string(buf->data(), buf->size()), names, events))
+					continue;
+				if (!events.count("intern a") || !events.count("intern b") || !events.count("intern c"))
+					continue;
+				found = true;
+				const uint32 a = events["intern a"], b = events["intern b"], c = events["intern c"];
+				CAGE_TEST(a == b);
+				CAGE_TEST(a != c);
+				CAGE_TEST(a < names.size() && names[a] == "interned name");
+				CAGE_TEST(c < names.size() && names[c] == "other name");
+				const std::set<std::string> unique(names.begin(), names.end());
+				CAGE_TEST(unique.size() == names.size());
+			}
+		}
+		CAGE_TEST(found);
+		configSetBool("cage/profiling/enabled", false);
+		conn.clear();
+	}
+
+	{
+		CAGE_TESTCASE("trace file with events from multiple threads");
+		const String path = pathToAbs("testdir/profiling/trace.json");
+		pathCreateDirectories(pathExtractDirectory(path));
+		startTraceFile(path);
+		{
+			Holder<Thread> thrs[2];
+			thrs[0] = newThread(Delegate<void()>().bind<&traceThread>(), "profiling trace 0");
+			thrs[1] = newThread(Delegate<void()>().bind<&traceThread>(), "profiling trace 1");
+			for (auto &t : thrs)
+				t->wait();
+		}
+		const std::string str = finishTraceFile(path);
+		const std::vector<std::string> ls = lines(str);
+		CAGE_TEST(ls.size() > 2);
+		CAGE_TEST(ls.front() == "[");
+		CAGE_TEST(ls.back() == "]");
+		std::map<std::string, std::string> threadNames; // tid -> name
+		std::map<std::string, std::vector<std::string>> datas; // tid -> datas of trace events
+		for (const std::string &l : ls)
+		{
+			if (jsonField(l, "ph") == "M" && jsonField(l, "name") == "thread_name")
+				threadNames[jsonField(l, "tid")] = jsonField(l, "args\":{\"name");
+			if (jsonField(l, "ph") == "X" && jsonField(l, "name") == "trace event")
+			{
+				CAGE_TEST(!jsonField(l, "ts").empty());
+				CAGE_TEST(!jsonField(l, "dur").empty());
+				datas[jsonField(l, "tid")].push_back(jsonField(l, "args\":{\"data"));
+			}
+		}
+		CAGE_TEST(datas.size() == 2);
+		std::set<std::string> seenThreads;
+		for (const auto &it : datas)
+		{
+			seenThreads.insert(threadNames[it.first]);
+			CAGE_TEST(it.second.size() == TraceEventsPerThread); // ring of each thread is drained completely
+			for (uint32 i = 0; i < TraceEventsPerThread; i++)
+				CAGE_TEST(it.second[i] == std::string("quote \" and \\ backslash ") + std::to_string(i)); // in order and unescaped
+		}
+		CAGE_TEST(seenThreads == std::set<std::string>({ "profiling trace 0", "profiling trace 1" }));
+	}
+
+	{
+		CAGE_TESTCASE("events overflowing the ring are counted as dropped");
+		const String path = pathToAbs("testdir/profiling/drops.json");
+		startTraceFile(path);
+		{
+			ScopeLock lock(capture.mutex);
+			capture.droppedEvents = 0;
+		}
+		newThread(Delegate<void()>().bind<&dropsThread>(), "profiling drops")->wait();
+		const std::string str = finishTraceFile(path);
+		uint32 written = 0;
+		for (const std::string &l : lines(str))
+			if (jsonField(l, "ph") == "X" && jsonField(l, "name") == "drop event")
+				written++;
+		ScopeLock lock(capture.mutex);
+		CAGE_TEST(capture.droppedEvents > 0);
+		CAGE_TEST(written > 0);
+		CAGE_TEST(written + capture.droppedEvents == DropsEvents);
+	}
+
+	configSetString("cage/profiling/traceFile", "");
+#endif // CAGE_PROFILING_ENABLED
 }
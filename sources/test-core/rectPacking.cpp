@@ -2,23 +2,292 @@
 
 #include <cage-core/math.h>
 #include <cage-core/rectPacking.h>
+#include <cage-core/timer.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	void checkDynamic(const DynamicRectPacking *rp, const std::vector<uint32> &ids, uint32 size, uint32 margin)
+	{
+		CAGE_TEST(rp->count() == ids.size());
+		std::vector<PackingRect> rs;
+		for (uint32 id : ids)
+		{
+			CAGE_TEST(rp->has(id));
+			const PackingRect r = rp->get(id);
+			CAGE_TEST(r.id == id);
+			CAGE_TEST(r.x >= margin && r.y >= margin);
+			CAGE_TEST(r.x + r.width + margin <= size && r.y + r.height + margin <= size);
+			rs.push_back(r);
+		}
+		for (uint32 i = 0; i < rs.size(); i++)
+		{
+			for (uint32 j = i + 1; j < rs.size(); j++)
+			{
+				const PackingRect &a = rs[i];
+				const PackingRect &b = rs[j];
+				const bool separate = a.x + a.width + margin * 2 <= b.x || b.x + b.width + margin * 2 <= a.x || a.y + a.height + margin * 2 <= b.y || b.y + b.height + margin * 2 <= a.y;
+				CAGE_TEST(separate);
+			}
+		}
+	}
+}
 
 void testRectPacking()
 {
 	CAGE_TESTCASE("rect packing");
 
-	Holder<RectPacking> rp = newRectPacking();
-	rp->resize(10);
-	for (uint32 i = 0; i < 10; i++)
-		rp->data()[i] = PackingRect{ i, (uint32)randomRange(10, 30), (uint32)randomRange(10, 30) };
-	RectPackingSolveConfig cfg;
-	cfg.margin = 2;
-	cfg.width = cfg.height = 30;
-	CAGE_TEST(!rp->solve(cfg)); // not enough space
-	cfg.width = 130;
-	cfg.height = 100;
-	CAGE_TEST(rp->solve(cfg)); // always enough
-	CAGE_TEST(rp->data().size() == 10);
-	for (const auto &it : rp->data())
-		CAGE_TEST(it.x <= 120 && it.y <= 90);
+	{
+		CAGE_TESTCASE("static");
+		Holder<RectPacking> rp = newRectPacking();
+		rp->resize(10);
+		for (uint32 i = 0; i < 10; i++)
+			rp->data()[i] = PackingRect{ i, (uint32)randomRange(10, 30), (uint32)randomRange(10, 30) };
+		RectPackingSolveConfig cfg;
+		cfg.margin = 2;
+		cfg.width = cfg.height = 30;
+		CAGE_TEST(!rp->solve(cfg)); // not enough space
+		cfg.width = 130;
+		cfg.height = 100;
+		CAGE_TEST(rp->solve(cfg)); // always enough
+		CAGE_TEST(rp->data().size() == 10);
+		for (const auto &it : rp->data())
+			CAGE_TEST(it.x <= 120 && it.y <= 90);
+	}
+
+	{
+		CAGE_TESTCASE("dynamic insert and remove");
+		DynamicRectPackingCreateConfig cfg;
+		cfg.width = cfg.height = 256;
+		cfg.margin = 1;
+		Holder<DynamicRectPacking> rp = newDynamicRectPacking(cfg);
+		CAGE_TEST(rp->count() == 0);
+		CAGE_TEST(rp->freeRectsCount() == 1);
+		CAGE_TEST(rp->occupancy() == 0);
+		std::vector<uint32> ids;
+		uint32 next = 0;
+		while (true)
+		{
+			PackingRect r{ next, (uint32)randomRange(4, 40), (uint32)randomRange(4, 40) };
+			if (!rp->insert(r))
+				break;
+			ids.push_back(next++);
+		}
+		CAGE_TEST(ids.size() > 10);
+		checkDynamic(+rp, ids, 256, 1);
+		CAGE_TEST(rp->occupancy() > 0.5 && rp->occupancy() <= 1);
+		{
+			PackingRect r{ ids[0], 1, 1 };
+			CAGE_TEST_THROWN(rp->insert(r)); // duplicate id
+		}
+		CAGE_TEST_THROWN(rp->remove(next + 100));
+		CAGE_TEST_THROWN(rp->get(next + 100));
+		{
+			PackingRect r{ next, 300, 10 };
+			CAGE_TEST(!rp->insert(r)); // larger than the whole area
+			CAGE_TEST(!rp->has(next));
+		}
+
+		for (uint32 round = 0; round < 20; round++)
+		{
+			for (uint32 i = 0; i < 5 && !ids.empty(); i++)
+			{
+				const uint32 k = randomRange(0u, numeric_cast<uint32>(ids.size()));
+				rp->remove(ids[k]);
+				CAGE_TEST(!rp->has(ids[k]));
+				ids.erase(ids.begin() + k);
+			}
+			for (uint32 i = 0; i < 5; i++)
+			{
+				PackingRect r{ next, (uint32)randomRange(4, 40), (uint32)randomRange(4, 40) };
+				if (rp->insert(r))
+					ids.push_back(next);
+				next++;
+			}
+			checkDynamic(+rp, ids, 256, 1);
+		}
+
+		const Real before = rp->occupancy();
+		for (uint32 id : ids)
+			rp->remove(id);
+		CAGE_TEST(before > 0);
+		CAGE_TEST(rp->count() == 0);
+		CAGE_TEST(rp->occupancy() == 0);
+		CAGE_TEST(rp->freeRectsCount() == 1);
+		PackingRect r{ 1, 254, 254 };
+		CAGE_TEST(rp->insert(r)); // the whole area is available again
+		CAGE_TEST(r.x == 1 && r.y == 1);
+		CAGE_TEST(rp->occupancy() == 1);
+		rp->clear();
+		CAGE_TEST(rp->count() == 0);
+		CAGE_TEST(rp->occupancy() == 0);
+	}
+
+	{
+		CAGE_TESTCASE("dynamic coalescing");
+		DynamicRectPackingCreateConfig cfg;
+		cfg.width = 64;
+		cfg.height = 64;
+		Holder<DynamicRectPacking> rp = newDynamicRectPacking(cfg);
+		for (uint32 i = 0; i < 16; i++)
+		{
+			PackingRect r{ i, 16, 16 };
+			CAGE_TEST(rp->insert(r));
+		}
+		CAGE_TEST(rp->occupancy() == 1);
+		CAGE_TEST(rp->freeRectsCount() == 0);
+		// free a vertical strip of four cells, it should merge into one rectangle
+		const uint32 x = rp->get(0).x;
+		std::vector<uint32> column;
+		for (uint32 i = 0; i < 16; i++)
+			if (rp->get(i).x == x)
+				column.push_back(i);
+		CAGE_TEST(column.size() == 4);
+		for (uint32 i : column)
+			rp->remove(i);
+		CAGE_TEST(rp->freeRectsCount() == 1);
+		PackingRect r{ 100, 16, 64 };
+		CAGE_TEST(rp->insert(r));
+		CAGE_TEST(r.x == x && r.y == 0);
+	}
+
+	{
+		CAGE_TESTCASE("dynamic defragment");
+		DynamicRectPackingCreateConfig cfg;
+		cfg.width = cfg.height = 200;
+		cfg.margin = 2;
+		Holder<DynamicRectPacking> rp = newDynamicRectPacking(cfg);
+		std::vector<uint32> ids;
+		for (uint32 i = 0; i < 200; i++)
+		{
+			PackingRect r{ i, (uint32)randomRange(3, 20), (uint32)randomRange(3, 20) };
+			if (rp->insert(r))
+				ids.push_back(i);
+		}
+		// remove every other to fragment the free space
+		std::vector<uint32> kept;
+		for (uint32 i = 0; i < ids.size(); i++)
+		{
+			if (i % 2)
+				rp->remove(ids[i]);
+			else
+				kept.push_back(ids[i]);
+		}
+		const Real occ = rp->occupancy();
+		std::vector<PackingRect> before;
+		for (uint32 id : kept)
+			before.push_back(rp->get(id));
+		Holder<PointerRange<PackingRect>> moved;
+		CAGE_TEST(rp->defragment(moved));
+		checkDynamic(+rp, kept, 200, 2);
+		CAGE_TEST(abs(rp->occupancy() - occ) < 1e-5);
+		for (const PackingRect &b : before)
+		{
+			const PackingRect a = rp->get(b.id);
+			CAGE_TEST(a.width == b.width && a.height == b.height);
+			const bool reported = std::any_of(moved.begin(), moved.end(), [&](const PackingRect &m) { return m.id == b.id; });
+			CAGE_TEST(reported == (a.x != b.x || a.y != b.y));
+		}
+		for (const PackingRect &m : moved)
+		{
+			const PackingRect a = rp->get(m.id);
+			CAGE_TEST(a.x == m.x && a.y == m.y);
+		}
+		CAGE_TEST(rp->freeRectsCount() <= kept.size() * 2 + 1);
+		Holder<PointerRange<PackingRect>> again;
+		CAGE_TEST(rp->defragment(again));
+		CAGE_TEST(again && again.size() == 0); // nothing moved
+	}
+
+	{
+		CAGE_TESTCASE("dynamic defragment that does not fit");
+		DynamicRectPackingCreateConfig cfg;
+		cfg.width = cfg.height = 8;
+		Holder<DynamicRectPacking> rp = newDynamicRectPacking(cfg);
+		// fits when inserted in this order, but not when repacked by decreasing height
+		const uint32 sizes[5][2] = { { 5, 1 }, { 1, 3 }, { 3, 1 }, { 3, 5 }, { 1, 5 } };
+		std::vector<PackingRect> before;
+		for (uint32 i = 0; i < 5; i++)
+		{
+			PackingRect r{ i, sizes[i][0], sizes[i][1] };
+			CAGE_TEST(rp->insert(r));
+			before.push_back(r);
+		}
+		const uint32 frees = rp->freeRectsCount();
+		Holder<PointerRange<PackingRect>> moved;
+		CAGE_TEST(!rp->defragment(moved));
+		CAGE_TEST(!moved);
+		for (const PackingRect &b : before)
+		{
+			const PackingRect a = rp->get(b.id);
+			CAGE_TEST(a.x == b.x && a.y == b.y); // unchanged
+		}
+		CAGE_TEST(rp->freeRectsCount() == frees);
+	}
+
+	{
+		CAGE_TESTCASE("dynamic zero area rectangles");
+		DynamicRectPackingCreateConfig cfg;
+		cfg.width = cfg.height = 64;
+		Holder<DynamicRectPacking> rp = newDynamicRectPacking(cfg);
+		PackingRect a{ 1, 16, 16 };
+		CAGE_TEST(rp->insert(a));
+		const uint32 frees = rp->freeRectsCount();
+		const Real occ = rp->occupancy();
+		PackingRect z{ 2, 0, 10 };
+		CAGE_TEST(rp->insert(z));
+		CAGE_TEST(rp->has(2));
+		CAGE_TEST(rp->freeRectsCount() == frees);
+		rp->remove(2);
+		CAGE_TEST(rp->freeRectsCount() == frees); // no degenerate free rectangle
+		CAGE_TEST(rp->occupancy() == occ);
+		rp->remove(1);
+		CAGE_TEST(rp->freeRectsCount() == 1);
+	}
+
+	{
+		CAGE_TESTCASE("dynamic churn performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 operations = 20000;
+#else
+		constexpr uint32 operations = 200000;
+#endif
+		DynamicRectPackingCreateConfig cfg;
+		cfg.width = cfg.height = 2048;
+		cfg.margin = 1;
+		Holder<DynamicRectPacking> rp = newDynamicRectPacking(cfg);
+		std::vector<uint32> ids;
+		uint32 next = 0, failed = 0;
+		Holder<Timer> tmr = newTimer();
+		for (uint32 i = 0; i < operations; i++)
+		{
+			if (ids.size() > 1000 || (!ids.empty() && randomChance() < 0.4))
+			{
+				const uint32 k = randomRange(0u, numeric_cast<uint32>(ids.size()));
+				rp->remove(ids[k]);
+				std::swap(ids[k], ids.back());
+				ids.pop_back();
+			}
+			else
+			{
+				PackingRect r{ next, (uint32)randomRange(8, 64), (uint32)randomRange(8, 64) };
+				if (rp->insert(r))
+					ids.push_back(next);
+				else
+					failed++;
+				next++;
+			}
+		}
+		const uint64 timeChurn = tmr->duration();
+		const uint32 fragments = rp->freeRectsCount();
+		const Real occ = rp->occupancy();
+		tmr->reset();
+		Holder<PointerRange<PackingRect>> movedRects;
+		CAGE_TEST(rp->defragment(movedRects));
+		const uint32 moved = numeric_cast<uint32>(movedRects.size());
+		const uint64 timeDefrag = tmr->duration();
+		CAGE_LOG(SeverityEnum::Info, "rect packing performance", Stringizer() + "operations: " + operations + ", churn: " + timeChurn + " us, failed inserts: " + failed + ", occupancy: " + occ + ", free rects: " + fragments + "; defragment: " + timeDefrag + " us, moved: " + moved + ", free rects: " + rp->freeRectsCount());
+	}
 }
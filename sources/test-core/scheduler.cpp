@@ -3,6 +3,9 @@
 #include <cage-core/scheduler.h>
 #include <cage-core/math.h> // randomRange
 #include <cage-core/concurrent.h> // threadSleep
+#include <cage-core/timer.h>
+
+#include <vector>
 
 namespace
 {
@@ -45,6 +48,44 @@ namespace
 	{
 		s->lockstep(false);
 	}
+
+	void sleep50(uint32 *ptr)
+	{
+		(*ptr)++;
+		threadSleep(50000);
+	}
+
+	void sleep10(uint32 *ptr)
+	{
+		(*ptr)++;
+		threadSleep(10000);
+	}
+
+	struct OrderRecorder
+	{
+		std::vector<uint32> order;
+		std::vector<uint64> threads;
+		uint32 index = 0;
+
+		void record(uint32 i)
+		{
+			order.push_back(i);
+			threads.push_back(currentThreadId());
+		}
+	};
+
+	OrderRecorder *orderRecorder = nullptr;
+
+	template<uint32 I>
+	void recordOrder()
+	{
+		orderRecorder->record(I);
+	}
+
+	void throwing()
+	{
+		CAGE_THROW_ERROR(Exception, "intentional exception in schedule");
+	}
 }
 
 void testScheduler()
@@ -593,4 +634,217 @@ void testScheduler()
 			a->detach();
 		}
 	}
+
+	{
+		CAGE_TESTCASE("threaded scheduler with independent slow schedule");
+		SchedulerCreateConfig sc;
+		sc.threaded = true;
+		Holder<Scheduler> sch = newScheduler(sc);
+		uint32 cntSlow = 0, cntFast = 0;
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::SteadyPeriodic;
+			c.action.bind<uint32 *, &sleep50>(&cntSlow);
+			c.name = "slow independent";
+			c.period = 60000;
+			c.independent = true;
+			sch->newSchedule(c);
+		}
+		Holder<Schedule> fast;
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::SteadyPeriodic;
+			c.action.bind<uint32 *, &inc>(&cntFast);
+			c.name = "fast";
+			c.period = 10000;
+			c.deadline = 20000;
+			fast = sch->newSchedule(c);
+		}
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::Once;
+			c.action.bind<Scheduler *, &stop>(+sch);
+			c.name = "terminator";
+			c.delay = 300000;
+			c.priority = 100;
+			sch->newSchedule(c);
+		}
+		sch->run();
+		CAGE_TEST(cntSlow >= 3 && cntSlow <= 6);
+		CAGE_TEST(cntFast >= 20 && cntFast <= 32);
+		CAGE_TEST(fast->statistics().deadlineMisses == 0); // the slow schedule does not block the fast one
+		CAGE_TEST(fast->statistics().maxDelay < 20000);
+	}
+
+	{
+		CAGE_TESTCASE("threaded scheduler wakes up when independent schedule finishes");
+		SchedulerCreateConfig sc;
+		sc.threaded = true;
+		sc.maxSleepDuration = 10000000;
+		Holder<Scheduler> sch = newScheduler(sc);
+		uint32 cnt = 0;
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::Once;
+			c.action.bind<uint32 *, &sleep50>(&cnt);
+			c.name = "slow independent";
+			c.independent = true;
+			sch->newSchedule(c);
+		}
+		Holder<Timer> tmr = newTimer();
+		sch->run();
+		CAGE_TEST(cnt == 1);
+		CAGE_TEST(tmr->duration() < 1000000); // does not wait for the max sleep duration
+	}
+
+	{
+		CAGE_TESTCASE("deadlines and budgets");
+		Holder<Scheduler> sch = newScheduler({});
+		uint32 cntSlow = 0, cntFast = 0;
+		Holder<Schedule> slow, fast;
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::SteadyPeriodic;
+			c.action.bind<uint32 *, &sleep50>(&cntSlow);
+			c.name = "slow";
+			c.period = 60000;
+			c.budget = 20000;
+			c.priority = 10;
+			slow = sch->newSchedule(c);
+		}
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::SteadyPeriodic;
+			c.action.bind<uint32 *, &inc>(&cntFast);
+			c.name = "fast";
+			c.period = 60000;
+			c.deadline = 20000;
+			c.budget = 20000;
+			fast = sch->newSchedule(c);
+		}
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::Once;
+			c.action.bind<Scheduler *, &stop>(+sch);
+			c.name = "terminator";
+			c.delay = 200000;
+			c.priority = 100;
+			sch->newSchedule(c);
+		}
+		sch->run();
+		CAGE_TEST(slow->statistics().runs > 0);
+		CAGE_TEST(slow->statistics().budgetOverruns == slow->statistics().runs);
+		CAGE_TEST(slow->statistics().deadlineMisses == 0); // no deadline
+		CAGE_TEST(fast->statistics().runs > 0);
+		CAGE_TEST(fast->statistics().budgetOverruns == 0);
+		CAGE_TEST(fast->statistics().deadlineMisses > 0); // delayed by the slow schedule
+	}
+
+	{
+		CAGE_TESTCASE("earlier deadline first");
+		OrderRecorder rec;
+		orderRecorder = &rec;
+		Holder<Scheduler> sch = newScheduler({});
+		{
+			ScheduleCreateConfig c;
+			c.action.bind<&recordOrder<1>>();
+			c.deadline = 50000;
+			sch->newSchedule(c);
+		}
+		{
+			ScheduleCreateConfig c;
+			c.action.bind<&recordOrder<2>>();
+			c.deadline = 10000;
+			sch->newSchedule(c);
+		}
+		{
+			ScheduleCreateConfig c;
+			c.action.bind<&recordOrder<3>>();
+			sch->newSchedule(c);
+		}
+		sch->lockstep(true);
+		sch->run();
+		CAGE_TEST(rec.order == std::vector<uint32>({ 2, 1, 3 }));
+		orderRecorder = nullptr;
+	}
+
+	{
+		CAGE_TESTCASE("threaded scheduler is deterministic in lockstep");
+		std::vector<uint32> orders[2];
+		for (uint32 attempt = 0; attempt < 2; attempt++)
+		{
+			OrderRecorder rec;
+			orderRecorder = &rec;
+			SchedulerCreateConfig sc;
+			sc.threaded = true;
+			Holder<Scheduler> sch = newScheduler(sc);
+			sch->lockstep(true);
+			{
+				ScheduleCreateConfig c;
+				c.type = ScheduleTypeEnum::SteadyPeriodic;
+				c.action.bind<&recordOrder<1>>();
+				c.period = 20000;
+				c.independent = true;
+				sch->newSchedule(c);
+			}
+			{
+				ScheduleCreateConfig c;
+				c.type = ScheduleTypeEnum::SteadyPeriodic;
+				c.action.bind<&recordOrder<2>>();
+				c.period = 30000;
+				c.independent = true;
+				sch->newSchedule(c);
+			}
+			{
+				ScheduleCreateConfig c;
+				c.type = ScheduleTypeEnum::SteadyPeriodic;
+				c.action.bind<&recordOrder<3>>();
+				c.period = 50000;
+				sch->newSchedule(c);
+			}
+			{
+				ScheduleCreateConfig c;
+				c.type = ScheduleTypeEnum::Once;
+				c.action.bind<Scheduler *, &stop>(+sch);
+				c.name = "terminator";
+				c.delay = 1000000;
+				c.priority = 100;
+				sch->newSchedule(c);
+			}
+			sch->run();
+			for (uint64 t : rec.threads)
+				CAGE_TEST(t == currentThreadId());
+			orders[attempt] = rec.order;
+			orderRecorder = nullptr;
+		}
+		CAGE_TEST(orders[0].size() > 50);
+		CAGE_TEST(orders[0] == orders[1]);
+	}
+
+	{
+		CAGE_TESTCASE("threaded scheduler propagates exceptions");
+		SchedulerCreateConfig sc;
+		sc.threaded = true;
+		Holder<Scheduler> sch = newScheduler(sc);
+		uint32 cnt = 0;
+		{
+			ScheduleCreateConfig c;
+			c.type = ScheduleTypeEnum::SteadyPeriodic;
+			c.action.bind<uint32 *, &sleep10>(&cnt);
+			c.name = "sleeping independent";
+			c.period = 5000;
+			c.independent = true;
+			sch->newSchedule(c);
+		}
+		{
+			ScheduleCreateConfig c;
+			c.action.bind<&throwing>();
+			c.name = "throwing independent";
+			c.delay = 50000;
+			c.independent = true;
+			sch->newSchedule(c);
+		}
+		CAGE_TEST_THROWN(sch->run());
+		CAGE_TEST(cnt > 0);
+	}
 }
@@ -2,6 +2,11 @@
 
 #include <cage-core/memoryBuffer.h>
 #include <cage-core/serialization.h>
+#include <cage-core/math.h>
+#include <cage-core/timer.h>
+
+#include <vector>
+#include <algorithm>
 
 namespace
 {
@@ -191,4 +196,252 @@ void testSerialization()
 			functionTakingCharPointer(items.data(), items.size());
 		}
 	}
+
+	{
+		CAGE_TESTCASE("varint");
+		MemoryBuffer b1;
+		Serializer ser(b1);
+		ser.writeVarint(0);
+		CAGE_TEST(b1.size() == 1);
+		ser.writeVarint(127);
+		CAGE_TEST(b1.size() == 2);
+		ser.writeVarint(128);
+		CAGE_TEST(b1.size() == 4);
+		ser.writeVarint(300);
+		ser.writeVarint((uint32)m);
+		ser.writeVarint(uint64(-1));
+		CAGE_TEST(b1.size() == 4 + 2 + 5 + 10);
+		ser.writeZigzag(0);
+		ser.writeZigzag(-1);
+		ser.writeZigzag(1);
+		ser.writeZigzag(-64);
+		CAGE_TEST(b1.size() == 21 + 4);
+		ser.writeZigzag(std::numeric_limits<sint64>::min());
+		ser.writeZigzag(std::numeric_limits<sint64>::max());
+		Deserializer des(b1);
+		CAGE_TEST(des.readVarint() == 0);
+		CAGE_TEST(des.readVarint() == 127);
+		CAGE_TEST(des.readVarint() == 128);
+		CAGE_TEST(des.readVarint() == 300);
+		CAGE_TEST(des.readVarint() == (uint32)m);
+		CAGE_TEST(des.readVarint() == uint64(-1));
+		CAGE_TEST(des.readZigzag() == 0);
+		CAGE_TEST(des.readZigzag() == -1);
+		CAGE_TEST(des.readZigzag() == 1);
+		CAGE_TEST(des.readZigzag() == -64);
+		CAGE_TEST(des.readZigzag() == std::numeric_limits<sint64>::min());
+		CAGE_TEST(des.readZigzag() == std::numeric_limits<sint64>::max());
+		CAGE_TEST(des.available() == 0);
+		CAGE_TEST_THROWN(des.readVarint());
+		{
+			const char truncated[] = { (char)0x80, (char)0x80 };
+			Deserializer d(PointerRange<const char>(truncated, truncated + 2));
+			CAGE_TEST_THROWN(d.readVarint());
+		}
+		{
+			char overlong[11];
+			for (char &c : overlong)
+				c = (char)0xFF;
+			overlong[10] = 0;
+			Deserializer d(PointerRange<const char>(overlong, overlong + 11));
+			CAGE_TEST_THROWN(d.readVarint());
+		}
+	}
+
+	{
+		CAGE_TESTCASE("reserved serializer after the buffer reallocated");
+		MemoryBuffer b1;
+		b1.reserve(16);
+		Serializer s(b1);
+		Serializer s1 = s.reserve(8);
+		const char *original = b1.data();
+		for (uint32 i = 0; i < 1000; i++)
+			s << i;
+		CAGE_TEST(b1.data() != original);
+		CAGE_TEST(b1.size() == 8 + 4000);
+		s1 << 13.0;
+		CAGE_TEST(b1.size() == 8 + 4000);
+		Deserializer d(b1);
+		double t;
+		d >> t;
+		CAGE_TEST(t == 13.0);
+		for (uint32 i = 0; i < 1000; i++)
+		{
+			uint32 k = m;
+			d >> k;
+			CAGE_TEST(k == i);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("memory buffer with limited size");
+		MemoryBuffer b1;
+		b1.reserve(100);
+		Serializer s(b1, 10);
+		s << (uint64)13;
+		CAGE_TEST(b1.size() == 8);
+		CAGE_TEST(s.available() == 2);
+		CAGE_TEST_THROWN(s << (uint32)42);
+		CAGE_TEST(b1.size() == 8);
+	}
+
+	{
+		CAGE_TESTCASE("fixed range bounds");
+		char buff[10] = {};
+		Serializer ser(PointerRange<char>(buff, buff + 10));
+		ser << (uint64)13;
+		CAGE_TEST(ser.available() == 2);
+		CAGE_TEST_THROWN(ser << (uint32)42);
+		ser << (uint16)42;
+		CAGE_TEST(ser.available() == 0);
+		Deserializer des(PointerRange<const char>(buff, buff + 10));
+		uint64 a = 0;
+		uint16 b = 0;
+		des >> a >> b;
+		CAGE_TEST(a == 13 && b == 42);
+		CAGE_TEST_THROWN(des >> b);
+	}
+
+	{
+		CAGE_TESTCASE("bits");
+		MemoryBuffer b1;
+		{
+			Serializer ser(b1);
+			BitSerializer bits(ser);
+			bits.write(true);
+			bits.write(5, 3);
+			bits.write(0x1FF, 9); // 13 bits total
+			CAGE_TEST(b1.size() == 0);
+			bits.write(0x12345678, 32);
+			CAGE_TEST(b1.size() == 4);
+			bits.write(0xDEADBEEFCAFEBABEull, 64);
+			bits.write(false);
+			bits.write(0xFFFF, 4); // only the low bits are written
+			bits.flush();
+			CAGE_TEST(b1.size() == (13 + 32 + 64 + 5 + 7) / 8);
+			ser << (uint8)200; // byte aligned data can follow
+		}
+		{
+			Deserializer des(b1);
+			BitDeserializer bits(des);
+			CAGE_TEST(bits.readBool());
+			CAGE_TEST(bits.read(3) == 5);
+			CAGE_TEST(bits.read(9) == 0x1FF);
+			CAGE_TEST(bits.read(32) == 0x12345678);
+			CAGE_TEST(bits.read(64) == 0xDEADBEEFCAFEBABEull);
+			CAGE_TEST(!bits.readBool());
+			CAGE_TEST(bits.read(4) == 0xF);
+			uint8 t = 0;
+			des >> t;
+			CAGE_TEST(t == 200);
+			CAGE_TEST_THROWN(bits.read(8));
+		}
+	}
+
+	{
+		CAGE_TESTCASE("quantization");
+		CAGE_TEST(quantize(0, 0, 1, 8) == 0);
+		CAGE_TEST(quantize(1, 0, 1, 8) == 255);
+		CAGE_TEST(quantize(5, 0, 1, 8) == 255); // clamped
+		CAGE_TEST(quantize(-5, 0, 1, 8) == 0);
+		CAGE_TEST(quantize(1, 0, 1, 32) == 0xFFFFFFFF);
+		CAGE_TEST(dequantize(0, -3, 7, 10) == -3);
+		CAGE_TEST(dequantize(1023, -3, 7, 10) == 7);
+		for (uint32 i = 0; i < 1000; i++)
+		{
+			const Real v = randomRange(-50.0, 50.0);
+			const Real d = dequantize(quantize(v, -50, 50, 16), -50, 50, 16);
+			CAGE_TEST(abs(d - v) <= 100.0 / 65535 * 0.5 + 1e-4);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("normalized vectors and quaternions");
+		std::vector<Vec3> dirs = { Vec3(1, 0, 0), Vec3(-1, 0, 0), Vec3(0, 1, 0), Vec3(0, -1, 0), Vec3(0, 0, 1), Vec3(0, 0, -1) };
+		std::vector<Quat> rots = { Quat(), Quat(0, 0, 0, -1), Quat(1, 0, 0, 0) };
+		for (uint32 i = 0; i < 200; i++)
+		{
+			dirs.push_back(randomDirection3());
+			rots.push_back(randomDirectionQuat());
+		}
+		MemoryBuffer b1;
+		{
+			Serializer ser(b1);
+			BitSerializer bits(ser);
+			for (const Vec3 &d : dirs)
+				bits.writeNormalized(d, 12);
+			for (const Quat &q : rots)
+				bits.writeNormalized(q, 12);
+			bits.flush();
+		}
+		CAGE_TEST(b1.size() == (dirs.size() * 24 + rots.size() * 38 + 7) / 8);
+		Deserializer des(b1);
+		BitDeserializer bits(des);
+		for (const Vec3 &d : dirs)
+		{
+			const Vec3 r = bits.readNormalizedVec3(12);
+			CAGE_TEST(abs(length(r) - 1) < 1e-4);
+			CAGE_TEST(dot(r, d) > 0.9999);
+		}
+		for (const Quat &q : rots)
+		{
+			const Quat r = bits.readNormalizedQuat(12);
+			CAGE_TEST(abs(dot(r, q)) > 0.9999);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 count = 100000;
+#else
+		constexpr uint32 count = 2000000;
+#endif
+		std::vector<uint32> values;
+		values.reserve(count);
+		for (uint32 i = 0; i < count; i++)
+			values.push_back(randomRange(0u, 1000u));
+		Holder<Timer> tmr = newTimer();
+		MemoryBuffer raw;
+		{
+			Serializer ser(raw);
+			for (uint32 v : values)
+				ser << v;
+		}
+		const uint64 tRaw = tmr->duration();
+		tmr->reset();
+		MemoryBuffer fixed;
+		fixed.allocate(count * sizeof(uint32));
+		{
+			Serializer ser(PointerRange<char>(fixed.data(), fixed.data() + fixed.size()));
+			for (uint32 v : values)
+				ser << v;
+		}
+		const uint64 tFixed = tmr->duration();
+		tmr->reset();
+		MemoryBuffer var;
+		{
+			Serializer ser(var);
+			for (uint32 v : values)
+				ser.writeVarint(v);
+		}
+		const uint64 tVar = tmr->duration();
+		tmr->reset();
+		MemoryBuffer packed;
+		{
+			Serializer ser(packed);
+			BitSerializer bits(ser);
+			for (uint32 v : values)
+				bits.write(v, 10);
+			bits.flush();
+		}
+		const uint64 tBits = tmr->duration();
+		CAGE_TEST(fixed.size() == raw.size() && std::equal(fixed.data(), fixed.data() + fixed.size(), raw.data()));
+		{
+			Deserializer des(var);
+			for (uint32 v : values)
+				CAGE_TEST(des.readVarint() == v);
+		}
+		CAGE_LOG(SeverityEnum::Info, "serialization performance", Stringizer() + "values: " + count + ", raw: " + raw.size() + " bytes " + tRaw + " us, fixed range: " + tFixed + " us, varint: " + var.size() + " bytes " + tVar + " us, bits: " + packed.size() + " bytes " + tBits + " us");
+	}
 }
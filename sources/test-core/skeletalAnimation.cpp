@@ -0,0 +1,573 @@
+#include "main.h"
+
+#include <cage-core/math.h>
+#include <cage-core/mat3x4.h>
+#include <cage-core/random.h>
+#include <cage-core/timer.h>
+#include <cage-core/skeletalAnimation.h>
+#include <cage-core/skeletalAnimationPreparator.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	constexpr uint16 TotalBones = 60;
+
+	struct Channel
+	{
+		std::vector<Real> posTimes, rotTimes, sclTimes;
+		std::vector<Vec3> positions, scales;
+		std::vector<Quat> rotations;
+	};
+
+	std::vector<Real> makeTimes(RandomGenerator &rng)
+	{
+		const uint32 cnt = rng.randomRange(1u, 20u);
+		std::vector<Real> times;
+		times.push_back(0);
+		for (uint32 i = 1; i < cnt; i++)
+			times.push_back(rng.randomChance());
+		std::sort(times.begin(), times.end());
+		if (cnt > 2)
+			times.back() = 1;
+		return times;
+	}
+
+	struct Character
+	{
+		Holder<SkeletonRig> rig;
+		Holder<SkeletalAnimation> anim;
+		std::vector<uint16> parents;
+		std::vector<uint16> mapping;
+		std::vector<Mat4> bases, invRests;
+		std::vector<Channel> channels;
+
+		explicit Character(uint64 seed)
+		{
+			RandomGenerator rng(seed, 13);
+			for (uint16 i = 0; i < TotalBones; i++)
+			{
+				parents.push_back(i == 0 ? uint16(m) : uint16((i - 1) / 2));
+				bases.push_back(Mat4(rng.randomRange3(-1, 1), rng.randomDirectionQuat()));
+				invRests.push_back(Mat4(rng.randomRange3(-1, 1), rng.randomDirectionQuat(), Vec3(rng.randomRange(0.5, 2.0))));
+				if ((i % 7) == 3)
+					mapping.push_back(m);
+				else
+				{
+					mapping.push_back(numeric_cast<uint16>(channels.size()));
+					Channel ch;
+					ch.posTimes = makeTimes(rng);
+					for (uint32 j = 0; j < ch.posTimes.size(); j++)
+						ch.positions.push_back(rng.randomRange3(-1, 1));
+					ch.rotTimes = makeTimes(rng);
+					for (uint32 j = 0; j < ch.rotTimes.size(); j++)
+						ch.rotations.push_back(rng.randomDirectionQuat());
+					ch.sclTimes = makeTimes(rng);
+					for (uint32 j = 0; j < ch.sclTimes.size(); j++)
+						ch.scales.push_back(Vec3(rng.randomRange(0.5, 2.0)));
+					channels.push_back(std::move(ch));
+				}
+			}
+
+			rig = newSkeletonRig();
+			rig->skeletonData(Mat4(Vec3(1, 2, 3)), parents, bases, invRests);
+
+			anim = newSkeletalAnimation();
+			anim->channelsMapping(TotalBones, numeric_cast<uint16>(channels.size()), mapping);
+			std::vector<PointerRange<const Real>> pt, rt, st;
+			std::vector<PointerRange<const Vec3>> pv, sv;
+			std::vector<PointerRange<const Quat>> rv;
+			for (const Channel &ch : channels)
+			{
+				pt.push_back(ch.posTimes);
+				pv.push_back(ch.positions);
+				rt.push_back(ch.rotTimes);
+				rv.push_back(ch.rotations);
+				st.push_back(ch.sclTimes);
+				sv.push_back(ch.scales);
+			}
+			anim->positionsData(pt, pv);
+			anim->rotationsData(rt, rv);
+			anim->scaleData(st, sv);
+			anim->duration(1000000);
+		}
+
+		template<class T>
+		static T sample(const std::vector<Real> &times, const std::vector<T> &values, Real coef)
+		{
+			if (times.size() == 1 || coef <= times[0])
+				return values[0];
+			for (uint32 i = 0; i + 1 < times.size(); i++)
+				if (coef <= times[i + 1])
+					return interpolate(values[i], values[i + 1], (coef - times[i]) / (times[i + 1] - times[i]));
+			return values.back();
+		}
+
+		// straightforward evaluation used as a reference
+		std::vector<Mat4> reference(Real coef) const
+		{
+			std::vector<Mat4> tmp;
+			tmp.resize(TotalBones);
+			for (uint32 i = 0; i < TotalBones; i++)
+			{
+				Mat4 local = bases[i];
+				if (mapping[i] != m)
+				{
+					const Channel &ch = channels[mapping[i]];
+					local = Mat4(sample(ch.posTimes, ch.positions, coef)) * Mat4(sample(ch.rotTimes, ch.rotations, coef)) * Mat4::scale(sample(ch.sclTimes, ch.scales, coef));
+				}
+				tmp[i] = parents[i] == m ? local : tmp[parents[i]] * local;
+			}
+			for (uint32 i = 0; i < TotalBones; i++)
+				tmp[i] = Mat4(Vec3(1, 2, 3)) * tmp[i] * invRests[i];
+			return tmp;
+		}
+	};
+
+	bool similar(const Mat4 &a, const Mat4 &b)
+	{
+		for (uint32 i = 0; i < 16; i++)
+			if (abs(a[i] - b[i]) > 1e-3 * max(Real(1), abs(b[i])))
+				return false;
+		return true;
+	}
+
+	void testEvaluation()
+	{
+		CAGE_TESTCASE("evaluation matches reference");
+		const Character c(42);
+		std::vector<Mat4> out;
+		out.resize(TotalBones);
+		std::vector<Mat3x4> out34;
+		out34.resize(TotalBones);
+		for (Real coef : { Real(0), Real(0.25), Real(0.5), Real(1) })
+		{
+			const auto ref = c.reference(coef);
+			animateSkin(+c.rig, +c.anim, coef, out);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(out[i], ref[i]));
+			animateSkin(+c.rig, +c.anim, coef, out34);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(Mat4(out34[i]), ref[i]));
+		}
+	}
+
+	void testCursor()
+	{
+		CAGE_TESTCASE("cursor gives same results as fresh evaluation");
+		const Character c(13);
+		Holder<SkeletalAnimationCursor> cursor = newSkeletalAnimationCursor();
+		std::vector<Mat4> a, b;
+		a.resize(TotalBones);
+		b.resize(TotalBones);
+		RandomGenerator rng(7, 11);
+		Real coef = 0;
+		for (uint32 step = 0; step < 500; step++)
+		{
+			switch (step / 100)
+			{
+			case 0: coef = saturate(coef + 0.003); break; // forward playback
+			case 1: coef = saturate(coef - 0.005); break; // backward playback
+			case 2: coef = (coef + 0.03) - (coef + 0.03 >= 1 ? 1 : 0); break; // looping
+			default: coef = rng.randomChance(); break; // seeking
+			}
+			animateSkin(+c.rig, +c.anim, coef, a);
+			animateSkin(+c.rig, +c.anim, coef, b, +cursor);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(a[i] == b[i]);
+		}
+
+		{
+			CAGE_TESTCASE("cursor reused with another animation");
+			const Character d(14);
+			animateSkin(+d.rig, +d.anim, 0.3, a);
+			animateSkin(+d.rig, +d.anim, 0.3, b, +cursor);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(a[i] == b[i]);
+			cursor->reset();
+			animateSkin(+c.rig, +c.anim, 0.6, a);
+			animateSkin(+c.rig, +c.anim, 0.6, b, +cursor);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(a[i] == b[i]);
+		}
+	}
+
+	void testPreparatorCursors()
+	{
+		CAGE_TESTCASE("preparator keeps cursors across frames");
+		Holder<SkeletalAnimationPreparatorCollection> col = newSkeletalAnimationPreparatorCollection(nullptr);
+		Holder<SkeletalAnimation> anim = newSkeletalAnimation();
+		int a = 0, b = 0;
+		col->create(&a, anim.share(), 0.1);
+		col->create(&b, anim.share(), 0.1);
+		CAGE_TEST(col->cursorsCount() == 2);
+		col->clear();
+		CAGE_TEST(col->cursorsCount() == 2);
+		col->create(&a, anim.share(), 0.2);
+		CAGE_TEST(col->cursorsCount() == 2);
+		col->clear();
+		col->clear(); // b was not used in two frames
+		CAGE_TEST(col->cursorsCount() == 1);
+		col->clear();
+		CAGE_TEST(col->cursorsCount() == 0);
+	}
+
+	void testNonAffine()
+	{
+		CAGE_TESTCASE("non-affine rig");
+		Character c(5);
+		c.invRests[3][3] = 0.5; // breaks the affine assumption, falls back to generic matrices
+		c.rig->skeletonData(Mat4(Vec3(1, 2, 3)), c.parents, c.bases, c.invRests);
+		std::vector<Mat4> out;
+		out.resize(TotalBones);
+		animateSkin(+c.rig, +c.anim, 0.4, out);
+		const auto ref = c.reference(0.4);
+		for (uint32 i = 0; i < TotalBones; i++)
+			CAGE_TEST(similar(out[i], ref[i]));
+	}
+
+	void testBlending()
+	{
+		CAGE_TESTCASE("blending layers");
+		const Character c(21);
+		const Character d(22);
+		std::vector<Mat4> a, b;
+		a.resize(TotalBones);
+		b.resize(TotalBones);
+
+		{
+			CAGE_TESTCASE("single layer");
+			SkeletalAnimationLayer l;
+			l.animation = +c.anim;
+			l.coefficient = 0.35;
+			animateSkin(+c.rig, +c.anim, 0.35, a);
+			animateSkin(+c.rig, { &l, &l + 1 }, b);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(a[i] == b[i]);
+		}
+
+		{
+			CAGE_TESTCASE("layers with zero weight are ignored");
+			SkeletalAnimationLayer ls[3];
+			ls[0].animation = +d.anim;
+			ls[0].coefficient = 0.8;
+			ls[0].weight = 0;
+			ls[1].animation = +c.anim;
+			ls[1].coefficient = 0.35;
+			ls[2].animation = +d.anim;
+			ls[2].coefficient = 0.1;
+			ls[2].weight = 0;
+			ls[2].additive = true;
+			animateSkin(+c.rig, +c.anim, 0.35, a);
+			animateSkin(+c.rig, ls, b);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(a[i] == b[i]);
+		}
+
+		{
+			CAGE_TESTCASE("blending a clip with itself");
+			SkeletalAnimationLayer ls[2];
+			ls[0].animation = +c.anim;
+			ls[0].coefficient = 0.6;
+			ls[0].weight = 0.3;
+			ls[1] = ls[0];
+			ls[1].weight = 2.5;
+			animateSkin(+c.rig, +c.anim, 0.6, a);
+			animateSkin(+c.rig, ls, b);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(a[i], b[i]));
+		}
+
+		{
+			CAGE_TESTCASE("crossfade weights move the result between the clips");
+			std::vector<Mat4> e;
+			e.resize(TotalBones);
+			animateSkin(+c.rig, +c.anim, 0.2, a);
+			animateSkin(+c.rig, +d.anim, 0.7, b);
+			SkeletalAnimationLayer ls[2];
+			ls[0].animation = +c.anim;
+			ls[0].coefficient = 0.2;
+			ls[1].animation = +d.anim;
+			ls[1].coefficient = 0.7;
+			ls[1].weight = 1e-6;
+			animateSkin(+c.rig, ls, e);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(e[i], a[i]));
+			ls[0].weight = 1e-6;
+			ls[1].weight = 1;
+			animateSkin(+c.rig, ls, e);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(e[i], b[i]));
+		}
+
+		{
+			CAGE_TESTCASE("additive identity layer");
+			Holder<SkeletalAnimation> identity = newSkeletalAnimation();
+			std::vector<uint16> mapping;
+			for (uint16 i = 0; i < TotalBones; i++)
+				mapping.push_back(i % 2 ? uint16(0) : uint16(m));
+			identity->channelsMapping(TotalBones, 1, mapping);
+			const Real times[] = { 0, 1 };
+			const Vec3 zeros[] = { Vec3(), Vec3() };
+			const Vec3 ones[] = { Vec3(1), Vec3(1) };
+			const Quat rots[] = { Quat(), Quat() };
+			const PointerRange<const Real> tr[] = { times };
+			const PointerRange<const Vec3> zr[] = { zeros };
+			const PointerRange<const Vec3> orr[] = { ones };
+			const PointerRange<const Quat> rr[] = { rots };
+			identity->positionsData(tr, zr);
+			identity->rotationsData(tr, rr);
+			identity->scaleData(tr, orr);
+			SkeletalAnimationLayer ls[2];
+			ls[0].animation = +c.anim;
+			ls[0].coefficient = 0.45;
+			ls[1].animation = +identity;
+			ls[1].coefficient = 0.45;
+			ls[1].weight = 0.7;
+			ls[1].additive = true;
+			animateSkin(+c.rig, +c.anim, 0.45, a);
+			animateSkin(+c.rig, ls, b);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(a[i], b[i]));
+		}
+
+		{
+			CAGE_TESTCASE("crossfade over partially animated bones");
+			Holder<SkeletalAnimation> partial = newSkeletalAnimation();
+			std::vector<uint16> mapping;
+			for (uint16 i = 0; i < TotalBones; i++)
+				mapping.push_back(i % 2 ? uint16(0) : uint16(m)); // bone 3 is animated here but not in the character clip
+			partial->channelsMapping(TotalBones, 1, mapping);
+			const Real times[] = { 0, 1 };
+			const Vec3 poss[] = { Vec3(0.3, -0.2, 0.1), Vec3(0.3, -0.2, 0.1) };
+			const Vec3 ones[] = { Vec3(1), Vec3(1) };
+			const Quat rots[] = { Quat(Degs(20), Degs(), Degs()), Quat(Degs(20), Degs(), Degs()) };
+			const PointerRange<const Real> tr[] = { times };
+			const PointerRange<const Vec3> pr[] = { poss };
+			const PointerRange<const Vec3> orr[] = { ones };
+			const PointerRange<const Quat> rr[] = { rots };
+			partial->positionsData(tr, pr);
+			partial->rotationsData(tr, rr);
+			partial->scaleData(tr, orr);
+			partial->duration(1000000);
+
+			std::vector<Mat4> e;
+			e.resize(TotalBones);
+			animateSkin(+c.rig, +c.anim, 0.25, a);
+			animateSkin(+c.rig, +partial, 0.25, b);
+			SkeletalAnimationLayer ls[2];
+			ls[0].animation = +c.anim;
+			ls[0].coefficient = 0.25;
+			ls[1].animation = +partial;
+			ls[1].coefficient = 0.25;
+			ls[1].weight = 1e-6;
+			animateSkin(+c.rig, ls, e);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(e[i], a[i]));
+			ls[0].weight = 1e-6;
+			ls[1].weight = 1;
+			animateSkin(+c.rig, ls, e);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(e[i], b[i]));
+
+			// the root bone is not animated by the partial clip, it moves halfway towards its base pose
+			ls[0].weight = 0.5;
+			ls[1].weight = 0.5;
+			animateSkin(+c.rig, ls, e);
+			const Mat4 local = inverse(Mat4(Vec3(1, 2, 3))) * e[0] * inverse(c.invRests[0]);
+			const Vec3 animated = Character::sample(c.channels[c.mapping[0]].posTimes, c.channels[c.mapping[0]].positions, 0.25);
+			const Vec3 base = Vec3(c.bases[0][12], c.bases[0][13], c.bases[0][14]);
+			const Vec3 mid = (animated + base) * 0.5;
+			for (uint32 k = 0; k < 3; k++)
+				CAGE_TEST(abs(local[12 + k] - mid[k]) < 1e-3);
+		}
+	}
+
+	bool similar(const Mat4 &a, const Mat4 &b, Real tolerance)
+	{
+		for (uint32 i = 0; i < 16; i++)
+			if (abs(a[i] - b[i]) > tolerance)
+				return false;
+		return true;
+	}
+
+	void testCompression()
+	{
+		CAGE_TESTCASE("compressed clips");
+		const Character c(31);
+		std::vector<Mat4> a, b;
+		a.resize(TotalBones);
+		b.resize(TotalBones);
+
+		{
+			CAGE_TESTCASE("compression preserves the animation");
+			const auto original = c.anim->exportBuffer();
+			Holder<SkeletalAnimation> anim = c.anim->copy();
+			CAGE_TEST(!anim->compressed());
+			anim->compress();
+			CAGE_TEST(anim->compressed());
+			CAGE_TEST(anim->channelsCount() == c.anim->channelsCount());
+			CAGE_TEST(anim->bonesCount() == c.anim->bonesCount());
+			const auto compressed = anim->exportBuffer();
+			CAGE_LOG(SeverityEnum::Info, "skeletal animation", Stringizer() + "original size: " + original.size() + ", compressed: " + compressed.size());
+			CAGE_TEST(compressed.size() < original.size());
+			Holder<SkeletalAnimation> imported = newSkeletalAnimation();
+			imported->importBuffer(compressed);
+			CAGE_TEST(imported->compressed());
+			Holder<SkeletalAnimationCursor> cursor = newSkeletalAnimationCursor();
+			std::vector<Mat4> e;
+			e.resize(TotalBones);
+			for (Real coef = 0; coef <= 1; coef += 0.0173)
+			{
+				animateSkin(+c.rig, +c.anim, coef, a);
+				animateSkin(+c.rig, +anim, coef, b);
+				animateSkin(+c.rig, +imported, coef, e, +cursor);
+				for (uint32 i = 0; i < TotalBones; i++)
+				{
+					CAGE_TEST(similar(a[i], b[i], 0.05));
+					CAGE_TEST(b[i] == e[i]);
+				}
+			}
+		}
+
+		{
+			CAGE_TESTCASE("redundant keyframes are removed");
+			Holder<SkeletalAnimation> anim = newSkeletalAnimation();
+			const uint16 mapping[] = { 0 };
+			anim->channelsMapping(1, 1, mapping);
+			std::vector<Real> times;
+			std::vector<Vec3> positions, scales;
+			std::vector<Quat> rotations;
+			for (uint32 i = 0; i < 100; i++)
+			{
+				const Real t = i / 99.0;
+				times.push_back(t);
+				positions.push_back(Vec3(t * 3, 1 - t, 5));
+				rotations.push_back(Quat(Vec3(0, 1, 0), Degs(20)));
+				scales.push_back(Vec3(2));
+			}
+			const PointerRange<const Real> tr[] = { times };
+			const PointerRange<const Vec3> pr[] = { positions };
+			const PointerRange<const Quat> rr[] = { rotations };
+			const PointerRange<const Vec3> sr[] = { scales };
+			anim->positionsData(tr, pr);
+			anim->rotationsData(tr, rr);
+			anim->scaleData(tr, sr);
+			const uint32 originalSize = numeric_cast<uint32>(anim->exportBuffer().size());
+			anim->compress();
+			const uint32 compressedSize = numeric_cast<uint32>(anim->exportBuffer().size());
+			CAGE_TEST(compressedSize * 10 < originalSize);
+
+			Holder<SkeletonRig> rig = newSkeletonRig();
+			const uint16 parents[] = { m };
+			const Mat4 mats[] = { Mat4() };
+			rig->skeletonData(Mat4(), parents, mats, mats);
+			Mat4 r;
+			animateSkin(+rig, +anim, 0.37, { &r, &r + 1 });
+			CAGE_TEST(similar(r, Mat4(Vec3(0.37 * 3, 1 - 0.37, 5), Quat(Vec3(0, 1, 0), Degs(20)), Vec3(2)), 1e-3));
+		}
+
+		{
+			CAGE_TESTCASE("modifying compressed clip");
+			Holder<SkeletalAnimation> anim = c.anim->copy();
+			anim->compress();
+			std::vector<PointerRange<const Real>> trs;
+			std::vector<PointerRange<const Vec3>> prs;
+			for (const auto &it : c.channels)
+			{
+				trs.push_back(it.posTimes);
+				prs.push_back(it.positions);
+			}
+			anim->positionsData(trs, prs);
+			CAGE_TEST(!anim->compressed());
+			CAGE_TEST(anim->channelsCount() == c.anim->channelsCount());
+			animateSkin(+c.rig, +c.anim, 0.5, a);
+			animateSkin(+c.rig, +anim, 0.5, b);
+			for (uint32 i = 0; i < TotalBones; i++)
+				CAGE_TEST(similar(a[i], b[i], 0.05));
+		}
+	}
+
+	void testPerformance()
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 TotalCharacters = 100;
+#else
+		constexpr uint32 TotalCharacters = 1000;
+#endif
+		constexpr uint32 TotalFrames = 10;
+		std::vector<Character> characters;
+		characters.reserve(10);
+		for (uint32 i = 0; i < 10; i++)
+			characters.emplace_back(i + 100);
+		std::vector<Holder<SkeletalAnimationCursor>> cursors;
+		for (uint32 i = 0; i < TotalCharacters; i++)
+			cursors.push_back(newSkeletalAnimationCursor());
+		std::vector<Mat3x4> armatures;
+		armatures.resize(TotalCharacters * TotalBones);
+
+		static constexpr const char *modes[] = { "single clip without cursors", "single clip with cursors", "two blended clips with cursors", "compressed clip with cursors" };
+		std::vector<Holder<SkeletalAnimation>> compressed;
+		for (const Character &c : characters)
+		{
+			compressed.push_back(c.anim->copy());
+			compressed.back()->compress();
+		}
+		std::vector<Holder<SkeletalAnimationCursor>> cursors2;
+		for (uint32 i = 0; i < TotalCharacters; i++)
+			cursors2.push_back(newSkeletalAnimationCursor());
+
+		for (uint32 mode = 0; mode < 4; mode++)
+		{
+			Holder<Timer> tmr = newTimer();
+			for (uint32 frame = 0; frame < TotalFrames; frame++)
+			{
+				for (uint32 i = 0; i < TotalCharacters; i++)
+				{
+					const Character &c = characters[i % characters.size()];
+					const Real coef = Real(frame * 0.01 + i * 0.0001);
+					const PointerRange<Mat3x4> output = PointerRange<Mat3x4>(armatures.data() + i * TotalBones, armatures.data() + (i + 1) * TotalBones);
+					switch (mode)
+					{
+					case 0:
+						animateSkin(+c.rig, +c.anim, coef, output);
+						break;
+					case 1:
+						animateSkin(+c.rig, +c.anim, coef, output, +cursors[i]);
+						break;
+					case 2:
+					{
+						SkeletalAnimationLayer ls[2];
+						ls[0].animation = +c.anim;
+						ls[0].cursor = +cursors[i];
+						ls[0].coefficient = coef;
+						ls[1].animation = +characters[(i + 1) % characters.size()].anim;
+						ls[1].cursor = +cursors2[i];
+						ls[1].coefficient = 1 - coef;
+						ls[1].weight = 0.4;
+						animateSkin(+c.rig, ls, output);
+					} break;
+					case 3:
+						animateSkin(+c.rig, +compressed[i % characters.size()], coef, output, +cursors2[i]);
+						break;
+					}
+				}
+			}
+			CAGE_LOG(SeverityEnum::Info, "skeletal animation performance", Stringizer() + modes[mode] + ", " + TotalCharacters + " characters with " + TotalBones + " bones, avg time per frame: " + (tmr->duration() / TotalFrames) + " us");
+		}
+	}
+}
+
+void testSkeletalAnimation()
+{
+	CAGE_TESTCASE("skeletal animation");
+	testEvaluation();
+	testCursor();
+	testPreparatorCursors();
+	testNonAffine();
+	testBlending();
+	testCompression();
+	testPerformance();
+}
@@ -0,0 +1,140 @@
+#include "main.h"
+
+#include <cage-core/math.h>
+#include <cage-core/geometry.h>
+#include <cage-core/camera.h>
+#include <cage-core/timer.h>
+#include <cage-core/spatialCulling.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	Aabb randomBox()
+	{
+		const Vec3 c = randomRange3(-200.0, 200.0);
+		const Vec3 s = randomRange3(0.1, 3.0);
+		return Aabb(c - s, c + s);
+	}
+
+	Frustum randomFrustum()
+	{
+		const Mat4 proj = perspectiveProjection(Degs(randomRange(30.0, 90.0)), randomRange(0.5, 2.0), 0.1, randomRange(50.0, 300.0));
+		const Mat4 view = inverse(Mat4(Transform(randomRange3(-100.0, 100.0), Quat(randomDirection3(), randomDirection3()))));
+		return Frustum(proj * view);
+	}
+
+	std::vector<uint32> bruteForce(const std::vector<Aabb> &boxes, const Frustum &f)
+	{
+		std::vector<uint32> res;
+		for (uint32 i = 0; i < boxes.size(); i++)
+			if (boxes[i].valid() && intersects(boxes[i], f))
+				res.push_back(i);
+		return res;
+	}
+
+	std::vector<uint32> sorted(PointerRange<const uint32> r)
+	{
+		std::vector<uint32> v(r.begin(), r.end());
+		std::sort(v.begin(), v.end());
+		return v;
+	}
+}
+
+void testSpatialCulling()
+{
+	CAGE_TESTCASE("spatial culling");
+
+	{
+		CAGE_TESTCASE("randomized updates");
+		SpatialCullingCreateConfig cfg;
+		cfg.settleCommits = 3;
+		Holder<SpatialCulling> culling = newSpatialCulling(cfg);
+		std::vector<Aabb> boxes;
+		boxes.resize(3000);
+		for (uint32 i = 0; i < boxes.size(); i++)
+		{
+			boxes[i] = randomBox();
+			culling->update(i, boxes[i]);
+		}
+		for (uint32 round = 0; round < 20; round++)
+		{
+			for (uint32 i = 0; i < 100; i++)
+			{
+				const uint32 k = randomRange(0u, numeric_cast<uint32>(boxes.size()));
+				if (randomChance() < 0.1)
+				{
+					boxes[k] = Aabb();
+					culling->remove(k);
+				}
+				else
+				{
+					boxes[k] = randomBox();
+					culling->update(k, boxes[k]);
+				}
+			}
+			if (round == 10)
+			{
+				boxes[5] = Aabb::Universe();
+				culling->update(5, boxes[5]);
+			}
+			culling->commit();
+			CAGE_TEST(culling->dynamicCount() < boxes.size());
+			for (uint32 i = 0; i < 5; i++)
+			{
+				const Frustum f = randomFrustum();
+				CAGE_TEST(sorted(culling->cull(f)) == bruteForce(boxes, f));
+			}
+		}
+		culling->clear();
+		CAGE_TEST(culling->count() == 0);
+		culling->commit();
+		CAGE_TEST(culling->cull(randomFrustum()).empty());
+	}
+
+	{
+		CAGE_TESTCASE("performance");
+#ifdef CAGE_DEBUG
+		constexpr uint32 count = 20000;
+#else
+		constexpr uint32 count = 200000;
+#endif
+		Holder<SpatialCulling> culling = newSpatialCulling({});
+		std::vector<Aabb> boxes;
+		boxes.reserve(count);
+		for (uint32 i = 0; i < count; i++)
+		{
+			boxes.push_back(randomBox());
+			culling->update(i, boxes[i]);
+		}
+		culling->commit();
+		std::vector<Frustum> frustums;
+		for (uint32 i = 0; i < 4; i++)
+			frustums.push_back(randomFrustum());
+		uint64 timeCulling = 0, timeBrute = 0, found = 0;
+		Holder<Timer> tmr = newTimer();
+		for (uint32 frame = 0; frame < 10; frame++)
+		{
+			// few moving objects every frame
+			tmr->reset();
+			for (uint32 i = 0; i < count / 100; i++)
+			{
+				boxes[i] = randomBox();
+				culling->update(i, boxes[i]);
+			}
+			for (uint32 i = 0; i < count; i++)
+				culling->update(i, boxes[i]); // unchanged
+			culling->commit();
+			for (const Frustum &f : frustums)
+				found += culling->cull(f).size();
+			timeCulling += tmr->duration();
+			tmr->reset();
+			for (const Frustum &f : frustums)
+				found -= bruteForce(boxes, f).size();
+			timeBrute += tmr->duration();
+		}
+		CAGE_TEST(found == 0);
+		CAGE_LOG(SeverityEnum::Info, "spatial culling performance", Stringizer() + "items: " + count + ", culling: " + (timeCulling / 10) + " us per frame, brute force: " + (timeBrute / 10) + " us per frame");
+	}
+}
@@ -1,6 +1,12 @@
 #include "main.h"
 
 #include <cage-core/systemInformation.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/threadPool.h>
+#include <cage-core/files.h>
+
+#include <algorithm>
+#include <atomic>
 
 namespace
 {
@@ -23,6 +29,26 @@ namespace
 				CAGE_TEST(*p == v++);
 		}
 	};
+
+	void writeSysfs(const String &path, const String &content)
+	{
+		writeFile(pathJoin("testdir/sysfs", path))->write(content + "\n");
+	}
+
+	std::atomic<uint32> affinityCounter = 0;
+
+	void affinityPoolFunction(uint32, uint32)
+	{
+		affinityCounter++;
+	}
+
+	const ProcessorTopology &processor(const ProcessorsTopology &t, uint32 id)
+	{
+		for (const ProcessorTopology &p : t.processors)
+			if (p.id == id)
+				return p;
+		CAGE_THROW_ERROR(Exception, "processor not found");
+	}
 }
 
 void testSystemInformation()
@@ -51,4 +77,161 @@ void testSystemInformation()
 		CAGE_TEST(a > 10);
 		CAGE_TEST(b > a + 10);
 	}
+
+	{
+		CAGE_TESTCASE("processors topology: dual socket with smt");
+		pathRemove("testdir/sysfs");
+		// two packages, each with two cores, each with two threads
+		writeSysfs("devices/system/cpu/online", "0-7");
+		for (uint32 i = 0; i < 8; i++)
+		{
+			const String dir = Stringizer() + "devices/system/cpu/cpu" + i;
+			const uint32 core = i % 4;
+			const uint32 package = core / 2;
+			writeSysfs(dir + "/topology/physical_package_id", Stringizer() + package);
+			writeSysfs(dir + "/topology/core_id", Stringizer() + (core % 2));
+			writeSysfs(dir + "/topology/thread_siblings_list", Stringizer() + core + "," + (core + 4));
+			writeSysfs(dir + "/cache/index0/level", "1");
+			writeSysfs(dir + "/cache/index0/shared_cpu_list", Stringizer() + core + "," + (core + 4));
+			writeSysfs(dir + "/cache/index1/level", "3");
+			writeSysfs(dir + "/cache/index1/shared_cpu_list", package ? "2-3,6-7" : "0-1,4-5");
+		}
+		writeSysfs("devices/system/node/online", "0-1");
+		writeSysfs("devices/system/node/node0/cpulist", "0-1,4-5");
+		writeSysfs("devices/system/node/node1/cpulist", "2-3,6-7");
+
+		const ProcessorsTopology t = processorsTopologyFromSysfs("testdir/sysfs");
+		CAGE_TEST(t.processors.size() == 8);
+		CAGE_TEST(t.cores == 4);
+		CAGE_TEST(t.packages == 2);
+		CAGE_TEST(t.numaNodes == 2);
+		CAGE_TEST(t.cacheGroups == 2);
+		CAGE_TEST(!t.hybrid);
+		CAGE_TEST(processor(t, 0).core == processor(t, 4).core);
+		CAGE_TEST(processor(t, 0).core != processor(t, 1).core);
+		CAGE_TEST(processor(t, 0).smt == 0);
+		CAGE_TEST(processor(t, 4).smt == 1);
+		CAGE_TEST(processor(t, 1).package == processor(t, 5).package);
+		CAGE_TEST(processor(t, 1).package != processor(t, 2).package);
+		CAGE_TEST(processor(t, 3).numaNode == processor(t, 6).numaNode);
+		CAGE_TEST(processor(t, 3).cacheGroup != processor(t, 0).cacheGroup);
+
+		{
+			const auto plan = threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Spread, 8);
+			CAGE_TEST(plan.size() == 8);
+			for (const auto &a : plan)
+				CAGE_TEST(a.size() == 1);
+			CAGE_TEST(processor(t, plan[0][0]).numaNode != processor(t, plan[1][0]).numaNode);
+			std::vector<uint32> cores;
+			for (uint32 i = 0; i < 4; i++)
+			{
+				CAGE_TEST(processor(t, plan[i][0]).smt == 0);
+				cores.push_back(processor(t, plan[i][0]).core);
+			}
+			std::sort(cores.begin(), cores.end());
+			CAGE_TEST(std::unique(cores.begin(), cores.end()) == cores.end());
+			for (uint32 i = 4; i < 8; i++)
+				CAGE_TEST(processor(t, plan[i][0]).smt == 1);
+		}
+		{
+			const auto plan = threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Compact, 4);
+			for (const auto &a : plan)
+				CAGE_TEST(processor(t, a[0]).numaNode == processor(t, plan[0][0]).numaNode);
+			CAGE_TEST(processor(t, plan[0][0]).core != processor(t, plan[1][0]).core);
+			CAGE_TEST(processor(t, plan[1][0]).smt == 0);
+			CAGE_TEST(processor(t, plan[2][0]).smt == 1);
+		}
+		{
+			const auto plan = threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Spread, 20);
+			CAGE_TEST(plan.size() == 20);
+			CAGE_TEST(plan[8] == plan[0]);
+		}
+		for (const auto &a : threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Performance, 3))
+			CAGE_TEST(a.empty()); // not hybrid
+		for (const auto &a : threadsAffinityPlan(t, ThreadAffinityPolicyEnum::None, 3))
+			CAGE_TEST(a.empty());
+	}
+
+	{
+		CAGE_TESTCASE("processors topology: hybrid");
+		pathRemove("testdir/sysfs");
+		// two performance cores with two threads each, two efficiency cores
+		writeSysfs("devices/system/cpu/online", "0-5");
+		for (uint32 i = 0; i < 6; i++)
+		{
+			const String dir = Stringizer() + "devices/system/cpu/cpu" + i;
+			writeSysfs(dir + "/topology/physical_package_id", "0");
+			writeSysfs(dir + "/topology/core_cpus_list", i < 4 ? String(Stringizer() + (i / 2 * 2) + "-" + (i / 2 * 2 + 1)) : String(Stringizer() + i));
+		}
+		writeSysfs("devices/cpu_atom/cpus", "4-5");
+		writeSysfs("devices/cpu_core/cpus", "0-3");
+
+		const ProcessorsTopology t = processorsTopologyFromSysfs("testdir/sysfs");
+		CAGE_TEST(t.processors.size() == 6);
+		CAGE_TEST(t.cores == 4);
+		CAGE_TEST(t.packages == 1);
+		CAGE_TEST(t.numaNodes == 1);
+		CAGE_TEST(t.hybrid);
+		CAGE_TEST(processor(t, 1).smt == 1);
+		CAGE_TEST(processor(t, 2).processorClass == ProcessorClassEnum::Performance);
+		CAGE_TEST(processor(t, 5).processorClass == ProcessorClassEnum::Efficiency);
+		{
+			const auto plan = threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Performance, 2);
+			CAGE_TEST(plan[0] == std::vector<uint32>({ 0, 1, 2, 3 }));
+			CAGE_TEST(plan[1] == plan[0]);
+		}
+		{
+			const auto plan = threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Efficiency, 1);
+			CAGE_TEST(plan[0] == std::vector<uint32>({ 4, 5 }));
+		}
+		{
+			const auto plan = threadsAffinityPlan(t, ThreadAffinityPolicyEnum::Spread, 4);
+			CAGE_TEST(processor(t, plan[0][0]).processorClass == ProcessorClassEnum::Performance);
+			CAGE_TEST(processor(t, plan[1][0]).processorClass == ProcessorClassEnum::Performance);
+			CAGE_TEST(processor(t, plan[0][0]).core != processor(t, plan[1][0]).core);
+			CAGE_TEST(processor(t, plan[2][0]).processorClass == ProcessorClassEnum::Efficiency);
+		}
+	}
+
+	{
+		CAGE_TESTCASE("processors topology: capacities and offline processors");
+		pathRemove("testdir/sysfs");
+		writeSysfs("devices/system/cpu/online", "0,2-3");
+		writeSysfs("devices/system/cpu/cpu0/cpu_capacity", "1024");
+		writeSysfs("devices/system/cpu/cpu2/cpu_capacity", "446");
+		writeSysfs("devices/system/cpu/cpu3/cpu_capacity", "446");
+		const ProcessorsTopology t = processorsTopologyFromSysfs("testdir/sysfs");
+		CAGE_TEST(t.processors.size() == 3);
+		CAGE_TEST(t.processors[1].id == 2);
+		CAGE_TEST(t.cores == 3);
+		CAGE_TEST(t.hybrid);
+		CAGE_TEST(processor(t, 0).processorClass == ProcessorClassEnum::Performance);
+		CAGE_TEST(processor(t, 3).processorClass == ProcessorClassEnum::Efficiency);
+	}
+
+	{
+		CAGE_TESTCASE("processors topology: invalid");
+		pathRemove("testdir/sysfs");
+		{
+			CAGE_LOG_THROW("expected exception");
+			CAGE_TEST_THROWN(processorsTopologyFromSysfs("testdir/sysfs"));
+		}
+		CAGE_TEST(threadAffinityPolicyFromString("Spread") == ThreadAffinityPolicyEnum::Spread);
+		CAGE_TEST(threadAffinityPolicyFromString("") == ThreadAffinityPolicyEnum::None);
+		CAGE_TEST_THROWN(threadAffinityPolicyFromString("bogus"));
+	}
+
+	{
+		CAGE_TESTCASE("processors topology: current system");
+		const ProcessorsTopology &t = processorsTopology();
+		CAGE_TEST(!t.processors.empty());
+		CAGE_TEST(t.cores > 0 && t.cores <= t.processors.size());
+		CAGE_LOG(SeverityEnum::Info, "info", Stringizer() + "processors: " + t.processors.size() + ", cores: " + t.cores + ", packages: " + t.packages + ", numa nodes: " + t.numaNodes + ", cache groups: " + t.cacheGroups + ", hybrid: " + t.hybrid);
+		currentThreadAffinity(std::vector<uint32>({ t.processors[0].id }));
+		currentThreadAffinity({});
+		Holder<ThreadPool> pool = newThreadPool("affinity_", 3, ThreadAffinityPolicyEnum::Spread);
+		pool->function.bind<&affinityPoolFunction>();
+		pool->run();
+		CAGE_TEST(affinityCounter == 3);
+	}
 }
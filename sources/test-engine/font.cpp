@@ -0,0 +1,214 @@
+#include "../test-core/main.h"
+
+#include <cage-core/assetManager.h>
+#include <cage-core/assetContext.h>
+#include <cage-core/serialization.h>
+#include <cage-core/concurrent.h>
+#include <cage-core/textPack.h>
+#include <cage-core/files.h>
+#include <cage-core/utf.h>
+
+#include <cage-engine/assetStructs.h>
+#include <cage-engine/font.h>
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	// glyph 0 is the missing character, the last glyph is the cursor
+	// no image is set, therefore no opengl is needed for transcripting and layouting
+	Holder<const Font> makeFont(const std::vector<uint32> &chars, Real advance = 0.5)
+	{
+		Holder<Font> font = newFont();
+		font->setLine(1.2, 1);
+		std::vector<FontHeader::GlyphData> glyphs;
+		glyphs.resize(chars.size() + 2);
+		for (FontHeader::GlyphData &g : glyphs)
+		{
+			g.size = Vec2(advance, 1);
+			g.advance = advance;
+		}
+		font->setGlyphs(bufferCast<const char, const FontHeader::GlyphData>(glyphs), {});
+		std::vector<uint32> indices;
+		for (uint32 i = 0; i < chars.size(); i++)
+			indices.push_back(i + 1);
+		font->setCharmap(chars, indices);
+		return std::move(font).cast<const Font>();
+	}
+
+	uint32 referenceGlyph(const std::vector<uint32> &chars, uint32 character)
+	{
+		auto it = std::lower_bound(chars.begin(), chars.end(), character);
+		if (it == chars.end() || *it != character)
+			return 0;
+		return numeric_cast<uint32>(it - chars.begin()) + 1;
+	}
+}
+
+void testFont()
+{
+	CAGE_TESTCASE("font");
+
+	{
+		CAGE_TESTCASE("direct charmap matches searching");
+		std::vector<uint32> chars;
+		for (uint32 c = ' '; c < 0x80; c++)
+			chars.push_back(c);
+		for (uint32 c = 0x400; c < 0x500; c += 3) // sparse, with gaps
+			chars.push_back(c);
+		chars.push_back('\n');
+		chars.push_back(0x2FFF); // last directly mapped character
+		chars.push_back(0x3000); // first searched character
+		chars.push_back(0x4E00);
+		chars.push_back(0x1F600);
+		std::sort(chars.begin(), chars.end());
+		Holder<const Font> font = makeFont(chars);
+
+		std::vector<uint32> codes;
+		for (uint32 c = 1; c < 0x3100; c++)
+			codes.push_back(c);
+		codes.push_back(0x4E00);
+		codes.push_back(0x4E01);
+		codes.push_back(0x1F600);
+		Holder<PointerRange<char>> text = utf32to8(codes);
+		Holder<PointerRange<uint32>> glyphs = font->transcript(PointerRange<const char>(*text));
+		CAGE_TEST(glyphs.size() == codes.size());
+		for (uint32 i = 0; i < codes.size(); i++)
+			CAGE_TEST(glyphs[i] == referenceGlyph(chars, codes[i]));
+	}
+
+	{
+		CAGE_TESTCASE("charmap without direct characters");
+		std::vector<uint32> chars = { 0x3001, 0x3005, 0x10000 };
+		Holder<const Font> font = makeFont(chars);
+		Holder<PointerRange<uint32>> glyphs = font->transcript("a");
+		CAGE_TEST(glyphs.size() == 1 && glyphs[0] == 0);
+		const std::vector<uint32> codes = { 0x3000, 0x3001, 0x3005, 0x10000, 0x10001 };
+		Holder<PointerRange<char>> text = utf32to8(codes);
+		glyphs = font->transcript(PointerRange<const char>(*text));
+		for (uint32 i = 0; i < 5; i++)
+			CAGE_TEST(glyphs[i] == referenceGlyph(chars, codes[i]));
+	}
+
+	std::vector<uint32> chars;
+	for (uint32 c = ' '; c < 0x80; c++)
+		chars.push_back(c);
+	const Holder<const Font> fontA = makeFont(chars);
+	const Holder<const Font> fontB = makeFont(chars, 0.7);
+
+	{
+		CAGE_TESTCASE("layout cache hits");
+		Holder<TextLayoutCache> cache = newTextLayoutCache({});
+		const FontFormat format;
+		Holder<const FontLayout> a = cache->get(fontA, "hello world", format);
+		CAGE_TEST(a);
+		CAGE_TEST(a->glyphs.size() == 11);
+		CAGE_TEST(a->instances.size() == 11);
+		CAGE_TEST(cache->count() == 1);
+		Holder<const FontLayout> b = cache->get(fontA, "hello world", format);
+		CAGE_TEST(+a == +b);
+		CAGE_TEST(cache->count() == 1);
+		const FontLayout direct = fontA->layout(fontA->transcript("hello world"), format);
+		CAGE_TEST(direct.size == a->size);
+	}
+
+	{
+		CAGE_TESTCASE("layout cache misses");
+		Holder<TextLayoutCache> cache = newTextLayoutCache({});
+		const FontFormat base;
+		Holder<const FontLayout> a = cache->get(fontA, "hello world", base);
+		uint32 expected = 1;
+		const auto &miss = [&](const Holder<const Font> &font, const String &text, const FontFormat &format) {
+			Holder<const FontLayout> b = cache->get(font, text, format);
+			CAGE_TEST(+a != +b);
+			expected++;
+			CAGE_TEST(cache->count() == expected);
+		};
+		miss(fontA, "hello world!", base);
+		miss(fontB, "hello world", base);
+		{
+			FontFormat f = base;
+			f.size = 20;
+			miss(fontA, "hello world", f);
+		}
+		{
+			FontFormat f = base;
+			f.wrapWidth = 30;
+			miss(fontA, "hello world", f);
+		}
+		{
+			FontFormat f = base;
+			f.lineSpacing = 2;
+			miss(fontA, "hello world", f);
+		}
+		{
+			FontFormat f = base;
+			f.align = TextAlignEnum::Center;
+			f.wrapWidth = 100;
+			miss(fontA, "hello world", f);
+		}
+		CAGE_TEST(+cache->get(fontA, "hello world", base) == +a);
+		CAGE_TEST(cache->count() == expected);
+		cache->clear();
+		CAGE_TEST(cache->count() == 0);
+	}
+
+	{
+		CAGE_TESTCASE("layout cache eviction");
+		TextLayoutCacheCreateConfig cfg;
+		cfg.unusedFramesLimit = 3;
+		Holder<TextLayoutCache> cache = newTextLayoutCache(cfg);
+		const FontFormat format;
+		cache->get(fontA, "used", format);
+		cache->get(fontA, "unused", format);
+		CAGE_TEST(cache->count() == 2);
+		for (uint32 i = 0; i < cfg.unusedFramesLimit; i++)
+		{
+			cache->nextFrame();
+			cache->get(fontA, "used", format);
+			CAGE_TEST(cache->count() == 2);
+		}
+		cache->nextFrame();
+		CAGE_TEST(cache->count() == 1);
+		cache->get(fontA, "used", format);
+		CAGE_TEST(cache->count() == 1);
+		for (uint32 i = 0; i < cfg.unusedFramesLimit + 1; i++)
+			cache->nextFrame();
+		CAGE_TEST(cache->count() == 0);
+	}
+
+	{
+		CAGE_TESTCASE("layout cache with text packs");
+		pathCreateDirectories("testdir/font");
+		AssetManagerCreateConfig acfg;
+		acfg.assetsFolderName = "testdir/font";
+		Holder<AssetManager> assets = newAssetManager(acfg);
+		assets->defineScheme<AssetSchemeIndexTextPack, TextPack>(genAssetSchemeTextPack());
+		{
+			Holder<TextPack> pack = newTextPack();
+			pack->set(42, "hi {0}, bye {1}");
+			pack->set(43, "other");
+			assets->fabricate<AssetSchemeIndexTextPack, TextPack>(13, std::move(pack));
+		}
+		while (assets->processing())
+			threadYield();
+
+		Holder<TextLayoutCache> cache = newTextLayoutCache({});
+		const FontFormat format;
+		Holder<const FontLayout> a = cache->get(fontA, +assets, 13, 42, "you|me", format);
+		const FontLayout direct = fontA->layout(fontA->transcript(loadFormattedString(+assets, 13, 42, "you|me")), format);
+		CAGE_TEST(a->glyphs.size() == direct.glyphs.size());
+		CAGE_TEST(a->glyphs.size() == String("hi you, bye me").length());
+		CAGE_TEST(+cache->get(fontA, +assets, 13, 42, "you|me", format) == +a);
+		CAGE_TEST(cache->count() == 1);
+		CAGE_TEST(+cache->get(fontA, +assets, 13, 42, "them|me", format) != +a); // params
+		CAGE_TEST(+cache->get(fontA, +assets, 13, 43, "you|me", format) != +a); // text name
+		CAGE_TEST(+cache->get(fontA, "you|me", format) != +a); // no pack
+		CAGE_TEST(cache->count() == 4);
+		CAGE_TEST(cache->get(fontA, +assets, 14, 42, "you|me", format)->glyphs.size() == 0); // missing pack
+		cache.clear();
+		assets->remove(13);
+		assets->unloadWait();
+	}
+}
@@ -0,0 +1,22 @@
+#include "../test-core/main.h"
+
+#include <cage-core/logger.h>
+
+void testRenderQueue();
+void testFont();
+
+int main()
+{
+	Holder<Logger> log1 = newLogger();
+	log1->format.bind<logFormatConsole>();
+	log1->output.bind<logOutputStdOut>();
+
+	testRenderQueue();
+	testFont();
+
+	{
+		CAGE_TESTCASE("all tests done ok");
+	}
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include "../test-core/main.h"
+
+#include <cage-engine/provisionalGraphics.h>
+#include <cage-engine/renderQueue.h>
+
+namespace
+{
+	uint32 count(const RenderQueueInspection &ins, StringLiteral name)
+	{
+		uint32 res = 0;
+		for (StringLiteral n : ins.commands)
+			if (String(n) == String(name))
+				res++;
+		return res;
+	}
+}
+
+void testRenderQueue()
+{
+	CAGE_TESTCASE("render queue");
+
+	// provisional resources are not resolved by inspection, therefore no opengl context is needed
+	Holder<ProvisionalGraphics> prov = newProvisionalGraphics();
+	const TextureHandle a = prov->texture("a");
+	const TextureHandle b = prov->texture("b");
+
+	{
+		CAGE_TESTCASE("inspect lists commands");
+		Holder<RenderQueue> q = newRenderQueue("test", +prov);
+		q->viewport(Vec2i(), Vec2i(100));
+		q->bind(a, 0);
+		q->resetAllTextures();
+		const RenderQueueInspection ins = q->inspect();
+		CAGE_TEST(ins.commands.size() == 5);
+		CAGE_TEST(String(ins.commands[0]) == "viewport");
+		CAGE_TEST(String(ins.commands[1]) == "texture bind");
+		CAGE_TEST(String(ins.commands[2]) == "push scope");
+		CAGE_TEST(String(ins.commands[3]) == "textures reset");
+		CAGE_TEST(String(ins.commands[4]) == "pop scope");
+		CAGE_TEST(ins.redundant == 0);
+	}
+
+	{
+		CAGE_TESTCASE("redundant texture binds are skipped");
+		Holder<RenderQueue> q = newRenderQueue("test", +prov);
+		q->bind(a, 0);
+		q->bind(a, 0);
+		q->bind(a, 1);
+		q->bind(b, 0);
+		q->bind(a, 1);
+		const RenderQueueInspection ins = q->inspect();
+		CAGE_TEST(count(ins, "texture bind") == 3);
+		CAGE_TEST(ins.redundant == 2);
+	}
+
+	{
+		CAGE_TESTCASE("resetting textures invalidates the tracked units");
+		Holder<RenderQueue> q = newRenderQueue("test", +prov);
+		q->bind(a, 0);
+		q->resetAllTextures();
+		q->bind(a, 0);
+		const RenderQueueInspection ins = q->inspect();
+		CAGE_TEST(count(ins, "texture bind") == 2);
+		CAGE_TEST(ins.redundant == 0);
+	}
+
+	{
+		CAGE_TESTCASE("binding points outside of the tracked range are never skipped");
+		Holder<RenderQueue> q = newRenderQueue("test", +prov);
+		q->bind(a, 100);
+		q->bind(a, 100);
+		const RenderQueueInspection ins = q->inspect();
+		CAGE_TEST(count(ins, "texture bind") == 2);
+		CAGE_TEST(ins.redundant == 0);
+	}
+
+	{
+		CAGE_TESTCASE("enqueued queues share the tracked state");
+		Holder<RenderQueue> inner = newRenderQueue("inner", +prov);
+		inner->bind(a, 0);
+		inner->bind(b, 1);
+		Holder<RenderQueue> q = newRenderQueue("test", +prov);
+		q->bind(a, 0);
+		q->enqueue(inner.share());
+		q->bind(b, 1);
+		q->bind(b, 0);
+		const RenderQueueInspection ins = q->inspect();
+		CAGE_TEST(count(ins, "enqueue") == 1);
+		CAGE_TEST(count(ins, "texture bind") == 3);
+		CAGE_TEST(ins.redundant == 2);
+	}
+
+	{
+		CAGE_TESTCASE("inspection is repeatable");
+		Holder<RenderQueue> q = newRenderQueue("test", +prov);
+		q->bind(a, 0);
+		q->bind(a, 0);
+		const RenderQueueInspection ins1 = q->inspect();
+		const RenderQueueInspection ins2 = q->inspect();
+		CAGE_TEST(ins1.commands.size() == ins2.commands.size());
+		CAGE_TEST(ins1.redundant == 1 && ins2.redundant == 1);
+	}
+}
@@ -0,0 +1,106 @@
+#include <cage-core/core.h>
+#include <cage-core/networkGinnel.h>
+#include <cage-core/serialization.h>
+#include <cage-core/memoryBuffer.h>
+
+using namespace cage;
+
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+	constexpr uint64 TickDuration = 10000; // simulated microseconds per update
+	constexpr uint32 UnreliableSize = 200;
+	constexpr uint32 ReliableSize = 2000;
+	constexpr uint32 ReliablePeriod = 10; // ticks
+
+	MemoryBuffer makeMessage(uint64 time, uint32 size)
+	{
+		MemoryBuffer b(size);
+		detail::memset(b.data(), 0, size);
+		Serializer ser(b);
+		ser << time;
+		return b;
+	}
+
+	uint64 percentile(const std::vector<uint64> &sorted, uint32 p)
+	{
+		if (sorted.empty())
+			return 0;
+		return sorted[std::min(sorted.size() * p / 100, sorted.size() - 1)];
+	}
+}
+
+void runBenchmark(const GinnelSimulatorCreateConfig &config, uint32 connections, uint64 duration)
+{
+	CAGE_LOG(SeverityEnum::Info, "config", Stringizer() + "running in benchmark mode");
+	CAGE_LOG(SeverityEnum::Info, "config", Stringizer() + "connections: " + connections + ", duration: " + (duration / 1000000) + " s, seed: " + config.seed);
+	CAGE_LOG(SeverityEnum::Info, "config", Stringizer() + "latency: " + (config.latency / 1000) + " ms, jitter: " + (config.jitter / 1000) + " ms, bandwidth: " + (config.bandwidth / 1024) + " KB/s, loss: " + config.packetLoss + ", duplication: " + config.duplication + ", reordering: " + config.reordering);
+
+	Holder<GinnelSimulator> sim = newGinnelSimulator(config);
+	Holder<GinnelServer> server = newGinnelServer(1234, +sim);
+	std::vector<Holder<GinnelConnection>> serverConns;
+	serverConns.reserve(connections);
+	std::vector<Holder<GinnelConnection>> clients;
+	clients.reserve(connections);
+	for (uint32 i = 0; i < connections; i++)
+		clients.push_back(newGinnelConnection("", 1234, 0, +sim));
+
+	std::vector<uint64> latencies;
+	uint64 messagesReceived = 0, bytesReceived = 0;
+	const uint64 startSim = sim->time();
+	const uint64 startReal = applicationTime();
+	for (uint32 tick = 0; sim->time() < startSim + duration; tick++)
+	{
+		while (auto c = server->accept())
+			serverConns.push_back(std::move(c));
+		for (auto &c : serverConns)
+		{
+			while (c->available())
+			{
+				uint32 ch;
+				bool r;
+				Holder<PointerRange<char>> b = c->read(ch, r);
+				c->write(b, ch, r); // echo
+			}
+			c->update();
+		}
+
+		const uint64 now = sim->time();
+		for (auto &c : clients)
+		{
+			while (c->available())
+			{
+				Holder<PointerRange<char>> b = c->read();
+				Deserializer des(b);
+				uint64 sent = 0;
+				des >> sent;
+				latencies.push_back(now - sent);
+				messagesReceived++;
+				bytesReceived += b.size();
+			}
+			c->write(makeMessage(now, UnreliableSize), 1, false);
+			if ((tick % ReliablePeriod) == 0)
+				c->write(makeMessage(now, ReliableSize), 2, true);
+			c->update();
+		}
+
+		sim->advance(TickDuration);
+	}
+	const uint64 realDuration = std::max(applicationTime() - startReal, uint64(1));
+	const uint64 simDuration = sim->time() - startSim;
+
+	std::sort(latencies.begin(), latencies.end());
+	const GinnelSimulatorStatistics st = sim->statistics();
+	uint64 bandwidthSum = 0;
+	for (const auto &c : clients)
+		bandwidthSum += c->bandwidth();
+
+	CAGE_LOG(SeverityEnum::Info, "benchmark", Stringizer() + "accepted connections: " + serverConns.size() + " / " + connections);
+	CAGE_LOG(SeverityEnum::Info, "benchmark", Stringizer() + "packets sent: " + st.packetsSent + ", delivered: " + st.packetsDelivered + ", lost: " + st.packetsLost + ", overflow: " + st.packetsOverflow + ", duplicated: " + st.packetsDuplicated + ", reordered: " + st.packetsReordered);
+	CAGE_LOG(SeverityEnum::Info, "benchmark", Stringizer() + "throughput: " + (1000000 * st.bytesDelivered / simDuration / 1024) + " KB/s total, messages echoed: " + messagesReceived + " (" + (1000000 * bytesReceived / simDuration / 1024) + " KB/s)");
+	CAGE_LOG(SeverityEnum::Info, "benchmark", Stringizer() + "round trip latency [ms]: p50: " + (percentile(latencies, 50) / 1000) + ", p90: " + (percentile(latencies, 90) / 1000) + ", p99: " + (percentile(latencies, 99) / 1000) + ", max: " + (latencies.empty() ? 0 : latencies.back() / 1000));
+	CAGE_LOG(SeverityEnum::Info, "benchmark", Stringizer() + "average estimated bandwidth: " + (bandwidthSum / std::max(connections, 1u) / 1024) + " KB/s per connection");
+	CAGE_LOG(SeverityEnum::Info, "benchmark", Stringizer() + "real time: " + (realDuration / 1000) + " ms, cpu per packet: " + (double(realDuration) / std::max(st.packetsSent, uint64(1))) + " us, simulation speed: " + (double(simDuration) / realDuration) + "x");
+}
@@ -5,11 +5,13 @@
 #include <cage-core/concurrent.h>
 #include <cage-core/config.h>
 #include <cage-core/debug.h>
+#include <cage-core/networkGinnel.h>
 
 using namespace cage;
 
 void runServer();
 void runClient();
+void runBenchmark(const GinnelSimulatorCreateConfig &config, uint32 connections, uint64 duration);
 
 namespace
 {
@@ -97,6 +99,7 @@ int main(int argc, const char *args[])
 		ConfigUint64 maxBytesPerSecond("maxBytesPerSecond");
 		const bool modeServer = cmd->cmdBool('s', "server", false);
 		const bool modeClient = cmd->cmdBool('c', "client", false);
+		const bool modeBenchmark = cmd->cmdBool('b', "benchmark", false);
 		const String name = cmd->cmdString('n', "name", "");
 		address = cmd->cmdString('a', "address", address);
 		port = cmd->cmdUint32('p', "port", port);
@@ -106,11 +109,29 @@ int main(int argc, const char *args[])
 		if (packetLoss < 0 || packetLoss > 1)
 			CAGE_THROW_ERROR(Exception, "invalid packet loss");
 		maxBytesPerSecond = cmd->cmdUint64('l', "limit", MaxBytesPerSecond);
+		GinnelSimulatorCreateConfig simulation;
+		uint32 connections = 0;
+		uint64 duration = 0;
+		if (modeBenchmark)
+		{
+			// the benchmark runs within the simulator, the impairments are applied by the simulator
+			simulation.packetLoss = packetLoss;
+			packetLoss = 0;
+			simulation.seed = cmd->cmdUint64('r', "seed", 0);
+			simulation.latency = cmd->cmdUint64('t', "latency", 30) * 1000;
+			simulation.jitter = cmd->cmdUint64('j', "jitter", 10) * 1000;
+			simulation.bandwidth = cmd->cmdUint64('w', "bandwidth", 0);
+			simulation.duplication = cmd->cmdFloat('u', "duplication", 0);
+			simulation.reordering = cmd->cmdFloat('o', "reordering", 0);
+			simulation.manualTime = true;
+			connections = cmd->cmdUint32('k', "connections", 1000);
+			duration = cmd->cmdUint64('d', "duration", 10) * 1000000;
+		}
 		cmd->checkUnusedWithHelp();
 		cmd.clear();
 
-		if (modeServer == modeClient)
-			CAGE_THROW_ERROR(Exception, "invalid mode (exactly one of -s or -c must be set)");
+		if (modeServer + modeClient + modeBenchmark != 1)
+			CAGE_THROW_ERROR(Exception, "invalid mode (exactly one of -s, -c or -b must be set)");
 
 		if (!name.empty())
 			initializeSecondaryLog(name + ".log");
@@ -120,6 +141,8 @@ int main(int argc, const char *args[])
 			runServer();
 		if (modeClient)
 			runClient();
+		if (modeBenchmark)
+			runBenchmark(simulation, connections, duration);
 
 		return 0;
 	}